@@ -140,6 +140,12 @@ void about_menu(GtkWidget *parent) {
              radio->name, radio->soapy.hardware_key, radio->soapy.driver_key);
     break;
 #endif
+
+  case FILE_PROTOCOL:
+    snprintf(text, sizeof(text), "Device: IQ file playback, %d RX, %d Hz\n"
+                                 "    %s",
+             radio->supported_receivers, radio->playback.sample_rate, radio->playback.file[0]);
+    break;
   }
 
   label = gtk_label_new(text);
@@ -38,9 +38,11 @@
 #include "ps_menu.h"
 #include "radio.h"
 #include "receiver.h"
+#include "recorder.h"
 #include "sliders.h"
 #include "store.h"
 #include "toolbar.h"
+#include "transmitter.h"
 #include "vfo.h"
 
 //
@@ -184,6 +186,7 @@ ACTION_TABLE ActionTable[] = {
   {RCL7,                "Rcl 7",                "RCL7",         AT_BTN},
   {RCL8,                "Rcl 8",                "RCL8",         AT_BTN},
   {RCL9,                "Rcl 9",                "RCL9",         AT_BTN},
+  {RECORD,              "Record",               "REC",          AT_BTN},
   {RF_GAIN,             "RF Gain",              "RFGAIN",       AT_KNB | AT_ENC | AT_SLD},
   {RF_GAIN_RX1,         "RF Gain\nRX1",         "RFGAIN1",      AT_KNB | AT_ENC},
   {RF_GAIN_RX2,         "RF Gain\nRX2",         "RFGAIN2",      AT_KNB | AT_ENC},
@@ -366,23 +369,22 @@ void schedule_action(enum ACTION action, enum ACTION_MODE mode, int val) {
     break;
 
   case CW_KEYER_KEYDOWN: {
-    static double last = 0.0;
-    double now;
+    static long long last = 0;
+    long long now;
     int wait;
-    struct timespec ts;
     //
     // hard "key-up/down" action WITHOUT break-in
     // intended for external keyers (MIDI or GPIO connected)
     // which take care of PTT themselves.
+    // The time between events is measured with the CW clock,
+    // that is, in TX samples. The GPIO CW output is switched by
+    // the TX engine when it executes the events.
     //
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    now = ts.tv_sec + 1.0E-9 * ts.tv_nsec;
-    wait = (int) (48000.0 * (now - last) + 0.5);
+    now = tx_cw_clock();
+    wait = (now - last > 96000) ? 96000 : (int) (now - last);
     last = now;
 
     if (mode == PRESSED && (!cw_keyer_internal || MIDI_cw_is_active)) {
-      gpio_set_cw(1);
-
       if (wait > 48000) {
         //
         // first key-down after a pause: queue without delay if local,
@@ -400,7 +402,6 @@ void schedule_action(enum ACTION action, enum ACTION_MODE mode, int val) {
       tx_queue_cw_event(1, wait);
       cw_key_hit = 1;
     } else {
-      gpio_set_cw(0);
       tx_queue_cw_event(0, wait);
     }
   }
@@ -426,6 +427,32 @@ int process_action(void *data) {
   enum ACTION action = a->action;
 
   //t_print("%s: a=%p action=%d mode=%d value=%d\n",__FUNCTION__,a,action,a->mode,a->val);
+  //
+  // There are no menus when running headless
+  //
+  if (headless) {
+    switch (action) {
+    case MENU_AGC:
+    case MENU_BAND:
+    case MENU_BANDSTACK:
+    case MENU_DIVERSITY:
+    case MENU_FILTER:
+    case MENU_FREQUENCY:
+    case MENU_MAIN:
+    case MENU_MEMORY:
+    case MENU_MODE:
+    case MENU_NOISE:
+    case MENU_PS:
+    case MENU_RX:
+    case MENU_TX:
+      g_free(data);
+      return 0;
+
+    default:
+      break;
+    }
+  }
+
   switch (action) {
   case A_SWAP_B:
     if (a->mode == PRESSED) {
@@ -1397,6 +1424,21 @@ int process_action(void *data) {
 
     break;
 
+  case RECORD:
+
+    //
+    // IQ and audio recording is done on the server side only
+    //
+    if (!radio_is_remote && a->mode == PRESSED) {
+      if (recording) {
+        recorder_stop();
+      } else {
+        recorder_start();
+      }
+    }
+
+    break;
+
   case RF_GAIN:
     if (have_rx_gain) {
       value = KnobOrWheel(a, adc[active_receiver->adc].gain, adc[active_receiver->adc].min_gain,
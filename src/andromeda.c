@@ -27,6 +27,7 @@
 #include "actions.h"
 #include "band.h"
 #include "ext.h"
+#include "main.h"
 #include "new_menu.h"
 #include "radio.h"
 #include "toolbar.h"
@@ -63,7 +64,8 @@ int andromeda_execute_button(int v, int p) {
           startstop ? radio_protocol_run() : radio_protocol_stop();
         }
       } else if (v == 2) {
-        new_menu();
+        if (!headless) { new_menu(); }
+
         longpress = 1;
       }
 
@@ -192,7 +194,7 @@ int andromeda_execute_button(int v, int p) {
         vfo_id_band_changed(active_receiver->id ? VFO_B : VFO_A, band);
         shift = 0;
       } else if (!shift && v == 1) {
-        if (p == 30) { start_tx(); }                                  // MODE DATA
+        if (p == 30) { if (!headless) { start_tx(); } }               // MODE DATA
         else if (p == 31) { schedule_action(MODE_PLUS, PRESSED, 0); } // MODE+
         else if (p == 32) { schedule_action(FILTER_PLUS, PRESSED, 0); } // FILTER+
         else if (p == 33) { radio_change_receivers(receivers == 1 ? 2 : 1); } // RX2
@@ -287,7 +289,8 @@ int andromeda_execute_button(int v, int p) {
           }
         }
       } else if (v == 2) {
-        start_ps();
+        if (!headless) { start_ps(); }
+
         longpress = 1;
       }
 
@@ -34,9 +34,11 @@
 #include "audio.h"
 #include "client_server.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "radio.h"
 #include "receiver.h"
+#include "threads.h"
 #include "transmitter.h"
 #include "vfo.h"
 
@@ -459,6 +461,8 @@ int cw_audio_write(RECEIVER *rx, float sample) {
         if (rc < 0) {
           switch (rc) {
           case -EPIPE:
+            metric_inc(METRIC_AUDIO_UNDERRUNS, rx->id);
+
             if ((rc = snd_pcm_prepare (rx->playback_handle)) < 0) {
               t_print("%s: cannot prepare audio interface for use %ld (%s)\n", __FUNCTION__, rc, snd_strerror (rc));
               rx->local_audio_buffer_offset = 0;
@@ -598,6 +602,8 @@ int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
         if (rc < 0) {
           switch (rc) {
           case -EPIPE:
+            metric_inc(METRIC_AUDIO_UNDERRUNS, rx->id);
+
             if ((rc = snd_pcm_prepare (rx->playback_handle)) < 0) {
               t_print("%s: cannot prepare audio interface for use %ld (%s)\n", __FUNCTION__, rc, snd_strerror (rc));
               rx->local_audio_buffer_offset = 0;
@@ -632,6 +638,7 @@ static void *mic_read_thread(gpointer arg) {
   float sample;
   int i;
   t_print("%s: mic_buffer_size=%d\n", __FUNCTION__, mic_buffer_size);
+  thread_setup(THREAD_AUDIO, "ALSA mic");
   t_print("%s: snd_pcm_start\n", __FUNCTION__);
 
   if ((rc = snd_pcm_start (record_handle)) < 0) {
@@ -708,6 +715,8 @@ static void *mic_read_thread(gpointer arg) {
             mic_ring_buffer[mic_ring_write_pt] = sample;
             // atomic update of mic_ring_write_pt
             mic_ring_write_pt = newpt;
+          } else {
+            metric_inc(METRIC_MIC_OVERRUNS, 0);
           }
         }
       }
@@ -48,6 +48,10 @@
  * the receive thread, so we need a mutex in send_bytes. It is important that
  * a packet (that is, a bunch of data that belongs together) is sent in a single
  * call to send_bytes.
+ *
+ * On the server side, once the client is authorised, send_bytes only queues
+ * the packet and a separate writer thread does the actual sending (see
+ * send_queue.c), so a slow connection cannot stall the RX engine.
  */
 
 /*
@@ -64,6 +68,7 @@
 #include "filter.h"
 #include "message.h"
 #include "radio.h"
+#include "send_queue.h"
 #include "store.h"
 #include "vfo.h"
 
@@ -113,6 +118,212 @@ void generate_pwd_hash(unsigned char *s, unsigned char *hash, const char *pwd) {
   }
 }
 
+//
+// State packets describe a complete piece of the radio state (a receiver,
+// a VFO, a band stack entry, ...). Each connection remembers a hash of the
+// last state packet sent for each piece, such that unchanged state need not
+// be sent again. The key identifies the piece, it is zero if the packet
+// is not a state packet.
+//
+int remote_state_key(const char *buffer, int bytes, uint32_t *key) {
+  const HEADER *header = (const HEADER *) buffer;
+  int type, id, size;
+
+  if (bytes < (int) sizeof(HEADER) || memcmp(header->sync, syncbytes, sizeof(syncbytes)) != 0) {
+    return 0;
+  }
+
+  type = from_short(header->data_type);
+
+  switch (type) {
+  case INFO_RADIO:
+    size = sizeof(RADIO_DATA);
+    id = 0;
+    break;
+
+  case INFO_ADC:
+    size = sizeof(ADC_DATA);
+    id = ((const ADC_DATA *) buffer)->adc;
+    break;
+
+  case INFO_RECEIVER:
+    size = sizeof(RECEIVER_DATA);
+    id = ((const RECEIVER_DATA *) buffer)->id;
+    break;
+
+  case INFO_TRANSMITTER:
+    size = sizeof(TRANSMITTER_DATA);
+    id = 0;
+    break;
+
+  case INFO_VFO:
+    size = sizeof(VFO_DATA);
+    id = ((const VFO_DATA *) buffer)->vfo;
+    break;
+
+  case INFO_BAND:
+    size = sizeof(BAND_DATA);
+    id = ((const BAND_DATA *) buffer)->band;
+    break;
+
+  case INFO_BANDSTACK:
+    size = sizeof(BANDSTACK_DATA);
+    id = (((const BANDSTACK_DATA *) buffer)->band << 8) | ((const BANDSTACK_DATA *) buffer)->stack;
+    break;
+
+  case INFO_MEMORY:
+    size = sizeof(MEMORY_DATA);
+    id = ((const MEMORY_DATA *) buffer)->index;
+    break;
+
+  case CMD_FILTER_VAR:
+    size = sizeof(HEADER);
+    id = (header->b1 << 8) | header->b2;
+    break;
+
+  default:
+    return 0;
+  }
+
+  if (bytes != size) { return 0; }
+
+  *key = ((uint32_t) (type + 1) << 16) | id;
+  return 1;
+}
+
+//
+// 64-bit FNV-1a hash of a packet
+//
+uint64_t remote_state_hash(const char *buffer, int bytes) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (int i = 0; i < bytes; i++) {
+    hash ^= (uint8_t) buffer[i];
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+GHashTable *remote_state_new() {
+  return g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+}
+
+//
+// Record a packet in a state table. The function value is FALSE if this
+// is a state packet that has not changed since it was recorded last.
+//
+int remote_state_update(GHashTable *state, const char *buffer, int bytes) {
+  uint32_t key;
+
+  if (!remote_state_key(buffer, bytes, &key)) { return TRUE; }
+
+  uint64_t hash = remote_state_hash(buffer, bytes);
+  uint64_t *old = g_hash_table_lookup(state, GUINT_TO_POINTER(key));
+
+  if (old != NULL && *old == hash) { return FALSE; }
+
+  if (old == NULL) {
+    old = g_new(uint64_t, 1);
+    g_hash_table_insert(state, GUINT_TO_POINTER(key), old);
+  }
+
+  *old = hash;
+  return TRUE;
+}
+
+static gboolean state_is_volatile(gpointer key, gpointer value, gpointer data) {
+  switch ((GPOINTER_TO_UINT(key) >> 16) - 1) {
+  case INFO_BAND:
+  case INFO_BANDSTACK:
+  case INFO_MEMORY:
+  case CMD_FILTER_VAR:
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+//
+// A packet from the client to the server. If it is a state packet, the
+// client has that state and the server takes it over. Any other command
+// may change the receiver, transmitter, VFO or radio state on either side
+// in a way the table does not know, so these entries are forgotten. This
+// guarantees that the server sends them again.
+//
+void remote_state_command(GHashTable *state, const char *buffer, int bytes) {
+  const HEADER *header = (const HEADER *) buffer;
+
+  if (bytes < (int) sizeof(HEADER) || memcmp(header->sync, syncbytes, sizeof(syncbytes)) != 0) {
+    return;
+  }
+
+  switch (from_short(header->data_type)) {
+  case CMD_HEARTBEAT:
+  case CMD_MEDIA:
+  case CMD_RX_AUDIO:
+  case CMD_STATE_DIGEST:
+  case CMD_SCREEN:
+  case CMD_RX_FPS:
+  case CMD_RX_SPECTRUM:
+  case CMD_TX_SPECTRUM:
+  case INFO_TXAUDIO:
+    return;
+  }
+
+  uint32_t key;
+
+  if (remote_state_key(buffer, bytes, &key)) {
+    remote_state_update(state, buffer, bytes);
+  } else {
+    g_hash_table_foreach_remove(state, state_is_volatile, NULL);
+  }
+}
+
+//
+// Compress (or decompress) a block of data using the zlib format.
+// Returns NULL if the data is corrupt.
+//
+GByteArray *remote_zlib(int compress, const void *data, gsize length) {
+  GConverter *conv = compress ? G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, -1))
+                     : G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB));
+  GByteArray *out = g_byte_array_new();
+  const guint8 *in = data;
+  guint8 buf[16384];
+  GConverterResult rc;
+
+  do {
+    gsize nread, nwritten;
+    GError *error = NULL;
+    rc = g_converter_convert(conv, in, length, buf, sizeof(buf), G_CONVERTER_INPUT_AT_END,
+                             &nread, &nwritten, &error);
+
+    if (rc == G_CONVERTER_ERROR) {
+      t_print("%s: %s\n", __FUNCTION__, error->message);
+      g_error_free(error);
+      g_byte_array_free(out, TRUE);
+      out = NULL;
+      break;
+    }
+
+    in += nread;
+    length -= nread;
+    g_byte_array_append(out, buf, nwritten);
+
+    //
+    // Decompressing data that ends too early
+    //
+    if (nread == 0 && nwritten == 0 && rc != G_CONVERTER_FINISHED) {
+      g_byte_array_free(out, TRUE);
+      out = NULL;
+      break;
+    }
+  } while (rc != G_CONVERTER_FINISHED);
+
+  g_object_unref(conv);
+  return out;
+}
+
 int recv_bytes(int s, char *buffer, int bytes) {
   int bytes_read = 0;
   int count = 0;
@@ -136,7 +347,7 @@ int recv_bytes(int s, char *buffer, int bytes) {
         //
         // This is the server. Note client's death.
         //
-        remoteclient.running = FALSE;
+        remote_client_gone(s);
       }
 
       break;
@@ -153,13 +364,40 @@ int recv_bytes(int s, char *buffer, int bytes) {
 // also from the receive thread (via remote_rxaudio).
 // To make this bullet proof, we need a mutex here in case a
 // remote_rxaudio occurs while sending another packet.
+// If there is a writer thread for this socket, the data is
+// only queued.
 //
 int send_bytes(int s, char *buffer, int bytes) {
   static GMutex send_mutex;  // static so correctly initialised
   int bytes_sent = 0;
 
+  if (!radio_is_remote && s == SEND_SNAPSHOT) {
+    //
+    // Server: collect the initial state for a new client
+    //
+    server_snapshot_add(buffer, bytes);
+    return bytes;
+  }
+
+  if (radio_is_remote && s >= 0) {
+    client_state_command(buffer, bytes);
+  }
+
+  if (!radio_is_remote && s == SEND_ALL) {
+    //
+    // Server: send to all clients
+    //
+    return send_queue_put(s, buffer, bytes);
+  }
+
   if (s < 0) { return -1; }
 
+  if (!radio_is_remote) {
+    int rc = send_queue_put(s, buffer, bytes);
+
+    if (rc != 0) { return rc; }
+  }
+
   g_mutex_lock(&send_mutex);
 
   while (bytes_sent != bytes) {
@@ -176,7 +414,7 @@ int send_bytes(int s, char *buffer, int bytes) {
         //
         // This is the server. Note client's death.
         //
-        remoteclient.running = FALSE;
+        remote_client_gone(s);
       }
 
       break;
@@ -243,8 +481,19 @@ void send_radiomenu(int sock) {
   send_bytes(sock, (char *)&data, sizeof(RADIOMENU_DATA));
 }
 
+void send_media(int s, int state, int port, uint32_t token) {
+  U64_COMMAND command;
+  SYNC(command.header.sync);
+  command.header.data_type = to_short(CMD_MEDIA);
+  command.header.b1 = state;
+  command.header.s1 = to_short(port);
+  command.u64 = to_ll(token);
+  send_bytes(s, (char *)&command, sizeof(command));
+}
+
 void send_memory_data(int sock, int index) {
   MEMORY_DATA data;
+  memset(&data, 0, sizeof(data));
   SYNC(data.header.sync);
   data.header.data_type = to_short(INFO_MEMORY);
   data.index              = index;
@@ -272,6 +521,7 @@ void send_memory_data(int sock, int index) {
 
 void send_band_data(int sock, int b) {
   BAND_DATA data;
+  memset(&data, 0, sizeof(data));
   SYNC(data.header.sync);
   data.header.data_type = to_short(INFO_BAND);
   BAND *band = band_get_band(b);
@@ -301,6 +551,7 @@ void send_xvtr_changed(int sock) {
 
 void send_bandstack_data(int sock, int b, int stack) {
   BANDSTACK_DATA data;
+  memset(&data, 0, sizeof(data));
   SYNC(data.header.sync);
   data.header.data_type = to_short(INFO_BANDSTACK);
   BAND *band = band_get_band(b);
@@ -321,6 +572,7 @@ void send_bandstack_data(int sock, int b, int stack) {
 
 void send_radio_data(int sock) {
   RADIO_DATA data;
+  memset(&data, 0, sizeof(data));
   SYNC(data.header.sync);
   data.header.data_type = to_short(INFO_RADIO);
   snprintf(data.name, sizeof(data.name), "%s", radio->name);
@@ -458,6 +710,7 @@ void send_radio_data(int sock) {
 
 void send_adc_data(int sock, int i) {
   ADC_DATA data;
+  memset(&data, 0, sizeof(data));
   SYNC(data.header.sync);
   data.header.data_type = to_short(INFO_ADC);
   data.adc = i;
@@ -478,6 +731,7 @@ void send_tx_data(int sock) {
   if (can_transmit) {
     TRANSMITTER_DATA data;
     const TRANSMITTER *tx = transmitter;
+    memset(&data, 0, sizeof(data));
     SYNC(data.header.sync);
     data.header.data_type = to_short(INFO_TRANSMITTER);
     //
@@ -549,6 +803,7 @@ void send_tx_data(int sock) {
 
 void send_rx_data(int sock, int id) {
   RECEIVER_DATA data;
+  memset(&data, 0, sizeof(data));
   SYNC(data.header.sync);
   data.header.data_type = to_short(INFO_RECEIVER);
   const RECEIVER *rx = receiver[id];
@@ -626,6 +881,7 @@ void send_rx_data(int sock, int id) {
 
 void send_vfo_data(int sock, int v) {
   VFO_DATA vfo_data;
+  memset(&vfo_data, 0, sizeof(vfo_data));
   SYNC(vfo_data.header.sync);
   vfo_data.header.data_type = to_short(INFO_VFO);
   vfo_data.vfo = v;
@@ -1546,3 +1802,16 @@ void send_mute_rx(int s, int id, int mute) {
   send_bytes(s, (char *)&header, sizeof(HEADER));
 }
 
+//
+// A client asks for (state=1) or gives up (state=0) the audio of
+// receiver #id. This only affects the audio stream to that client.
+//
+void send_rx_audio(int s, int id, int state) {
+  HEADER header;
+  SYNC(header.sync);
+  header.data_type = to_short(CMD_RX_AUDIO);
+  header.b1 = id;
+  header.b2 = state;
+  send_bytes(s, (char *)&header, sizeof(HEADER));
+}
+
@@ -58,6 +58,7 @@ enum _header_type_enum {
   CMD_FREQ,
   CMD_HEARTBEAT,
   CMD_LOCK,
+  CMD_MEDIA,
   CMD_METER,
   CMD_MICGAIN,
   CMD_MODE,
@@ -84,6 +85,7 @@ enum _header_type_enum {
   CMD_RIT_STEP,
   CMD_RXFFT,
   CMD_RXMENU,
+  CMD_RX_AUDIO,
   CMD_RX_DISPLAY,
   CMD_RX_EQ,
   CMD_RX_FILTER_CUT,
@@ -100,6 +102,7 @@ enum _header_type_enum {
   CMD_SPLIT,
   CMD_SQUELCH,
   CMD_START_RADIO,
+  CMD_STATE_DIGEST,
   CMD_STEP,
   CMD_STORE,
   CMD_TOGGLE_MOX,
@@ -133,6 +136,7 @@ enum _header_type_enum {
   INFO_RECEIVER,
   INFO_RXAUDIO,
   INFO_RX_SPECTRUM,
+  INFO_SNAPSHOT,
   INFO_TX_SPECTRUM,
   INFO_TRANSMITTER,
   INFO_TXAUDIO,
@@ -140,19 +144,47 @@ enum _header_type_enum {
   CLIENT_SERVER_COMMANDS,
 };
 
-#define CLIENT_SERVER_VERSION 0x01250001 // 32-bit version number
+#define CLIENT_SERVER_VERSION 0x01260003 // 32-bit version number
 #define SPECTRUM_DATA_SIZE 4096          // Maximum width of a panadapter
 #define AUDIO_DATA_SIZE 512              // 512 stereo samples
 
+#define MAX_REMOTE_CLIENTS 4             // max. number of clients connected at the same time
+#define SNAPSHOT_VERSION 1               // format of the INFO_SNAPSHOT payload
+#define SNAPSHOT_MAX_SIZE 4000000        // max. size of an uncompressed snapshot
+#define MAX_STATE_DIGESTS 2048           // max. number of entries in a CMD_STATE_DIGEST
+#define SEND_SNAPSHOT -3                 // "socket" for collecting the initial state
+
+#define MEDIA_AUDIO_FRAMES 256           // stereo samples per UDP audio packet
+#define MEDIA_STREAM_RXAUDIO(id)    (id)
+#define MEDIA_STREAM_RXSPECTRUM(id) (8 + (id))
+#define MEDIA_STREAM_TXSPECTRUM     16
+#define MEDIA_STREAMS               17
+
+//
+// Each client has its own subscriptions. Only one client (the one that
+// connected first) controls the radio, the others are listen-only.
+//
 typedef struct _remote_client {
   int running;
-  int authorised;
   int socket;
   socklen_t address_length;
   struct sockaddr_in address;
-  guint timer_id;
+  GThread *thread_id;
+  int control;                           // client may control the radio
+  int seqno;                             // order of connection, for passing on control
   int send_rx_spectrum[8];
   int send_tx_spectrum;
+  int send_rx_audio[8];
+  int rx_fps[8];                         // spectrum frame rate wanted (0: all frames)
+  double rx_credit[8];                   // for reducing the spectrum frame rate
+  int width;                             // screen width of the client (0: unknown)
+  int stack_horizontal;
+  volatile int snapshot_sent;            // initial state has been queued
+  guint snapshot_source;                 // GTK idle source making the snapshot
+  volatile int media;                    // audio and spectrum go through UDP
+  uint32_t media_token;                  // identifies UDP packets of this client
+  struct sockaddr_in media_address;      // UDP address of the client
+  uint32_t media_seqno[MEDIA_STREAMS];
 } REMOTE_CLIENT;
 
 typedef struct __attribute__((__packed__)) _header {
@@ -803,6 +835,48 @@ typedef struct __attribute__((__packed__)) _noise_command {
   mydouble nr4_post_threshold;
 } NOISE_COMMAND;
 
+//
+// Upon connection, the server sends the complete radio state in a single
+// packet. The payload is the concatenation of the state packets (INFO_RADIO,
+// INFO_ADC, INFO_RECEIVER, INFO_VFO, ...) as they would be sent one by one,
+// compressed with zlib. header.s1 contains the SNAPSHOT_VERSION.
+//
+typedef struct __attribute__((__packed__)) _snapshot_data {
+  HEADER header;
+  uint32_t length;                       // size of the payload after decompression
+  uint32_t compressed;                   // size of the payload that follows
+} SNAPSHOT_DATA;
+
+//
+// Directly after authentication, the client reports which state it
+// already has (from an earlier connection), such that the server need
+// not send it again. The header is followed by "count" entries.
+//
+typedef struct __attribute__((__packed__)) _state_digest {
+  HEADER header;
+  uint32_t count;
+} STATE_DIGEST;
+
+typedef struct __attribute__((__packed__)) _state_digest_entry {
+  uint32_t key;
+  uint64_t hash;
+} STATE_DIGEST_ENTRY;
+
+//
+// Packets of the UDP media channel are a MEDIA_DATA header followed by
+// an INFO_RXAUDIO, INFO_TXAUDIO, INFO_RX_SPECTRUM or INFO_TX_SPECTRUM
+// packet. Audio packets only contain "numsamples" samples. A packet
+// that only consists of a CMD_MEDIA header is a keep-alive.
+// Each stream has its own sequence numbers, audio packets are time-stamped
+// with the number of the first sample.
+//
+typedef struct __attribute__((__packed__)) _media_data {
+  uint8_t sync[4];
+  uint32_t token;
+  uint32_t seqno;
+  uint32_t timestamp;
+} MEDIA_DATA;
+
 #define HPSDR_PWD_LEN 64
 extern int hpsdr_server;
 extern int server_stops_protocol;
@@ -813,7 +887,10 @@ extern int start_spectrum(void *data);
 extern void start_vfo_timer(void);
 extern gboolean remote_started;
 
-extern REMOTE_CLIENT remoteclient;
+extern REMOTE_CLIENT remoteclient[MAX_REMOTE_CLIENTS];
+extern int remoteclients;
+extern void remote_client_gone(int sock);
+extern const REMOTE_CLIENT *remote_control_client(void);
 
 extern int listen_port;
 
@@ -823,7 +900,10 @@ extern int destroy_hpsdr_server(void);
 extern int radio_connect_remote(char *host, int port, const char *pwd);
 extern void remote_rxaudio(const RECEIVER *rx, short left_sample, short right_sample);
 extern void server_tx_audio(short sample);
+extern void server_mic_audio(const short *samples, int numsamples, int udp);
 extern short remote_get_mic_sample();
+extern void client_rxaudio(int id, const short *samples, int numsamples);
+extern void client_spectrum(int type, const SPECTRUM_DATA *data);
 extern void  send_rxspectrum(int id);
 extern void  send_txspectrum(void);
 
@@ -862,6 +942,7 @@ extern void send_rxfps(int s, int rx, int fps);
 extern void send_txfps(int s, int fps);
 extern void send_heartbeat(int s);
 extern void send_lock(int s, int lock);
+extern void send_media(int s, int state, int port, uint32_t token);
 extern void send_memory_data(int sock, int index);
 extern void send_meter(int s, int metermode, int alcmode);
 extern void send_micgain(int s, double gain);
@@ -887,6 +968,7 @@ extern void send_restart(int s);
 extern void send_rfgain(int s, int rx, double gain);
 extern void send_rit(int s, int id);
 extern void send_rit_step(int s, int v, int step);
+extern void send_rx_audio(int s, int id, int state);
 extern void send_rx_data(int s, int id);
 extern void send_rx_fft(int s, const RECEIVER *rx);
 extern void send_rx_select(int s, int rx);
@@ -931,6 +1013,15 @@ extern void send_zoom(int s, const RECEIVER *rx);
 extern void update_vfo_move(int v, long long hz, int round);
 extern void update_vfo_step(int v, int steps);
 
+extern int remote_state_key(const char *buffer, int bytes, uint32_t *key);
+extern uint64_t remote_state_hash(const char *buffer, int bytes);
+extern GHashTable *remote_state_new(void);
+extern int remote_state_update(GHashTable *state, const char *buffer, int bytes);
+extern void remote_state_command(GHashTable *state, const char *buffer, int bytes);
+extern GByteArray *remote_zlib(int compress, const void *data, gsize length);
+extern void server_snapshot_add(const char *buffer, int bytes);
+extern void client_state_command(const char *buffer, int bytes);
+
 extern int recv_bytes(int s, char *buffer, int bytes);
 extern int send_bytes(int s, char *buffer, int bytes);
 extern void generate_pwd_hash(unsigned char *s, unsigned char *hash, const char *pwd);
@@ -33,6 +33,8 @@
 #include "client_server.h"
 #include "ext.h"
 #include "filter.h"
+#include "main.h"
+#include "media.h"
 #include "message.h"
 #include "radio.h"
 #include "sliders.h"
@@ -51,7 +53,28 @@ static long long accumulated_hz[2] = {0LL, 0LL};
 static int accumulated_round[2] = {FALSE, FALSE};
 guint check_vfo_timer_id = 0;
 
+#define CLIENT_RECONNECT_TRIES 10      // attempts to re-connect after losing the connection
+#define CLIENT_RECONNECT_WAIT  3       // seconds between attempts
+
+//
+// For re-connecting
+//
+static char remote_host[128];
+static int remote_port;
+static char remote_pwd[HPSDR_PWD_LEN];
+
+//
+// Table of the state packets received from the server, kept
+// across connections (see remote_state_update()).
+//
+static GHashTable *client_state = NULL;
+static GMutex client_state_mutex;        // static so correctly initialised
+static GByteArray *received = NULL;      // the packet currently being received
+static GByteArray *replay = NULL;        // the decompressed snapshot
+static guint replay_pos = 0;
+
 static void *client_thread(void* arg);
+static void client_loop(char *server);
 
 //
 // version of connect() which takes a time-out.
@@ -125,26 +148,128 @@ static int connect_wait (int sockno, struct sockaddr * addr, size_t addrlen, str
 // -4  wrong version number
 // -5  wrong password
 //
-int radio_connect_remote(char *host, int port, const char *pwd) {
+//
+// Send the keys and hashes of all state packets we have
+//
+static void client_send_digest(int sock) {
+  g_mutex_lock(&client_state_mutex);
+  guint count = g_hash_table_size(client_state);
+
+  if (count > MAX_STATE_DIGESTS) { count = 0; }
+
+  int bytes = sizeof(STATE_DIGEST) + count * sizeof(STATE_DIGEST_ENTRY);
+  char *buffer = g_malloc0(bytes);
+  STATE_DIGEST *digest = (STATE_DIGEST *)buffer;
+  STATE_DIGEST_ENTRY *entry = (STATE_DIGEST_ENTRY *)(buffer + sizeof(STATE_DIGEST));
+  SYNC(digest->header.sync);
+  digest->header.data_type = to_short(CMD_STATE_DIGEST);
+  digest->count = to_int(count);
+
+  if (count > 0) {
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, client_state);
+
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+      entry->key = to_int(GPOINTER_TO_UINT(key));
+      entry->hash = to_ll(*(uint64_t *)value);
+      entry++;
+    }
+  }
+
+  g_mutex_unlock(&client_state_mutex);
+  send_bytes(sock, buffer, bytes);
+  g_free(buffer);
+}
+
+//
+// Called by send_bytes() for each packet sent to the server
+//
+void client_state_command(const char *buffer, int bytes) {
+  g_mutex_lock(&client_state_mutex);
+
+  if (client_state) { remote_state_command(client_state, buffer, bytes); }
+
+  g_mutex_unlock(&client_state_mutex);
+}
+
+//
+// Note the packet that has just been processed
+//
+static void client_state_note() {
+  g_mutex_lock(&client_state_mutex);
+  remote_state_update(client_state, (const char *)received->data, received->len);
+  g_mutex_unlock(&client_state_mutex);
+  g_byte_array_set_size(received, 0);
+}
+
+//
+// Read data from the server. While a snapshot is being processed,
+// the data is taken from there.
+//
+static int client_recv(char *buffer, int bytes) {
+  int rc;
+
+  if (replay) {
+    if (replay_pos + bytes > replay->len) {
+      t_print("%s: snapshot truncated\n", __FUNCTION__);
+      rc = -1;
+    } else {
+      memcpy(buffer, replay->data + replay_pos, bytes);
+      replay_pos += bytes;
+      rc = bytes;
+    }
+
+    if (rc < 0 || replay_pos >= replay->len) {
+      g_byte_array_free(replay, TRUE);
+      replay = NULL;
+    }
+  } else {
+    rc = recv_bytes(client_socket, buffer, bytes);
+  }
+
+  if (rc > 0) { g_byte_array_append(received, (const guint8 *)buffer, rc); }
+
+  return rc;
+}
+
+//
+// After re-connecting, subscribe to the spectrum data again
+//
+static int client_resubscribe(gpointer data) {
+  send_screen(client_socket, rx_stack_horizontal, display_width[display_size]);
+
+  for (int i = 0; i < receivers; i++) {
+    send_rxfps(client_socket, i, receiver[i]->fps);
+    send_startstop_rxspectrum(client_socket, i, 1);
+  }
+
+  if (can_transmit && radio_is_transmitting()) {
+    send_startstop_txspectrum(client_socket, 1);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static int client_connect(const char *host, int port, const char *pwd) {
   struct sockaddr_in server_address;
   struct timeval timeout;
   int on = 1;
   int rc;
-  client_socket = socket(AF_INET, SOCK_STREAM, 0);
-  static char server_host[128];
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
 
-  if (client_socket == -1) {
+  if (sock == -1) {
     t_print("%s: socket creation failed...\n", __FUNCTION__);
     return -1;
   }
 
-  setsockopt(client_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
-  setsockopt(client_socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
   struct hostent *server = gethostbyname(host);
 
   if (server == NULL) {
     t_print("%s: no such host: %s\n", __FUNCTION__, host);
-    close(client_socket);
+    close(sock);
     return -3;
   }
 
@@ -155,21 +280,21 @@ int radio_connect_remote(char *host, int port, const char *pwd) {
   server_address.sin_port = to_short(port);
   timeout.tv_sec = 10;
   timeout.tv_usec = 0;
-  rc = connect_wait(client_socket, (struct sockaddr *)&server_address, sizeof(server_address), &timeout);
+  rc = connect_wait(sock, (struct sockaddr *)&server_address, sizeof(server_address), &timeout);
 
   if (rc != 0) {
     t_perror("ConnectWait");
-    close(client_socket);
+    close(sock);
     return rc;  // -1: general error, -2: timeout
   }
 
-  t_print("%s: socket %d bound to %s:%d\n", __FUNCTION__, client_socket, host, port);
+  t_print("%s: socket %d bound to %s:%d\n", __FUNCTION__, sock, host, port);
   unsigned char s[2 * SHA512_DIGEST_LENGTH];
   unsigned char sha[SHA512_DIGEST_LENGTH];
 
-  if (recv_bytes(client_socket, (char *)s, 4) < 0) {
+  if (recv_bytes(sock, (char *)s, 4) < 0) {
     t_print("%s: Could not receive Version number\n", __FUNCTION__);
-    close(client_socket);
+    close(sock);
     return -1;
   }
 
@@ -178,36 +303,101 @@ int radio_connect_remote(char *host, int port, const char *pwd) {
       ((CLIENT_SERVER_VERSION >>  8) & 0xFF) != s[2] ||
       ((CLIENT_SERVER_VERSION      ) & 0xFF) != s[3]) {
     t_print("%s: Wrong Client/Server version number\n", __FUNCTION__);
-    close(client_socket);
+    close(sock);
     return -4;
   }
 
-  if (recv_bytes(client_socket, (char *)s, SHA512_DIGEST_LENGTH) < 0) {
+  if (recv_bytes(sock, (char *)s, SHA512_DIGEST_LENGTH) < 0) {
     t_print("%s: Could not receive Challenge\n", __FUNCTION__);
-    close(client_socket);
+    close(sock);
     return -1;
   }
 
   generate_pwd_hash(s, sha, pwd);
-  send_bytes(client_socket, (char *)sha, SHA512_DIGEST_LENGTH);
+  send_bytes(sock, (char *)sha, SHA512_DIGEST_LENGTH);
 
-  if (recv_bytes(client_socket, (char *)s, 1) < 0) {
+  if (recv_bytes(sock, (char *)s, 1) < 0) {
     t_print("%s: Could not receive Pwd Receipt\n", __FUNCTION__);
-    close(client_socket);
+    close(sock);
     return -1;
   }
 
   if (*s != 0x7F) {
     t_print("%s: Server did not accept password\n", __FUNCTION__);
-    close(client_socket);
+    close(sock);
     return -5;
   }
 
+  //
+  // Tell the server which state we already have
+  //
+  client_send_digest(sock);
+
+  //
+  // Ask for a UDP channel for audio and spectrum data
+  //
+  if (remote_media) { send_media(sock, 1, 0, 0); }
+
+  client_socket = sock;
+  return 0;
+}
+
+int radio_connect_remote(char *host, int port, const char *pwd) {
+  static char server_host[128];
+  int rc;
+
+  if (client_state == NULL) {
+    client_state = remote_state_new();
+    received = g_byte_array_new();
+  }
+
+  rc = client_connect(host, port, pwd);
+
+  if (rc != 0) { return rc; }
+
+  snprintf(remote_host, sizeof(remote_host), "%s", host);
+  snprintf(remote_pwd, sizeof(remote_pwd), "%s", pwd);
+  remote_port = port;
   snprintf(server_host, sizeof(server_host), "%s:%d", host, port);
   client_thread_id = g_thread_new("remote_client", client_thread, &server_host);
   return 0;
 }
 
+//
+// The connection to the server has been lost. Try to connect again with
+// the same credentials. The client keeps its state, and the server only
+// sends what has changed in the meantime.
+//
+static int client_reconnect() {
+  media_client_stop();
+  int sock = client_socket;
+  client_socket = -1;
+
+  if (sock >= 0) { close(sock); }
+
+  if (replay) {
+    g_byte_array_free(replay, TRUE);
+    replay = NULL;
+  }
+
+  g_byte_array_set_size(received, 0);
+
+  for (int i = 1; i <= CLIENT_RECONNECT_TRIES && client_running; i++) {
+    sleep(CLIENT_RECONNECT_WAIT);
+    t_print("%s: attempt #%d to re-connect to %s:%d\n", __FUNCTION__, i, remote_host, remote_port);
+    int rc = client_connect(remote_host, remote_port, remote_pwd);
+
+    if (rc == 0) { return 0; }
+
+    //
+    // Do not try again if the server has changed
+    //
+    if (rc == -4 || rc == -5) { break; }
+  }
+
+  return -1;
+}
+
 void server_tx_audio(short sample) {
   //
   // This is called in the client and collects data to be
@@ -229,8 +419,12 @@ void server_tx_audio(short sample) {
   if (-sample > speak) { speak = -sample; }
 
   txaudio_data.samples[txaudio_buffer_index++] = to_short(sample);
+  //
+  // Through the UDP media channel, smaller packets are sent
+  //
+  int media = media_client_active();
 
-  if (txaudio_buffer_index >= AUDIO_DATA_SIZE) {
+  if (txaudio_buffer_index >= (media ? MEDIA_AUDIO_FRAMES : AUDIO_DATA_SIZE)) {
     int txmode = vfo_get_tx_mode();
 
     if (radio_is_transmitting() && txmode != modeCWU && txmode != modeCWL && !transmitter->tune && !transmitter->twotone) {
@@ -238,15 +432,25 @@ void server_tx_audio(short sample) {
       // The actual transmission of the mic audio samples only takes  place
       // if we *need* them (note VOX is handled locally)
       //
-      SYNC(txaudio_data.header.sync);
-      txaudio_data.header.data_type = to_short(INFO_TXAUDIO);
-      txaudio_data.numsamples = to_short(txaudio_buffer_index);
-
-      if (send_bytes(client_socket, (char *)&txaudio_data, sizeof(TXAUDIO_DATA)) < 0) {
-        t_perror("server_txaudio");
-        client_socket = -1;
+      if (media) {
+        media_client_txaudio(txaudio_data.samples, txaudio_buffer_index);
+      } else {
+        SYNC(txaudio_data.header.sync);
+        txaudio_data.header.data_type = to_short(INFO_TXAUDIO);
+        txaudio_data.numsamples = to_short(txaudio_buffer_index);
+
+        if (send_bytes(client_socket, (char *)&txaudio_data, sizeof(TXAUDIO_DATA)) < 0) {
+          t_perror("server_txaudio");
+          client_socket = -1;
+        }
       }
 
+      txaudio_buffer_index = 0;
+    } else if (media) {
+      //
+      // The UDP channel has a small cushion on the server side,
+      // so no data is kept for a RX/TX transition
+      //
       txaudio_buffer_index = 0;
     } else {
       //
@@ -262,6 +466,119 @@ void server_tx_audio(short sample) {
   }
 }
 
+//
+// Play RX audio. This comes either through the TCP connection or
+// (via the jitter buffer) through the UDP media channel.
+// Note CAPTURing is only done on the server side
+//
+void client_rxaudio(int id, const short *samples, int numsamples) {
+  if (id < 0 || id >= receivers) { return; }
+
+  RECEIVER *rx = receiver[id];
+
+  for (int i = 0; i < numsamples; i++) {
+    short left_sample = samples[i * 2];
+    short right_sample = samples[(i * 2) + 1];
+
+    if (radio_is_transmitting() && (!duplex || mute_rx_while_transmitting)) {
+      left_sample = 0.0;
+      right_sample = 0.0;
+    }
+
+    if (rx->mute_radio || (rx != active_receiver && rx->mute_when_not_active)) {
+      left_sample = 0;
+      right_sample = 0;
+    }
+
+    if (rx->audio_channel == LEFT)  { right_sample = 0; }
+
+    if (rx->audio_channel == RIGHT) { left_sample  = 0; }
+
+    if (rx->local_audio) {
+      audio_write(rx, (float)left_sample / 32767.0, (float)right_sample / 32767.0);
+    }
+  }
+}
+
+//
+// Process spectrum data. This comes either through the TCP connection or
+// through the UDP media channel.
+//
+void client_spectrum(int type, const SPECTRUM_DATA *data) {
+  //
+  // We load the current VFO frequencies on top of the spectrum data packets,
+  // so we can apply this info *before* drawing the spectrum. Normally the
+  // data should not have changed.
+  //
+  long long frequency_a = from_ll(data->vfo_a_freq);
+  long long frequency_b = from_ll(data->vfo_b_freq);
+  long long ctun_frequency_a = from_ll(data->vfo_a_ctun_freq);
+  long long ctun_frequency_b = from_ll(data->vfo_b_ctun_freq);
+  long long offset_a = from_ll(data->vfo_a_offset);
+  long long offset_b = from_ll(data->vfo_b_offset);
+
+  if (vfo[VFO_A].frequency != frequency_a || vfo[VFO_B].frequency != frequency_b
+      || vfo[VFO_A].ctun_frequency != ctun_frequency_a || vfo[VFO_B].ctun_frequency != ctun_frequency_b
+      || vfo[VFO_A].offset != offset_a || vfo[VFO_B].offset != offset_b) {
+    vfo[VFO_A].frequency = frequency_a;
+    vfo[VFO_B].frequency = frequency_b;
+    vfo[VFO_A].ctun_frequency = ctun_frequency_a;
+    vfo[VFO_B].ctun_frequency = ctun_frequency_b;
+    vfo[VFO_A].offset = offset_a;
+    vfo[VFO_B].offset = offset_b;
+    g_idle_add(ext_vfo_update, NULL);
+  }
+
+  if (type == INFO_RX_SPECTRUM && data->id < receivers) {
+    RECEIVER *rx = receiver[data->id];
+    rx->cA = from_double(data->cA);
+    rx->cB = from_double(data->cB);
+    rx->cAp = from_double(data->cAp);
+    rx->cBp = from_double(data->cBp);
+    rx->meter = from_double(data->meter);
+    rx->pixels_available = data->avail;
+    int width = from_short(data->width);
+
+    if (width == rx->width) {
+      g_mutex_lock(&rx->display_mutex);
+
+      if (rx->pixel_samples == NULL) {
+        rx->pixel_samples = g_new(float, (int) rx->width);
+      }
+
+      for (int i = 0; i < rx->width; i++) {
+        rx->pixel_samples[i] = (float)((int)data->sample[i] - 200);
+      }
+
+      g_mutex_unlock(&rx->display_mutex);
+      g_idle_add(rx_remote_update_display, rx);
+    }
+  }
+
+  if (type == INFO_TX_SPECTRUM && can_transmit) {
+    TRANSMITTER *tx = transmitter;
+    tx->alc = from_double(data->alc);
+    tx->fwd = from_double(data->fwd);
+    tx->swr = from_double(data->swr);
+    int width = from_short(data->width);
+
+    if (tx->pixel_samples == NULL) {
+      tx->pixel_samples = g_new(float, (int) tx->width);
+    }
+
+    if (width == tx->width) {
+      g_mutex_lock(&tx->display_mutex);
+
+      for (int i = 0; i < tx->width; i++) {
+        tx->pixel_samples[i] = (float)((int)data->sample[i] - 200);
+      }
+
+      g_mutex_unlock(&tx->display_mutex);
+      g_idle_add(tx_remote_update_display, tx);
+    }
+  }
+}
+
 //
 // Not all VFO frequency updates generate a packet to be sent by the client.
 // Instead, frequency updates are "collected" and sent out  (if necessary)
@@ -341,10 +658,7 @@ void start_vfo_timer() {
 ////////////////////////////////////////////////////////////////////////////
 
 static void *client_thread(void* arg) {
-  int bytes_read;
-  HEADER header;
   char *server = (char *)arg;
-  static char title[256];
   client_running = TRUE;
   //
   // Some settings/allocation must be made HERE
@@ -385,6 +699,7 @@ static void *client_thread(void* arg) {
     rx->waterfall_percent = 25;
     rx->display_filled = 1;
     rx->display_gradient = 1;
+    rx->display_raster = 0;
     rx->local_audio_buffer = NULL;
     rx->local_audio = 0;
     snprintf(rx->audio_name, sizeof(rx->audio_name), "NO AUDIO");
@@ -418,13 +733,36 @@ static void *client_thread(void* arg) {
     rx->id = PS_RX_FEEDBACK;
   }
 
+  while (client_running) {
+    client_loop(server);
+
+    if (client_running && client_reconnect() < 0) {
+      g_idle_add(fatal_error, "FATAL: connection to the server lost");
+      break;
+    }
+  }
+
+  media_client_stop();
+  return NULL;
+}
+
+//
+// Receive and process packets from the server. This function returns
+// if the connection is lost.
+//
+static void client_loop(char *server) {
+  int bytes_read;
+  HEADER header;
+  static char title[256];
+
   while (client_running) {
     int type;
-    bytes_read = recv_bytes(client_socket, (char *)&header, sizeof(header));
+    client_state_note();
+    bytes_read = client_recv((char *)&header, sizeof(header));
 
     if (bytes_read <= 0) {
       t_print("%s: ReadErr for HEADER\n", __FUNCTION__);
-      return NULL;
+      return;
     }
 
     if (memcmp(header.sync, syncbytes, sizeof(syncbytes))  != 0) {
@@ -437,11 +775,11 @@ static void *client_thread(void* arg) {
       uint8_t c;
 
       while (syncs != sizeof(syncbytes) && client_running) {
-        bytes_read = recv_bytes(client_socket, (char *)&c, 1);
+        bytes_read = client_recv((char *)&c, 1);
 
         if (bytes_read <= 0) {
           t_print("%s: ReadErr for HEADER RESYNC\n", __FUNCTION__);
-          return NULL;
+          return;
         }
 
         if (c == syncbytes[syncs]) {
@@ -451,8 +789,8 @@ static void *client_thread(void* arg) {
         }
       }
 
-      if (recv_bytes(client_socket, (char *)&header + sizeof(header.sync), sizeof(header) - sizeof(header.sync)) <= 0) {
-        return NULL;
+      if (client_recv((char *)&header + sizeof(header.sync), sizeof(header) - sizeof(header.sync)) <= 0) {
+        return;
       }
 
       t_print("%s: Re-SYNC was successful!\n", __FUNCTION__);
@@ -468,7 +806,7 @@ static void *client_thread(void* arg) {
       //
       DISPLAY_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return; }
 
       adc[0].overload = data.adc0_overload;
       adc[1].overload = data.adc1_overload;
@@ -504,7 +842,7 @@ static void *client_thread(void* arg) {
       if (can_transmit) {
         PS_DATA data;
 
-        if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return NULL; }
+        if (client_recv((char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return; }
 
         for (int i = 0; i < 16; i++) {
           transmitter->psinfo[i] = from_short(data.psinfo[i]);
@@ -519,7 +857,7 @@ static void *client_thread(void* arg) {
     case INFO_MEMORY: {
       MEMORY_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return; }
 
       int index = data.index;
       mem[index].sat_mode           = data.sat_mode;
@@ -545,7 +883,7 @@ static void *client_thread(void* arg) {
     case INFO_BAND: {
       BAND_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return; }
 
       if (data.band > BANDS + XVTRS) {
         t_print("%s: WARNING: band data received for b=%d, too large.\n", __FUNCTION__, data.band);
@@ -578,7 +916,7 @@ static void *client_thread(void* arg) {
     case INFO_BANDSTACK: {
       BANDSTACK_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return; }
 
       if (data.band > BANDS + XVTRS) {
         t_print("%s: WARNING: band data received for b=%d, too large.\n", __FUNCTION__, data.band);
@@ -608,7 +946,7 @@ static void *client_thread(void* arg) {
     case INFO_RADIO: {
       RADIO_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return; }
 
       snprintf(radio->name, sizeof(radio->name), "%s", data.name);
       locked = data.locked;
@@ -754,7 +1092,7 @@ static void *client_thread(void* arg) {
     case INFO_ADC: {
       ADC_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(ADC_DATA) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(ADC_DATA) - sizeof(HEADER)) < 0) { return; }
 
       int i = data.adc;
       adc[i].preamp = data.preamp;
@@ -779,7 +1117,7 @@ static void *client_thread(void* arg) {
     case INFO_RECEIVER: {
       RECEIVER_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(RECEIVER_DATA) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(RECEIVER_DATA) - sizeof(HEADER)) < 0) { return; }
 
       int id = data.id;
       RECEIVER *rx = receiver[id];
@@ -861,7 +1199,7 @@ static void *client_thread(void* arg) {
     case INFO_TRANSMITTER: {
       TRANSMITTER_DATA data;
 
-      if (recv_bytes(client_socket, (char *)&data + sizeof(HEADER), sizeof(TRANSMITTER_DATA) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(TRANSMITTER_DATA) - sizeof(HEADER)) < 0) { return; }
 
       //
       // When transmitter data is fully received, we can set can_transmit
@@ -939,7 +1277,7 @@ static void *client_thread(void* arg) {
     case INFO_VFO: {
       VFO_DATA vfo_data;
 
-      if (recv_bytes(client_socket, (char *)&vfo_data + sizeof(HEADER), sizeof(VFO_DATA) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&vfo_data + sizeof(HEADER), sizeof(VFO_DATA) - sizeof(HEADER)) < 0) { return; }
 
       int v = vfo_data.vfo;
       vfo[v].band = vfo_data.band;
@@ -974,79 +1312,54 @@ static void *client_thread(void* arg) {
       //
       size_t payload = from_short(header.s1);
 
-      if (recv_bytes(client_socket, (char *)&spectrum_data + sizeof(HEADER), payload) < 0) { return NULL; }
+      if (client_recv((char *)&spectrum_data + sizeof(HEADER), payload) < 0) { return; }
+
+      client_spectrum(type, &spectrum_data);
+    }
+    break;
 
+    case INFO_SNAPSHOT: {
       //
-      // We load the current VFO frequencies on top of the spectrum data packets,
-      // so we can apply this info *before* drawing the spectrum. Normally the
-      // data should not have changed.
+      // The state packets in the snapshot are processed as if
+      // they had been received one by one
       //
-      long long frequency_a = from_ll(spectrum_data.vfo_a_freq);
-      long long frequency_b = from_ll(spectrum_data.vfo_b_freq);
-      long long ctun_frequency_a = from_ll(spectrum_data.vfo_a_ctun_freq);
-      long long ctun_frequency_b = from_ll(spectrum_data.vfo_b_ctun_freq);
-      long long offset_a = from_ll(spectrum_data.vfo_a_offset);
-      long long offset_b = from_ll(spectrum_data.vfo_b_offset);
-
-      if (vfo[VFO_A].frequency != frequency_a || vfo[VFO_B].frequency != frequency_b
-          || vfo[VFO_A].ctun_frequency != ctun_frequency_a || vfo[VFO_B].ctun_frequency != ctun_frequency_b
-          || vfo[VFO_A].offset != offset_a || vfo[VFO_B].offset != offset_b) {
-        vfo[VFO_A].frequency = frequency_a;
-        vfo[VFO_B].frequency = frequency_b;
-        vfo[VFO_A].ctun_frequency = ctun_frequency_a;
-        vfo[VFO_B].ctun_frequency = ctun_frequency_b;
-        vfo[VFO_A].offset = offset_a;
-        vfo[VFO_B].offset = offset_b;
-        g_idle_add(ext_vfo_update, NULL);
+      SNAPSHOT_DATA data;
+
+      if (client_recv((char *)&data + sizeof(HEADER), sizeof(data) - sizeof(HEADER)) < 0) { return; }
+
+      unsigned int length = from_int(data.length);
+      unsigned int compressed = from_int(data.compressed);
+
+      if (from_short(header.s1) != SNAPSHOT_VERSION || length > SNAPSHOT_MAX_SIZE || compressed > SNAPSHOT_MAX_SIZE) {
+        t_print("%s: cannot process snapshot (version=%d length=%u)\n", __FUNCTION__, from_short(header.s1), length);
+        return;
       }
 
-      if (type == INFO_RX_SPECTRUM && spectrum_data.id < receivers) {
-        RECEIVER *rx = receiver[spectrum_data.id];
-        rx->cA = from_double(spectrum_data.cA);
-        rx->cB = from_double(spectrum_data.cB);
-        rx->cAp = from_double(spectrum_data.cAp);
-        rx->cBp = from_double(spectrum_data.cBp);
-        rx->meter = from_double(spectrum_data.meter);
-        rx->pixels_available = spectrum_data.avail;
-        int width = from_short(spectrum_data.width);
-
-        if (width == rx->width) {
-          g_mutex_lock(&rx->display_mutex);
-
-          if (rx->pixel_samples == NULL) {
-            rx->pixel_samples = g_new(float, (int) rx->width);
-          }
-
-          for (int i = 0; i < rx->width; i++) {
-            rx->pixel_samples[i] = (float)((int)spectrum_data.sample[i] - 200);
-          }
-
-          g_mutex_unlock(&rx->display_mutex);
-          g_idle_add(rx_remote_update_display, rx);
-        }
+      char *zdata = g_malloc(compressed);
+
+      if (client_recv(zdata, compressed) < 0) {
+        g_free(zdata);
+        return;
       }
 
-      if (type == INFO_TX_SPECTRUM && can_transmit) {
-        TRANSMITTER *tx = transmitter;
-        tx->alc = from_double(spectrum_data.alc);
-        tx->fwd = from_double(spectrum_data.fwd);
-        tx->swr = from_double(spectrum_data.swr);
-        int width = from_short(spectrum_data.width);
+      GByteArray *state = remote_zlib(FALSE, zdata, compressed);
+      g_free(zdata);
 
-        if (tx->pixel_samples == NULL) {
-          tx->pixel_samples = g_new(float, (int) tx->width);
-        }
+      if (state == NULL || state->len != length) {
+        t_print("%s: corrupt snapshot\n", __FUNCTION__);
 
-        if (width == tx->width) {
-          g_mutex_lock(&tx->display_mutex);
+        if (state) { g_byte_array_free(state, TRUE); }
 
-          for (int i = 0; i < tx->width; i++) {
-            tx->pixel_samples[i] = (float)((int)spectrum_data.sample[i] - 200);
-          }
+        return;
+      }
 
-          g_mutex_unlock(&tx->display_mutex);
-          g_idle_add(tx_remote_update_display, tx);
-        }
+      t_print("%s: snapshot with %u bytes of state\n", __FUNCTION__, length);
+
+      if (length > 0) {
+        replay = state;
+        replay_pos = 0;
+      } else {
+        g_byte_array_free(state, TRUE);
       }
     }
     break;
@@ -1054,42 +1367,26 @@ static void *client_thread(void* arg) {
     case INFO_RXAUDIO: {
       RXAUDIO_DATA rxaudio_data;
 
-      if (recv_bytes(client_socket, (char *)&rxaudio_data + sizeof(HEADER), sizeof(RXAUDIO_DATA) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&rxaudio_data + sizeof(HEADER), sizeof(RXAUDIO_DATA) - sizeof(HEADER)) < 0) { return; }
 
-      RECEIVER *rx = receiver[rxaudio_data.rx];
       int numsamples = from_short(rxaudio_data.numsamples);
+      short samples[2 * AUDIO_DATA_SIZE];
 
-      //
-      // Note CAPTURing is only done on the server side
-      //
-      for (int i = 0; i < numsamples; i++) {
-        short left_sample = from_short(rxaudio_data.samples[(i * 2)]);
-        short right_sample = from_short(rxaudio_data.samples[(i * 2) + 1]);
-
-        if (radio_is_transmitting() && (!duplex || mute_rx_while_transmitting)) {
-          left_sample = 0.0;
-          right_sample = 0.0;
-        }
-
-        if (rx->mute_radio || (rx != active_receiver && rx->mute_when_not_active)) {
-          left_sample = 0;
-          right_sample = 0;
-        }
+      if (numsamples > AUDIO_DATA_SIZE) { numsamples = AUDIO_DATA_SIZE; }
 
-        if (rx->audio_channel == LEFT)  { right_sample = 0; }
-
-        if (rx->audio_channel == RIGHT) { left_sample  = 0; }
-
-        if (rx->local_audio) {
-          audio_write(rx, (float)left_sample / 32767.0, (float)right_sample / 32767.0);
-        }
+      for (int i = 0; i < 2 * numsamples; i++) {
+        samples[i] = from_short(rxaudio_data.samples[i]);
       }
+
+      client_rxaudio(rxaudio_data.rx, samples, numsamples);
     }
     break;
 
     case CMD_START_RADIO: {
       if (!remote_started) {
         g_idle_add(radio_remote_start, (gpointer)server);
+      } else {
+        g_idle_add(client_resubscribe, NULL);
       }
 
       g_idle_add(ext_vfo_update, NULL);
@@ -1099,7 +1396,7 @@ static void *client_thread(void* arg) {
     case CMD_SAMPLE_RATE: {
       U64_COMMAND cmd;
 
-      if (recv_bytes(client_socket, (char *)&cmd + sizeof(HEADER), sizeof(U64_COMMAND) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&cmd + sizeof(HEADER), sizeof(U64_COMMAND) - sizeof(HEADER)) < 0) { return; }
 
       int id = header.b1;
       long long rate = from_ll(cmd.u64);
@@ -1107,6 +1404,22 @@ static void *client_thread(void* arg) {
     }
     break;
 
+    case CMD_MEDIA: {
+      //
+      // Answer of the server to our request for a UDP media channel
+      //
+      U64_COMMAND cmd;
+
+      if (client_recv((char *)&cmd + sizeof(HEADER), sizeof(U64_COMMAND) - sizeof(HEADER)) < 0) { return; }
+
+      if (header.b1 && remote_media) {
+        media_client_start(client_socket, from_short(header.s1) & 0xFFFF, (uint32_t) from_ll(cmd.u64));
+      } else {
+        media_client_stop();
+      }
+    }
+    break;
+
     case CMD_LOCK: {
       locked = header.b1;
       g_idle_add(ext_vfo_update, NULL);
@@ -1207,7 +1520,7 @@ static void *client_thread(void* arg) {
     case CMD_VOLUME: {
       DOUBLE_COMMAND cmd;
 
-      if (recv_bytes(client_socket, (char *)&cmd + sizeof(HEADER), sizeof(DOUBLE_COMMAND) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&cmd + sizeof(HEADER), sizeof(DOUBLE_COMMAND) - sizeof(HEADER)) < 0) { return; }
 
       int id = cmd.header.b1;
       double volume = from_double(cmd.dbl);
@@ -1223,7 +1536,7 @@ static void *client_thread(void* arg) {
       //
       AGC_GAIN_COMMAND agc_gain_cmd;
 
-      if (recv_bytes(client_socket, (char *)&agc_gain_cmd + sizeof(HEADER), sizeof(AGC_GAIN_COMMAND) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&agc_gain_cmd + sizeof(HEADER), sizeof(AGC_GAIN_COMMAND) - sizeof(HEADER)) < 0) { return; }
 
       int id = agc_gain_cmd.id;
       receiver[id]->agc_gain = from_double(agc_gain_cmd.gain);
@@ -1243,7 +1556,7 @@ static void *client_thread(void* arg) {
     case CMD_RFGAIN: {
       DOUBLE_COMMAND command;
 
-      if (recv_bytes(client_socket, (char *)&command + sizeof(HEADER), sizeof(DOUBLE_COMMAND) - sizeof(HEADER)) < 0) { return NULL; }
+      if (client_recv((char *)&command + sizeof(HEADER), sizeof(DOUBLE_COMMAND) - sizeof(HEADER)) < 0) { return; }
 
       int id = command.header.b1;
       double gain = from_double(command.dbl);
@@ -1284,7 +1597,4 @@ static void *client_thread(void* arg) {
       break;
     }
   }
-
-  return NULL;
 }
-
@@ -58,6 +58,8 @@
 
 #define SOAPYSDR_USB_DEVICE     2000
 
+#define FILE_DEVICE             3000
+
 #define STATE_AVAILABLE 2
 #define STATE_SENDING 3
 #define STATE_INCOMPATIBLE 4
@@ -66,6 +68,7 @@
 #define NEW_PROTOCOL      1
 #define SOAPYSDR_PROTOCOL 2
 #define STEMLAB_PROTOCOL  5
+#define FILE_PROTOCOL     6
 
 // A STEMlab discovered via Avahi will have this protocol until the SDR
 // application itself is started, at which point it will be changed to the old
@@ -118,6 +121,7 @@ struct _DISCOVERED {
   int fpga_version;
   int status;
   int supported_receivers;
+  int ddcs;           // P2: number of DDCs reported by the radio (0: unknown)
   int adcs;
   int dacs;
   double frequency_min;
@@ -147,6 +151,21 @@ struct _DISCOVERED {
     SOAPYCHANNEL tx;
   } soapy;
 
+  //
+  // IQ file playback: RX1 and RX2 may come from the same multi-channel
+  // file, or from two different files that are played back in lock-step.
+  //
+  struct playback {
+    char         file[2][256];           // data file of RX1, RX2
+    int          format[2];              // sample format (PLAYBACK_xxx)
+    int          channels[2];            // real-valued channels per sample frame
+    int          channel[2];             // channel of the I sample
+    long long    offset[2];              // file offset of the sample data
+    long long    length[2];              // bytes of sample data
+    long long    frequency[2];           // center frequency, 0 if unknown
+    int          sample_rate;
+  } playback;
+
 };
 
 typedef struct _DISCOVERED DISCOVERED;
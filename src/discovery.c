@@ -36,8 +36,10 @@
 #endif
 #include "discovered.h"
 #include "ext.h"
+#include "file_discovery.h"
 #include "gpio.h"
 #include "main.h"
+#include "media.h"
 #include "message.h"
 #include "new_discovery.h"
 #include "old_discovery.h"
@@ -123,6 +125,15 @@ static void print_devices(void) {
               discovered[i].soapy.hardware_key,
               discovered[i].soapy.address);
       break;
+
+    case FILE_PROTOCOL:
+      t_print("%s: found protocol=%d file=%s receivers=%d sample_rate=%d status=%d\n", __FUNCTION__,
+              discovered[i].protocol,
+              discovered[i].playback.file[0],
+              discovered[i].supported_receivers,
+              discovered[i].playback.sample_rate,
+              discovered[i].status);
+      break;
     }
   }
 }
@@ -211,6 +222,7 @@ static gboolean discover_cb (GtkWidget *widget, GdkEventButton *event, gpointer
 
 static gboolean exit_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
   gtk_widget_destroy(discovery_dialog);
+  t_print_flush();
   _exit(0);
   return TRUE;
 }
@@ -249,6 +261,10 @@ static void tcp_en_cb(GtkWidget *widget, gpointer data) {
 // Supporting functions for the server selection screen |
 //------------------------------------------------------+
 
+static void remote_media_cb(GtkWidget *widget, gpointer data) {
+  remote_media = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+}
+
 static void save_hostlist() {
   g_signal_handler_block(G_OBJECT(host_combo), host_combo_signal_id);
   clearProperties();
@@ -269,6 +285,7 @@ static void save_hostlist() {
   }
 
   SetPropI0("num_hosts", count);
+  SetPropI0("remote_media", remote_media);
   SetPropS0("current_host", host_addr);
 
   if (pwd_from_props) {
@@ -478,6 +495,10 @@ gboolean discovery_keypress_cb(GtkWidget *widget, GdkEventKey *event, gpointer d
         p = "run by the Soapy Library";
         break;
 
+      case FILE_PROTOCOL:
+        p = "playing back an IQ file";
+        break;
+
       default:
         p = "run by unknown protocol";
         break;
@@ -535,6 +556,10 @@ gboolean discovery_keypress_cb(GtkWidget *widget, GdkEventKey *event, gpointer d
         r = "Soapy";
         break;
 
+      case FILE_DEVICE:
+        r = "a recording";
+        break;
+
       default:
         r = "unkown";
       }
@@ -589,12 +614,7 @@ gboolean discovery_keypress_cb(GtkWidget *widget, GdkEventKey *event, gpointer d
 // Build the discovery window                         |
 //----------------------------------------------------+
 
-static void discovery() {
-  //
-  // On the discovery screen, make the combo-boxes "touchscreen-friendly"
-  //
-  discovery_state = DISCOVERY_RUNNING;
-  optimize_for_touchscreen = 1;
+static void discovery_probe() {
   protocolsRestoreState();
   selected_device = 0;
   devices = 0;
@@ -678,10 +698,72 @@ static void discovery() {
   }
 
 #endif
+
+  if (enable_file_playback && !discover_only_stemlab) {
+    status_text("IQ file playback ... Looking for recordings");
+    file_discovery();
+  }
+
   status_text("Discovery completed.");
   // subsequent discoveries check all protocols enabled.
   discover_only_stemlab = 0;
   print_devices();
+}
+
+//
+// Headless operation: discover devices, and return the first available
+// one, or the first one that matches the IP address, MAC address
+// or (part of) the name given in want.
+//
+DISCOVERED *discovery_headless(const char *want) {
+  //
+  // Set up the GPIO controller as on the discovery screen. Otherwise it
+  // would not start, and saving the radio state would erase its settings.
+  //
+  controller = NO_CONTROLLER;
+  gpioRestoreState();
+  gpio_set_defaults(controller);
+  discovery_probe();
+
+  for (int i = 0; i < devices; i++) {
+    DISCOVERED *dev = &discovered[i];
+    char macStr[18];
+
+    if (dev->status != STATE_AVAILABLE) { continue; }
+
+    // STEMlab apps can only be started from the discovery dialog
+    if (dev->protocol == STEMLAB_PROTOCOL) { continue; }
+
+    if (want == NULL) { return dev; }
+
+    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             dev->network.mac_address[0],
+             dev->network.mac_address[1],
+             dev->network.mac_address[2],
+             dev->network.mac_address[3],
+             dev->network.mac_address[4],
+             dev->network.mac_address[5]);
+
+    if (!g_ascii_strcasecmp(want, macStr) || strstr(dev->name, want) != NULL) {
+      return dev;
+    }
+
+    if ((dev->protocol == ORIGINAL_PROTOCOL || dev->protocol == NEW_PROTOCOL) &&
+        !strcmp(want, inet_ntoa(dev->network.address.sin_addr))) {
+      return dev;
+    }
+  }
+
+  return NULL;
+}
+
+static void discovery() {
+  //
+  // On the discovery screen, make the combo-boxes "touchscreen-friendly"
+  //
+  discovery_state = DISCOVERY_RUNNING;
+  optimize_for_touchscreen = 1;
+  discovery_probe();
   gdk_window_set_cursor(gtk_widget_get_window(top_window), gdk_cursor_new(GDK_ARROW));
   discovery_dialog = gtk_dialog_new();
   gtk_window_set_transient_for(GTK_WINDOW(discovery_dialog), GTK_WINDOW(top_window));
@@ -754,6 +836,12 @@ static void discovery() {
       case STEMLAB_PROTOCOL:
         snprintf(text, sizeof(text), "Choose SDR App from %s: ",
                  inet_ntoa(d->network.address.sin_addr));
+        break;
+
+      case FILE_PROTOCOL:
+        snprintf(text, sizeof(text), "%s (IQ file, %d RX, %d kHz)", d->name,
+                 d->supported_receivers, d->playback.sample_rate / 1000);
+        break;
       }
 
       GtkWidget *label = gtk_label_new(text);
@@ -784,7 +872,7 @@ static void discovery() {
         break;
       }
 
-      if (d->device != SOAPYSDR_USB_DEVICE) {
+      if (d->device != SOAPYSDR_USB_DEVICE && d->device != FILE_DEVICE) {
         int can_connect = 0;
 
         //
@@ -872,6 +960,7 @@ static void discovery() {
   int num_hosts = 0;
   char str[128];
   GetPropI0("num_hosts", num_hosts);
+  GetPropI0("remote_media", remote_media);
 
   for (int i = 0; i < num_hosts; i++) {
     *str = 0;
@@ -939,6 +1028,12 @@ static void discovery() {
   GtkWidget *protocols_b = gtk_button_new_with_label("Protocols");
   g_signal_connect (protocols_b, "button-press-event", G_CALLBACK(protocols_cb), NULL);
   gtk_grid_attach(GTK_GRID(grid), protocols_b, 2, row, 1, 1);
+  GtkWidget *media_b = gtk_check_button_new_with_label("UDP audio");
+  gtk_widget_set_name(media_b, "boldlabel");
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(media_b), remote_media);
+  gtk_widget_set_halign (media_b, GTK_ALIGN_START);
+  gtk_grid_attach(GTK_GRID(grid), media_b, 3, row, 1, 1);
+  g_signal_connect(media_b, "toggled", G_CALLBACK(remote_media_cb), NULL);
   //
   row++;
   GtkWidget *tcp_b = gtk_label_new("Radio IP Addr ");
@@ -19,10 +19,13 @@
 
 #include <gtk/gtk.h>
 
+#include "discovered.h"
+
 extern int  discover_only_stemlab;
 extern char ipaddr_radio[];
 extern int  tcp_enable;
 
 extern int delayed_discovery(gpointer data);
 extern void discovery(void);
+extern DISCOVERED *discovery_headless(const char *want);
 extern gboolean discovery_keypress_cb(GtkWidget *widget, GdkEventKey *event, gpointer data);
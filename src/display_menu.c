@@ -178,6 +178,10 @@ static void gradient_cb(GtkWidget *widget, gpointer data) {
   myrx->display_gradient = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
 }
 
+static void raster_cb(GtkWidget *widget, gpointer data) {
+  myrx->display_raster = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+}
+
 static void frames_per_second_value_changed_cb(GtkWidget *widget, gpointer data) {
   myrx->fps = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
 
@@ -486,6 +490,12 @@ void display_menu(GtkWidget *parent) {
   gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (b_display_waterfall), myrx->display_waterfall);
   gtk_grid_attach(GTK_GRID(general_grid), b_display_waterfall, col + 1, row, 1, 1);
   g_signal_connect(b_display_waterfall, "toggled", G_CALLBACK(display_waterfall_cb), NULL);
+  row++;
+  GtkWidget *raster_b = gtk_check_button_new_with_label("Fast Trace");
+  gtk_widget_set_name (raster_b, "boldlabel");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (raster_b), myrx->display_raster);
+  gtk_grid_attach(GTK_GRID(general_grid), raster_b, col, row, 1, 1);
+  g_signal_connect(raster_b, "toggled", G_CALLBACK(raster_cb), NULL);
   //
   // Peaks container and controls therein
   //
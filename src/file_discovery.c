@@ -0,0 +1,417 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "discovered.h"
+#include "file_discovery.h"
+#include "message.h"
+#include "protocols.h"
+
+typedef struct _iq_file {
+  int format;
+  int channels;
+  int sample_rate;
+  long long offset;
+  long long length;
+  long long frequency;
+} IQ_FILE;
+
+static uint32_t get16(const unsigned char *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const unsigned char *p) {
+  return get16(p) | (get16(p + 2) << 16);
+}
+
+static uint64_t get64(const unsigned char *p) {
+  return get32(p) | ((uint64_t) get32(p + 4) << 32);
+}
+
+static long long file_size(const char *path) {
+  struct stat st;
+
+  if (stat(path, &st) != 0) { return -1; }
+
+  return st.st_size;
+}
+
+//
+// Just enough JSON for SigMF meta data: the keys used here occur only once,
+// or (core:frequency, core:header_bytes) their first occurrence is the one
+// in the first capture segment.
+//
+static const char *json_value(const char *json, const char *key) {
+  char pattern[64];
+  const char *p;
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+
+  if ((p = strstr(json, pattern)) == NULL) { return NULL; }
+
+  p += strlen(pattern);
+
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') { p++; }
+
+  if (*p++ != ':') { return NULL; }
+
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') { p++; }
+
+  return p;
+}
+
+static int json_string(const char *json, const char *key, char *buf, size_t len) {
+  const char *p = json_value(json, key);
+  size_t n = 0;
+
+  if (p == NULL || *p++ != '"') { return -1; }
+
+  while (*p && *p != '"' && n + 1 < len) { buf[n++] = *p++; }
+
+  buf[n] = 0;
+  return 0;
+}
+
+static double json_number(const char *json, const char *key, double def) {
+  const char *p = json_value(json, key);
+  return p ? strtod(p, NULL) : def;
+}
+
+//
+// WAV and RF64 files: walk through the chunks up to the data chunk
+//
+static int parse_wav(const char *path, IQ_FILE *f) {
+  unsigned char h[40];
+  long long size = file_size(path);
+  uint64_t data64 = 0;
+  int tag = 0, bits = 0, rc = -1;
+  FILE *fp;
+  memset(f, 0, sizeof(IQ_FILE));
+
+  if ((fp = fopen(path, "rb")) == NULL) { return -1; }
+
+  if (fread(h, 1, 12, fp) != 12 || (memcmp(h, "RIFF", 4) && memcmp(h, "RF64", 4)) || memcmp(h + 8, "WAVE", 4)) {
+    fclose(fp);
+    return -1;
+  }
+
+  for (;;) {
+    long long pos;
+    uint32_t len;
+
+    if (fread(h, 1, 8, fp) != 8) { break; }
+
+    len = get32(h + 4);
+    pos = ftello(fp);
+
+    if (!memcmp(h, "ds64", 4)) {
+      if (len >= 16 && fread(h, 1, 16, fp) == 16) { data64 = get64(h + 8); }
+    } else if (!memcmp(h, "fmt ", 4)) {
+      size_t n = len < sizeof(h) ? len : sizeof(h);
+
+      if (n < 16 || fread(h, 1, n, fp) != n) { break; }
+
+      tag = get16(h);
+      f->channels = get16(h + 2);
+      f->sample_rate = get32(h + 4);
+      bits = get16(h + 14);
+
+      if (tag == 0xFFFE && n >= 26) {
+        // WAVE_FORMAT_EXTENSIBLE: the format is in the sub-format GUID
+        tag = get16(h + 24);
+      }
+    } else if (!memcmp(h, "auxi", 4)) {
+      // start time, stop time (two SYSTEMTIMEs), then the center frequency
+      if (len >= 36 && fread(h, 1, 36, fp) == 36) { f->frequency = get32(h + 32); }
+    } else if (!memcmp(h, "data", 4)) {
+      f->offset = pos;
+      f->length = (len == 0xFFFFFFFF && data64 > 0) ? (long long) data64 : (long long) len;
+
+      //
+      // The header of a recording that has not been closed properly
+      // may not be up-to-date
+      //
+      if (f->length == 0 || f->offset + f->length > size) { f->length = size - f->offset; }
+
+      rc = 0;
+      break;
+    }
+
+    if (fseeko(fp, pos + len + (len & 1), SEEK_SET) != 0) { break; }
+  }
+
+  fclose(fp);
+
+  if (rc != 0) { return -1; }
+
+  if (tag == 1 && bits == 16) {
+    f->format = PLAYBACK_S16;
+  } else if (tag == 3 && bits == 32) {
+    f->format = PLAYBACK_F32;
+  } else {
+    t_print("%s: %s: unsupported format %d (%d bits)\n", __FUNCTION__, path, tag, bits);
+    return -1;
+  }
+
+  if (f->channels != 2 && f->channels != 4) { return -1; }
+
+  return 0;
+}
+
+static int sigmf_format(const char *datatype) {
+  if (!strcmp(datatype, "cf32_le")) { return PLAYBACK_F32; }
+
+  if (!strcmp(datatype, "ci16_le")) { return PLAYBACK_S16; }
+
+  if (!strcmp(datatype, "ci8")) { return PLAYBACK_S8; }
+
+  if (!strcmp(datatype, "cu8")) { return PLAYBACK_U8; }
+
+  return -1;
+}
+
+static int rate_supported(int rate) {
+  for (int r = 48000; r <= 1536000; r *= 2) {
+    if (r == rate) { return 1; }
+  }
+
+  return 0;
+}
+
+static void add_radio(const char *name, const char *path1, const IQ_FILE *f1, const char *path2, const IQ_FILE *f2) {
+  DISCOVERED *d;
+
+  if (devices >= MAX_DEVICES) {
+    t_print("%s: MAX_DEVICES met for file=%s\n", __FUNCTION__, path1);
+    return;
+  }
+
+  d = &discovered[devices];
+  memset(d, 0, sizeof(DISCOVERED));
+  d->protocol = FILE_PROTOCOL;
+  d->device = FILE_DEVICE;
+  snprintf(d->name, sizeof(d->name), "%s", name);
+  d->frequency_min = 0.0;
+  d->frequency_max = 6000000000.0;
+  d->playback.sample_rate = f1->sample_rate;
+
+  //
+  // The sample rate must be a power-of-two multiple of 48k, since
+  // this is what the receivers can digest
+  //
+  if (rate_supported(f1->sample_rate)) {
+    d->status = STATE_AVAILABLE;
+  } else {
+    t_print("%s: %s: sample rate %d not supported\n", __FUNCTION__, path1, f1->sample_rate);
+    d->status = STATE_INCOMPATIBLE;
+  }
+
+  if (path2 == NULL) {
+    //
+    // With two channels, RX2 gets the same samples as RX1
+    //
+    path2 = path1;
+    f2 = f1;
+    d->playback.channel[1] = (f1->channels >= 4) ? 2 : 0;
+    d->supported_receivers = f1->channels / 2;
+  } else {
+    d->supported_receivers = 2;
+  }
+
+  snprintf(d->playback.file[0], sizeof(d->playback.file[0]), "%s", path1);
+  snprintf(d->playback.file[1], sizeof(d->playback.file[1]), "%s", path2);
+
+  for (int i = 0; i < 2; i++) {
+    const IQ_FILE *f = i ? f2 : f1;
+    int frame = f->channels * PLAYBACK_BYTES(f->format);
+    d->playback.format[i] = f->format;
+    d->playback.channels[i] = f->channels;
+    d->playback.offset[i] = f->offset;
+    d->playback.length[i] = f->length - f->length % frame;
+    d->playback.frequency[i] = f->frequency;
+  }
+
+  d->adcs = d->supported_receivers;
+  t_print("%s: %s: %d RX, rate=%d, freq=%lld, %lld samples\n", __FUNCTION__, name,
+          d->supported_receivers, d->playback.sample_rate, d->playback.frequency[0],
+          d->playback.length[0] / (f1->channels * PLAYBACK_BYTES(f1->format)));
+  devices++;
+}
+
+//
+// Check whether the RX1 and RX2 recordings of the piHPSDR recorder can
+// be played back as a single radio
+//
+static int pair(const char *path1, IQ_FILE *f1, const char *path2, IQ_FILE *f2) {
+  if (parse_wav(path1, f1) != 0 || parse_wav(path2, f2) != 0) { return 0; }
+
+  return f1->channels == 2 && f2->channels == 2 && f1->sample_rate == f2->sample_rate;
+}
+
+static void meta_frequency(const char *path, IQ_FILE *f) {
+  char meta[600];
+  gchar *json;
+  snprintf(meta, sizeof(meta), "%.*s.sigmf-meta", (int) strlen(path) - 4, path);
+
+  if (g_file_get_contents(meta, &json, NULL, NULL)) {
+    f->frequency = (long long) json_number(json, "core:frequency", f->frequency);
+    g_free(json);
+  }
+}
+
+static void discover_wav(const char *name) {
+  char base[256];
+  char path[512];
+  char meta[512];
+  char other[512];
+  IQ_FILE f, f1, f2;
+  gchar *json;
+  snprintf(base, sizeof(base), "%.*s", (int) strlen(name) - 4, name);
+  snprintf(path, sizeof(path), "%s/%s", playback_directory, name);
+
+  if (parse_wav(path, &f) != 0) { return; }
+
+  snprintf(meta, sizeof(meta), "%s/%s.sigmf-meta", playback_directory, base);
+
+  if (g_file_get_contents(meta, &json, NULL, NULL)) {
+    char datatype[32];
+
+    //
+    // Skip audio recordings (real-valued data)
+    //
+    if (json_string(json, "core:datatype", datatype, sizeof(datatype)) == 0 && *datatype != 'c') {
+      g_free(json);
+      return;
+    }
+
+    f.frequency = (long long) json_number(json, "core:frequency", f.frequency);
+    g_free(json);
+  }
+
+  if (g_str_has_suffix(base, "-rx2-iq")) {
+    snprintf(other, sizeof(other), "%s/%.*s-rx1-iq.wav", playback_directory, (int) strlen(base) - 7, base);
+
+    if (pair(other, &f1, path, &f2)) {
+      // played back together with RX1
+      return;
+    }
+  }
+
+  if (g_str_has_suffix(base, "-rx1-iq")) {
+    snprintf(other, sizeof(other), "%s/%.*s-rx2-iq.wav", playback_directory, (int) strlen(base) - 7, base);
+
+    if (pair(path, &f1, other, &f2)) {
+      f1.frequency = f.frequency;
+      meta_frequency(other, &f2);
+      base[strlen(base) - 7] = 0;
+      add_radio(base, path, &f1, other, &f2);
+      return;
+    }
+  }
+
+  add_radio(base, path, &f, NULL, NULL);
+}
+
+static void discover_sigmf(const char *name) {
+  char base[256];
+  char path[512];
+  char dataset[256];
+  char datatype[32];
+  IQ_FILE f;
+  gchar *json;
+  int num_channels;
+  snprintf(base, sizeof(base), "%.*s", (int) strlen(name) - 11, name);
+  snprintf(path, sizeof(path), "%s/%s", playback_directory, name);
+
+  if (!g_file_get_contents(path, &json, NULL, NULL)) { return; }
+
+  if (json_string(json, "core:dataset", dataset, sizeof(dataset)) == 0) {
+    if (g_str_has_suffix(dataset, ".wav")) {
+      // taken care of when the WAV file is found
+      g_free(json);
+      return;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", playback_directory, dataset);
+  } else {
+    snprintf(path, sizeof(path), "%s/%s.sigmf-data", playback_directory, base);
+  }
+
+  memset(&f, 0, sizeof(IQ_FILE));
+
+  if (json_string(json, "core:datatype", datatype, sizeof(datatype)) != 0 || (f.format = sigmf_format(datatype)) < 0) {
+    t_print("%s: %s: unsupported data type\n", __FUNCTION__, name);
+    g_free(json);
+    return;
+  }
+
+  num_channels = (int) json_number(json, "core:num_channels", 1);
+  f.channels = 2 * num_channels;
+  f.sample_rate = (int) (json_number(json, "core:sample_rate", 0) + 0.5);
+  f.frequency = (long long) json_number(json, "core:frequency", 0);
+  f.offset = (long long) json_number(json, "core:header_bytes", 0);
+  f.length = file_size(path) - f.offset;
+  g_free(json);
+
+  if (num_channels < 1 || num_channels > 2 || f.length <= 0) { return; }
+
+  add_radio(base, path, &f, NULL, NULL);
+}
+
+static gint compare_names(gconstpointer a, gconstpointer b) {
+  return strcmp(*(const char * const *) a, *(const char * const *) b);
+}
+
+void file_discovery() {
+  GDir *dir;
+  const gchar *entry;
+  GPtrArray *names;
+
+  if ((dir = g_dir_open(playback_directory, 0, NULL)) == NULL) {
+    t_print("%s: cannot open directory %s\n", __FUNCTION__, playback_directory);
+    return;
+  }
+
+  names = g_ptr_array_new_with_free_func(g_free);
+
+  while ((entry = g_dir_read_name(dir)) != NULL) {
+    if (g_str_has_suffix(entry, ".wav") || g_str_has_suffix(entry, ".sigmf-meta")) {
+      g_ptr_array_add(names, g_strdup(entry));
+    }
+  }
+
+  g_dir_close(dir);
+  g_ptr_array_sort(names, compare_names);
+
+  for (guint i = 0; i < names->len; i++) {
+    const char *name = g_ptr_array_index(names, i);
+
+    if (g_str_has_suffix(name, ".wav")) {
+      discover_wav(name);
+    } else {
+      discover_sigmf(name);
+    }
+  }
+
+  g_ptr_array_free(names, TRUE);
+}
@@ -0,0 +1,48 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _FILE_DISCOVERY_H_
+#define _FILE_DISCOVERY_H_
+
+//
+// Sample formats of IQ files (all little-endian)
+//
+#define PLAYBACK_U8   0                  // unsigned 8-bit (SigMF cu8, RTL-SDR)
+#define PLAYBACK_S8   1                  // signed 8-bit (SigMF ci8)
+#define PLAYBACK_S16  2                  // signed 16-bit (WAV PCM, SigMF ci16_le)
+#define PLAYBACK_F32  3                  // 32-bit float (WAV IEEE float, SigMF cf32_le)
+
+#define PLAYBACK_BYTES(f) ((f) == PLAYBACK_F32 ? 4 : (f) == PLAYBACK_S16 ? 2 : 1)
+
+//
+// Look for IQ recordings in playback_directory and list each of them
+// as a "radio" in the discovered[] array. Recognized are
+//
+// - WAV and RF64 files with 16-bit PCM or 32-bit float samples and two
+//   (RX1) or four (RX1, RX2) channels. The center frequency is taken
+//   from a SigMF meta data file with the same name (piHPSDR recorder),
+//   or from an "auxi" chunk (HDSDR, SDR#).
+// - SigMF recordings (.sigmf-meta and .sigmf-data) with complex samples
+//   and one or two channels.
+//
+// Two piHPSDR recordings of RX1 and RX2 made at the same time are
+// combined into a single radio with two receivers.
+//
+extern void file_discovery(void);
+
+#endif
@@ -0,0 +1,266 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "discovered.h"
+#include "file_discovery.h"
+#include "file_protocol.h"
+#include "main.h"
+#include "message.h"
+#include "property.h"
+#include "radio.h"
+#include "receiver.h"
+#include "threads.h"
+#include "vfo.h"
+
+#define PLAYBACK_BLOCK 1024            // sample frames per read
+
+int playback_mode = PLAYBACK_REALTIME;
+int playback_loop = 1;
+
+static FILE *playback_fp[2] = { NULL, NULL };
+static int nfiles;                     // 1 if both receivers read from the same file
+static long long remaining[2];         // bytes until the end of the sample data
+static GThread *playback_thread_id = NULL;
+static int running = 0;
+
+static double get_sample(const unsigned char *p, int format) {
+  switch (format) {
+  case PLAYBACK_U8:
+    return (p[0] - 127.5) * 0.0078125;
+
+  case PLAYBACK_S8:
+    return (signed char) p[0] * 0.0078125;
+
+  case PLAYBACK_S16:
+    return (int16_t) (p[0] | (p[1] << 8)) * 0.000030517578125;
+
+  case PLAYBACK_F32: {
+    union {
+      uint32_t u;
+      float f;
+    } v;
+    v.u = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    return v.f;
+  }
+  }
+
+  return 0.0;
+}
+
+static void rewind_files() {
+  for (int i = 0; i < nfiles; i++) {
+    if (fseeko(playback_fp[i], radio->playback.offset[i], SEEK_SET) != 0) {
+      t_print("%s: seek failed on %s\n", __FUNCTION__, radio->playback.file[i]);
+    }
+
+    remaining[i] = radio->playback.length[i];
+  }
+}
+
+//
+// Read (up to) n sample frames from each file. The function value is the
+// number of frames available from all files.
+//
+static int read_block(unsigned char **buf, int n) {
+  for (int i = 0; i < nfiles; i++) {
+    long long frame = radio->playback.channels[i] * PLAYBACK_BYTES(radio->playback.format[i]);
+    long long want = n * frame;
+    size_t got;
+
+    if (want > remaining[i]) { want = remaining[i]; }
+
+    got = fread(buf[i], 1, want, playback_fp[i]);
+    remaining[i] -= got;
+
+    if (got < want) {
+      // truncated file
+      remaining[i] = 0;
+    }
+
+    if ((long long) got / frame < n) { n = got / frame; }
+  }
+
+  return n;
+}
+
+static long long now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static gpointer playback_thread(gpointer data) {
+  unsigned char *buf[2];
+  double i_sample[2], q_sample[2];
+  const int rate = radio->playback.sample_rate;
+  long long start = now_ns();
+  long long played = 0;
+  int mode = playback_mode;
+  thread_setup(THREAD_NET, "IQ playback");
+  t_print("%s: started, rate=%d mode=%d loop=%d\n", __FUNCTION__, rate, playback_mode, playback_loop);
+
+  for (int i = 0; i < nfiles; i++) {
+    buf[i] = g_new(unsigned char, PLAYBACK_BLOCK * radio->playback.channels[i] * 4);
+  }
+
+  while (running) {
+    int n = read_block(buf, PLAYBACK_BLOCK);
+
+    if (n == 0) {
+      if (!playback_loop || radio->playback.length[0] == 0) {
+        t_print("%s: end of recording\n", __FUNCTION__);
+        break;
+      }
+
+      rewind_files();
+      continue;
+    }
+
+    for (int j = 0; j < n; j++) {
+      for (int r = 0; r < 2; r++) {
+        int f = (nfiles == 2) ? r : 0;
+        int format = radio->playback.format[f];
+        int bytes = PLAYBACK_BYTES(format);
+        const unsigned char *p = buf[f] + (j * radio->playback.channels[f] + radio->playback.channel[r]) * bytes;
+        i_sample[r] = get_sample(p, format);
+        q_sample[r] = get_sample(p + bytes, format);
+      }
+
+      if (diversity_enabled && radio->supported_receivers > 1) {
+        rx_add_div_iq_samples(receiver[0], i_sample[0], q_sample[0], i_sample[1], q_sample[1]);
+
+        if (receivers > 1) { rx_add_iq_samples(receiver[1], i_sample[1], q_sample[1]); }
+      } else {
+        for (int r = 0; r < receivers; r++) {
+          rx_add_iq_samples(receiver[r], i_sample[r], q_sample[r]);
+        }
+      }
+    }
+
+    played += n;
+
+    if (playback_mode != mode) {
+      mode = playback_mode;
+      start = now_ns();
+      played = 0;
+    }
+
+    switch (mode) {
+    case PLAYBACK_REALTIME: {
+      //
+      // Sleep until the time of the next sample. If we are more than one
+      // second late (e.g. the computer was suspended), do not try to catch up.
+      //
+      long long ahead = start + played * 1000000000LL / rate - now_ns();
+
+      if (ahead > 0) {
+        usleep(ahead / 1000);
+      } else if (ahead < -1000000000LL) {
+        t_print("%s: %lld msec late, re-sync\n", __FUNCTION__, -ahead / 1000000);
+        start = now_ns();
+        played = 0;
+      }
+    }
+    break;
+
+    case PLAYBACK_FREERUN:
+      usleep(n * 1000000LL / rate);
+      break;
+
+    case PLAYBACK_FAST:
+      break;
+    }
+  }
+
+  for (int i = 0; i < nfiles; i++) {
+    g_free(buf[i]);
+  }
+
+  return NULL;
+}
+
+void file_protocol_init() {
+  ASSERT_SERVER();
+  nfiles = strcmp(radio->playback.file[0], radio->playback.file[1]) ? 2 : 1;
+
+  for (int i = 0; i < nfiles; i++) {
+    if ((playback_fp[i] = fopen(radio->playback.file[i], "rb")) == NULL) {
+      t_print("%s: cannot open %s\n", __FUNCTION__, radio->playback.file[i]);
+      g_idle_add(fatal_error, "FATAL: cannot open IQ file");
+      return;
+    }
+  }
+
+  rewind_files();
+
+  //
+  // Tune to the center frequency of the recording, and use CTUN
+  // to move around in the recorded spectrum
+  //
+  for (int id = 0; id < 2; id++) {
+    long long f = radio->playback.frequency[id];
+
+    if (f > 0) {
+      vfo_id_ctun_update(id, 0);
+      vfo_id_set_frequency(id, f);
+      vfo_id_ctun_update(id, 1);
+    }
+  }
+}
+
+void file_protocol_run() {
+  ASSERT_SERVER();
+
+  if (playback_thread_id != NULL || playback_fp[0] == NULL) { return; }
+
+  //
+  // If the end of a recording has been reached, start over
+  //
+  if (remaining[0] == 0) { rewind_files(); }
+
+  running = 1;
+  playback_thread_id = g_thread_new("IQ playback", playback_thread, NULL);
+}
+
+void file_protocol_stop() {
+  ASSERT_SERVER();
+  running = 0;
+
+  if (playback_thread_id != NULL) {
+    g_thread_join(playback_thread_id);
+    playback_thread_id = NULL;
+  }
+}
+
+void file_protocol_save_state() {
+  SetPropI0("playback.mode",                                 playback_mode);
+  SetPropI0("playback.loop",                                 playback_loop);
+}
+
+void file_protocol_restore_state() {
+  GetPropI0("playback.mode",                                 playback_mode);
+  GetPropI0("playback.loop",                                 playback_loop);
+}
@@ -0,0 +1,46 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _FILE_PROTOCOL_H_
+#define _FILE_PROTOCOL_H_
+
+//
+// Playback of an IQ file found by file_discovery(). The samples are fed
+// into the receivers via rx_add_iq_samples(), just as with a real radio.
+// The file radio has no transmitter, and neither the frequency nor the
+// sample rate can be changed. If the center frequency of the recording
+// is known, the VFOs are set to it and CTUN is switched on, such that
+// one can tune within the recorded spectrum.
+//
+enum _playback_mode {
+  PLAYBACK_REALTIME = 0,       // paced by the system clock, at the nominal sample rate
+  PLAYBACK_FREERUN,            // fixed sleep after each block, the playback lags behind
+  PLAYBACK_FAST                // as fast as the RX engine can process the samples
+};
+
+extern int playback_mode;
+extern int playback_loop;      // start over at the end of the file
+
+extern void file_protocol_init(void);
+extern void file_protocol_run(void);
+extern void file_protocol_stop(void);
+
+extern void file_protocol_save_state(void);
+extern void file_protocol_restore_state(void);
+
+#endif
@@ -37,6 +37,8 @@
   #include <linux/i2c-dev.h>
   #include <i2c/smbus.h>
   #include <sys/ioctl.h>
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
 #endif
 
 #include "actions.h"
@@ -49,6 +51,7 @@
 #include "gpio.h"
 #include "i2c.h"
 #include "iambic.h"
+#include "input_queue.h"
 #include "main.h"
 #include "message.h"
 #include "mode.h"
@@ -56,6 +59,7 @@
 #include "property.h"
 #include "radio.h"
 #include "sliders.h"
+#include "threads.h"
 #include "toolbar.h"
 #include "vfo.h"
 
@@ -225,7 +229,6 @@ guchar encoder_state_table[13][4] = {
   char *gpio_device            = NULL;
 
   static struct gpiod_chip *chip = NULL;
-  static GMutex encoder_mutex;
   static GThread *monitor_thread_id;
 #endif
 
@@ -397,176 +400,109 @@ SWITCH *switches = NULL;
 #define I2C_INTERRUPT  15
 #define MAX_LINES 32
 
-static GThread *rotary_encoder_thread_id;
-static uint64_t epochMilli;
-static long settle_time = 50; // ms
+//
+// Input lines are requested once (with edge detection) and kept until
+// gpio_close(). The monitor thread waits in epoll_wait() on the event
+// file descriptors of all lines, so it only wakes up when an edge occurs.
+// Each edge carries a time stamp taken by the kernel, this is used for
+// debouncing and for encoder acceleration.
+//
+// If the environment variable PIHPSDR_VIRTUAL_GPIO contains the name of
+// a FIFO, no GPIO chip is opened. Instead, the monitor thread reads
+// lines of the form "<offset> <value>" from that FIFO, where value is the
+// logic level (0: low = pressed, 1: high = released). Output lines are
+// then ignored. This allows to test controller set-ups without hardware.
+//
+#define WAKEUP_INDEX  MAX_LINES
+#define VIRTUAL_INDEX (MAX_LINES + 1)
+
+static struct gpiod_line *input_lines[MAX_LINES];
 static unsigned int monitor_lines[MAX_LINES];
 static int lines = 0;
+static int wakeup_fd = -1;
+static int virtual_fd = -1;
+static int monitor_running = 0;
+#endif
 
-static void initialiseEpoch() {
-  struct timespec ts ;
-  clock_gettime (CLOCK_MONOTONIC_RAW, &ts) ;
-  epochMilli = (uint64_t)ts.tv_sec * (uint64_t)1000    + (uint64_t)(ts.tv_nsec / 1000000L) ;
-}
+static int gpio_debounce = 50;          // ms, switch debounce time
+static int gpio_vfo_acceleration = 1;   // VFO encoder acceleration on/off
 
-static unsigned int millis () {
-  uint64_t now ;
-  struct  timespec ts ;
-  clock_gettime (CLOCK_MONOTONIC_RAW, &ts) ;
-  now  = (uint64_t)ts.tv_sec * (uint64_t)1000 + (uint64_t)(ts.tv_nsec / 1000000L) ;
-  return (uint32_t)(now - epochMilli) ;
+#ifdef GPIO
+static gint64 gpio_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
 
-static gpointer rotary_encoder_thread(gpointer data) {
-  int i;
-  enum ACTION action;
-  enum ACTION_MODE mode;
-  int val;
-  usleep(250000);
-  t_print("%s\n", __FUNCTION__);
-
-  while (TRUE) {
-    g_mutex_lock(&encoder_mutex);
-
-    for (i = 0; i < MAX_ENCODERS; i++) {
-      if (encoders[i].bottom_encoder_enabled && encoders[i].bottom_encoder_pos != 0) {
-        action = encoders[i].bottom_encoder_function;
-        mode = RELATIVE;
-        val = encoders[i].bottom_encoder_pos;
-        encoders[i].bottom_encoder_pos = 0;
-        schedule_action(action, mode, val);
-      }
+//
+// Encoder acceleration: if the VFO knob is turned fast, a tick moves the
+// frequency by more than one step. The time between two ticks is taken
+// from the edge time stamps, so it does not depend on thread scheduling.
+//
+static int encoder_step(int function, gint64 *last, gint64 ts) {
+  gint64 dt = ts - *last;
+  *last = ts;
 
-      if (encoders[i].top_encoder_enabled && encoders[i].top_encoder_pos != 0) {
-        action = encoders[i].top_encoder_function;
-        mode = RELATIVE;
-        val = encoders[i].top_encoder_pos;
-        encoders[i].top_encoder_pos = 0;
-        schedule_action(action, mode, val);
-      }
-    }
+  if (function != VFO || !gpio_vfo_acceleration) { return 1; }
 
-    g_mutex_unlock(&encoder_mutex);
-    usleep(100000); // sleep for 100ms
-  }
+  if (dt < 10000000LL) { return 4; }
 
-  return NULL;
+  if (dt < 30000000LL) { return 2; }
+
+  return 1;
 }
 
-static void process_encoder(int e, int l, int addr, int val) {
+static void process_encoder(int e, int l, int addr, int val, gint64 ts) {
+  ENCODER *enc = &encoders[e];
   guchar pinstate;
-  g_mutex_lock(&encoder_mutex);
-
-  switch (l) {
-  case BOTTOM_ENCODER:
-    switch (addr) {
-    case A:
-      encoders[e].bottom_encoder_a_value = val;
-      pinstate = (encoders[e].bottom_encoder_b_value << 1) | encoders[e].bottom_encoder_a_value;
-      encoders[e].bottom_encoder_state = encoder_state_table[encoders[e].bottom_encoder_state & 0xf][pinstate];
-
-      switch (encoders[e].bottom_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
-
-      case DIR_CW:
-        encoders[e].bottom_encoder_pos++;
-        break;
-
-      case DIR_CCW:
-        encoders[e].bottom_encoder_pos--;
-        break;
-
-      default:
-        break;
-      }
-
-      break;
-
-    case B:
-      encoders[e].bottom_encoder_b_value = val;
-      pinstate = (encoders[e].bottom_encoder_b_value << 1) | encoders[e].bottom_encoder_a_value;
-      encoders[e].bottom_encoder_state = encoder_state_table[encoders[e].bottom_encoder_state & 0xf][pinstate];
-
-      switch (encoders[e].bottom_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
-
-      case DIR_CW:
-        encoders[e].bottom_encoder_pos++;
-        break;
-
-      case DIR_CCW:
-        encoders[e].bottom_encoder_pos--;
-        break;
+  int *a, *b;
+  guchar *state;
+  gint64 *tick;
+  int function;
+
+  if (l == BOTTOM_ENCODER) {
+    a = &enc->bottom_encoder_a_value;
+    b = &enc->bottom_encoder_b_value;
+    state = &enc->bottom_encoder_state;
+    tick = &enc->bottom_encoder_tick;
+    function = enc->bottom_encoder_function;
+  } else {
+    a = &enc->top_encoder_a_value;
+    b = &enc->top_encoder_b_value;
+    state = &enc->top_encoder_state;
+    tick = &enc->top_encoder_tick;
+    function = enc->top_encoder_function;
+  }
 
-      default:
-        break;
-      }
+  if (addr == A) {
+    *a = val;
+  } else {
+    *b = val;
+  }
 
-      break;
-    }
+  pinstate = (*b << 1) | *a;
+  *state = encoder_state_table[*state & 0xf][pinstate];
 
+  //
+  // Each tick is queued immediately. Ticks arriving faster than the
+  // GTK main loop can process them are merged in the input queue.
+  //
+  switch (*state & 0x30) {
+  case DIR_CW:
+    input_queue_action(function, RELATIVE, encoder_step(function, tick, ts));
     break;
 
-  case TOP_ENCODER:
-    switch (addr) {
-    case A:
-      encoders[e].top_encoder_a_value = val;
-      pinstate = (encoders[e].top_encoder_b_value << 1) | encoders[e].top_encoder_a_value;
-      encoders[e].top_encoder_state = encoder_state_table[encoders[e].top_encoder_state & 0xf][pinstate];
-
-      switch (encoders[e].top_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
-
-      case DIR_CW:
-        encoders[e].top_encoder_pos++;
-        break;
-
-      case DIR_CCW:
-        encoders[e].top_encoder_pos--;
-        break;
-
-      default:
-        break;
-      }
-
-      break;
-
-    case B:
-      encoders[e].top_encoder_b_value = val;
-      pinstate = (encoders[e].top_encoder_b_value << 1) | encoders[e].top_encoder_a_value;
-      encoders[e].top_encoder_state = encoder_state_table[encoders[e].top_encoder_state & 0xf][pinstate];
-
-      switch (encoders[e].top_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
-
-      case DIR_CW:
-        encoders[e].top_encoder_pos++;
-        break;
-
-      case DIR_CCW:
-        encoders[e].top_encoder_pos--;
-        break;
-
-      default:
-        break;
-      }
-
-      break;
-    }
+  case DIR_CCW:
+    input_queue_action(function, RELATIVE, -encoder_step(function, tick, ts));
+    break;
 
+  default:
     break;
   }
-
-  g_mutex_unlock(&encoder_mutex);
 }
 
-static void process_edge(int offset, int value) {
+static void process_edge(int offset, int value, gint64 ts) {
   int i;
-  unsigned int t;
   gboolean found;
   found = FALSE;
 
@@ -575,30 +511,28 @@ static void process_edge(int offset, int value) {
   //
   for (i = 0; i < MAX_ENCODERS; i++) {
     if (encoders[i].bottom_encoder_enabled && encoders[i].bottom_encoder_address_a == offset) {
-      process_encoder(i, BOTTOM_ENCODER, A, SET(value == PRESSED));
+      process_encoder(i, BOTTOM_ENCODER, A, SET(value == PRESSED), ts);
       found = TRUE;
       break;
     } else if (encoders[i].bottom_encoder_enabled && encoders[i].bottom_encoder_address_b == offset) {
-      process_encoder(i, BOTTOM_ENCODER, B, SET(value == PRESSED));
+      process_encoder(i, BOTTOM_ENCODER, B, SET(value == PRESSED), ts);
       found = TRUE;
       break;
     } else if (encoders[i].top_encoder_enabled && encoders[i].top_encoder_address_a == offset) {
-      process_encoder(i, TOP_ENCODER, A, SET(value == PRESSED));
+      process_encoder(i, TOP_ENCODER, A, SET(value == PRESSED), ts);
       found = TRUE;
       break;
     } else if (encoders[i].top_encoder_enabled && encoders[i].top_encoder_address_b == offset) {
-      process_encoder(i, TOP_ENCODER, B, SET(value == PRESSED));
+      process_encoder(i, TOP_ENCODER, B, SET(value == PRESSED), ts);
       found = TRUE;
       break;
     } else if (encoders[i].switch_enabled && encoders[i].switch_address == offset) {
-      t = millis();
-
-      if (t < encoders[i].switch_debounce) {
+      if (ts < encoders[i].switch_debounce) {
         return;
       }
 
-      encoders[i].switch_debounce = t + settle_time;
-      schedule_action(encoders[i].switch_function, value, 0);
+      encoders[i].switch_debounce = ts + gpio_debounce * 1000000LL;
+      input_queue_action(encoders[i].switch_function, value, 0);
       found = TRUE;
       break;
     }
@@ -611,22 +545,22 @@ static void process_edge(int offset, int value) {
   // take care for "external" debouncing!
   //
   if (offset == CWL_LINE) {
-    schedule_action(CW_LEFT, value, 0);
+    input_queue_action(CW_LEFT, value, 0);
     found = TRUE;
   }
 
   if (offset == CWR_LINE) {
-    schedule_action(CW_RIGHT, value, 0);
+    input_queue_action(CW_RIGHT, value, 0);
     found = TRUE;
   }
 
   if (offset == CWKEY_LINE) {
-    schedule_action(CW_KEYER_KEYDOWN, value, 0);
+    input_queue_action(CW_KEYER_KEYDOWN, value, 0);
     found = TRUE;
   }
 
   if (offset == PTTIN_LINE) {
-    schedule_action(CW_KEYER_PTT, value, 0);
+    input_queue_action(CW_KEYER_PTT, value, 0);
     found = TRUE;
   }
 
@@ -652,15 +586,14 @@ static void process_edge(int offset, int value) {
   //
   for (i = 0; i < MAX_SWITCHES; i++) {
     if (switches[i].switch_enabled && switches[i].switch_address == offset) {
-      t = millis();
       found = TRUE;
 
-      if (t < switches[i].switch_debounce) {
+      if (ts < switches[i].switch_debounce) {
         return;
       }
 
-      switches[i].switch_debounce = t + settle_time;
-      schedule_action(switches[i].switch_function, value, 0);
+      switches[i].switch_debounce = ts + gpio_debounce * 1000000LL;
+      input_queue_action(switches[i].switch_function, value, 0);
       break;
     }
   }
@@ -670,25 +603,41 @@ static void process_edge(int offset, int value) {
   t_print("%s: could not find %d\n", __FUNCTION__, offset);
 }
 
-// cppcheck-suppress constParameterCallback
-static int interrupt_cb(int event_type, unsigned int line, const struct timespec *timeout, void* data) {
-  switch (event_type) {
-  case GPIOD_CTXLESS_EVENT_CB_TIMEOUT:
-    // timeout - ignore
-    break;
+//
+// Read "<offset> <value>" lines from the virtual GPIO FIFO.
+// Incomplete lines are kept in the buffer until the rest arrives.
+//
+static void read_virtual_lines() {
+  static char buf[256];
+  static int len = 0;
+  char *p, *nl;
+  ssize_t n = read(virtual_fd, buf + len, sizeof(buf) - 1 - len);
 
-  case GPIOD_CTXLESS_EVENT_CB_RISING_EDGE:
-    process_edge(line, RELEASED);
-    break;
+  if (n <= 0) { return; }
 
-  case GPIOD_CTXLESS_EVENT_CB_FALLING_EDGE:
-    process_edge(line, PRESSED);
-    break;
+  len += n;
+  buf[len] = 0;
+  p = buf;
+
+  while ((nl = strchr(p, '\n')) != NULL) {
+    int offset, value;
+    *nl = 0;
+
+    if (sscanf(p, "%d %d", &offset, &value) == 2) {
+      process_edge(offset, value ? RELEASED : PRESSED, gpio_now());
+    }
+
+    p = nl + 1;
   }
 
-  return GPIOD_CTXLESS_EVENT_CB_RET_OK;
-}
+  len -= p - buf;
+  memmove(buf, p, len);
 
+  if (len == sizeof(buf) - 1) {
+    // garbage without line feed
+    len = 0;
+  }
+}
 #endif
 
 void gpio_default_encoder_actions(int ctrlr) {
@@ -904,6 +853,8 @@ void gpioRestoreState() {
   }
 
 #endif
+  GetPropI0("debounce",                                           gpio_debounce);
+  GetPropI0("vfo_acceleration",                                   gpio_vfo_acceleration);
   gpio_set_defaults(controller);
 
   for (int i = 0; i < MAX_ENCODERS; i++) {
@@ -930,6 +881,8 @@ void gpioRestoreState() {
 void gpioSaveState() {
   clearProperties();
   SetPropI0("controller",                                         controller);
+  SetPropI0("debounce",                                           gpio_debounce);
+  SetPropI0("vfo_acceleration",                                   gpio_vfo_acceleration);
 
   for (int i = 0; i < MAX_ENCODERS; i++) {
     SetPropI1("encoders[%d].bottom_encoder_enabled", i,           encoders[i].bottom_encoder_enabled);
@@ -998,63 +951,132 @@ void gpioSaveActions() {
 
 #ifdef GPIO
 static gpointer monitor_thread(gpointer arg) {
-  struct timespec t;
+  struct epoll_event events[MAX_LINES + 2];
+  struct epoll_event ev;
+  int epfd;
   // thread to monitor gpio events
   t_print("%s: monitoring %d lines.\n", __FUNCTION__, lines);
+  //
+  // CW key and paddle events are delivered by this thread, so it
+  // runs with the priority of the audio threads.
+  //
+  thread_setup(THREAD_AUDIO, "GPIO monitor");
+  epfd = epoll_create1(EPOLL_CLOEXEC);
 
-  if (gpio_device == NULL) {
+  if (epfd < 0) {
+    t_print("%s: epoll_create1 failed: %s\n", __FUNCTION__, g_strerror(errno));
     return NULL;
   }
 
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+
   for (int i = 0; i < lines; i++) {
     t_print("%s: ... monitoring line  %u\n", __FUNCTION__, monitor_lines[i]);
+
+    if (input_lines[i] == NULL) { continue; }
+
+    ev.data.u32 = i;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, gpiod_line_event_get_fd(input_lines[i]), &ev) < 0) {
+      t_print("%s: epoll_ctl line %u failed: %s\n", __FUNCTION__, monitor_lines[i], g_strerror(errno));
+    }
   }
 
-  t.tv_sec = 60;
-  t.tv_nsec = 0;
-  int ret = gpiod_ctxless_event_monitor_multiple(
-              gpio_device, GPIOD_CTXLESS_EVENT_BOTH_EDGES,
-              monitor_lines, lines, FALSE,
-              consumer, &t, NULL, interrupt_cb, NULL);
+  ev.data.u32 = WAKEUP_INDEX;
+  epoll_ctl(epfd, EPOLL_CTL_ADD, wakeup_fd, &ev);
+
+  if (virtual_fd >= 0) {
+    ev.data.u32 = VIRTUAL_INDEX;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, virtual_fd, &ev);
+  }
+
+  while (__atomic_load_n(&monitor_running, __ATOMIC_ACQUIRE)) {
+    int n = epoll_wait(epfd, events, MAX_LINES + 2, -1);
+
+    if (n < 0) {
+      if (errno == EINTR) { continue; }
 
-  if (ret < 0) {
-    t_print("%s: ctxless event monitor failed: %s\n", __FUNCTION__, g_strerror(errno));
+      t_print("%s: epoll_wait failed: %s\n", __FUNCTION__, g_strerror(errno));
+      break;
+    }
+
+    for (int i = 0; i < n; i++) {
+      unsigned int index = events[i].data.u32;
+
+      if (index == WAKEUP_INDEX) {
+        uint64_t dummy;
+
+        if (read(wakeup_fd, &dummy, sizeof(dummy)) < 0) {
+          t_print("%s: wakeup read failed: %s\n", __FUNCTION__, g_strerror(errno));
+        }
+      } else if (index == VIRTUAL_INDEX) {
+        read_virtual_lines();
+      } else if (index < (unsigned int) lines) {
+        struct gpiod_line_event le;
+
+        //
+        // Only one event is read. If more are pending, epoll_wait
+        // returns immediately with this line again.
+        //
+        if (gpiod_line_event_read(input_lines[index], &le) == 0) {
+          gint64 ts = (gint64)le.ts.tv_sec * 1000000000LL + le.ts.tv_nsec;
+          process_edge(monitor_lines[index], le.event_type == GPIOD_LINE_EVENT_RISING_EDGE ? RELEASED : PRESSED, ts);
+        }
+      }
+    }
   }
 
+  close(epfd);
   t_print("%s: exit\n", __FUNCTION__);
   return NULL;
 }
 
 static int setup_input_line(struct gpiod_chip *chip, int offset, gboolean pullup) {
   //
-  // Set up an input line. If this succeeds, record offset in monitor[]
-  // and release line (it will be requested again later in the monitor thread).
+  // Set up an input line with edge detection. If this succeeds, record
+  // the line and its offset in input_lines[] and monitor_lines[].
+  // With the virtual GPIO backend, there is no chip and only the
+  // offset is recorded.
   //
   int ret;
   struct gpiod_line_request_config config;
+  struct gpiod_line *line = NULL;
   t_print("%s: %d\n", __FUNCTION__, offset);
-  struct gpiod_line *line = gpiod_chip_get_line(chip, offset);
 
-  if (!line) {
-    t_print("%s: get line %d failed: %s\n", __FUNCTION__, offset, g_strerror(errno));
+  if (lines >= MAX_LINES) {
+    t_print("%s: too many lines\n", __FUNCTION__);
     return -1;
   }
 
-  config.consumer = consumer;
-  config.request_type = GPIOD_LINE_REQUEST_DIRECTION_INPUT | GPIOD_LINE_REQUEST_EVENT_BOTH_EDGES;
+  if (chip != NULL) {
+    line = gpiod_chip_get_line(chip, offset);
+
+    if (!line) {
+      t_print("%s: get line %d failed: %s\n", __FUNCTION__, offset, g_strerror(errno));
+      return -1;
+    }
+
+    config.consumer = consumer;
+    config.request_type = GPIOD_LINE_REQUEST_EVENT_BOTH_EDGES;
 #ifdef OLD_GPIOD
-  config.flags = pullup ? GPIOD_LINE_REQUEST_FLAG_ACTIVE_LOW : 0;
+    //
+    // No bias settings in old libgpiod versions. The lines must not
+    // be active-low, since a falling edge means "pressed".
+    //
+    config.flags = 0;
 #else
-  config.flags = pullup ? GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP : GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_DOWN;
+    config.flags = pullup ? GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP : GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_DOWN;
 #endif
-  ret = gpiod_line_request(line, &config, 1);
+    ret = gpiod_line_request(line, &config, 1);
 
-  if (ret < 0) {
-    t_print("%s: line %d gpiod_line_request failed: %s\n", __FUNCTION__, offset, g_strerror(errno));
-    return ret;
+    if (ret < 0) {
+      t_print("%s: line %d gpiod_line_request failed: %s\n", __FUNCTION__, offset, g_strerror(errno));
+      return ret;
+    }
   }
 
-  gpiod_line_release(line);  // release line since the event monitor will request it later
+  input_lines[lines] = line;
   monitor_lines[lines] = offset;
   lines++;
   return 0;
@@ -1063,10 +1085,13 @@ static int setup_input_line(struct gpiod_chip *chip, int offset, gboolean pullup
 static struct gpiod_line *setup_output_line(struct gpiod_chip *chip, int offset, int initialValue)  {
   //
   // Setup an active-high output line and return the "line"
-  // (in case of failure: NULL).
+  // (in case of failure, or with the virtual GPIO backend: NULL).
   //
   struct gpiod_line_request_config config;
   t_print("%s: %d\n", __FUNCTION__, offset);
+
+  if (chip == NULL) { return NULL; }
+
   struct gpiod_line *line = gpiod_chip_get_line(chip, offset);
 
   if (!line) {
@@ -1087,6 +1112,23 @@ static struct gpiod_line *setup_output_line(struct gpiod_chip *chip, int offset,
   return line;
 }
 
+static void release_lines() {
+  for (int i = 0; i < lines; i++) {
+    if (input_lines[i] != NULL) { gpiod_line_release(input_lines[i]); }
+
+    input_lines[i] = NULL;
+  }
+
+  lines = 0;
+
+  if (pttout_line != NULL) { gpiod_line_release(pttout_line); }
+
+  if (cwout_line != NULL) { gpiod_line_release(cwout_line); }
+
+  pttout_line = NULL;
+  cwout_line = NULL;
+}
+
 #endif
 
 //
@@ -1096,21 +1138,37 @@ static struct gpiod_line *setup_output_line(struct gpiod_chip *chip, int offset,
 int gpio_init() {
 #ifdef GPIO
   int ret = 0;
-  initialiseEpoch();
-  g_mutex_init(&encoder_mutex);
+  const char *virtual_gpio = getenv("PIHPSDR_VIRTUAL_GPIO");
   gpio_set_defaults(controller);
   chip = NULL;
+  lines = 0;
+
+  if (virtual_gpio != NULL) {
+    //
+    // Opening the FIFO read-write means that it never reports
+    // end-of-file when a writer goes away.
+    //
+    virtual_fd = open(virtual_gpio, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+    if (virtual_fd < 0) {
+      t_print("%s: open virtual GPIO %s failed: %s\n", __FUNCTION__, virtual_gpio, g_strerror(errno));
+      ret = -1;
+      goto err;
+    }
+
+    gpio_device = "virtual";
+  }
 
   //
   // Open GPIO device. Try several devices, until
   // there is success.
   //
-  if (chip == NULL) {
+  if (chip == NULL && virtual_fd < 0) {
     gpio_device = "/dev/gpiochip4";      // works on RPI5
     chip = gpiod_chip_open(gpio_device);
   }
 
-  if (chip == NULL) {
+  if (chip == NULL && virtual_fd < 0) {
     gpio_device = "/dev/gpiochip0";     // works on RPI4
     chip = gpiod_chip_open(gpio_device);
   }
@@ -1118,7 +1176,7 @@ int gpio_init() {
   //
   // If no success so far, give up
   //
-  if (chip == NULL) {
+  if (chip == NULL && virtual_fd < 0) {
     t_print("%s: open chip failed: %s\n", __FUNCTION__, g_strerror(errno));
     ret = -1;
     goto err;
@@ -1230,26 +1288,36 @@ int gpio_init() {
   }
 
   if (have_button || (controller != NO_CONTROLLER && controller != G2_V2)) {
+    wakeup_fd = eventfd(0, EFD_CLOEXEC);
+
+    if (wakeup_fd < 0) {
+      t_print("%s: eventfd failed: %s\n", __FUNCTION__, g_strerror(errno));
+      ret = -1;
+      goto err;
+    }
+
+    monitor_running = 1;
     monitor_thread_id = g_thread_new( "gpiod monitor", monitor_thread, NULL);
     t_print("%s: monitor_thread: id=%p\n", __FUNCTION__, monitor_thread_id);
   }
 
-  if (controller != NO_CONTROLLER && controller != G2_V2) {
-    rotary_encoder_thread_id = g_thread_new( "encoders", rotary_encoder_thread, NULL);
-    t_print("%s: rotary_encoder_thread: id=%p\n", __FUNCTION__, rotary_encoder_thread_id);
-  }
-
 #endif
   return 0;
 #ifdef GPIO
 err:
   t_print("%s: err\n", __FUNCTION__);
+  release_lines();
 
   if (chip != NULL) {
     gpiod_chip_close(chip);
   }
 
+  if (virtual_fd >= 0) {
+    close(virtual_fd);
+  }
+
   chip = NULL;
+  virtual_fd = -1;
   gpio_device = NULL;
   return ret;
 #endif
@@ -1258,7 +1326,29 @@ err:
 void gpio_close() {
 #ifdef GPIO
 
+  if (monitor_thread_id != NULL) {
+    uint64_t one = 1;
+    __atomic_store_n(&monitor_running, 0, __ATOMIC_RELEASE);
+
+    if (write(wakeup_fd, &one, sizeof(one)) < 0) {
+      t_print("%s: wakeup failed: %s\n", __FUNCTION__, g_strerror(errno));
+    }
+
+    g_thread_join(monitor_thread_id);
+    monitor_thread_id = NULL;
+  }
+
+  if (wakeup_fd >= 0) { close(wakeup_fd); }
+
+  wakeup_fd = -1;
+  release_lines();
+
+  if (virtual_fd >= 0) { close(virtual_fd); }
+
+  virtual_fd = -1;
+
   if (chip != NULL) { gpiod_chip_close(chip); }
 
+  chip = NULL;
 #endif
 }
@@ -32,7 +32,7 @@ typedef struct _encoder {
   int bottom_encoder_a_value;
   int bottom_encoder_address_b;
   int bottom_encoder_b_value;
-  int bottom_encoder_pos;
+  gint64 bottom_encoder_tick;      // time stamp (ns) of the last tick
   int bottom_encoder_function;
   guchar bottom_encoder_state;
   int top_encoder_enabled;
@@ -41,14 +41,14 @@ typedef struct _encoder {
   int top_encoder_a_value;
   int top_encoder_address_b;
   int top_encoder_b_value;
-  int top_encoder_pos;
+  gint64 top_encoder_tick;
   int top_encoder_function;
   guchar top_encoder_state;
   gboolean switch_enabled;
   gboolean switch_pullup;
   int switch_address;
   int switch_function;
-  gulong switch_debounce;
+  gint64 switch_debounce;          // edges are ignored until this time (ns)
 } ENCODER;
 
 extern ENCODER *encoders;
@@ -58,7 +58,7 @@ typedef struct _switch {
   gboolean switch_pullup;
   int switch_address;
   int switch_function;
-  gulong switch_debounce;
+  gint64 switch_debounce;
 } SWITCH;
 
 extern SWITCH *switches;
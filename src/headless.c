@@ -0,0 +1,108 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <wdsp.h>    // only needed for WDSPwisdom()
+
+#include "audio.h"
+#include "discovered.h"
+#include "discovery.h"
+#include "headless.h"
+#include "main.h"
+#include "message.h"
+#include "radio.h"
+#include "version.h"
+
+static GMainLoop *headless_loop = NULL;
+static const char *headless_device = NULL;
+
+static gboolean headless_signal(gpointer data) {
+  t_print("%s: received signal %d, stopping ...\n", __FUNCTION__, GPOINTER_TO_INT(data));
+
+  if (radio != NULL) {
+    radio_stop_program();
+  }
+
+  g_main_loop_quit(headless_loop);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean headless_start(gpointer data) {
+  char wisdom_directory[1025];
+  char text[1024];
+  audio_get_cards();
+  //
+  // There is nobody to look at a progress report, so compute
+  // the wisdom plans (if necessary) right here.
+  //
+  (void) getcwd(text, sizeof(text));
+  snprintf(wisdom_directory, sizeof(wisdom_directory), "%s/", text);
+  t_print("%s: Securing wisdom file in directory: %s\n", __FUNCTION__, wisdom_directory);
+
+  if (WDSPwisdom(wisdom_directory)) {
+    t_print("%s: WDSP wisdom file has been rebuilt.\n", __FUNCTION__);
+  } else {
+    t_print("%s: Re-using existing WDSP wisdom file.\n", __FUNCTION__);
+  }
+
+  radio = discovery_headless(headless_device);
+
+  if (radio == NULL) {
+    if (headless_device) {
+      t_print("%s: device %s not found or not available\n", __FUNCTION__, headless_device);
+    }
+
+    fatal_error("FATAL: no radio to start");
+    return G_SOURCE_REMOVE;
+  }
+
+  t_print("%s: starting %s\n", __FUNCTION__, radio->name);
+  radio_start_radio();
+  return G_SOURCE_REMOVE;
+}
+
+int headless_run(const char *device) {
+  t_print("%s: Build: %s (Commit: %s, Date: %s)\n", __FUNCTION__, build_version, build_commit, build_date);
+  t_print("%s: running headless\n", __FUNCTION__);
+  headless_device = device;
+  //
+  // There is no monitor, so assume a "virtual" one for the
+  // "full screen" case. Remote clients set the spectrum width
+  // they need anyway.
+  //
+  display_width[0] = 1280;
+  display_height[0] = 720;
+  headless_loop = g_main_loop_new(NULL, FALSE);
+  g_unix_signal_add(SIGINT, headless_signal, GINT_TO_POINTER(SIGINT));
+  g_unix_signal_add(SIGTERM, headless_signal, GINT_TO_POINTER(SIGTERM));
+  g_idle_add(headless_start, NULL);
+  g_main_loop_run(headless_loop);
+  g_main_loop_unref(headless_loop);
+  t_print("%s: exiting ...\n", __FUNCTION__);
+  t_print_flush();
+  //
+  // The protocol, rigctl, TCI and server threads may still be running,
+  // so do not return from main() but exit as radio_exit_program() does.
+  //
+  _exit(0);
+}
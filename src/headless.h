@@ -0,0 +1,30 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _HEADLESS_H_
+#define _HEADLESS_H_
+
+//
+// Run piHPSDR as a server without GUI (command line option -Headless).
+// No GTK widgets are created, and no display is needed. The GTK idle
+// queue is served by a plain GMainLoop on the default main context,
+// so g_idle_add() and g_timeout_add() work as usual.
+//
+extern int headless_run(const char *device);
+
+#endif
@@ -206,7 +206,7 @@ int  speed = 0;   // 0: nominal speed, -1: radio is 1% too slow, +1: radio is 1%
 
 static double txlevel;
 
-static double tonearg, tonearg2;
+static NCO    tone1, tone2;
 static double tonedelta, tonedelta2;
 static int    do_tone, t3p, t3l;
 
@@ -264,15 +264,19 @@ int main(int argc, char *argv[]) {
   radio_io8 = 0;
   // seed value for random number generator
   seed = ((uintptr_t) &seed) & 0xffffff;
-  tonearg = 0.0;
   tonedelta = 0.0;
-  tonearg2 = 0.0;
   tonedelta2 = 0.0;
   do_tone = 0;
   diversity = 0;
   noiseblank = 0;
   nb_pulse = 0;
   nb_width = 0;
+  load_ddcs = 0;
+  load_rate = 1536;
+  load_loss = 0.0;
+  load_reorder = 0.0;
+  load_burst = 1;
+  load_metrics_port = 0;
   const int MAC1 = 0x00;
   const int MAC2 = 0x1C;
   const int MAC3 = 0xC0;
@@ -332,14 +336,72 @@ int main(int argc, char *argv[]) {
       continue;
     }
 
+    if (!strncmp(argv[i], "-load",         5))  {
+      load_ddcs = 8;
+
+      if (i < argc - 1) { sscanf(argv[++i], "%d", &load_ddcs); }
+
+      if (i < argc - 1) { sscanf(argv[++i], "%d", &load_rate); }
+
+      if (load_ddcs < 1 || load_ddcs > 8) { load_ddcs = 8; }
+
+      if (load_rate < 0 || load_rate > 100000) { load_rate = 1536; }
+
+      continue;
+    }
+
+    if (!strncmp(argv[i], "-loss",         5))  {
+      if (i < argc - 1) { sscanf(argv[++i], "%lf", &load_loss); }
+
+      if (load_loss < 0.0 || load_loss > 50.0) { load_loss = 0.0; }
+
+      continue;
+    }
+
+    if (!strncmp(argv[i], "-reorder",      8))  {
+      if (i < argc - 1) { sscanf(argv[++i], "%lf", &load_reorder); }
+
+      if (load_reorder < 0.0 || load_reorder > 50.0) { load_reorder = 0.0; }
+
+      continue;
+    }
+
+    if (!strncmp(argv[i], "-burst",        6))  {
+      if (i < argc - 1) { sscanf(argv[++i], "%d", &load_burst); }
+
+      if (load_burst < 1 || load_burst > 1000) { load_burst = 1; }
+
+      continue;
+    }
+
+    if (!strncmp(argv[i], "-metrics",      8))  {
+      if (i < argc - 1) { sscanf(argv[++i], "%d", &load_metrics_port); }
+
+      if (load_metrics_port < 0 || load_metrics_port > 65535) { load_metrics_port = 0; }
+
+      continue;
+    }
+
     t_print("Unknown option: %s\n", argv[i]);
     t_print("Valid options are: -atlas | -metis  | -hermes     | -griffin     | -angelia |\n");
     t_print("                   -orion | -orion2 | -hermeslite | -hermeslite2 | -c25     |\n");
     t_print("                   -diversity | -P1 | -P2         | -fast        | -slow    |\n");
     t_print("                   -nb <num> <width>\n");
+    t_print("Load generator:    -load <ddcs> <rate> | -loss <percent> | -reorder <percent> |\n");
+    t_print("                   -burst <packets>    | -metrics <port>\n");
     exit(8);
   }
 
+  if (load_ddcs > 0) {
+    if (oldnew == 1) {
+      t_print("The load generator only works with the new protocol\n");
+      load_ddcs = 0;
+    } else {
+      t_print("LOAD: %d DDCs at %d kHz, loss=%.2f%% reorder=%.2f%% burst=%d\n",
+              load_ddcs, load_rate, load_loss, load_reorder, load_burst);
+    }
+  }
+
   switch (NEWDEVICE) {
   case   NDEV_ATLAS:
     t_print("DEVICE is ATLAS/METIS\n");
@@ -1073,7 +1135,7 @@ int main(int argc, char *argv[]) {
         buffer[11] = NEWDEVICE;
         buffer[12] = 38;
         buffer[13] = 19;
-        buffer[20] = 2;
+        buffer[20] = 8;  // number of DDCs
         buffer[21] = 1;
         buffer[22] = 3;
 
@@ -1772,6 +1834,13 @@ void *handler_ep6(void *arg) {
         rxptr = OLDRTXLEN / 2 - 4096;
       }
 
+      //
+      // The tones are produced by rotating phasors rather than
+      // calling cos() and sin() for each sample
+      //
+      nco_set(&tone1, tonedelta);
+      nco_set(&tone2, tonedelta2);
+
       for (j = 0; j < n; j++) {
         // ADC1: noise + weak tone on RX, feedback sig. on TX (except STEMlab)
         if (ptt && (OLDDEVICE != ODEV_C25)) {
@@ -1782,17 +1851,17 @@ void *handler_ep6(void *arg) {
           adc1qsample = (txatt_dbl * q1 * fac3 + noiseItab[noiseIQpt] * p1noisefac) * 8388607.0;
         } else if (diversity && do_tone == 1) {
           // man made noise to ADC1 samples
-          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + cos(tonearg) * fac1 + divtab[divpt] * fac2) * 8388607.0;
-          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + sin(tonearg) * fac1                   ) * 8388607.0;
+          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + tone1.re * fac1 + divtab[divpt] * fac2) * 8388607.0;
+          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + tone1.im * fac1                   ) * 8388607.0;
         } else if (do_tone == 1) {
-          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + cos(tonearg) * fac1) * 8388607.0;
-          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + sin(tonearg) * fac1) * 8388607.0;
+          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + tone1.re * fac1) * 8388607.0;
+          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + tone1.im * fac1) * 8388607.0;
         } else if (do_tone == 2) {
-          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + (cos(tonearg) + cos(tonearg2)) * fac1) * 8388607.0;
-          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + (sin(tonearg) + sin(tonearg2)) * fac1) * 8388607.0;
+          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + (tone1.re + tone2.re) * fac1) * 8388607.0;
+          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + (tone1.im + tone2.im) * fac1) * 8388607.0;
         } else if (do_tone == 3 && t3p >= 0) {
-          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + cos(tonearg) * fac1a) * 8388607.0;
-          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + sin(tonearg) * fac1a) * 8388607.0;
+          adc1isample = (noiseItab[noiseIQpt] * p1noisefac + tone1.re * fac1a) * 8388607.0;
+          adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac + tone1.im * fac1a) * 8388607.0;
         } else {
           adc1isample = (noiseItab[noiseIQpt] * p1noisefac ) * 8388607.0;
           adc1qsample = (noiseQtab[noiseIQpt] * p1noisefac ) * 8388607.0;
@@ -1873,21 +1942,16 @@ void *handler_ep6(void *arg) {
 
         if (t3p >= t3l) { t3p = -t3l; }
 
-        tonearg  += tonedelta;
-        tonearg2 += tonedelta2;
-
-        if (tonearg > 6.3) { tonearg -= 6.283185307179586476925286766559; }
-
-        if (tonearg2 > 6.3) { tonearg2 -= 6.283185307179586476925286766559; }
-
-        if (tonearg < -6.3) { tonearg += 6.283185307179586476925286766559; }
-
-        if (tonearg2 < -6.3) { tonearg2  += 6.283185307179586476925286766559; }
+        nco_step(&tone1);
+        nco_step(&tone2);
 
         divpt += decimation;
 
         if (divpt >= LENDIV) { divpt = 0; }
       }
+
+      nco_norm(&tone1);
+      nco_norm(&tone2);
     }
 
     //
@@ -135,6 +135,51 @@ extern int clock_nanosleep(clockid_t __clock_id, int __flags,
 #define IM3a  0.60
 #define IM3b  0.20
 
+//
+// Block NCO for the test tones. Instead of calling sin() and cos() for
+// every sample, a phasor is rotated by multiplying it with a constant
+// complex factor. nco_norm() must be called once per block to prevent
+// the amplitude from drifting away.
+//
+typedef struct _nco {
+  double re, im;   // current phasor
+  double dre, dim; // rotation per sample
+  double delta;    // phase increment per sample
+} NCO;
+
+static inline void nco_set(NCO *nco, double delta) {
+  if (nco->re == 0.0 && nco->im == 0.0) { nco->re = 1.0; }
+
+  if (delta != nco->delta || (nco->dre == 0.0 && nco->dim == 0.0)) {
+    nco->delta = delta;
+    nco->dre = cos(delta);
+    nco->dim = sin(delta);
+  }
+}
+
+static inline void nco_step(NCO *nco) {
+  double re = nco->re * nco->dre - nco->im * nco->dim;
+  nco->im = nco->re * nco->dim + nco->im * nco->dre;
+  nco->re = re;
+}
+
+static inline void nco_norm(NCO *nco) {
+  double mag = 1.5 - 0.5 * (nco->re * nco->re + nco->im * nco->im);
+  nco->re *= mag;
+  nco->im *= mag;
+}
+
+//
+// Store a sample (-1.0 ... 1.0) as a 24-bit big-endian number
+//
+static inline unsigned char *put24(unsigned char *p, double sample) {
+  int32_t s = sample * 8388607.0;
+  p[0] = (s >> 16) & 0xFF;
+  p[1] = (s >>  8) & 0xFF;
+  p[2] = (s      ) & 0xFF;
+  return p + 3;
+}
+
 //
 // Digital Inputs, reported to the SDR program
 //
@@ -147,6 +192,21 @@ EXTERN uint8_t radio_io5, radio_io6, radio_io8;
 // Flag for modifying the clock speed of the radio
 //
 EXTERN int speed;
+
+//
+// Load generator (new protocol only): the first load_ddcs DDCs send
+// pre-computed packets at load_rate kHz (0: as fast as possible),
+// with load_loss percent of the packets dropped, load_reorder percent
+// sent after their successor, and load_burst packets sent back-to-back.
+// If load_metrics_port is set, the sequence errors seen by piHPSDR are
+// fetched from its metrics server and reported with the injected ones.
+//
+EXTERN int    load_ddcs;
+EXTERN int    load_rate;
+EXTERN double load_loss;
+EXTERN double load_reorder;
+EXTERN int    load_burst;
+EXTERN int    load_metrics_port;
 //
 // message printing
 //
@@ -37,6 +37,7 @@
 #include "ext.h"
 #include "gpio.h"
 #include "i2c.h"
+#include "input_queue.h"
 #include "message.h"
 #include "radio.h"
 #include "toolbar.h"
@@ -131,7 +132,7 @@ void i2c_interrupt() {
         // The input line associated with switch #i has triggered an interrupt
         // clear *this* bit in flags
         flags &= ~i2c_sw[i];
-        schedule_action(switches[i].switch_function, (ints & i2c_sw[i]) ? PRESSED : RELEASED, 0);
+        input_queue_action(switches[i].switch_function, (ints & i2c_sw[i]) ? PRESSED : RELEASED, 0);
       }
     }
   }
@@ -34,7 +34,6 @@
 #include <sys/mman.h>
 
 #include "ext.h"
-#include "gpio.h"
 #include "iambic.h"
 #include "main.h"
 #include "message.h"
@@ -120,6 +119,20 @@
  *
  * - during a dot or dash the keyer thread simply waits and does no busy spinning.
  *
+ * TIMING
+ * ======
+ *
+ * (2026) The keyer does not use wall-clock sleeps. All waiting is done on the
+ * CW clock (tx_cw_clock()), which counts the microphone samples processed by the
+ * TX engine, that is, the position in the TX IQ and side tone streams. The keyer
+ * keeps its own time line of the elements queued (kclock) and queues the key-down
+ * of the next element shortly (KEYER_LOOKAHEAD) before the previous one has ended,
+ * such that the elements follow each other with sample accuracy. While waiting
+ * for a paddle (straight key, CW vox hang time), the keyer sleeps until
+ * keyer_event() wakes it up. Waits for the end of an element or space cannot
+ * be cut short by paddle events, so the paddles are always sampled at the
+ * end of the element.
+ *
  * DOT/DASH MEMORY
  * ===============
  *
@@ -202,14 +215,20 @@ static void* keyer_thread(void *arg);
 static pthread_t keyer_thread_id;
 
 #define MY_PRIORITY (90)
-#define NSEC_PER_SEC   (1000000000)
+
+//
+// The decision about the next element is made this many samples (4 msec)
+// before the current one ends, so the key-down event is in the ring buffer
+// before the TX thread gets there. This must cover the size of the
+// microphone sample packets, which are processed in one go.
+//
+#define KEYER_LOOKAHEAD 192
 
 static int dot_memory = 0;
 static int dash_memory = 0;
 static int dot_held = 0;
 static int dash_held = 0;
 static int key_state = CHECK;
-static int dot_length = 0;
 static int dot_samples = 0;
 static int dash_samples = 0;
 static int kcwl = 0;
@@ -226,19 +245,14 @@ static int running = 0;
 #endif
 
 #ifdef __APPLE__
-#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
-#else
-
-// using clock_nanosleep of librt
-extern int clock_nanosleep(clockid_t __clock_id, int __flags,
-                           __const struct timespec *__req,
-                           struct timespec *__rem);
+  #include "MacOS.h"  // apple_sem
 #endif
 
 static void keyer_close() {
   t_print("%s\n", __FUNCTION__);
   running = 0;
   // keyer thread may be sleeping, so wake it up
+  tx_cw_wakeup();
 #ifdef __APPLE__
   sem_post(cw_event);
 #else
@@ -285,7 +299,6 @@ void keyer_update() {
   //
   // The most important thing here is to start/stop the keyer thread.
   //
-  dot_length = 1200 / cw_keyer_speed;
   dot_samples = 57600 / cw_keyer_speed;
   dash_samples = (3456 * cw_keyer_weight) / cw_keyer_speed;
 
@@ -347,15 +360,23 @@ void keyer_event(int left, int state) {
     sem_post(&cw_event);
 #endif
   }
+
+  //
+  // If the keyer is waiting for a paddle change (straight key,
+  // CW vox hang time), let it re-check now. This does not end
+  // a wait for the end of an element or space.
+  //
+  tx_cw_wakeup();
 }
 
 static void* keyer_thread(void *arg) {
-  struct timespec loop_delay;
   int i;
-  // initializing the following two variables
+  // initializing the following variables
   // makes the clang static analyzer happy
-  double tdown = 0.0;
-  int kdelay = 0;
+  long long tdown = 0;
+  long long kclock = 0;
+  long long vox_end = 0;
+  long long now;
   int txmode;
   int moxbefore;
   int cwvox;
@@ -407,32 +428,28 @@ static void* keyer_thread(void *arg) {
 
       while (!mox && i-- > 0) { usleep(1000L); }
 
-      cwvox = (int) cw_keyer_hang_time;
+      cwvox = 1;
     }
 
     key_state = CHECK;
+    kclock = tx_cw_clock();
+    vox_end = kclock + 48 * cw_keyer_hang_time;
 
-    while (key_state != EXITLOOP || cwvox > 0) {
-      //
-      // if key_state == EXITLOOP and cwvox == 0, then
-      // just leave the while-loop without removing MOX
+    while (running) {
       //
-      // re-trigger VOX if *not* busy-spinning
-      // (that is, for *all* states except EXITLOOP and CHECK)
+      // kclock is the time (CW clock) at which the last element queued
+      // (including the inter-element pause) ends.
       //
-      if (cwvox > 0 && key_state != EXITLOOP && key_state != CHECK) { cwvox = (int) cw_keyer_hang_time; }
+      now = tx_cw_clock();
 
-      clock_gettime(CLOCK_MONOTONIC, &loop_delay);
+      if (key_state == EXITLOOP) {
+        //
+        // Without CW vox, or if the CW vox time has expired, leave the loop.
+        // Otherwise wait until the hang time has passed or a paddle is hit.
+        //
+        if (!cwvox) { break; }
 
-      switch (key_state) {
-      case EXITLOOP:
-        // If we arrive here, cwvox is greater than zero, since key_state==EXITLOOP
-        // AND cwvox==0 leaves the outer "while" loop.
-        cwvox--;
-
-        // If CW-vox still hanging, continue "busy-spinning"
-        if (cwvox == 0) {
-          // we have just reduced cwvox from 1 to 0.
+        if (now >= vox_end) {
           if (!moxbefore) {
             g_idle_add(ext_radio_set_mox, GINT_TO_POINTER(0));
             // Wait for MOX really gone. This is necessary since otherwise we may
@@ -444,20 +461,27 @@ static void* keyer_thread(void *arg) {
 
             while (mox && i-- > 0) { usleep(1000L); }
           }
-        } else {
-          key_state = CHECK;
+
+          break;
         }
 
-        // wait 1 msec
-        loop_delay.tv_nsec += 1000000;
-        break;
+        tx_cw_paddle_arm();
 
+        if (running && !*kdot && !*kdash && !dot_memory && !dash_memory) { tx_cw_wait_paddle(vox_end); }
+
+        key_state = CHECK;
+        continue;
+      }
+
+      switch (key_state) {
       case CHECK: // check for key press
         key_state = EXITLOOP;  // default next state
 
-        // Do not decrement cwvox until zero here, otherwise
-        // we won't enter the code 10 lines above that de-activates MOX.
-        if (cwvox > 1) { cwvox--; }
+        //
+        // Elements start when the previous one has ended,
+        // or now if the keyer has been idle.
+        //
+        if (kclock < now) { kclock = now; }
 
         if (cw_keyer_mode == KEYER_STRAIGHT) {       // Straight/External key or bug
           if (*kdot) {
@@ -468,9 +492,8 @@ static void* keyer_thread(void *arg) {
           // If both paddles are pressed (should not happen), then
           // the dash paddle wins.
           if (*kdash) {                  // send manual dashes
-            tdown = loop_delay.tv_sec + 1.0E-9 * loop_delay.tv_nsec;
+            tdown = now;
             tx_queue_cw_event(1, 0);
-            gpio_set_cw(1);
             key_state = STRAIGHT;
           }
         } else {
@@ -483,42 +506,44 @@ static void* keyer_thread(void *arg) {
           if (*kdot) { key_state = PREDOT; }
         }
 
-        if (key_state == CHECK) {
-          // wait 1 msec
-          loop_delay.tv_nsec += 1000000;
-        }
-
         break;
 
       case STRAIGHT:
 
         //
         // Wait for dash paddle being released in "straight key" mode.
+        // keyer_event() wakes us up when this happens. The GPIO CW output
+        // is switched by the TX engine when it executes the events.
         //
+        tx_cw_paddle_arm();
+
         if (! *kdash) {
-          tx_queue_cw_event(0, (int)((loop_delay.tv_sec + 1.0E-9 * loop_delay.tv_nsec - tdown) * 48000.0));
-          gpio_set_cw(0);
+          tx_queue_cw_event(0, (int)(now - tdown));
+          kclock = now;
+          vox_end = now + 48 * cw_keyer_hang_time;
           key_state = CHECK;
-        } else {
-          loop_delay.tv_nsec += 1000000;
+        } else if (running) {
+          tx_cw_wait_paddle(now + 48000);
         }
 
         break;
 
       case PREDOT:
         //
-        // start sending the dot
+        // start sending the dot. The key-down is executed when the
+        // previous element (including its pause) has ended
         //
         dash_memory = 0;
         dash_held = *kdash;
-        gpio_set_cw(1);
         tx_queue_cw_event (1, 0);
         tx_queue_cw_event (0, dot_samples);
         tx_queue_cw_event (0, dot_samples);
+        kclock += 2 * dot_samples;
+        vox_end = kclock + 48 * cw_keyer_hang_time;
         //
         // wait for end of inter-element pause
         //
-        loop_delay.tv_nsec += (2 * dot_samples) * 20833;
+        tx_cw_wait(kclock - KEYER_LOOKAHEAD);
         key_state = AFTERDOT;
         break;
 
@@ -552,7 +577,6 @@ static void* keyer_thread(void *arg) {
           } else if (cw_keyer_spacing) {
             dot_memory = dash_memory = 0;
             key_state = LETTERSPACE;
-            kdelay = 0;
           } else {
             key_state = EXITLOOP;
           }
@@ -564,15 +588,16 @@ static void* keyer_thread(void *arg) {
 
       case PREDASH:
         //
-        // start sending the dot
+        // start sending the dash
         //
         dot_memory =  0;
         dot_held = *kdot;  // remember if dot is still held at beginning of the dash
-        gpio_set_cw(1);
         tx_queue_cw_event (1, 0);
         tx_queue_cw_event (0, dash_samples);
         tx_queue_cw_event (0, dot_samples);
-        loop_delay.tv_nsec += (dash_samples + dot_samples) * 20833;
+        kclock += dash_samples + dot_samples;
+        vox_end = kclock + 48 * cw_keyer_hang_time;
+        tx_cw_wait(kclock - KEYER_LOOKAHEAD);
         key_state = AFTERDASH;
         break;
 
@@ -597,7 +622,6 @@ static void* keyer_thread(void *arg) {
         } else if (cw_keyer_spacing) {
           dot_memory = dash_memory = 0;
           key_state = LETTERSPACE;
-          kdelay = 0;
         } else {
           key_state = EXITLOOP;
         }
@@ -606,31 +630,25 @@ static void* keyer_thread(void *arg) {
 
       case LETTERSPACE:
         // Add letter space (3 x dot delay) to end of character and check if a paddle is pressed during this time.
-        // Actually add 2 x dot_length since we already have a dot delay at the end of the character.
-        kdelay++;
-
-        if (kdelay > 2 * dot_length) {
-          if (dot_memory) {       // check if a dot or dash paddle was pressed during the delay.
-            key_state = PREDOT;
-          } else if (dash_memory) {
-            key_state = PREDASH;
-          } else { key_state = EXITLOOP; } // no memories set so restart
-        }
+        // Actually add 2 x dot delay since we already have a dot delay at the end of the character.
+        // The letter space is queued as a key-up event, so the next element starts exactly
+        // at its end.
+        tx_queue_cw_event(0, 2 * dot_samples);
+        kclock += 2 * dot_samples;
+        tx_cw_wait(kclock - KEYER_LOOKAHEAD);
+
+        if (dot_memory) {       // check if a dot or dash paddle was pressed during the delay.
+          key_state = PREDOT;
+        } else if (dash_memory) {
+          key_state = PREDASH;
+        } else { key_state = EXITLOOP; } // no memories set so restart
 
-        loop_delay.tv_nsec += 1000000;
         break;
 
       default:
         t_print("%s: unknown state=%d", __FUNCTION__, (int) key_state);
         key_state = EXITLOOP;
       }
-
-      while (loop_delay.tv_nsec >= NSEC_PER_SEC) {
-        loop_delay.tv_nsec -= NSEC_PER_SEC;
-        loop_delay.tv_sec++;
-      }
-
-      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &loop_delay, NULL);
     }
   }
 
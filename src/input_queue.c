@@ -0,0 +1,160 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+
+#include "actions.h"
+#include "input_queue.h"
+#include "message.h"
+#include "metrics.h"
+
+//
+// Bounded multi-producer ring buffer (D. Vyukov). Each slot carries a
+// sequence number: a slot with seq == pos is free for the producer that
+// claimed position pos, a slot with seq == pos + 1 is filled and can be
+// read by the consumer. There is only one consumer (the GTK main thread).
+//
+#define INPUT_QUEUE_SIZE 256   // must be a power of two
+#define INPUT_QUEUE_WAIT 20    // max. wait (msec) if the queue is full
+
+typedef struct _input_slot {
+  unsigned int seq;
+  PROCESS_ACTION a;
+} INPUT_SLOT;
+
+static INPUT_SLOT queue[INPUT_QUEUE_SIZE];
+static unsigned int queue_head = 0;   // next position to write, shared by all producers
+static unsigned int queue_tail = 0;   // next position to read, consumer only
+static gsize queue_init = 0;
+static int dispatch_pending = 0;
+
+static int input_queue_push(enum ACTION action, enum ACTION_MODE mode, int val) {
+  unsigned int pos = __atomic_load_n(&queue_head, __ATOMIC_RELAXED);
+
+  for (;;) {
+    INPUT_SLOT *slot = &queue[pos & (INPUT_QUEUE_SIZE - 1)];
+    unsigned int seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    int diff = (int)(seq - pos);
+
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&queue_head, &pos, pos + 1, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        slot->a.action = action;
+        slot->a.mode = mode;
+        slot->a.val = val;
+        __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+        return 1;
+      }
+
+      // pos has been updated by the failed compare-exchange
+    } else if (diff < 0) {
+      return 0;  // queue full
+    } else {
+      pos = __atomic_load_n(&queue_head, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+static int input_queue_pop(PROCESS_ACTION *a) {
+  INPUT_SLOT *slot = &queue[queue_tail & (INPUT_QUEUE_SIZE - 1)];
+  unsigned int seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+  if (seq != queue_tail + 1) {
+    return 0;  // queue empty
+  }
+
+  *a = slot->a;
+  __atomic_store_n(&slot->seq, queue_tail + INPUT_QUEUE_SIZE, __ATOMIC_RELEASE);
+  queue_tail++;
+  return 1;
+}
+
+static void input_queue_run(const PROCESS_ACTION *a) {
+  PROCESS_ACTION *p = g_new(PROCESS_ACTION, 1);
+  *p = *a;
+  process_action(p);  // this frees p
+}
+
+static int input_queue_dispatch(gpointer data) {
+  PROCESS_ACTION a, next;
+  int have = 0;
+  //
+  // Clear the flag before emptying the queue: an action queued
+  // from now on is either seen below, or schedules a new call.
+  //
+  __atomic_store_n(&dispatch_pending, 0, __ATOMIC_SEQ_CST);
+
+  while (input_queue_pop(&next)) {
+    if (have && a.mode == RELATIVE && next.mode == RELATIVE && a.action == next.action) {
+      a.val += next.val;
+      continue;
+    }
+
+    if (have) {
+      input_queue_run(&a);
+    }
+
+    a = next;
+    have = 1;
+  }
+
+  if (have) {
+    input_queue_run(&a);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+void input_queue_action(enum ACTION action, enum ACTION_MODE mode, int val) {
+  switch (action) {
+  case CW_LEFT:
+  case CW_RIGHT:
+  case CW_KEYER_KEYDOWN:
+    schedule_action(action, mode, val);
+    return;
+
+  default:
+    break;
+  }
+
+  if (g_once_init_enter(&queue_init)) {
+    for (unsigned int i = 0; i < INPUT_QUEUE_SIZE; i++) {
+      queue[i].seq = i;
+    }
+
+    g_once_init_leave(&queue_init, 1);
+  }
+
+  //
+  // If the queue is full (GTK main loop stalled), wait a little for the
+  // GTK thread to catch up. Then drop the action rather than executing
+  // it via schedule_action(), which could overtake actions still queued.
+  //
+  for (int wait = 0; !input_queue_push(action, mode, val); wait++) {
+    if (wait >= INPUT_QUEUE_WAIT) {
+      metric_inc(METRIC_RING_DROPS, METRIC_RING_INPUT);
+      t_print("%s: queue full, action %d dropped\n", __FUNCTION__, action);
+      return;
+    }
+
+    g_usleep(1000);
+  }
+
+  if (__atomic_exchange_n(&dispatch_pending, 1, __ATOMIC_SEQ_CST) == 0) {
+    g_idle_add(input_queue_dispatch, NULL);
+  }
+}
@@ -0,0 +1,40 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _INPUT_QUEUE_H_
+#define _INPUT_QUEUE_H_
+
+#include "actions.h"
+
+//
+// Queue for actions coming from input threads (GPIO lines, I2C switches,
+// G2 front panel). The threads put actions into a lock-free ring buffer,
+// which is emptied by a single GTK idle callback. Consecutive RELATIVE
+// actions of the same kind (encoder ticks) are merged there, so a fast
+// turning knob causes one VFO update per GTK main loop iteration, and
+// not one per tick.
+//
+// CW key and paddle events bypass the queue and go to schedule_action()
+// directly, since they must not wait for the GTK main loop. If the queue
+// stays full for some msec, further actions are dropped (and
+// counted as overflows of the "input" ring) so they cannot overtake
+// those still queued.
+//
+extern void input_queue_action(enum ACTION action, enum ACTION_MODE mode, int val);
+
+#endif
@@ -38,6 +38,7 @@
 #include "discovered.h"
 #include "ext.h"
 #include "gpio.h"
+#include "headless.h"
 #include "piHPSDR_logo.h"
 #include "main.h"
 #include "message.h"
@@ -71,10 +72,17 @@ static GdkCursor *cursor_watch;
 GtkWidget *top_window = NULL;
 GtkWidget *topgrid;
 gulong keypress_signal_id = 0;
+int headless = 0;
+int top_window_iconified = 0;
 
 static GtkWidget *status_label;
 
 void status_text(const char *text) {
+  if (headless) {
+    t_print("%s\n", text);
+    return;
+  }
+
   gtk_label_set_text(GTK_LABEL(status_label), text);
   usleep(100000);
 
@@ -103,9 +111,31 @@ static gboolean main_delete (GtkWidget *widget) {
     radio_stop_program();
   }
 
+  t_print_flush();
   _exit(0);
 }
 
+// cppcheck-suppress constParameterCallback
+static gboolean main_state(GtkWidget *widget, GdkEventWindowState *event, gpointer data) {
+  //
+  // If the main window is minimized, the receivers need not
+  // compute a spectrum for the local panadapters
+  //
+  if (event->changed_mask & GDK_WINDOW_STATE_ICONIFIED) {
+    top_window_iconified = SET(event->new_window_state & GDK_WINDOW_STATE_ICONIFIED);
+
+    if (radio != NULL && !radio_is_remote) {
+      for (int i = 0; i < receivers; i++) {
+        if (receiver[i] != NULL) {
+          rx_spectrum_local(receiver[i]);
+        }
+      }
+    }
+  }
+
+  return FALSE;
+}
+
 static int init(void *data) {
   char wisdom_directory[1025];
   char text[1024];
@@ -243,6 +273,7 @@ static void activate_pihpsdr(GtkApplication *app, gpointer data) {
   }
 
   g_signal_connect (top_window, "delete-event", G_CALLBACK (main_delete), NULL);
+  g_signal_connect (top_window, "window-state-event", G_CALLBACK (main_state), NULL);
   topgrid = gtk_grid_new();
   gtk_widget_set_size_request(topgrid, display_width[display_size], display_height[display_size]);
   gtk_grid_set_row_homogeneous(GTK_GRID(topgrid), FALSE);
@@ -318,6 +349,37 @@ int main(int argc, char **argv) {
     argc--;
   }
 
+  //
+  // If invoked with -LogFile <name>, all log messages go to that file
+  // rather than to stdout. The file is rotated when it exceeds 10 MByte,
+  // and three old versions (name.1, name.2, name.3) are kept.
+  //
+  if (argc >= 3 && !strcmp("-LogFile", argv[1])) {
+    t_print_logfile(argv[2], 10000000L, 3);
+
+    for (int i = 3; i < argc; i++) {
+      argv[i - 2] = argv[i];
+    }
+
+    argc -= 2;
+  }
+
+  //
+  // If invoked with -Headless [device], run as a server without any
+  // GUI. The radio is started from the props file, and the optional
+  // argument (IP address, MAC address, or part of the name) selects
+  // the device if more than one has been discovered.
+  //
+  if (argc >= 2 && !strcmp("-Headless", argv[1])) {
+    headless = 1;
+
+    for (int i = 2; i < argc; i++) {
+      argv[i - 1] = argv[i];
+    }
+
+    argc--;
+  }
+
   //
   // The following call will most likely fail (until this program
   // has the privileges to reduce the nice value). But if the
@@ -330,6 +392,11 @@ int main(int argc, char **argv) {
   rc = getpriority(PRIO_PROCESS, 0);
   t_print("%s: Base priority after adjustment: %d\n", __FUNCTION__, rc);
   startup(argv[0]);
+
+  if (headless) {
+    return headless_run(argc > 1 ? argv[1] : NULL);
+  }
+
   snprintf(name, sizeof(name), "org.g0orx.pihpsdr.pid%d", getpid());
   pihpsdr = gtk_application_new(name, G_APPLICATION_FLAGS_NONE);
   g_signal_connect(pihpsdr, "activate", G_CALLBACK(activate_pihpsdr), NULL);
@@ -359,6 +426,7 @@ int fatal_error(void *data) {
   }
 
   quit = 1;
+  t_print("%s: %s\n", __FUNCTION__, msg);
 
   if (top_window) {
     GtkDialogFlags flags = GTK_DIALOG_DESTROY_WITH_PARENT;
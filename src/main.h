@@ -41,9 +41,11 @@ extern int display_vfobar[6];  // Store VFO bar last used with this slot
 extern int this_monitor;
 
 extern GtkWidget *top_window;
+extern int top_window_iconified;
 extern GtkWidget *topgrid;
 extern void status_text(const char *text);
 
 extern gulong keypress_signal_id;
+extern int headless;           // run as a server without GUI
 extern int fatal_error(void *data);
 #endif
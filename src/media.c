@@ -0,0 +1,668 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// UDP media channel of the client/server model.
+//
+// With TCP, a single lost packet stalls all audio and spectrum data
+// until it has been re-transmitted, and the client has to keep a large
+// audio cushion to survive this. Through UDP, a lost audio packet is
+// simply concealed, and late packets are dropped.
+//
+// The channel is negotiated through the TCP connection:
+//
+// - the client asks for it by sending CMD_MEDIA with b1=1
+// - the server answers with CMD_MEDIA containing its UDP port and a
+//   random token that identifies this client
+// - the client sends "hello" datagrams (a CMD_MEDIA header) to this port
+//   until the server echoes one of them. From then on, the server sends
+//   RX audio and spectrum data of this client through UDP.
+// - if the client does not receive anything for some time, it falls
+//   back to TCP by sending CMD_MEDIA with b1=0.
+//
+// The client plays out RX audio through an adaptive jitter buffer,
+// whose delay follows the measured inter-arrival jitter (RFC 3550).
+//
+
+#include <gtk/gtk.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <openssl/rand.h>
+
+#include "client_server.h"
+#include "media.h"
+#include "message.h"
+#include "metrics.h"
+#include "threads.h"
+
+#define MEDIA_MAX_DATAGRAM   8192
+#define MEDIA_MAX_GAP        4          // conceal at most that many lost TX audio packets
+#define MEDIA_HELLO_MSEC     200        // hello interval until the channel works
+#define MEDIA_KEEPALIVE_MSEC 2000       // keep-alive interval (NAT bindings)
+#define MEDIA_TIMEOUT_MSEC   3000       // fall back to TCP after that time of silence
+
+//
+// Jitter buffer parameters (in usec)
+//
+#define JITTER_SLOTS        64
+#define JITTER_MIN_DELAY    20000
+#define JITTER_MAX_DELAY    250000
+#define JITTER_START_DELAY  60000
+#define JITTER_SLEW         500         // max. change of the play-out delay per packet
+#define JITTER_MAX_CONCEAL  8           // stop play-out after that many lost packets in a row
+#define JITTER_RESET        5000000     // re-start if the transit time jumps that much
+
+static double sample_usec(int64_t samples) {
+  return samples * (1000000.0 / 48000.0);
+}
+
+//
+// The sample fade used for concealment: the last packet is repeated
+// once with a linear fade-out, further missing packets are silence.
+//
+static void media_conceal(short *out, const short *last, int n, int count) {
+  for (int i = 0; i < n; i++) {
+    out[i] = count == 0 ? (short)((last[i] * (n - i)) / n) : 0;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Server side
+//
+/////////////////////////////////////////////////////////////////////////////
+
+static int server_socket = -1;
+static int server_port = 0;
+static volatile int server_running = 0;
+static GThread *server_thread_id = NULL;
+
+//
+// State of the incoming TX audio stream. Only the controlling
+// client transmits, so there is only one.
+//
+static uint32_t tx_token = 0;
+static uint32_t tx_next_seqno = 0;
+static short tx_last[AUDIO_DATA_SIZE];
+static int tx_last_n = 0;
+
+static REMOTE_CLIENT *media_find_client(uint32_t token) {
+  if (token == 0) { return NULL; }
+
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    if (remoteclient[c].running && remoteclient[c].media_token == token) {
+      return &remoteclient[c];
+    }
+  }
+
+  return NULL;
+}
+
+static void media_server_txaudio(const REMOTE_CLIENT *client, uint32_t seqno, const char *buffer, int bytes) {
+  const TXAUDIO_DATA *data = (const TXAUDIO_DATA *)buffer;
+  short samples[AUDIO_DATA_SIZE];
+  int n = from_short(data->numsamples);
+
+  if (!client->control || n <= 0 || n > AUDIO_DATA_SIZE
+      || bytes < (int)(sizeof(TXAUDIO_DATA) - (AUDIO_DATA_SIZE - n) * sizeof(uint16_t))) {
+    return;
+  }
+
+  if (client->media_token != tx_token) {
+    //
+    // New stream
+    //
+    tx_token = client->media_token;
+    tx_next_seqno = seqno;
+    tx_last_n = 0;
+  }
+
+  int gap = (int32_t)(seqno - tx_next_seqno);
+
+  if (gap < 0) {
+    // late or duplicate
+    return;
+  }
+
+  if (gap <= MEDIA_MAX_GAP) {
+    for (int i = 0; i < gap && tx_last_n > 0; i++) {
+      media_conceal(samples, tx_last, tx_last_n, i);
+      server_mic_audio(samples, tx_last_n, TRUE);
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    samples[i] = from_short(data->samples[i]);
+  }
+
+  server_mic_audio(samples, n, TRUE);
+  memcpy(tx_last, samples, n * sizeof(short));
+  tx_last_n = n;
+  tx_next_seqno = seqno + 1;
+}
+
+static gpointer media_server_thread(gpointer arg) {
+  char datagram[MEDIA_MAX_DATAGRAM];
+  struct sockaddr_in addr;
+  thread_setup(THREAD_NET, "media server");
+
+  while (server_running) {
+    socklen_t addrlen = sizeof(addr);
+    int bytes = recvfrom(server_socket, datagram, sizeof(datagram), 0, (struct sockaddr *)&addr, &addrlen);
+
+    if (bytes < (int)(sizeof(MEDIA_DATA) + sizeof(HEADER))) { continue; }
+
+    const MEDIA_DATA *media = (const MEDIA_DATA *)datagram;
+    const HEADER *header = (const HEADER *)(datagram + sizeof(MEDIA_DATA));
+
+    if (memcmp(media->sync, syncbytes, sizeof(syncbytes)) != 0) { continue; }
+
+    REMOTE_CLIENT *client = media_find_client(from_int(media->token));
+
+    if (client == NULL) { continue; }
+
+    switch (from_short(header->data_type)) {
+    case CMD_MEDIA:
+      //
+      // hello or keep-alive: (re-)register the address and echo it
+      //
+      client->media_address = addr;
+
+      if (!client->media) {
+        char s[64];
+        inet_ntop(AF_INET, &addr.sin_addr, s, sizeof(s));
+        t_print("%s: UDP media channel to client #%d at %s:%d\n", __FUNCTION__, client->seqno, s,
+                from_short(addr.sin_port) & 0xFFFF);
+        client->media = TRUE;
+      }
+
+      sendto(server_socket, datagram, bytes, 0, (struct sockaddr *)&addr, sizeof(addr));
+      break;
+
+    case INFO_TXAUDIO:
+      if (client->media && addr.sin_addr.s_addr == client->media_address.sin_addr.s_addr
+          && addr.sin_port == client->media_address.sin_port) {
+        media_server_txaudio(client, from_int(media->seqno), datagram + sizeof(MEDIA_DATA), bytes - sizeof(MEDIA_DATA));
+      }
+
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+int media_server_start(int port) {
+  struct sockaddr_in addr;
+  struct timeval timeout;
+  int on = 1;
+
+  if (server_socket >= 0) { return 0; }
+
+  server_socket = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (server_socket < 0) {
+    t_perror("media_server_start");
+    return -1;
+  }
+
+  setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  timeout.tv_sec = 0;
+  timeout.tv_usec = 100000;
+  setsockopt(server_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = INADDR_ANY;
+  addr.sin_port = to_short(port);
+
+  if (bind(server_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    t_perror("media_server_start: bind");
+    close(server_socket);
+    server_socket = -1;
+    return -1;
+  }
+
+  t_print("%s: UDP media channel on port %d\n", __FUNCTION__, port);
+  server_port = port;
+  server_running = TRUE;
+  server_thread_id = g_thread_new("media server", media_server_thread, NULL);
+  return 0;
+}
+
+void media_server_stop() {
+  if (server_socket < 0) { return; }
+
+  server_running = FALSE;
+
+  if (server_thread_id) {
+    g_thread_join(server_thread_id);
+    server_thread_id = NULL;
+  }
+
+  close(server_socket);
+  server_socket = -1;
+}
+
+//
+// Answer a CMD_MEDIA request of the client. If the channel is refused
+// (or given up by the client), data goes through TCP again.
+//
+void media_offer(REMOTE_CLIENT *client, int want) {
+  uint32_t token = 0;
+  client->media = FALSE;
+
+  if (want && server_socket >= 0) {
+    while (token == 0) {
+      if (RAND_bytes((unsigned char *)&token, sizeof(token)) != 1) { break; }
+    }
+  }
+
+  client->media_token = token;
+  memset(client->media_seqno, 0, sizeof(client->media_seqno));
+  t_print("%s: client #%d UDP media %s\n", __FUNCTION__, client->seqno, token ? "offered" : "off");
+  send_media(client->socket, token != 0, server_port, token);
+}
+
+int media_send(REMOTE_CLIENT *client, int stream, uint32_t timestamp, const char *buffer, int bytes) {
+  char datagram[MEDIA_MAX_DATAGRAM];
+  MEDIA_DATA *media = (MEDIA_DATA *)datagram;
+
+  if (server_socket < 0 || !client->media || bytes > MEDIA_MAX_DATAGRAM - (int)sizeof(MEDIA_DATA)) { return -1; }
+
+  SYNC(media->sync);
+  media->token = to_int(client->media_token);
+  media->seqno = to_int(client->media_seqno[stream]++);
+  media->timestamp = to_int(timestamp);
+  memcpy(datagram + sizeof(MEDIA_DATA), buffer, bytes);
+  int rc = sendto(server_socket, datagram, sizeof(MEDIA_DATA) + bytes, MSG_DONTWAIT,
+                  (struct sockaddr *)&client->media_address, sizeof(client->media_address));
+
+  if (rc > 0) { metric_add(METRIC_REMOTE_BYTES, 0, rc); }
+
+  return rc;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Client side
+//
+/////////////////////////////////////////////////////////////////////////////
+
+int remote_media = 0;
+
+static int client_udp = -1;
+static uint32_t client_token = 0;
+static volatile int client_media_running = 0;
+static volatile int client_media_ok = 0;
+static GThread *client_media_thread_id = NULL;
+static uint32_t client_tx_seqno = 0;
+static uint32_t client_tx_timestamp = 0;
+static uint32_t spectrum_seqno[MEDIA_STREAMS];
+static int spectrum_valid[MEDIA_STREAMS];
+
+//
+// Adaptive jitter buffer for the RX audio of one receiver.
+// All times are in usec. The "transit time" of a packet is its arrival
+// time minus its time stamp, and thus contains an unknown constant offset.
+// A packet is played at its time stamp plus "offset", which is kept at
+// (minimum transit time) + (target delay).
+//
+typedef struct _jitter_buffer {
+  int init;
+  int active;                          // play-out is running
+  uint32_t ts_last;                    // for extending the time stamps to 64 bit
+  int64_t ts_ext;
+  uint32_t next_seqno;                 // next packet to be played
+  int64_t next_ts;
+  int concealed;                       // lost packets in a row
+  double jitter;
+  double base;                         // minimum transit time
+  double last_transit;
+  double delay;                        // target delay
+  double offset;                       // current play-out offset
+  int valid[JITTER_SLOTS];
+  uint32_t seqno[JITTER_SLOTS];
+  int numsamples[JITTER_SLOTS];
+  short samples[JITTER_SLOTS][2 * MEDIA_AUDIO_FRAMES];
+  short last[2 * MEDIA_AUDIO_FRAMES];
+  int last_n;
+} JITTER_BUFFER;
+
+static JITTER_BUFFER jitter_buffer[2];
+
+static void jitter_reset(JITTER_BUFFER *jb, uint32_t ts, double transit) {
+  jb->init = 1;
+  jb->active = 0;
+  jb->ts_last = ts;
+  jb->ts_ext = ts;
+  jb->jitter = 0.0;
+  jb->base = transit;
+  jb->last_transit = transit;
+  jb->delay = JITTER_START_DELAY;
+  jb->last_n = 0;
+  memset(jb->valid, 0, sizeof(jb->valid));
+}
+
+static void jitter_put(int id, uint32_t seqno, uint32_t ts, const short *samples, int n, int64_t now) {
+  JITTER_BUFFER *jb = &jitter_buffer[id];
+  int64_t ext = jb->ts_ext + (int32_t)(ts - jb->ts_last);
+  double transit = now - sample_usec(ext);
+
+  if (!jb->init || fabs(transit - jb->last_transit) > JITTER_RESET
+      || (jb->active && (int32_t)(seqno - jb->next_seqno) >= JITTER_SLOTS)) {
+    jitter_reset(jb, ts, now - sample_usec(ts));
+    ext = ts;
+    transit = jb->last_transit;
+  } else {
+    double d = fabs(transit - jb->last_transit);
+    jb->jitter += (d - jb->jitter) / 16.0;
+
+    if (transit < jb->base) {
+      jb->base = transit;
+    } else {
+      // forget old minima slowly (clock drift)
+      jb->base += (transit - jb->base) / 1000.0;
+    }
+
+    jb->last_transit = transit;
+  }
+
+  if (ext > jb->ts_ext) {
+    jb->ts_ext = ext;
+    jb->ts_last = ts;
+  }
+
+  double delay = 3.0 * jb->jitter + sample_usec(MEDIA_AUDIO_FRAMES);
+
+  if (delay < JITTER_MIN_DELAY) { delay = JITTER_MIN_DELAY; }
+
+  if (delay > JITTER_MAX_DELAY) { delay = JITTER_MAX_DELAY; }
+
+  if (!jb->active) {
+    jb->active = 1;
+    jb->concealed = 0;
+    jb->next_seqno = seqno;
+    jb->next_ts = ext;
+    jb->offset = jb->base + jb->delay;
+  } else {
+    double want = jb->base + delay;
+
+    if (want > jb->offset + JITTER_SLEW) {
+      jb->offset += JITTER_SLEW;
+    } else if (want < jb->offset - JITTER_SLEW) {
+      jb->offset -= JITTER_SLEW;
+    } else {
+      jb->offset = want;
+    }
+  }
+
+  jb->delay = delay;
+  metric_set(METRIC_MEDIA_JITTER, id, (int64_t) jb->jitter);
+  metric_set(METRIC_MEDIA_DELAY, id, (int64_t)(jb->offset - jb->base));
+
+  if ((int32_t)(seqno - jb->next_seqno) < 0) {
+    metric_inc(METRIC_MEDIA_LATE, id);
+    return;
+  }
+
+  int slot = seqno % JITTER_SLOTS;
+  jb->valid[slot] = 1;
+  jb->seqno[slot] = seqno;
+  jb->numsamples[slot] = n;
+  memcpy(jb->samples[slot], samples, 2 * n * sizeof(short));
+}
+
+//
+// Play all packets that are due
+//
+static void jitter_play(int id, int64_t now) {
+  JITTER_BUFFER *jb = &jitter_buffer[id];
+
+  while (jb->active && now >= jb->offset + sample_usec(jb->next_ts)) {
+    int slot = jb->next_seqno % JITTER_SLOTS;
+    int n;
+
+    if (jb->valid[slot] && jb->seqno[slot] == jb->next_seqno) {
+      n = jb->numsamples[slot];
+      client_rxaudio(id, jb->samples[slot], n);
+      memcpy(jb->last, jb->samples[slot], 2 * n * sizeof(short));
+      jb->last_n = n;
+      jb->concealed = 0;
+    } else {
+      if (jb->concealed >= JITTER_MAX_CONCEAL || jb->last_n == 0) {
+        //
+        // The stream has stopped (or is interrupted for a long time).
+        // Play-out continues with the next packet that arrives.
+        //
+        jb->active = 0;
+        break;
+      }
+
+      short samples[2 * MEDIA_AUDIO_FRAMES];
+      metric_inc(METRIC_MEDIA_LOST, id);
+      media_conceal(samples, jb->last, 2 * jb->last_n, jb->concealed);
+      client_rxaudio(id, samples, jb->last_n);
+      n = jb->last_n;
+      jb->concealed++;
+    }
+
+    jb->valid[slot] = 0;
+    jb->next_seqno++;
+    jb->next_ts += n;
+  }
+}
+
+static void media_client_hello() {
+  struct __attribute__((__packed__)) {
+    MEDIA_DATA media;
+    HEADER header;
+  } hello;
+  memset(&hello, 0, sizeof(hello));
+  SYNC(hello.media.sync);
+  hello.media.token = to_int(client_token);
+  SYNC(hello.header.sync);
+  hello.header.data_type = to_short(CMD_MEDIA);
+  send(client_udp, (char *)&hello, sizeof(hello), MSG_DONTWAIT);
+}
+
+static gpointer media_client_thread(gpointer arg) {
+  char datagram[MEDIA_MAX_DATAGRAM];
+  int64_t last_rx = metric_start();
+  int64_t last_hello = 0;
+  thread_setup(THREAD_NET, "media client");
+
+  while (client_media_running) {
+    int bytes = recv(client_udp, datagram, sizeof(datagram), 0);
+    int64_t now = metric_start();
+
+    if (bytes >= (int)(sizeof(MEDIA_DATA) + sizeof(HEADER))) {
+      const MEDIA_DATA *media = (const MEDIA_DATA *)datagram;
+      const HEADER *header = (const HEADER *)(datagram + sizeof(MEDIA_DATA));
+
+      if (memcmp(media->sync, syncbytes, sizeof(syncbytes)) == 0 && from_int(media->token) == client_token) {
+        uint32_t seqno = from_int(media->seqno);
+        last_rx = now;
+
+        if (!client_media_ok) {
+          t_print("%s: UDP media channel established\n", __FUNCTION__);
+          client_media_ok = 1;
+        }
+
+        switch (from_short(header->data_type)) {
+        case INFO_RXAUDIO: {
+          const RXAUDIO_DATA *data = (const RXAUDIO_DATA *)header;
+          short samples[2 * MEDIA_AUDIO_FRAMES];
+          int n = from_short(data->numsamples);
+
+          if (data->rx >= 2 || n <= 0 || n > MEDIA_AUDIO_FRAMES
+              || bytes < (int)(sizeof(MEDIA_DATA) + sizeof(RXAUDIO_DATA) - 2 * (AUDIO_DATA_SIZE - n) * sizeof(uint16_t))) {
+            break;
+          }
+
+          for (int i = 0; i < 2 * n; i++) {
+            samples[i] = from_short(data->samples[i]);
+          }
+
+          jitter_put(data->rx, seqno, from_int(media->timestamp), samples, n, now);
+        }
+        break;
+
+        case INFO_RX_SPECTRUM:
+        case INFO_TX_SPECTRUM: {
+          const SPECTRUM_DATA *data = (const SPECTRUM_DATA *)header;
+          int type = from_short(header->data_type);
+          int stream = (type == INFO_TX_SPECTRUM) ? MEDIA_STREAM_TXSPECTRUM : MEDIA_STREAM_RXSPECTRUM(data->id & 7);
+          int width = from_short(data->width);
+
+          if (width < 0 || width > SPECTRUM_DATA_SIZE
+              || bytes < (int)(sizeof(MEDIA_DATA) + sizeof(SPECTRUM_DATA) - SPECTRUM_DATA_SIZE + width)) {
+            break;
+          }
+
+          //
+          // Only show spectra newer than the last one
+          //
+          if (spectrum_valid[stream] && (int32_t)(seqno - spectrum_seqno[stream]) <= 0) { break; }
+
+          spectrum_valid[stream] = 1;
+          spectrum_seqno[stream] = seqno;
+          client_spectrum(type, data);
+        }
+        break;
+        }
+      }
+    }
+
+    for (int id = 0; id < 2; id++) {
+      jitter_play(id, now);
+    }
+
+    if (now - last_hello > 1000LL * (client_media_ok ? MEDIA_KEEPALIVE_MSEC : MEDIA_HELLO_MSEC)) {
+      media_client_hello();
+      last_hello = now;
+    }
+
+    if (now - last_rx > 1000LL * MEDIA_TIMEOUT_MSEC) {
+      //
+      // Nothing arrives (blocked by a firewall, or the server is gone).
+      // Tell the server to use TCP again.
+      //
+      t_print("%s: no UDP data, falling back to TCP\n", __FUNCTION__);
+      client_media_ok = 0;
+      send_media(client_socket, 0, 0, 0);
+      break;
+    }
+  }
+
+  client_media_ok = 0;
+  return NULL;
+}
+
+int media_client_start(int tcp_socket, int port, uint32_t token) {
+  struct sockaddr_in addr;
+  socklen_t addrlen = sizeof(addr);
+  struct timeval timeout;
+  media_client_stop();
+
+  //
+  // The server's address is that of the TCP connection
+  //
+  if (getpeername(tcp_socket, (struct sockaddr *)&addr, &addrlen) < 0) {
+    t_perror("media_client_start: getpeername");
+    return -1;
+  }
+
+  addr.sin_port = to_short(port);
+  client_udp = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (client_udp < 0) {
+    t_perror("media_client_start: socket");
+    return -1;
+  }
+
+  timeout.tv_sec = 0;
+  timeout.tv_usec = 5000;
+  setsockopt(client_udp, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  if (connect(client_udp, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    t_perror("media_client_start: connect");
+    close(client_udp);
+    client_udp = -1;
+    return -1;
+  }
+
+  client_token = token;
+  client_tx_seqno = 0;
+  client_tx_timestamp = 0;
+  memset(jitter_buffer, 0, sizeof(jitter_buffer));
+  memset(spectrum_valid, 0, sizeof(spectrum_valid));
+  client_media_running = 1;
+  client_media_thread_id = g_thread_new("media client", media_client_thread, NULL);
+  return 0;
+}
+
+void media_client_stop() {
+  client_media_running = 0;
+  client_media_ok = 0;
+
+  if (client_media_thread_id) {
+    g_thread_join(client_media_thread_id);
+    client_media_thread_id = NULL;
+  }
+
+  if (client_udp >= 0) {
+    close(client_udp);
+    client_udp = -1;
+  }
+}
+
+int media_client_active() {
+  return client_media_ok;
+}
+
+//
+// Send TX audio. The samples are already in network byte order.
+//
+void media_client_txaudio(const void *samples, int numsamples) {
+  char datagram[sizeof(MEDIA_DATA) + sizeof(TXAUDIO_DATA)];
+  MEDIA_DATA *media = (MEDIA_DATA *)datagram;
+  TXAUDIO_DATA *data = (TXAUDIO_DATA *)(datagram + sizeof(MEDIA_DATA));
+
+  if (!client_media_ok || numsamples > AUDIO_DATA_SIZE) { return; }
+
+  SYNC(media->sync);
+  media->token = to_int(client_token);
+  media->seqno = to_int(client_tx_seqno++);
+  media->timestamp = to_int(client_tx_timestamp);
+  client_tx_timestamp += numsamples;
+  memset(&data->header, 0, sizeof(HEADER));
+  SYNC(data->header.sync);
+  data->header.data_type = to_short(INFO_TXAUDIO);
+  data->rx = 0;
+  data->numsamples = to_short(numsamples);
+  memcpy(data->samples, samples, numsamples * sizeof(uint16_t));
+  int bytes = sizeof(MEDIA_DATA) + sizeof(TXAUDIO_DATA) - (AUDIO_DATA_SIZE - numsamples) * sizeof(uint16_t);
+
+  if (send(client_udp, datagram, bytes, MSG_DONTWAIT) < 0) {
+    t_perror("media_client_txaudio");
+  }
+}
@@ -0,0 +1,50 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _MEDIA_H_
+#define _MEDIA_H_
+
+#include <stdint.h>
+
+#include "client_server.h"
+
+//
+// Optional UDP channel for RX audio, spectrum and TX audio of the
+// client/server model. It is negotiated through the TCP connection
+// (CMD_MEDIA), all control data still goes through TCP.
+//
+
+//
+// Server side
+//
+extern int  media_server_start(int port);
+extern void media_server_stop(void);
+extern void media_offer(REMOTE_CLIENT *client, int want);
+extern int  media_send(REMOTE_CLIENT *client, int stream, uint32_t timestamp, const char *buffer, int bytes);
+
+//
+// Client side. remote_media is the user's choice whether the UDP channel
+// should be used, media_client_active() tells whether it actually works.
+//
+extern int  remote_media;
+extern int  media_client_start(int tcp_socket, int port, uint32_t token);
+extern void media_client_stop(void);
+extern int  media_client_active(void);
+extern void media_client_txaudio(const void *samples, int numsamples);
+
+#endif
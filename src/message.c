@@ -31,41 +31,384 @@
  * Note ALL messages of the program should go through these two functions
  * so it is easy to either silence them completely, or routing them to
  * a separate window for debugging purposes.
+ *
+ * Since t_print() is also called from real-time threads (e.g. when the
+ * protocol receive threads report sequence errors), it must never block.
+ * The line is formatted into a slot of a lock-free ring buffer (multiple
+ * producers, single consumer), and a dedicated writer thread does the
+ * actual output. If the ring buffer is full, the message is dropped
+ * (and the number of dropped messages is reported later).
+ *
+ * Rate limiting: each call site (identified by the return address of
+ * t_print/t_perror) may produce LOG_BURST lines within LOG_WINDOW seconds
+ * if it has already been that busy in the previous window, else up to
+ * LOG_LISTING lines (so that one-time listings are not truncated).
+ * Further lines are only counted (not even formatted), and the writer
+ * thread reports the count when the window expires, e.g.
+ *
+ *   SEQ ERROR: ... [+312 similar in last 1s]
+ *
+ * t_print_logfile() re-directs the output to a file which is rotated
+ * when it exceeds a given size. t_print_flush() waits until all
+ * messages queued so far have been written.
  */
 
 #include <gdk/gdk.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <stdio.h>
 
-void t_print(const gchar *format, ...) {
-  va_list(args);
-  va_start(args, format);
+#define LOG_SLOTS    256       // size of the ring buffer, must be a power of two
+#define LOG_LINE_LEN 1024      // max. length of a line
+#define LOG_SITES    256       // size of call site table, must be a power of two
+#define LOG_BURST    20        // max. lines per call site within one window
+#define LOG_LISTING  128       // same, if the call site was quiet in the previous window
+#define LOG_WINDOW   1.0       // rate-limiting window (seconds)
+
+typedef struct _log_slot {
+  gint seq;                    // sequence number for the lock-free protocol
+  int site;                    // index into call site table
+  gint gen;                    // generation of the call site table entry
+  double time;                 // time stamp
+  char line[LOG_LINE_LEN];
+} LOG_SLOT;
+
+typedef struct _log_site {
+  gpointer caller;             // call site owning this entry
+  gint gen;                    // incremented when another call site takes over
+  gint window;                 // number of the current rate-limiting window
+  gint count;                  // lines from this call site in the current window
+  gint flooding;               // call site has been busy in the previous window
+  gint suppressed;             // lines suppressed in the current window
+} LOG_SITE;
+
+static LOG_SLOT log_ring[LOG_SLOTS];
+static gint log_head = 0;      // next slot to be claimed by a producer
+static guint log_tail = 0;     // next slot to be written (writer thread only)
+static gint log_claimed = 0;   // number of slots claimed by producers
+static gint log_written = 0;   // number of slots processed by the writer thread
+static gint log_dropped = 0;   // lines dropped since the ring buffer was full
+
+static LOG_SITE log_site[LOG_SITES];
+static char log_site_last[LOG_SITES][LOG_LINE_LEN];  // writer thread only
+static gint log_site_gen[LOG_SITES];                 // writer thread only
+
+static double starttime;
+static GThread *log_thread_id = NULL;
+
+static GMutex log_file_mutex;
+static FILE *log_file = NULL;
+static char log_file_name[PATH_MAX];
+static long log_file_maxsize = 0;
+static int log_file_keep = 0;
+
+static double log_now() {
   struct timespec ts;
-  double now;
-  static double starttime;
-  static int first = 1;
-  char line[1024];
   clock_gettime(CLOCK_MONOTONIC, &ts);
-  now = ts.tv_sec + 1E-9 * ts.tv_nsec;
+  return ts.tv_sec + 1E-9 * ts.tv_nsec;
+}
+
+//
+// Rotate log files: name.(n-1) -> name.n, ..., name -> name.1
+// and re-open name. Must be called with log_file_mutex locked.
+//
+static void log_rotate() {
+  char from[PATH_MAX + 16];
+  char to[PATH_MAX + 16];
+  fclose(log_file);
 
-  if (first) {
-    first = 0;
-    starttime = now;
+  for (int i = log_file_keep - 1; i >= 1; i--) {
+    snprintf(from, sizeof(from), "%s.%d", log_file_name, i);
+    snprintf(to, sizeof(to), "%s.%d", log_file_name, i + 1);
+    rename(from, to);
   }
 
+  if (log_file_keep > 0) {
+    snprintf(to, sizeof(to), "%s.1", log_file_name);
+    rename(log_file_name, to);
+  }
+
+  log_file = fopen(log_file_name, "w");
+}
+
+static void log_output(double t, const char *line) {
   //
   // After 11 days, the time reaches 999999.999 so we simply wrap around
   //
-  if (now - starttime >= 999999.995) { starttime += 1000000.0; }
+  t -= starttime;
+
+  while (t >= 999999.995) { t -= 1000000.0; }
+
+  g_mutex_lock(&log_file_mutex);
+
+  if (log_file) {
+    fprintf(log_file, "%10.3f %s", t, line);
+    fflush(log_file);
+
+    if (log_file_maxsize > 0 && ftell(log_file) > log_file_maxsize) {
+      log_rotate();
+    }
+  } else {
+    //
+    // g_print() seems to be thread-safe but call it only ONCE.
+    //
+    g_print("%10.3f %s", t, line);
+  }
+
+  g_mutex_unlock(&log_file_mutex);
+}
+
+//
+// Report suppressed lines of all call sites whose window has expired.
+// Called from the writer thread only.
+//
+static void log_report_suppressed(double now) {
+  gint window = (gint)(now / LOG_WINDOW);
+
+  for (int i = 0; i < LOG_SITES; i++) {
+    LOG_SITE *site = &log_site[i];
+    gint suppressed = g_atomic_int_get(&site->suppressed);
+
+    if (suppressed > 0 && g_atomic_int_get(&site->window) != window) {
+      char line[LOG_LINE_LEN + 64];
+      int len;
+
+      if (log_site_gen[i] != g_atomic_int_get(&site->gen)) {
+        //
+        // The last line seen is from the previous owner of this entry
+        //
+        log_site_gen[i] = g_atomic_int_get(&site->gen);
+        snprintf(log_site_last[i], LOG_LINE_LEN, "t_print: lines suppressed");
+      }
+
+      len = strlen(log_site_last[i]);
+
+      while (len > 0 && log_site_last[i][len - 1] == '\n') { len--; }
+
+      g_atomic_int_add(&site->suppressed, -suppressed);
+      snprintf(line, sizeof(line), "%.*s [+%d similar in last %.0fs]\n",
+               len, log_site_last[i], suppressed, LOG_WINDOW);
+      log_output(now, line);
+    }
+  }
+}
+
+//
+// Write all pending lines. Called from the writer thread only.
+// Returns the number of lines processed.
+//
+static int log_drain() {
+  int n = 0;
+
+  for (;;) {
+    LOG_SLOT *slot = &log_ring[log_tail & (LOG_SLOTS - 1)];
+
+    if ((gint)((guint)g_atomic_int_get(&slot->seq) - (log_tail + 1)) < 0) {
+      break;  // ring buffer empty
+    }
+
+    log_output(slot->time, slot->line);
+    memcpy(log_site_last[slot->site], slot->line, sizeof(slot->line));
+    log_site_gen[slot->site] = slot->gen;
+    g_atomic_int_set(&slot->seq, (gint)(log_tail + LOG_SLOTS));
+    log_tail++;
+    g_atomic_int_inc(&log_written);
+    n++;
+  }
+
+  gint dropped = g_atomic_int_get(&log_dropped);
+
+  if (dropped > 0) {
+    char line[128];
+    g_atomic_int_add(&log_dropped, -dropped);
+    snprintf(line, sizeof(line), "t_print: %d messages dropped (log buffer full)\n", dropped);
+    log_output(log_now(), line);
+  }
+
+  return n;
+}
+
+static gpointer log_writer_thread(gpointer data) {
+  int idle = 0;
+
+  for (;;) {
+    if (log_drain() > 0) {
+      idle = 0;
+    } else if (idle < 20) {
+      idle++;
+    }
+
+    log_report_suppressed(log_now());
+    //
+    // Producers must not make system calls, so they do not wake up
+    // the writer thread. Instead, the ring buffer is polled quickly
+    // after activity, and slowly (about 100 msec) if there is none.
+    //
+    g_usleep(5000 * idle + 1000);
+  }
+
+  return NULL;
+}
+
+void t_print_flush() {
+  //
+  // Wait (at most 500 msec) until the writer thread has processed
+  // all messages queued so far.
+  //
+  if (log_thread_id == NULL) { return; }
+
+  gint target = g_atomic_int_get(&log_claimed);
+
+  for (int i = 0; i < 100; i++) {
+    if (g_atomic_int_get(&log_written) - target >= 0) { break; }
+
+    g_usleep(5000);
+  }
+}
+
+static void log_init() {
+  static gsize initialized = 0;
+
+  if (g_once_init_enter(&initialized)) {
+    starttime = log_now();
+
+    for (int i = 0; i < LOG_SLOTS; i++) {
+      log_ring[i].seq = i;
+    }
+
+    g_mutex_init(&log_file_mutex);
+    log_thread_id = g_thread_new("t_print", log_writer_thread, NULL);
+    atexit(t_print_flush);
+    g_once_init_leave(&initialized, 1);
+  }
+}
+
+//
+// Returns the call site table index for caller, or -1 if
+// the line is to be suppressed.
+//
+static int log_rate_limit(gpointer caller, double now) {
+  int i = (((uintptr_t)caller >> 2) ^ ((uintptr_t)caller >> 10)) & (LOG_SITES - 1);
+  LOG_SITE *site = &log_site[i];
+  gint window = (gint)(now / LOG_WINDOW);
+  gpointer owner = g_atomic_pointer_get(&site->caller);
+
+  if (owner != caller) {
+    //
+    // Take over this entry. On a (rare) hash collision of two
+    // simultaneously active call sites, the rate limiting becomes
+    // somewhat inaccurate but nothing worse happens. The count of
+    // suppressed lines and the last line seen (in the writer thread,
+    // through the generation) are reset.
+    //
+    g_atomic_pointer_compare_and_exchange(&site->caller, owner, caller);
+    g_atomic_int_inc(&site->gen);
+    g_atomic_int_set(&site->suppressed, 0);
+    g_atomic_int_set(&site->window, window);
+    g_atomic_int_set(&site->count, 0);
+    g_atomic_int_set(&site->flooding, 0);
+  } else if (g_atomic_int_get(&site->window) != window) {
+    g_atomic_int_set(&site->flooding, g_atomic_int_get(&site->window) == window - 1 &&
+                     g_atomic_int_get(&site->count) >= LOG_BURST);
+    g_atomic_int_set(&site->window, window);
+    g_atomic_int_set(&site->count, 0);
+  }
+
+  if (g_atomic_int_add(&site->count, 1) >= (g_atomic_int_get(&site->flooding) ? LOG_BURST : LOG_LISTING)) {
+    g_atomic_int_inc(&site->suppressed);
+    return -1;
+  }
+
+  return i;
+}
+
+static void log_vprint(gpointer caller, const gchar *format, va_list args) {
+  double now;
+  int site;
+  guint pos;
+  LOG_SLOT *slot;
+  log_init();
+  now = log_now();
+  site = log_rate_limit(caller, now);
+
+  if (site < 0) { return; }
 
+  //
+  // Claim a slot in the ring buffer (lock-free)
+  //
+  pos = (guint) g_atomic_int_get(&log_head);
+
+  for (;;) {
+    slot = &log_ring[pos & (LOG_SLOTS - 1)];
+    gint diff = (gint)((guint)g_atomic_int_get(&slot->seq) - pos);
+
+    if (diff == 0) {
+      if (g_atomic_int_compare_and_exchange(&log_head, (gint)pos, (gint)(pos + 1))) {
+        break;
+      }
+    } else if (diff < 0) {
+      //
+      // ring buffer full: drop this message
+      //
+      g_atomic_int_inc(&log_dropped);
+      return;
+    }
+
+    pos = (guint) g_atomic_int_get(&log_head);
+  }
+
+  g_atomic_int_inc(&log_claimed);
+  slot->site = site;
+  slot->gen = g_atomic_int_get(&log_site[site].gen);
+  slot->time = now;
+  vsnprintf(slot->line, sizeof(slot->line), format, args);
+  g_atomic_int_set(&slot->seq, (gint)(pos + 1));
+}
+
+//
+// The call site is the caller of t_print/t_perror, not the format string,
+// since many call sites share the same format (e.g. "%s: %s\n")
+//
+void t_print(const gchar *format, ...) {
+  va_list(args);
   //
   // We have to use vsnprintf to handle the varargs stuff
-  // g_print() seems to be thread-safe but call it only ONCE.
   //
-  vsnprintf(line, sizeof(line), format, args);
-  g_print("%10.3f %s", now - starttime, line);
+  va_start(args, format);
+  log_vprint(__builtin_return_address(0), format, args);
+  va_end(args);
+}
+
+static void log_print(gpointer caller, const gchar *format, ...) {
+  va_list(args);
+  va_start(args, format);
+  log_vprint(caller, format, args);
+  va_end(args);
 }
 
 void t_perror(const gchar *string) {
-  t_print("%s: %s\n", string, strerror(errno));
+  log_print(__builtin_return_address(0), "%s: %s\n", string, strerror(errno));
+}
+
+void t_print_logfile(const char *filename, long maxsize, int keep) {
+  log_init();
+  g_mutex_lock(&log_file_mutex);
+
+  if (log_file) {
+    fclose(log_file);
+    log_file = NULL;
+  }
+
+  if (filename != NULL) {
+    snprintf(log_file_name, sizeof(log_file_name), "%s", filename);
+    log_file_maxsize = maxsize;
+    log_file_keep = keep;
+    log_file = fopen(log_file_name, "a");
+  }
+
+  g_mutex_unlock(&log_file_mutex);
+
+  if (filename != NULL && log_file == NULL) {
+    t_perror("t_print_logfile");
+  }
 }
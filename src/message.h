@@ -32,7 +32,11 @@
 #ifdef TPRINTDEBUG
   #define t_print printf
   #define t_perror perror
+  #define t_print_flush()
+  #define t_print_logfile(name, size, keep)
 #else
   extern void t_print(const gchar *format, ...);
   extern void t_perror(const gchar *string);
+  extern void t_print_flush(void);
+  extern void t_print_logfile(const char *filename, long maxsize, int keep);
 #endif
@@ -104,12 +104,19 @@ void meter_update(RECEIVER *rx, int meter_type, double value, double alc, double
   double rxlvl;   // only used for RX input level, clones "value"
   double pwr;     // only used for TX power, clones "value"
   char sf[32];
-  cairo_t *cr = cairo_create (meter_surface);
+  cairo_t *cr;
   int txvfo = vfo_get_tx_vfo();
   int txmode = vfo[txvfo].mode;
   int cwmode = (txmode == modeCWU || txmode == modeCWL);
   const BAND *band = band_get_band(vfo[txvfo].band);
 
+  if (meter_surface == NULL) {
+    // no meter on screen (yet), or running headless
+    return;
+  }
+
+  cr = cairo_create (meter_surface);
+
   //
   // First, do all the work that  does not depend on whether the
   // meter is analog or digital.
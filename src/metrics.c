@@ -0,0 +1,493 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Runtime metrics registry
+//
+// The metrics are updated by the protocol threads, the RX/TX engines,
+// the audio modules, TCI and rigctl. They can be read out
+//
+// - in the "Metrics" menu
+// - via the CAT command ZZXM (see rigctl.c)
+// - via a (local) HTTP endpoint in the Prometheus text format,
+//   e.g. "curl http://127.0.0.1:9110/metrics"
+//
+// Histograms are accumulated in micro-seconds but exported in seconds
+// as required by Prometheus.
+//
+
+#include <gtk/gtk.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "message.h"
+#include "metrics.h"
+#include "property.h"
+#include "recorder.h"
+#include "send_queue.h"
+
+METRIC_VALUE metric_value[METRIC_NUM][METRIC_MAX_INST];
+
+int metrics_http_enable = 0;
+int metrics_http_port = 9110;
+
+typedef struct _metric_info {
+  const char *name;
+  const char *help;
+  int type;
+  const char *label;            // label name, NULL if only one instance
+  int ninst;                    // number of instances
+} METRIC_INFO;
+
+static const METRIC_INFO metric_info[METRIC_NUM] = {
+  {"pihpsdr_packets_received_total",   "Packets received from the radio",         METRIC_COUNTER,   NULL,   1},
+  {"pihpsdr_sequence_errors_total",    "Sequence errors in packets from the radio", METRIC_COUNTER, NULL,   1},
+  {"pihpsdr_p2_network_buffers",       "Number of P2 network buffers allocated",  METRIC_GAUGE,     NULL,   1},
+  {"pihpsdr_ring_fill_percent",        "Fill level of ring buffers",              METRIC_GAUGE,     "ring", METRIC_RING_NUM},
+  {"pihpsdr_ring_overflows_total",     "Overflows of ring buffers",               METRIC_COUNTER,   "ring", METRIC_RING_NUM},
+  {"pihpsdr_rx_iq_samples_total",      "IQ samples fed into the RX engine",       METRIC_COUNTER,   "rx",   4},
+  {"pihpsdr_rx_exchange_errors_total", "fexchange0 errors in the RX engine",      METRIC_COUNTER,   "rx",   4},
+  {"pihpsdr_rx_exchange_seconds",      "fexchange0 execution time (RX)",          METRIC_HISTOGRAM, "rx",   4},
+  {"pihpsdr_rx_spectrum_seconds",      "Spectrum0 execution time (RX)",           METRIC_HISTOGRAM, "rx",   4},
+  {"pihpsdr_tx_exchange_seconds",      "fexchange0 execution time (TX)",          METRIC_HISTOGRAM, NULL,   1},
+  {"pihpsdr_tx_exchange_errors_total", "fexchange0 errors in the TX engine",      METRIC_COUNTER,   NULL,   1},
+  {"pihpsdr_audio_underruns_total",    "Underruns of the local audio output",     METRIC_COUNTER,   "rx",   4},
+  {"pihpsdr_mic_overruns_total",       "Overruns of the local microphone input",  METRIC_COUNTER,   NULL,   1},
+  {"pihpsdr_tci_messages_total",       "TCI messages processed",                  METRIC_COUNTER,   NULL,   1},
+  {"pihpsdr_cat_commands_total",       "CAT commands processed",                  METRIC_COUNTER,   NULL,   1},
+  {"pihpsdr_record_bytes_total",       "Bytes written by the recorder",           METRIC_COUNTER,   "stream", RECORD_STREAMS},
+  {"pihpsdr_record_drops_total",       "Samples dropped by the recorder",         METRIC_COUNTER,   "stream", RECORD_STREAMS},
+  {"pihpsdr_remote_queued_bytes",      "Bytes queued for the remote client",      METRIC_GAUGE,     "queue", SEND_PRIO_NUM},
+  {"pihpsdr_remote_drops_total",       "Packets to the remote client dropped",    METRIC_COUNTER,   "queue", SEND_PRIO_NUM},
+  {"pihpsdr_remote_sent_bytes_total",  "Bytes sent to the remote client",         METRIC_COUNTER,   NULL,   1},
+  {"pihpsdr_remote_queue_seconds",     "Queueing time of packets to the remote client", METRIC_HISTOGRAM, NULL, 1},
+  {"pihpsdr_remote_rtt_usec",          "Round trip time to the remote client",    METRIC_GAUGE,     NULL,   1},
+  {"pihpsdr_media_lost_total",         "UDP audio packets lost",                  METRIC_COUNTER,   "rx",   2},
+  {"pihpsdr_media_late_total",         "UDP audio packets arriving too late",     METRIC_COUNTER,   "rx",   2},
+  {"pihpsdr_media_jitter_usec",        "UDP audio inter-arrival jitter",          METRIC_GAUGE,     "rx",   2},
+  {"pihpsdr_media_delay_usec",         "UDP audio jitter buffer delay",           METRIC_GAUGE,     "rx",   2}
+};
+
+//
+// All instances of a metric must fit into its row of metric_value,
+// else the update functions silently drop the upper instances
+//
+_Static_assert(METRIC_RING_NUM <= METRIC_MAX_INST, "METRIC_MAX_INST too small for the ring metrics");
+_Static_assert(RECORD_STREAMS <= METRIC_MAX_INST, "METRIC_MAX_INST too small for the recorder metrics");
+_Static_assert(SEND_PRIO_NUM <= METRIC_MAX_INST, "METRIC_MAX_INST too small for the remote queue metrics");
+_Static_assert(4 <= METRIC_MAX_INST, "METRIC_MAX_INST too small for the receiver metrics");
+
+static const char *metric_ring_name[METRIC_RING_NUM] = {
+  "p1_rx", "p1_tx", "p2_ddc0", "p2_ddc1", "p2_ddc2", "p2_ddc3",
+  "p2_ddc4", "p2_ddc5", "p2_ddc6", "p2_ddc7", "p2_mic", "p2_rxaudio", "p2_txiq",
+  "input"
+};
+
+static const char *metric_stream_name[RECORD_STREAMS] = {
+  "rx1_iq", "rx1_audio", "rx2_iq", "rx2_audio"
+};
+
+static const char *metric_queue_name[SEND_PRIO_NUM] = {
+  "control", "audio", "spectrum"
+};
+
+//
+// Upper limits (in usec) of the histogram buckets, the last one is "+Inf"
+//
+static const int64_t metric_bucket_limit[METRIC_HIST_NUM - 1] = {
+  20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000
+};
+
+void metric_observe_usec(int id, int inst, int64_t usec) {
+  int i;
+
+  if (!metric_ok(id, inst)) { return; }
+
+  for (i = 0; i < METRIC_HIST_NUM - 1; i++) {
+    if (usec <= metric_bucket_limit[i]) { break; }
+  }
+
+  METRIC_VALUE *v = &metric_value[id][inst];
+  __atomic_fetch_add(&v->bucket[i], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&v->count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&v->value, usec, __ATOMIC_RELAXED);
+}
+
+static int64_t metric_get(const int64_t *p) {
+  return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static void metric_label(int id, int inst, char *buf, int len) {
+  const METRIC_INFO *info = &metric_info[id];
+
+  if (info->label == NULL) {
+    *buf = 0;
+  } else if (!strcmp(info->label, "ring")) {
+    snprintf(buf, len, "%s=\"%s\"", info->label, metric_ring_name[inst]);
+  } else if (!strcmp(info->label, "stream")) {
+    snprintf(buf, len, "%s=\"%s\"", info->label, metric_stream_name[inst]);
+  } else if (!strcmp(info->label, "queue")) {
+    snprintf(buf, len, "%s=\"%s\"", info->label, metric_queue_name[inst]);
+  } else {
+    snprintf(buf, len, "%s=\"%d\"", info->label, inst);
+  }
+}
+
+//
+// Metrics without a label are written without braces, as in
+// "pihpsdr_sequence_errors_total 0"
+//
+static void metric_braces(const char *label, char *buf, int len) {
+  if (*label) {
+    snprintf(buf, len, "{%s}", label);
+  } else {
+    *buf = 0;
+  }
+}
+
+//
+// For the menu and the CAT command, all instances of all metrics are
+// numbered consecutively. metric_get_line() produces a single line for
+// metric number n, e.g.
+//
+// pihpsdr_ring_overflows_total{ring="p2_ddc0"} 3
+// pihpsdr_rx_exchange_seconds{rx="0"} n=1024 avg=312us
+//
+int metric_get_num() {
+  int n = 0;
+
+  for (int id = 0; id < METRIC_NUM; id++) {
+    n += metric_info[id].ninst;
+  }
+
+  return n;
+}
+
+static int metric_locate(int n, int *id, int *inst) {
+  if (n < 0) { return 0; }
+
+  for (int i = 0; i < METRIC_NUM; i++) {
+    if (n < metric_info[i].ninst) {
+      *id = i;
+      *inst = n;
+      return 1;
+    }
+
+    n -= metric_info[i].ninst;
+  }
+
+  return 0;
+}
+
+//
+// Raw values of metric number n. For histograms, value is the sum
+// of the observations (in usec) and count the number of observations.
+//
+int metric_get_value(int n, int *type, int64_t *value, int64_t *count) {
+  int id, inst;
+
+  if (!metric_locate(n, &id, &inst)) { return 0; }
+
+  *type = metric_info[id].type;
+  *value = metric_get(&metric_value[id][inst].value);
+  *count = metric_get(&metric_value[id][inst].count);
+  return 1;
+}
+
+int metric_get_line(int n, char *line, int len) {
+  char label[64];
+  char braces[68];
+  int id, inst;
+
+  if (!metric_locate(n, &id, &inst)) {
+    *line = 0;
+    return 0;
+  }
+
+  const METRIC_INFO *info = &metric_info[id];
+  const METRIC_VALUE *v = &metric_value[id][inst];
+  metric_label(id, inst, label, sizeof(label));
+  metric_braces(label, braces, sizeof(braces));
+
+  if (info->type == METRIC_HISTOGRAM) {
+    int64_t count = metric_get(&v->count);
+    int64_t sum = metric_get(&v->value);
+    snprintf(line, len, "%s%s n=%lld avg=%lldus", info->name, braces,
+             (long long) count, (long long) (count > 0 ? sum / count : 0));
+  } else {
+    snprintf(line, len, "%s%s %lld", info->name, braces, (long long) metric_get(&v->value));
+  }
+
+  return 1;
+}
+
+//
+// Per-thread CPU time (Linux only). Reads /proc/self/task/<tid>/stat,
+// the thread names are those given in g_thread_new() (at most
+// 15 characters)
+//
+int metrics_threads(METRIC_THREAD *t, int max) {
+  int n = 0;
+#ifdef __linux__
+  DIR *dir = opendir("/proc/self/task");
+  const struct dirent *ent;
+  long ticks = sysconf(_SC_CLK_TCK);
+
+  if (dir == NULL) { return 0; }
+
+  while (n < max && (ent = readdir(dir)) != NULL) {
+    char path[300];
+    char stat[1024];
+    FILE *fp;
+    unsigned long utime, stime;
+
+    if (ent->d_name[0] < '0' || ent->d_name[0] > '9') { continue; }
+
+    snprintf(path, sizeof(path), "/proc/self/task/%s/stat", ent->d_name);
+    fp = fopen(path, "r");
+
+    if (fp == NULL) { continue; }
+
+    if (fgets(stat, sizeof(stat), fp) == NULL) {
+      fclose(fp);
+      continue;
+    }
+
+    fclose(fp);
+    //
+    // The thread name is enclosed in parentheses and may contain blanks,
+    // utime and stime are the 12th and 13th field after the name.
+    //
+    const char *p = strchr(stat, '(');
+    const char *q = strrchr(stat, ')');
+
+    if (p == NULL || q == NULL || q < p) { continue; }
+
+    if (sscanf(q + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) { continue; }
+
+    //
+    // The CPU the thread last ran on is the 37th field after the name
+    //
+    const char *r = q + 2;
+    t[n].core = -1;
+
+    for (int i = 0; i < 36 && r != NULL; i++) {
+      r = strchr(r, ' ');
+
+      if (r != NULL) { r++; }
+    }
+
+    if (r != NULL) { t[n].core = atoi(r); }
+
+    t[n].tid = atoi(ent->d_name);
+    snprintf(t[n].name, sizeof(t[n].name), "%.*s", (int)(q - p - 1), p + 1);
+    t[n].cpu = (double)(utime + stime) / (double) ticks;
+    n++;
+  }
+
+  closedir(dir);
+#endif
+  return n;
+}
+
+//
+// Produce all metrics in the Prometheus text format.
+// The result must be free'd by the caller (g_free).
+//
+char *metrics_text() {
+  GString *s = g_string_new(NULL);
+  char label[64];
+  char braces[68];
+  METRIC_THREAD thread[64];
+  int nthread;
+
+  for (int id = 0; id < METRIC_NUM; id++) {
+    const METRIC_INFO *info = &metric_info[id];
+    static const char *typename[] = {"counter", "gauge", "histogram"};
+    g_string_append_printf(s, "# HELP %s %s\n", info->name, info->help);
+    g_string_append_printf(s, "# TYPE %s %s\n", info->name, typename[info->type]);
+
+    for (int inst = 0; inst < info->ninst; inst++) {
+      const METRIC_VALUE *v = &metric_value[id][inst];
+      metric_label(id, inst, label, sizeof(label));
+      metric_braces(label, braces, sizeof(braces));
+
+      if (info->type == METRIC_HISTOGRAM) {
+        const char *sep = *label ? "," : "";
+        int64_t cumul = 0;
+
+        for (int i = 0; i < METRIC_HIST_NUM; i++) {
+          cumul += metric_get(&v->bucket[i]);
+
+          if (i < METRIC_HIST_NUM - 1) {
+            g_string_append_printf(s, "%s_bucket{%s%sle=\"%g\"} %lld\n", info->name, label, sep,
+                                   1.0E-6 * metric_bucket_limit[i], (long long) cumul);
+          } else {
+            g_string_append_printf(s, "%s_bucket{%s%sle=\"+Inf\"} %lld\n", info->name, label, sep,
+                                   (long long) cumul);
+          }
+        }
+
+        g_string_append_printf(s, "%s_sum%s %g\n", info->name, braces, 1.0E-6 * metric_get(&v->value));
+        g_string_append_printf(s, "%s_count%s %lld\n", info->name, braces, (long long) metric_get(&v->count));
+      } else {
+        g_string_append_printf(s, "%s%s %lld\n", info->name, braces, (long long) metric_get(&v->value));
+      }
+    }
+  }
+
+  nthread = metrics_threads(thread, 64);
+
+  if (nthread > 0) {
+    g_string_append(s, "# HELP pihpsdr_thread_cpu_seconds_total CPU time used per thread\n");
+    g_string_append(s, "# TYPE pihpsdr_thread_cpu_seconds_total counter\n");
+
+    for (int i = 0; i < nthread; i++) {
+      g_string_append_printf(s, "pihpsdr_thread_cpu_seconds_total{thread=\"%s\",tid=\"%d\"} %.2f\n",
+                             thread[i].name, thread[i].tid, thread[i].cpu);
+    }
+  }
+
+  return g_string_free(s, FALSE);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//
+// HTTP endpoint. This is a minimal server which answers each request
+// with the metrics text and closes the connection. It only listens
+// on the loopback interface.
+//
+////////////////////////////////////////////////////////////////////////////
+
+static GThread *http_thread_id = NULL;
+static volatile int http_running = 0;
+static int http_socket = -1;
+
+static gpointer metrics_http_thread(gpointer data) {
+  int port = GPOINTER_TO_INT(data);
+  int on = 1;
+  struct sockaddr_in addr;
+  struct timeval tv;
+  tv.tv_sec = 0;
+  tv.tv_usec = 100000;
+  http_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (http_socket < 0) {
+    t_perror("MetricsHTTP socket");
+    return NULL;
+  }
+
+  setsockopt(http_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(http_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+
+  if (bind(http_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(http_socket, 3) < 0) {
+    t_perror("MetricsHTTP bind/listen");
+    close(http_socket);
+    http_socket = -1;
+    return NULL;
+  }
+
+  t_print("%s: serving metrics on http://127.0.0.1:%d/metrics\n", __FUNCTION__, port);
+
+  while (http_running) {
+    char request[1024];
+    char header[256];
+    int fd = accept(http_socket, NULL, NULL);
+
+    if (fd < 0) {
+      // Since we have a 0.1 sec time-out, this is normal
+      continue;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ssize_t n = read(fd, request, sizeof(request) - 1);
+
+    if (n > 0) {
+      request[n] = 0;
+
+      if (!strncmp(request, "GET /metrics", 12) || !strncmp(request, "GET / ", 6)) {
+        char *text = metrics_text();
+        size_t len = strlen(text);
+        snprintf(header, sizeof(header),
+                 "HTTP/1.0 200 OK\r\n"
+                 "Content-Type: text/plain; version=0.0.4\r\n"
+                 "Content-Length: %zu\r\n\r\n", len);
+
+        if (write(fd, header, strlen(header)) > 0) {
+          size_t done = 0;
+
+          while (done < len) {
+            ssize_t rc = write(fd, text + done, len - done);
+
+            if (rc <= 0) { break; }
+
+            done += rc;
+          }
+        }
+
+        g_free(text);
+      } else {
+        snprintf(header, sizeof(header), "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+
+        if (write(fd, header, strlen(header)) < 0) {
+          t_perror("MetricsHTTP write");
+        }
+      }
+    }
+
+    close(fd);
+  }
+
+  close(http_socket);
+  http_socket = -1;
+  return NULL;
+}
+
+void metrics_http_start() {
+  if (http_thread_id != NULL) { return; }
+
+  http_running = 1;
+  http_thread_id = g_thread_new("metrics http", metrics_http_thread, GINT_TO_POINTER(metrics_http_port));
+}
+
+void metrics_http_stop() {
+  if (http_thread_id == NULL) { return; }
+
+  http_running = 0;
+  g_thread_join(http_thread_id);
+  http_thread_id = NULL;
+}
+
+void metrics_save_state() {
+  SetPropI0("metrics_http_enable",                           metrics_http_enable);
+  SetPropI0("metrics_http_port",                             metrics_http_port);
+}
+
+void metrics_restore_state() {
+  GetPropI0("metrics_http_enable",                           metrics_http_enable);
+  GetPropI0("metrics_http_port",                             metrics_http_port);
+}
@@ -0,0 +1,178 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdint.h>
+#include <time.h>
+
+//
+// Runtime metrics registry.
+//
+// All metrics are updated with relaxed atomic operations, so they can
+// be updated from real-time threads without locking. Each metric has
+// a fixed number of instances (e.g. one per receiver, or one per ring
+// buffer), the label used to distinguish them is given in the
+// metric table in metrics.c
+//
+enum _metric_type {
+  METRIC_COUNTER = 0,
+  METRIC_GAUGE,
+  METRIC_HISTOGRAM
+};
+
+enum _metric_id {
+  METRIC_PACKETS = 0,              // packets received from the radio
+  METRIC_SEQUENCE_ERRORS,          // sequence errors
+  METRIC_NET_BUFFERS,              // P2 network buffers allocated
+  METRIC_RING_FILL,                // ring buffer fill level (percent), per ring
+  METRIC_RING_DROPS,               // ring buffer overflows, per ring
+  METRIC_RX_SAMPLES,               // IQ samples fed into the RX engine, per receiver
+  METRIC_RX_EXCHANGE_ERRORS,       // fexchange0 errors, per receiver
+  METRIC_RX_EXCHANGE_TIME,         // fexchange0 execution time, per receiver
+  METRIC_RX_SPECTRUM_TIME,         // Spectrum0 execution time, per receiver
+  METRIC_TX_EXCHANGE_TIME,         // fexchange0 execution time of the TX engine
+  METRIC_TX_EXCHANGE_ERRORS,       // fexchange0 errors of the TX engine
+  METRIC_AUDIO_UNDERRUNS,          // local audio output underruns, per receiver
+  METRIC_MIC_OVERRUNS,             // local microphone input overruns
+  METRIC_TCI_MESSAGES,             // TCI messages processed
+  METRIC_RIGCTL_COMMANDS,          // CAT commands processed
+  METRIC_RECORD_BYTES,             // bytes written by the recorder, per stream
+  METRIC_RECORD_DROPS,             // samples dropped by the recorder, per stream
+  METRIC_REMOTE_QUEUED,            // bytes queued for the remote client, per queue
+  METRIC_REMOTE_DROPS,             // packets to the remote client dropped, per queue
+  METRIC_REMOTE_BYTES,             // bytes sent to the remote client
+  METRIC_REMOTE_LATENCY,           // time packets to the remote client were queued
+  METRIC_REMOTE_RTT,               // round trip time to the remote client (usec)
+  METRIC_MEDIA_LOST,               // UDP audio packets lost (concealed), per receiver
+  METRIC_MEDIA_LATE,               // UDP audio packets arriving too late, per receiver
+  METRIC_MEDIA_JITTER,             // UDP audio inter-arrival jitter (usec), per receiver
+  METRIC_MEDIA_DELAY,              // UDP audio jitter buffer delay (usec), per receiver
+  METRIC_NUM
+};
+
+//
+// Instances of METRIC_RING_FILL and METRIC_RING_DROPS
+//
+enum _metric_ring {
+  METRIC_RING_P1_RX = 0,
+  METRIC_RING_P1_TX,
+  METRIC_RING_P2_DDC0,
+  METRIC_RING_P2_DDC1,
+  METRIC_RING_P2_DDC2,
+  METRIC_RING_P2_DDC3,
+  METRIC_RING_P2_DDC4,
+  METRIC_RING_P2_DDC5,
+  METRIC_RING_P2_DDC6,
+  METRIC_RING_P2_DDC7,
+  METRIC_RING_P2_MIC,
+  METRIC_RING_P2_RXAUDIO,
+  METRIC_RING_P2_TXIQ,
+  METRIC_RING_INPUT,
+  METRIC_RING_NUM
+};
+
+#define METRIC_MAX_INST   16       // max. number of instances of a metric
+#define METRIC_HIST_NUM   12       // number of histogram buckets (incl. +Inf)
+
+typedef struct _metric_value {
+  int64_t value;                   // counter/gauge value, or sum (usec) for histograms
+  int64_t count;                   // number of observations (histograms only)
+  int64_t bucket[METRIC_HIST_NUM]; // histogram buckets (not cumulative)
+} METRIC_VALUE;
+
+extern METRIC_VALUE metric_value[METRIC_NUM][METRIC_MAX_INST];
+
+//
+// The update functions are inline since they are called from
+// the real-time threads at high rate. Out-of-range instances
+// are silently ignored.
+//
+static inline int metric_ok(int id, int inst) {
+  return inst >= 0 && inst < METRIC_MAX_INST && id >= 0 && id < METRIC_NUM;
+}
+
+static inline void metric_add(int id, int inst, int64_t n) {
+  if (metric_ok(id, inst)) {
+    __atomic_fetch_add(&metric_value[id][inst].value, n, __ATOMIC_RELAXED);
+  }
+}
+
+static inline void metric_inc(int id, int inst) {
+  metric_add(id, inst, 1);
+}
+
+static inline void metric_set(int id, int inst, int64_t n) {
+  if (metric_ok(id, inst)) {
+    __atomic_store_n(&metric_value[id][inst].value, n, __ATOMIC_RELAXED);
+  }
+}
+
+//
+// Set the fill level (in percent) of a ring buffer given the
+// in/out pointers and the length of the buffer.
+//
+static inline void metric_ring(int ring, int inptr, int outptr, int len) {
+  int used = inptr - outptr;
+
+  if (used < 0) { used += len; }
+
+  metric_set(METRIC_RING_FILL, ring, (100 * (int64_t) used) / len);
+}
+
+//
+// Time stamps for histograms (in usec). Usage:
+//
+//   int64_t t = metric_start();
+//   ... something to be timed ...
+//   metric_observe(METRIC_RX_EXCHANGE_TIME, rx->id, t);
+//
+static inline int64_t metric_start() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return 1000000LL * ts.tv_sec + ts.tv_nsec / 1000;
+}
+
+extern void metric_observe_usec(int id, int inst, int64_t usec);
+
+static inline void metric_observe(int id, int inst, int64_t start) {
+  metric_observe_usec(id, inst, metric_start() - start);
+}
+
+typedef struct _metric_thread {
+  int tid;
+  char name[32];
+  double cpu;                      // CPU time used so far (seconds)
+  int core;                        // CPU core the thread last ran on
+} METRIC_THREAD;
+
+extern int   metric_get_num(void);
+extern int   metric_get_line(int n, char *line, int len);
+extern int   metric_get_value(int n, int *type, int64_t *value, int64_t *count);
+extern int   metrics_threads(METRIC_THREAD *t, int max);
+extern char *metrics_text(void);
+extern void metrics_save_state(void);
+extern void metrics_restore_state(void);
+extern void metrics_http_start(void);
+extern void metrics_http_stop(void);
+
+extern int metrics_http_enable;
+extern int metrics_http_port;
+
+#endif
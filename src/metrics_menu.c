@@ -0,0 +1,354 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <wdsp.h>
+
+#include "metrics.h"
+#include "metrics_menu.h"
+#include "new_menu.h"
+#include "radio.h"
+#include "receiver.h"
+#include "threads.h"
+#include "transmitter.h"
+
+static GtkWidget *dialog = NULL;
+static GtkWidget *text_l = NULL;
+static guint metrics_timer = 0;
+static int wdsp_profile = 0;
+static int profile_rx = -1;
+static int profile_tx = -1;
+
+//
+// Values of the previous update, for calculating rates
+//
+#define MAX_LINES   256
+#define MAX_THREADS 64
+
+static int64_t last_value[MAX_LINES];
+static int64_t last_count[MAX_LINES];
+static METRIC_THREAD last_thread[MAX_THREADS];
+static int last_nthread = 0;
+static gint64 last_time = 0;
+
+static void cleanup() {
+  if (dialog != NULL) {
+    GtkWidget *tmp = dialog;
+    dialog = NULL;
+
+    if (metrics_timer > 0) {
+      g_source_remove(metrics_timer);
+      metrics_timer = 0;
+    }
+
+    if (wdsp_profile) {
+      if (profile_rx >= 0) { SetChannelProfileRun(profile_rx, 0); }
+
+      if (profile_tx >= 0) { SetChannelProfileRun(profile_tx, 0); }
+
+      wdsp_profile = 0;
+    }
+
+    gtk_widget_destroy(tmp);
+    sub_menu = NULL;
+    active_menu  = NO_MENU;
+    radio_save_state();
+  }
+}
+
+static gboolean close_cb () {
+  cleanup();
+  return TRUE;
+}
+
+static void http_enable_cb(GtkWidget *widget, gpointer data) {
+  metrics_http_enable = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+
+  if (metrics_http_enable) {
+    metrics_http_start();
+  } else {
+    metrics_http_stop();
+  }
+}
+
+static void core_cb(GtkWidget *widget, gpointer data) {
+  int slot = GPOINTER_TO_INT(data);
+  thread_core[slot] = gtk_combo_box_get_active(GTK_COMBO_BOX(widget)) - 1;
+  thread_apply_all();
+}
+
+static void rt_cb(GtkWidget *widget, gpointer data) {
+  thread_rt = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+  thread_apply_all();
+}
+
+//
+// Profiling of the WDSP stages is done for the active receiver and
+// the transmitter, and only while this menu is open.
+//
+static void profile_cb(GtkWidget *widget, gpointer data) {
+  wdsp_profile = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+
+  if (profile_rx >= 0) { SetChannelProfileRun(profile_rx, 0); }
+
+  if (profile_tx >= 0) { SetChannelProfileRun(profile_tx, 0); }
+
+  profile_rx = profile_tx = -1;
+
+  if (wdsp_profile) {
+    profile_rx = active_receiver->id;
+    SetChannelProfileRun(profile_rx, 1);
+
+    if (can_transmit) {
+      profile_tx = transmitter->id;
+      SetChannelProfileRun(profile_tx, 1);
+    }
+  }
+}
+
+static void fast_math_cb(GtkWidget *widget, gpointer data) {
+  wdsp_fast_math = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+  SetWDSPFastMath(wdsp_fast_math);
+}
+
+static void profile_text(GString *s, int channel, int tx) {
+  double avg[64], peak[64];
+  double sum = 0.0;
+  int n = tx ? GetTXAStageTimes(channel, avg, peak, 64) : GetRXAStageTimes(channel, avg, peak, 64);
+
+  for (int i = 0; i < n; i++) { sum += avg[i]; }
+
+  if (sum <= 0.0) { return; }
+
+  g_string_append_printf(s, "\n%s stage               avg(us)   max(us)     %%\n", tx ? "TX" : "RX");
+
+  for (int i = 0; i < n; i++) {
+    if (peak[i] <= 0.0) { continue; }
+
+    g_string_append_printf(s, "%-24s %9.1f %9.1f %5.1f\n", tx ? GetTXAStageName(i) : GetRXAStageName(i),
+                           avg[i], peak[i], 100.0 * avg[i] / sum);
+  }
+}
+
+static void http_port_cb(GtkWidget *widget, gpointer data) {
+  if (metrics_http_enable) { metrics_http_stop(); }
+
+  metrics_http_port = gtk_spin_button_get_value(GTK_SPIN_BUTTON(widget));
+
+  if (metrics_http_enable) { metrics_http_start(); }
+}
+
+//
+// Update the text once per second. Metrics that never changed
+// are not shown. For counters and histograms, the rate (per second)
+// since the last update is shown as well.
+//
+static int metrics_update(gpointer data) {
+  GString *s;
+  METRIC_THREAD thread[MAX_THREADS];
+  THREAD_INFO map[MAX_THREADS];
+  int nthread, nmap;
+  gint64 now = g_get_monotonic_time();
+  double dt = 1.0E-6 * (now - last_time);
+  int num = metric_get_num();
+
+  if (dialog == NULL) { return FALSE; }
+
+  if (num > MAX_LINES) { num = MAX_LINES; }
+
+  s = g_string_new(NULL);
+
+  for (int n = 0; n < num; n++) {
+    char line[200];
+    int type;
+    int64_t value, count;
+
+    if (!metric_get_value(n, &type, &value, &count)) { continue; }
+
+    if (value != 0 || count != 0) {
+      metric_get_line(n, line, sizeof(line));
+      g_string_append(s, line);
+
+      if (last_time > 0 && dt > 0.1) {
+        if (type == METRIC_COUNTER) {
+          g_string_append_printf(s, "  (%.1f/s)", (value - last_value[n]) / dt);
+        } else if (type == METRIC_HISTOGRAM && count > last_count[n]) {
+          g_string_append_printf(s, "  (%.1f/s, avg=%lldus)", (count - last_count[n]) / dt,
+                                 (long long) ((value - last_value[n]) / (count - last_count[n])));
+        }
+      }
+
+      g_string_append_c(s, '\n');
+    }
+
+    last_value[n] = value;
+    last_count[n] = count;
+  }
+
+  nthread = metrics_threads(thread, MAX_THREADS);
+  nmap = thread_get_map(map, MAX_THREADS);
+
+  if (nthread > 0) {
+    g_string_append(s, "\nThread               CPU  Core  Slot\n");
+
+    for (int i = 0; i < nthread; i++) {
+      double load = -1.0;
+      const char *slot = "";
+
+      for (int j = 0; j < nmap; j++) {
+        if (map[j].tid == thread[i].tid) {
+          slot = thread_slot_name[map[j].slot];
+          break;
+        }
+      }
+
+      for (int j = 0; j < last_nthread; j++) {
+        if (last_thread[j].tid == thread[i].tid && dt > 0.1) {
+          load = 100.0 * (thread[i].cpu - last_thread[j].cpu) / dt;
+          break;
+        }
+      }
+
+      if (load >= 0.0) {
+        g_string_append_printf(s, "%-16s %6.1f%%  %4d  %s\n", thread[i].name, load, thread[i].core, slot);
+      } else {
+        g_string_append_printf(s, "%-16s      -   %4d  %s\n", thread[i].name, thread[i].core, slot);
+      }
+    }
+  }
+
+  if (wdsp_profile) {
+    if (profile_rx >= 0) { profile_text(s, profile_rx, 0); }
+
+    if (profile_tx >= 0) { profile_text(s, profile_tx, 1); }
+  }
+
+  memcpy(last_thread, thread, nthread * sizeof(METRIC_THREAD));
+  last_nthread = nthread;
+  last_time = now;
+  //
+  // Use a fixed-width font so the columns line up
+  //
+  char *escaped = g_markup_escape_text(s->str, -1);
+  char *markup = g_strdup_printf("<tt>%s</tt>", escaped);
+  gtk_label_set_markup(GTK_LABEL(text_l), markup);
+  g_free(markup);
+  g_free(escaped);
+  g_string_free(s, TRUE);
+  return TRUE;
+}
+
+void metrics_menu(GtkWidget *parent) {
+  GtkWidget *w;
+  dialog = gtk_dialog_new();
+  gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(parent));
+  GtkWidget *headerbar = gtk_header_bar_new();
+  gtk_window_set_titlebar(GTK_WINDOW(dialog), headerbar);
+  gtk_header_bar_set_show_close_button(GTK_HEADER_BAR(headerbar), TRUE);
+  gtk_header_bar_set_title(GTK_HEADER_BAR(headerbar), "piHPSDR - Metrics");
+  g_signal_connect (dialog, "delete_event", G_CALLBACK (close_cb), NULL);
+  g_signal_connect (dialog, "destroy", G_CALLBACK (close_cb), NULL);
+  GtkWidget *content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+  GtkWidget *grid = gtk_grid_new();
+  gtk_grid_set_row_spacing (GTK_GRID(grid), 5);
+  gtk_grid_set_column_spacing (GTK_GRID(grid), 10);
+  int row = 0;
+  w = gtk_button_new_with_label("Close");
+  gtk_widget_set_name(w, "close_button");
+  g_signal_connect (w, "button-press-event", G_CALLBACK(close_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), w, 0, row, 1, 1);
+  w = gtk_label_new("HTTP port");
+  gtk_widget_set_name(w, "boldlabel");
+  gtk_widget_set_halign(w, GTK_ALIGN_END);
+  gtk_grid_attach(GTK_GRID(grid), w, 1, row, 1, 1);
+  w = gtk_spin_button_new_with_range(1024, 65535, 1);
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), (double)metrics_http_port);
+  gtk_grid_attach(GTK_GRID(grid), w, 2, row, 1, 1);
+  g_signal_connect(w, "value_changed", G_CALLBACK(http_port_cb), NULL);
+  w = gtk_check_button_new_with_label("Enable");
+  gtk_widget_set_name(w, "boldlabel");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (w), metrics_http_enable);
+  gtk_grid_attach(GTK_GRID(grid), w, 3, row, 1, 1);
+  g_signal_connect(w, "toggled", G_CALLBACK(http_enable_cb), NULL);
+  row++;
+  //
+  // CPU core for each thread slot, and real-time scheduling
+  //
+  int ncores = thread_num_cores();
+
+  for (int slot = 0; slot < THREAD_SLOTS; slot++) {
+    int col = 2 * (slot % 3);
+    w = gtk_label_new(thread_slot_name[slot]);
+    gtk_widget_set_name(w, "boldlabel");
+    gtk_widget_set_halign(w, GTK_ALIGN_END);
+    gtk_grid_attach(GTK_GRID(grid), w, col, row + slot / 3, 1, 1);
+    w = gtk_combo_box_text_new();
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "Any core");
+
+    for (int core = 0; core < ncores; core++) {
+      char text[32];
+      snprintf(text, sizeof(text), "Core %d", core);
+      gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, text);
+    }
+
+    gtk_combo_box_set_active(GTK_COMBO_BOX(w), thread_core[slot] < ncores ? thread_core[slot] + 1 : 0);
+    my_combo_attach(GTK_GRID(grid), w, col + 1, row + slot / 3, 1, 1);
+    g_signal_connect(w, "changed", G_CALLBACK(core_cb), GINT_TO_POINTER(slot));
+  }
+
+  row += 2;
+  w = gtk_check_button_new_with_label("Real-time scheduling (SCHED_FIFO)");
+  gtk_widget_set_name(w, "boldlabel");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (w), thread_rt);
+  gtk_grid_attach(GTK_GRID(grid), w, 0, row, 3, 1);
+  g_signal_connect(w, "toggled", G_CALLBACK(rt_cb), NULL);
+
+  if (!radio_is_remote) {
+    w = gtk_check_button_new_with_label("Profile WDSP stages");
+    gtk_widget_set_name(w, "boldlabel");
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (w), wdsp_profile);
+    gtk_grid_attach(GTK_GRID(grid), w, 3, row, 3, 1);
+    g_signal_connect(w, "toggled", G_CALLBACK(profile_cb), NULL);
+    row++;
+    w = gtk_check_button_new_with_label("WDSP fast math (approximate log/exp)");
+    gtk_widget_set_name(w, "boldlabel");
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (w), wdsp_fast_math);
+    gtk_grid_attach(GTK_GRID(grid), w, 0, row, 3, 1);
+    g_signal_connect(w, "toggled", G_CALLBACK(fast_math_cb), NULL);
+  }
+
+  row++;
+  GtkWidget *sw = gtk_scrolled_window_new(NULL, NULL);
+  gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(sw), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_widget_set_size_request(sw, 640, 400);
+  text_l = gtk_label_new(NULL);
+  gtk_widget_set_halign(text_l, GTK_ALIGN_START);
+  gtk_widget_set_valign(text_l, GTK_ALIGN_START);
+  gtk_container_add(GTK_CONTAINER(sw), text_l);
+  gtk_grid_attach(GTK_GRID(grid), sw, 0, row, 6, 1);
+  gtk_container_add(GTK_CONTAINER(content), grid);
+  sub_menu = dialog;
+  gtk_widget_show_all(dialog);
+  last_time = 0;
+  last_nthread = 0;
+  metrics_update(NULL);
+  metrics_timer = g_timeout_add(1000, metrics_update, NULL);
+}
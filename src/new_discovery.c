@@ -360,11 +360,11 @@ static gpointer new_discover_receive_thread(gpointer data) {
             snprintf(discovered[devices].network.interface_name, sizeof(discovered[devices].network.interface_name), "%s",
                      interface_name);
             discovered[devices].supported_receivers = 2;
+            discovered[devices].ddcs = buffer[20] & 0xFF;
             //
             // Info not yet made use of:
             //
             // buffer[12]: P2 version supported (e.g. 39 for 3.9)
-            // buffer[20]: number of DDCs
             // buffer[23]: beta version number (if nonzero)
             //             E.g. if buffer[13] is 21 and buffer[23] is 18 this
             //             means firmware Version 2.1.18
@@ -42,6 +42,7 @@
 #include "gpio.h"
 #include "main.h"
 #include "meter_menu.h"
+#include "metrics_menu.h"
 #ifdef MIDI
   #include "midi_menu.h"
   #include "midi.h"
@@ -149,6 +150,12 @@ static gboolean about_cb (GtkWidget *widget, GdkEventButton *event, gpointer dat
   return TRUE;
 }
 
+static gboolean metrics_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  cleanup();
+  metrics_menu(top_window);
+  return TRUE;
+}
+
 static gboolean exit_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
   cleanup();
   exit_menu(top_window);
@@ -756,11 +763,14 @@ void new_menu() {
     gtk_grid_attach(GTK_GRID(grid), BotSeparator, 0, row, 6, 1);
     row++;
     //
-    // Last row: About and Iconify Button
+    // Last row: About, Metrics and Iconify Button
     //
     GtkWidget *about_b = gtk_button_new_with_label("About");
     g_signal_connect (about_b, "button-press-event", G_CALLBACK(about_cb), NULL);
     gtk_grid_attach(GTK_GRID(grid), about_b, 0, row, 2, 1);
+    GtkWidget *metrics_b = gtk_button_new_with_label("Metrics");
+    g_signal_connect (metrics_b, "button-press-event", G_CALLBACK(metrics_cb), NULL);
+    gtk_grid_attach(GTK_GRID(grid), metrics_b, 2, row, 2, 1);
     GtkWidget *minimize_b = gtk_button_new_with_label("Iconify");
     g_signal_connect (minimize_b, "button-press-event", G_CALLBACK(minimize_cb), NULL);
     gtk_grid_attach(GTK_GRID(grid), minimize_b, 4, row, 2, 1);
@@ -49,6 +49,7 @@
 #include "iambic.h"
 #include "main.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "new_protocol.h"
 #include "radio.h"
@@ -57,6 +58,7 @@
 #ifdef SATURN
   #include "saturnmain.h"
 #endif
+#include "threads.h"
 #include "toolbar.h"
 #include "transmitter.h"
 #include "vfo.h"
@@ -84,6 +86,8 @@
 
 static int rxcase[MAX_DDC];
 static int rxid[MAX_DDC];
+static int n_ddc = 4;        // number of DDCs the radio has
+static int n_rxddc = 4;      // number of DDCs that may feed a receiver (with an iq thread)
 
 int data_socket = -1;
 
@@ -313,6 +317,7 @@ static mybuffer *get_my_buffer() {
     }
   }
 
+  metric_set(METRIC_NET_BUFFERS, 0, num_buf);
   t_print("NewProtocol: number of buffers increased to %d\n", num_buf);
   // Mark the first buffer in list as used and return that one.
   buflist->free = 0;
@@ -393,20 +398,16 @@ static void update_action_table() {
   // Set up rxcase and rxid for each of the 12 cases
   // note that rxid[i] can be left unspecified if rxcase[i] == RXACTION_SKIP
   //
-  rxcase[0] = RXACTION_SKIP;
-  rxcase[1] = RXACTION_SKIP;
-  rxcase[2] = RXACTION_SKIP;
-  rxcase[3] = RXACTION_SKIP;
+  for (int i = 0; i < MAX_DDC; i++) {
+    rxcase[i] = RXACTION_SKIP;
+  }
 
   switch (flag) {
   case       0:                                                       // HERMES, RX, no DIVERSITY
   case   10100:                                                       // HERMES, TX, no PureSignal, DUPLEX
-    rxid[0] = 0;
-    rxcase[0] = RXACTION_NORMAL;
-
-    if (receivers > 1) {
-      rxid[1] = 1;
-      rxcase[1] = RXACTION_NORMAL;
+    for (int i = 0; i < receivers && i < n_rxddc; i++) {
+      rxid[i] = i;
+      rxcase[i] = RXACTION_NORMAL;
     }
 
     break;
@@ -434,12 +435,9 @@ static void update_action_table() {
 
   case 1000:                                                          // ORION, RX, no DIVERSITY
   case 11100:                                                         // ORION, TX, no PureSignal, DUPLEX
-    rxid[2] = 0;
-    rxcase[2] = RXACTION_NORMAL;
-
-    if (receivers > 1) {
-      rxid[3] = 1;
-      rxcase[3] = RXACTION_NORMAL;
+    for (int i = 0; i < receivers && i + 2 < n_rxddc; i++) {
+      rxid[i + 2] = i;
+      rxcase[i + 2] = RXACTION_NORMAL;
     }
 
     break;
@@ -482,6 +480,26 @@ void new_protocol_init() {
     }
   }
 
+  //
+  // There is one iq thread for each DDC that can feed a receiver. Since
+  // each DDC feeds at most one receiver, this thread does the RX processing
+  // for that receiver, and all receivers run in parallel.
+  // Older firmware does not report the number of DDCs, and ORION and
+  // beyond use DDC2 and DDC3 for the receivers, so we need at least four.
+  // DDCs beyond DDC(RECEIVERS+1) are never enabled (see the action table
+  // and new_protocol_receive_specific()), so they get no thread.
+  //
+  n_ddc = radio->ddcs;
+
+  if (n_ddc < 4) { n_ddc = 4; }
+
+  if (n_ddc > MAX_DDC) { n_ddc = MAX_DDC; }
+
+  n_rxddc = RECEIVERS + 2;
+
+  if (n_rxddc > n_ddc) { n_rxddc = n_ddc; }
+
+  t_print("%s: radio has %d DDCs, using %d\n", __FUNCTION__, n_ddc, n_rxddc);
   //
   // Initialise semaphores for the never-finishing threads
   // (HighPrio, Mic, rxIQ) and spawn these threads.
@@ -491,7 +509,7 @@ void new_protocol_init() {
   high_priority_sem_buffer = apple_sem(0);
   mic_line_sem = apple_sem(0);
 
-  for (i = 0; i < MAX_DDC; i++) {
+  for (i = 0; i < n_rxddc; i++) {
     iq_sem[i] = apple_sem(0);
   }
 
@@ -500,7 +518,7 @@ void new_protocol_init() {
   (void)sem_init(&high_priority_sem_buffer, 0, 0); // check return value!
   (void)sem_init(&mic_line_sem, 0, 0); // check return value!
 
-  for (i = 0; i < MAX_DDC; i++) {
+  for (i = 0; i < n_rxddc; i++) {
     (void)sem_init(&iq_sem[i], 0, 0); // check return value!
   }
 
@@ -508,7 +526,7 @@ void new_protocol_init() {
   high_priority_thread_id = g_thread_new( "P2 HP", high_priority_thread, NULL);
   mic_line_thread_id = g_thread_new( "P2 MIC", mic_line_thread, NULL);
 
-  for (i = 0; i < MAX_DDC; i++) {
+  for (i = 0; i < n_rxddc; i++) {
     char text[16];
     snprintf(text, sizeof(text), "P2 DDC%d", i);
     iq_thread_id[i] = g_thread_new(text, iq_thread, GINT_TO_POINTER(i));
@@ -1768,6 +1786,7 @@ static gpointer new_protocol_rxaudio_thread(gpointer data) {
   ASSERT_SERVER(NULL);
   int nptr;
   unsigned char audiobuffer[260];
+  thread_setup(THREAD_AUDIO, "P2 RX audio");
 
   //
   // Ideally, a RX audio buffer with 64 samples is sent every 1333 usecs.
@@ -1880,6 +1899,7 @@ static gpointer new_protocol_txiq_thread(gpointer data) {
   ASSERT_SERVER(NULL);
   int nptr;
   unsigned char iqbuffer[1444];
+  thread_setup(THREAD_TX, "P2 TX IQ");
 
   //
   // Ideally, a TX IQ buffer with 240 sample is sent every 1250 usecs.
@@ -1969,6 +1989,7 @@ static gpointer new_protocol_txiq_thread(gpointer data) {
 static gpointer new_protocol_thread(gpointer data) {
   ASSERT_SERVER(NULL);
   t_print("new_protocol_thread\n");
+  thread_setup(THREAD_NET, "P2 receive");
 
   //
   // This thread should do as little work as possible and avoid any blocking.
@@ -2004,6 +2025,7 @@ static gpointer new_protocol_thread(gpointer data) {
       break;
     }
 
+    metric_inc(METRIC_PACKETS, 0);
     sourceport = ntohs(addr.sin_port);
 
     //t_print("new_protocol_thread: recvd %d bytes on port %d\n",bytesread,sourceport);
@@ -2051,6 +2073,7 @@ static gpointer new_protocol_thread(gpointer data) {
 static gpointer high_priority_thread(gpointer data) {
   ASSERT_SERVER(NULL);
   t_print("high_priority_thread\n");
+  thread_setup(THREAD_NET, "P2 high prio");
 
   while (1) {
 #ifdef __APPLE__
@@ -2070,6 +2093,7 @@ static gpointer high_priority_thread(gpointer data) {
 static gpointer mic_line_thread(gpointer data) {
   ASSERT_SERVER(NULL);
   t_print("mic_line_thread\n");
+  thread_setup(THREAD_TX, "P2 mic");
   mybuffer *mybuf;
   int nptr;
 
@@ -2144,6 +2168,7 @@ void saturn_post_micaudio(int bytesread, mybuffer *mybuf) {
   if (nptr != mic_outptr) {
     mic_line_buffer[mic_inptr] = mybuf;
     MEMORY_BARRIER;
+    metric_ring(METRIC_RING_P2_MIC, nptr, mic_outptr, MICRINGBUFLEN);
 #ifdef __APPLE__
     sem_post(mic_line_sem);
 #else
@@ -2152,6 +2177,7 @@ void saturn_post_micaudio(int bytesread, mybuffer *mybuf) {
     mic_inptr = nptr;
   } else {
     t_print("%s: buffer overflow.\n", __FUNCTION__);
+    metric_inc(METRIC_RING_DROPS, METRIC_RING_P2_MIC);
     mybuf->free = 1;
     // skip 16 mic buffers (21 msec)
     mic_count = -16;
@@ -2167,6 +2193,16 @@ void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
     return;
   }
 
+  if (ddc >= n_rxddc) {
+    //
+    // A DDC without an iq thread (it cannot feed a receiver). Count the
+    // packet as dropped instead of logging each one.
+    //
+    metric_inc(METRIC_RING_DROPS, METRIC_RING_P2_DDC0 + ddc);
+    mybuf->free = 1;
+    return;
+  }
+
   if (!P2running) {
     mybuf->free = 1;
     return;
@@ -2190,6 +2226,7 @@ void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
   if (ddc_sequence[ddc] != sequence) {
     t_print("%s: DDC(%d) sequence error: expected %lu got %lu\n", __FUNCTION__, ddc, ddc_sequence[ddc], sequence);
     sequence_errors++;
+    metric_inc(METRIC_SEQUENCE_ERRORS, 0);
   }
 
   ddc_sequence[ddc] = sequence + 1;
@@ -2202,6 +2239,7 @@ void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
     iq_buffer[ddc][iptr] = mybuf;
     MEMORY_BARRIER;
     iq_inptr[ddc] = nptr;
+    metric_ring(METRIC_RING_P2_DDC0 + ddc, nptr, iq_outptr[ddc], RXIQRINGBUFLEN);
 #ifdef __APPLE__
     sem_post(iq_sem[ddc]);
 #else
@@ -2209,6 +2247,7 @@ void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
 #endif
   } else {
     t_print("%s: DDC(%d) buffer overflow.\n", __FUNCTION__, ddc);
+    metric_inc(METRIC_RING_DROPS, METRIC_RING_P2_DDC0 + ddc);
     mybuf->free = 1;
     // skip 128 incoming buffers
     iq_count[ddc] = -128;
@@ -2226,7 +2265,10 @@ static gpointer iq_thread(gpointer data) {
   long expected_sequence = 0;
   volatile mybuffer *mybuf;
   const unsigned char *buffer;
+  int slot = -1;
+  char name[32];
   t_print("iq_thread: ddc=%d\n", ddc);
+  snprintf(name, sizeof(name), "P2 DDC%d", ddc);
 
   //
   // At a regular pace, a buffer with 238 samples arrives
@@ -2264,10 +2306,24 @@ static gpointer iq_thread(gpointer data) {
     if (sequence != expected_sequence) {
       t_print("%s: DDC(%d) sequence error: expected %ld got %ld\n", __FUNCTION__, ddc, expected_sequence, sequence);
       sequence_errors++;
+      metric_inc(METRIC_SEQUENCE_ERRORS, 0);
     }
 
     expected_sequence = sequence + 1;
 
+    //
+    //  This thread does the fexchange() for the receiver this DDC is
+    //  assigned to, so it goes into that receiver's thread slot.
+    //  The assignment changes e.g. when switching PureSignal or Diversity.
+    //
+    int newslot = rxcase[ddc] == RXACTION_NORMAL ? thread_rx_slot(rxid[ddc]) :
+                  rxcase[ddc] == RXACTION_DIV    ? THREAD_RX1 : THREAD_TX;
+
+    if (newslot != slot) {
+      slot = newslot;
+      thread_setup(slot, name);
+    }
+
     //
     //  Now comes the action table:
     //  for each DDC we have set up which action to be taken
@@ -2485,6 +2541,7 @@ static void process_high_priority() {
     t_print("HighPrio SeqErr Expected=%lu Seen=%lu\n", highprio_rcvd_sequence, sequence);
     highprio_rcvd_sequence = sequence;
     sequence_errors++;
+    metric_inc(METRIC_SEQUENCE_ERRORS, 0);
   }
 
   highprio_rcvd_sequence++;
@@ -2609,6 +2666,7 @@ static void process_mic_data(const unsigned char *buffer) {
   if (sequence != micsamples_sequence) {
     t_print("MicSample SeqErr Expected=%lu Seen=%lu\n", micsamples_sequence, sequence);
     sequence_errors++;
+    metric_inc(METRIC_SEQUENCE_ERRORS, 0);
   }
 
   micsamples_sequence = sequence + 1;
@@ -2668,6 +2726,7 @@ void new_protocol_cw_audio_samples(short left_audio_sample, short right_audio_sa
 
       if (nptr != rxaudio_outptr) {
         rxaudio_inptr = nptr;
+        metric_ring(METRIC_RING_P2_RXAUDIO, nptr, rxaudio_outptr, RXAUDIORINGBUFLEN);
 #ifdef __APPLE__
         sem_post(rxaudio_sem);
 #else
@@ -2676,6 +2735,7 @@ void new_protocol_cw_audio_samples(short left_audio_sample, short right_audio_sa
         rxaudio_count = 0;
       } else {
         t_print("%s: buffer overflow\n", __FUNCTION__);
+        metric_inc(METRIC_RING_DROPS, METRIC_RING_P2_RXAUDIO);
         // skip some audio samples
         rxaudio_count = -4096;
       }
@@ -2727,6 +2787,7 @@ void new_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
 
     if (nptr != rxaudio_outptr) {
       rxaudio_inptr = nptr;
+      metric_ring(METRIC_RING_P2_RXAUDIO, nptr, rxaudio_outptr, RXAUDIORINGBUFLEN);
 #ifdef __APPLE__
       sem_post(rxaudio_sem);
 #else
@@ -2735,6 +2796,7 @@ void new_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
       rxaudio_count = 0;
     } else {
       t_print("%s: buffer overflow\n", __FUNCTION__);
+      metric_inc(METRIC_RING_DROPS, METRIC_RING_P2_RXAUDIO);
       // skip some audio samples
       rxaudio_count = -4096;
     }
@@ -2777,6 +2839,7 @@ void new_protocol_iq_samples(int isample, int qsample) {
     if (nptr != txiq_outptr) {
       txiq_inptr = nptr;
       txiq_count = 0;
+      metric_ring(METRIC_RING_P2_TXIQ, nptr, txiq_outptr, TXIQRINGBUFLEN);
 #ifdef __APPLE__
       sem_post(txiq_sem);
 #else
@@ -2784,6 +2847,7 @@ void new_protocol_iq_samples(int isample, int qsample) {
 #endif
     } else {
       t_print("%s: output buffer overflow\n", __FUNCTION__);
+      metric_inc(METRIC_RING_DROPS, METRIC_RING_P2_TXIQ);
       // skip 4800 samples ( 25 msec @ 192k )
       txiq_count = -4800;
     }
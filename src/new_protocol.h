@@ -23,7 +23,11 @@
 #include "MacOS.h"   // for semaphores
 #include "receiver.h"
 
-#define MAX_DDC 4
+//
+// Max. number of DDCs that can be used. The number actually used is
+// reported by the radio upon discovery (but at least four).
+//
+#define MAX_DDC 8
 
 // port definitions from host
 #define GENERAL_REGISTERS_FROM_HOST_PORT              1024
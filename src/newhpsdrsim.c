@@ -55,7 +55,7 @@
   static int first_audio_count = -1;
 #endif
 
-#define NUMRECEIVERS 4
+#define NUMRECEIVERS 8
 
 /*
  * These variables represent the state of the machine
@@ -163,6 +163,9 @@ void   *duc_specific_thread(void*);
 void   *highprio_thread(void*);
 void   *send_highprio_thread(void*);
 void   *rx_thread(void *);
+void   *load_thread(void *);
+static void load_init(void);
+static void load_report(void);
 void   *tx_thread(void *);
 void   *mic_thread(void *);
 void   *audio_thread(void *);
@@ -829,8 +832,10 @@ void *highprio_thread(void *data) {
           t_perror("***** ERROR: Create DUC specific thread");
         }
 
+        if (load_ddcs > 0) { load_init(); }
+
         for (i = 0; i < NUMRECEIVERS; i++) {
-          if (pthread_create(&rx_thread_id[i], NULL, rx_thread, (void *) (uintptr_t) i) < 0) {
+          if (pthread_create(&rx_thread_id[i], NULL, i < load_ddcs ? load_thread : rx_thread, (void *) (uintptr_t) i) < 0) {
             t_perror("***** ERROR: Create RX thread");
           }
         }
@@ -1054,6 +1059,8 @@ void *highprio_thread(void *data) {
     pthread_join(rx_thread_id[i], NULL);
   }
 
+  if (load_ddcs > 0) { load_report(); }
+
   pthread_join(send_highprio_thread_id, NULL);
   pthread_join(tx_thread_id, NULL);
   pthread_join(mic_thread_id, NULL);
@@ -1075,10 +1082,10 @@ void *rx_thread(void *data) {
   int yes = 1;
   int i;
   long wait;
-  double i0sample, q0sample;
-  double i1sample, q1sample;
+  double i0buf[238], q0buf[238];
+  double i1buf[119], q1buf[119];
   double irsample, qrsample;
-  int sample;
+  double noisefac;
   unsigned char *p;
   int noisept;
   int myddc;
@@ -1088,12 +1095,15 @@ void *rx_thread(void *data) {
   int divptr;
   int decimation;
   unsigned int seed;
-  double off, tonearg, tonedelta;
-  double off2, tonearg2, tonedelta2;
+  double off, tonedelta;
+  double off2, tonedelta2;
   int do_tone, t3p, t3l;
   struct timespec delay;
-  tonearg = 0.0;
-  tonearg2 = 0.0;
+  NCO tone, tone2;
+  memset(&tone, 0, sizeof(tone));
+  memset(&tone2, 0, sizeof(tone2));
+  tonedelta = 0.0;
+  tonedelta2 = 0.0;
   t3l = 0.0;
   t3p = 0.0;
   myddc = (int) (uintptr_t) data;
@@ -1222,25 +1232,33 @@ void *rx_thread(void *data) {
       rxptr = NEWRTXLEN / 2 - 8192;
     }
 
+    //
+    // The samples are made block-wise. First, the noise is taken from
+    // the table (a simple loop the compiler can vectorize), then the
+    // signals are added, and finally everything is packed into the buffer.
+    // The noise pointer is restarted early such that the table needs
+    // not wrap around within a block.
+    //
+    if (noisept + size > LENNOISE) { noisept = rand_r(&seed) / NOISEDIV; }
+
+    noisefac = p2noisefac[myddc];
+
     for (i = 0; i < size; i++) {
-      //
-      // produce noise depending on the ADC
-      //
-      i1sample = i0sample = noiseItab[noisept] * p2noisefac[myddc];
-      q1sample = q0sample = noiseQtab[noisept++] * p2noisefac[myddc];
+      i0buf[i] = i1buf[i] = noiseItab[noisept + i] * noisefac;
+      q0buf[i] = q1buf[i] = noiseQtab[noisept + i] * noisefac;
+    }
 
-      if (noisept == LENNOISE) { noisept = rand_r(&seed) / NOISEDIV; }
+    noisept += size;
 
+    if (sync && (rxrate[myadc] == 192) && ptt && (syncadc == n_adc)) {
       //
       // PS: produce sample PAIRS,
       // a) distorted TX data (with Drive and Attenuation and ADC noise)
       // b) original TX data (normalised)
       //
-      // DIV: produce sample PAIRS,
-      // a) add man-made-noise on I-sample of RX channel
-      // b) add man-made-noise on Q-sample of "synced" channel
-      //
-      if (sync && (rxrate[myadc] == 192) && ptt && (syncadc == n_adc)) {
+      double fbfac = (NEWDEVICE == NDEV_SATURN) ? 0.6121 : 0.2899;
+
+      for (i = 0; i < size; i++) {
         irsample = isample[rxptr];
         qrsample = qsample[rxptr++];
 
@@ -1249,102 +1267,91 @@ void *rx_thread(void *data) {
         if (myadc == 0) {
           double fac = txatt0_dbl * txdrv_dbl * (IM3a + IM3b * (irsample * irsample + qrsample * qrsample) * txdrv_dbl *
                                                  txdrv_dbl);
-          i0sample += irsample * fac;
-          q0sample += qrsample * fac;
+          i0buf[i] += irsample * fac;
+          q0buf[i] += qrsample * fac;
         }
 
-        if (NEWDEVICE == NDEV_SATURN) {
-          i1sample = irsample * 0.6121;
-          q1sample = qrsample * 0.6121;
-        } else {
-          i1sample = irsample * 0.2899;
-          q1sample = qrsample * 0.2899;
-        }
-      } else if (do_tone == 1) {
-        i0sample += cos(tonearg) * 0.0002239 * rxatt0_dbl;
-        q0sample += sin(tonearg) * 0.0002239 * rxatt0_dbl;
-        tonearg += tonedelta;
-
-        if (tonearg > 6.3) { tonearg -= 6.283185307179586476925286766559; }
-
-        if (tonearg < -6.3) { tonearg += 6.283185307179586476925286766559; }
-      } else if (do_tone == 2) {
-        i0sample += (cos(tonearg) + cos(tonearg2)) * 0.0002239 * rxatt0_dbl;
-        q0sample += (sin(tonearg) + sin(tonearg2)) * 0.0002239 * rxatt0_dbl;
-        tonearg += tonedelta;
-        tonearg2 += tonedelta2;
-
-        if (tonearg > 6.3) { tonearg -= 6.283185307179586476925286766559; }
-
-        if (tonearg2 > 6.3) { tonearg2 -= 6.283185307179586476925286766559; }
+        i1buf[i] = irsample * fbfac;
+        q1buf[i] = qrsample * fbfac;
+      }
+    } else if (do_tone == 1 || do_tone == 2) {
+      double amp = 0.0002239 * rxatt0_dbl;
+      nco_set(&tone, tonedelta);
+      nco_set(&tone2, tonedelta2);
+
+      for (i = 0; i < size; i++) {
+        i0buf[i] += tone.re * amp;
+        q0buf[i] += tone.im * amp;
+        nco_step(&tone);
+      }
 
-        if (tonearg < -6.3) { tonearg += 6.283185307179586476925286766559; }
+      if (do_tone == 2) {
+        for (i = 0; i < size; i++) {
+          i0buf[i] += tone2.re * amp;
+          q0buf[i] += tone2.im * amp;
+          nco_step(&tone2);
+        }
+      }
+    } else if (do_tone == 3) {
+      double amp = 0.000003162278 * rxatt0_dbl;
+      nco_set(&tone, tonedelta);
+
+      for (i = 0; i < size; i++) {
+        if (t3p >= 0) {
+          i0buf[i] += tone.re * amp;
+          q0buf[i] += tone.im * amp;
+        }
 
-        if (tonearg2 < -6.3) { tonearg2 += 6.283185307179586476925286766559; }
-      } else if (do_tone == 3 && t3p >= 0) {
-        i0sample += cos(tonearg) * 0.000003162278 * rxatt0_dbl;
-        q0sample += sin(tonearg) * 0.000003162278 * rxatt0_dbl;
-        tonearg += tonedelta;
+        nco_step(&tone);
 
-        if (tonearg > 6.3) { tonearg -= 6.283185307179586476925286766559; }
+        t3p++;
 
-        if (tonearg < -6.3) { tonearg += 6.283185307179586476925286766559; }
+        if (t3p >= t3l) { t3p = -t3l; }
       }
+    }
 
-      t3p++;
-
-      if (t3p >= t3l) { t3p = -t3l; }
+    nco_norm(&tone);
+    nco_norm(&tone2);
 
-      if (diversity && !sync && myadc == 0) {
-        i0sample += 0.0001 * rxatt0_dbl * divtab[divptr];
-        divptr += decimation;
-
-        if (divptr >= LENDIV) { divptr = 0; }
-      }
+    //
+    // DIV: add man-made-noise on I-sample of RX channel,
+    // and on the Q-sample of the "synced" channel
+    //
+    if (diversity && !sync && (myadc == 0 || myadc == 1)) {
+      double fac = (myadc == 0) ? 0.0001 * rxatt0_dbl : 0.0002 * rxatt1_dbl;
+      double *buf = (myadc == 0) ? i0buf : q0buf;
 
-      if (diversity && !sync && myadc == 1) {
-        q0sample += 0.0002 * rxatt1_dbl * divtab[divptr];
+      for (i = 0; i < size; i++) {
+        buf[i] += fac * divtab[divptr];
         divptr += decimation;
 
         if (divptr >= LENDIV) { divptr = 0; }
       }
+    }
 
-      if (diversity && sync && !ptt) {
-        if (myadc == 0) { i0sample += 0.0001 * rxatt0_dbl * divtab[divptr]; }
+    if (diversity && sync && !ptt) {
+      for (i = 0; i < size; i++) {
+        if (myadc == 0) { i0buf[i] += 0.0001 * rxatt0_dbl * divtab[divptr]; }
 
-        if (syncadc == 1) { q1sample += 0.0002 * rxatt1_dbl * divtab[divptr]; }
+        if (syncadc == 1) { q1buf[i] += 0.0002 * rxatt1_dbl * divtab[divptr]; }
 
         divptr += decimation;
 
         if (divptr >= LENDIV) { divptr = 0; }
       }
+    }
 
-      if (sync) {
-        sample = i0sample * 8388607.0;
-        *p++ = (sample >> 16) & 0xFF;
-        *p++ = (sample >>  8) & 0xFF;
-        *p++ = (sample >>  0) & 0xFF;
-        sample = q0sample * 8388607.0;
-        *p++ = (sample >> 16) & 0xFF;
-        *p++ = (sample >>  8) & 0xFF;
-        *p++ = (sample >>  0) & 0xFF;
-        sample = i1sample * 8388607.0;
-        *p++ = (sample >> 16) & 0xFF;
-        *p++ = (sample >>  8) & 0xFF;
-        *p++ = (sample >>  0) & 0xFF;
-        sample = q1sample * 8388607.0;
-        *p++ = (sample >> 16) & 0xFF;
-        *p++ = (sample >>  8) & 0xFF;
-        *p++ = (sample >>  0) & 0xFF;
-      } else {
-        sample = i0sample * 8388607.0;
-        *p++ = (sample >> 16) & 0xFF;
-        *p++ = (sample >>  8) & 0xFF;
-        *p++ = (sample >>  0) & 0xFF;
-        sample = q0sample * 8388607.0;
-        *p++ = (sample >> 16) & 0xFF;
-        *p++ = (sample >>  8) & 0xFF;
-        *p++ = (sample >>  0) & 0xFF;
+    if (sync) {
+      for (i = 0; i < size; i++) {
+        p = put24(p, i0buf[i]);
+        p = put24(p, q0buf[i]);
+        p = put24(p, i1buf[i]);
+        p = put24(p, q1buf[i]);
+      }
+    } else {
+      for (i = 0; i < size; i++) {
+        p = put24(p, i0buf[i]);
+        p = put24(p, q0buf[i]);
       }
     }
 
@@ -1367,6 +1374,325 @@ void *rx_thread(void *data) {
   return NULL;
 }
 
+//
+// Load generator. For the first load_ddcs DDCs, this thread replaces
+// rx_thread. Since the packets are not computed on the fly, much higher
+// packet rates can be reached. The IQ data is taken from a set of
+// pre-computed packet templates, only the header (sequence number) is
+// made for each packet.
+//
+// Packets are dropped, re-ordered (sent after their successor) and sent
+// in bursts as requested. For each DDC, the number of sequence errors a
+// receiver must see is counted, such that it can be compared with what
+// piHPSDR reports.
+//
+#define LOAD_TEMPLATES 64
+#define LOAD_SAMPLES   238
+#define LOAD_REPORT    10      // seconds between two reports
+
+typedef struct _load_stats {
+  unsigned long sent;
+  unsigned long dropped;
+  unsigned long reordered;
+  unsigned long expected;      // next sequence number a receiver expects
+  unsigned long errors;        // sequence errors a receiver must see
+} LOAD_STATS;
+
+static unsigned char load_template[LOAD_TEMPLATES][6 * LOAD_SAMPLES];
+static LOAD_STATS load_stats[NUMRECEIVERS];
+
+static void load_init() {
+  //
+  // Noise plus a -73 dBm tone about 10 kHz above the center.
+  // The tone frequency is chosen such that the phase is continuous
+  // when the templates wrap around.
+  //
+  double noisefac = sqrt((double) (load_rate > 0 ? load_rate : 1536));
+  double tonedelta = 6.283185307179586476925286766559 * 99.0 / (LOAD_TEMPLATES * LOAD_SAMPLES);
+  int noisept = 0;
+
+  for (int t = 0; t < LOAD_TEMPLATES; t++) {
+    unsigned char *p = load_template[t];
+
+    for (int i = 0; i < LOAD_SAMPLES; i++) {
+      double arg = tonedelta * (t * LOAD_SAMPLES + i);
+      int sample = (noiseItab[noisept] * noisefac + cos(arg) * 0.0002239) * 8388607.0;
+      *p++ = (sample >> 16) & 0xFF;
+      *p++ = (sample >>  8) & 0xFF;
+      *p++ = (sample >>  0) & 0xFF;
+      sample = (noiseQtab[noisept++] * noisefac + sin(arg) * 0.0002239) * 8388607.0;
+      *p++ = (sample >> 16) & 0xFF;
+      *p++ = (sample >>  8) & 0xFF;
+      *p++ = (sample >>  0) & 0xFF;
+    }
+  }
+
+  memset(load_stats, 0, sizeof(load_stats));
+}
+
+//
+// Get the sequence error counter and the CPU time (seconds) used by
+// the DDC threads from the metrics server of piHPSDR, which only
+// listens on the loopback interface.
+//
+static long load_client_metrics(double *cpu) {
+  struct sockaddr_in addr;
+  struct timeval tv = {1, 0};
+  static char buffer[65536];
+  const char *key = "\npihpsdr_sequence_errors_total";
+  const char *cpukey = "pihpsdr_thread_cpu_seconds_total{thread=\"P2 DDC";
+  int len = 0, rc;
+  long errors = -1;
+  const char *p;
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+
+  for (int i = 0; i < NUMRECEIVERS; i++) { cpu[i] = -1.0; }
+
+  if (sock < 0) { return -1; }
+
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (void *)&tv, sizeof(tv));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(load_metrics_port);
+
+  if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(sock);
+    return -1;
+  }
+
+  const char *request = "GET /metrics HTTP/1.0\r\n\r\n";
+
+  if (send(sock, request, strlen(request), 0) > 0) {
+    while (len < (int) sizeof(buffer) - 1 && (rc = recv(sock, buffer + len, sizeof(buffer) - 1 - len, 0)) > 0) {
+      len += rc;
+    }
+  }
+
+  close(sock);
+  buffer[len] = 0;
+  //
+  // pihpsdr_sequence_errors_total 0
+  // (older versions of piHPSDR write pihpsdr_sequence_errors_total{} 0)
+  //
+  p = strstr(buffer, key);
+
+  if (p) {
+    p += strlen(key);
+
+    if (!strncmp(p, "{}", 2)) { p += 2; }
+
+    if (*p == ' ') { sscanf(p, "%ld", &errors); }
+  }
+
+  //
+  // pihpsdr_thread_cpu_seconds_total{thread="P2 DDC2",tid="1234"} 0.52
+  //
+  p = buffer;
+
+  while ((p = strstr(p, cpukey)) != NULL) {
+    int ddc;
+    double secs;
+    p += strlen(cpukey);
+
+    if (sscanf(p, "%d%*[^}]} %lf", &ddc, &secs) == 2 && ddc >= 0 && ddc < NUMRECEIVERS) {
+      cpu[ddc] = secs;
+    }
+  }
+
+  return errors;
+}
+
+static void load_report() {
+  static struct timespec last = {0, 0};
+  static unsigned long last_sent = 0;
+  static double last_cpu[NUMRECEIVERS];
+  struct timespec now;
+  unsigned long sent = 0, dropped = 0, reordered = 0, errors = 0;
+  double secs = 0.0;
+
+  for (int i = 0; i < load_ddcs; i++) {
+    sent += load_stats[i].sent;
+    dropped += load_stats[i].dropped;
+    reordered += load_stats[i].reordered;
+    errors += load_stats[i].errors;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  if (last.tv_sec != 0) {
+    secs = (now.tv_sec - last.tv_sec) + 1.0E-9 * (now.tv_nsec - last.tv_nsec);
+  }
+
+  if (secs > 0.0 && sent >= last_sent) {
+    double pps = (sent - last_sent) / secs;
+    t_print("LOAD: %.0f packets/sec, %.1f Mbit/sec\n", pps, pps * 1444.0 * 8.0E-6);
+  }
+
+  last = now;
+  last_sent = sent;
+  t_print("LOAD: sent=%lu dropped=%lu reordered=%lu expected seq errors=%lu\n", sent, dropped, reordered, errors);
+
+  if (load_metrics_port > 0) {
+    double cpu[NUMRECEIVERS];
+    long seen = load_client_metrics(cpu);
+
+    if (seen >= 0) {
+      t_print("LOAD: piHPSDR reports %ld seq errors\n", seen);
+
+      //
+      // CPU load of the DDC threads of piHPSDR (percent of one core)
+      // over the last reporting period. This is the data for the
+      // "CPU per DDC" scaling measurement.
+      //
+      for (int i = 0; i < load_ddcs; i++) {
+        if (cpu[i] >= 0.0 && last_cpu[i] >= 0.0 && secs > 0.0) {
+          t_print("LOAD: piHPSDR DDC%d thread: %.1f%% CPU\n", i, 100.0 * (cpu[i] - last_cpu[i]) / secs);
+        }
+      }
+    } else {
+      t_print("LOAD: cannot read metrics from port %d\n", load_metrics_port);
+    }
+
+    memcpy(last_cpu, cpu, sizeof(last_cpu));
+  }
+}
+
+static int load_send(int sock, int myddc, unsigned long seqnum, int tpl) {
+  unsigned char header[16];
+  struct iovec iov[2];
+  struct msghdr msg;
+  LOAD_STATS *stats = &load_stats[myddc];
+  memset(header, 0, sizeof(header));
+  header[0] = (seqnum >> 24) & 0xFF;
+  header[1] = (seqnum >> 16) & 0xFF;
+  header[2] = (seqnum >>  8) & 0xFF;
+  header[3] = (seqnum >>  0) & 0xFF;
+  // 24 bits per sample
+  header[13] = 24;
+  header[15] = LOAD_SAMPLES;
+  iov[0].iov_base = header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = load_template[tpl];
+  iov[1].iov_len = sizeof(load_template[tpl]);
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &addr_new;
+  msg.msg_namelen = sizeof(addr_new);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 2;
+
+  if (sendmsg(sock, &msg, 0) < 0) {
+    t_perror("***** ERROR: Load thread sendmsg");
+    return -1;
+  }
+
+  //
+  // Do the same sequence check as the receiver
+  //
+  if (seqnum != stats->expected) { stats->errors++; }
+
+  stats->expected = seqnum + 1;
+  stats->sent++;
+  return 0;
+}
+
+void *load_thread(void *data) {
+  int sock;
+  struct sockaddr_in addr;
+  int yes = 1;
+  int myddc = (int) (uintptr_t) data;
+  unsigned long seqnum = 0, held_seqnum = 0;
+  int tpl = 0, held = -1;
+  int inburst = 0;
+  long wait;
+  unsigned int seed;
+  struct timespec delay, report;
+
+  if (myddc < 0 || myddc >= NUMRECEIVERS) { return NULL; }
+
+  seed = ((uintptr_t) &seed) & 0xffffff;
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (sock < 0) {
+    t_perror("***** ERROR: Load thread: socket");
+    return NULL;
+  }
+
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (void *)&yes, sizeof(yes));
+  setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (void *)&yes, sizeof(yes));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(ddc0_port + myddc);
+
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    t_perror("***** ERROR: Load thread: bind");
+    close(sock);
+    return NULL;
+  }
+
+  // time for one packet in nano-secs
+  wait = load_rate > 0 ? (LOAD_SAMPLES * 1000000L) / load_rate : 0;
+
+  if (speed == 1) {
+    wait = (wait * 99) / 100;
+  } else if (speed == -1) {
+    wait = (wait * 101) / 100;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &delay);
+  report = delay;
+
+  while (run) {
+    double r = 100.0 * rand_r(&seed) / (double) RAND_MAX;
+
+    if (r < load_loss) {
+      load_stats[myddc].dropped++;
+    } else if (held < 0 && r < load_loss + load_reorder) {
+      held = tpl;
+      held_seqnum = seqnum;
+      load_stats[myddc].reordered++;
+    } else {
+      if (load_send(sock, myddc, seqnum, tpl) < 0) { break; }
+
+      if (held >= 0) {
+        if (load_send(sock, myddc, held_seqnum, held) < 0) { break; }
+
+        held = -1;
+      }
+    }
+
+    seqnum++;
+
+    if (++tpl >= LOAD_TEMPLATES) { tpl = 0; }
+
+    if (wait > 0 && ++inburst >= load_burst) {
+      delay.tv_nsec += wait * inburst;
+
+      while (delay.tv_nsec >= 1000000000) {
+        delay.tv_nsec -= 1000000000;
+        delay.tv_sec++;
+      }
+
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &delay, NULL);
+      inburst = 0;
+    }
+
+    if (myddc == 0) {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+
+      if (now.tv_sec >= report.tv_sec + LOAD_REPORT) {
+        load_report();
+        report = now;
+      }
+    }
+  }
+
+  close(sock);
+  return NULL;
+}
+
 //
 // This thread receives data (TX samples) from the PC
 //
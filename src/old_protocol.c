@@ -46,10 +46,12 @@
 #include "iambic.h"
 #include "main.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "old_protocol.h"
 #include "radio.h"
 #include "receiver.h"
+#include "threads.h"
 #include "transmitter.h"
 #include "vfo.h"
 
@@ -241,6 +243,7 @@ static volatile int rxring_count  = 0;  // a sample counter
 static gpointer old_protocol_txiq_thread(gpointer data) {
   ASSERT_SERVER(NULL);
   int nptr;
+  thread_setup(THREAD_TX, "P1 TX IQ");
 
   //
   // Ideally, an output METIS buffer with 126 samples is sent every 2625 usec.
@@ -547,6 +550,7 @@ static gpointer ozy_i2c_thread(gpointer arg) {
 static gpointer ozy_ep6_rx_thread(gpointer arg) {
   ASSERT_SERVER(NULL);
   t_print( "old_protocol: USB EP6 receive_thread\n");
+  thread_setup(THREAD_NET, "P1 USB receive");
   static unsigned char ep6_inbuffer[EP6_BUFFER_SIZE];
 
   for (;;) {
@@ -817,6 +821,7 @@ static gpointer receive_thread(gpointer arg) {
   int ep;
   uint32_t sequence;
   t_print( "old_protocol: receive_thread\n");
+  thread_setup(THREAD_NET, "P1 receive");
   length = sizeof(addr);
 
   for (;;) {
@@ -871,6 +876,8 @@ static gpointer receive_thread(gpointer arg) {
         continue;
       }
 
+      metric_inc(METRIC_PACKETS, 0);
+
       if (buffer[0] == 0xEF && buffer[1] == 0xFE) {
         switch (buffer[2]) {
         case 1:
@@ -884,6 +891,7 @@ static gpointer receive_thread(gpointer arg) {
           if (sequence != 0 && sequence != last_seq_num + 1) {
             t_print("SEQ ERROR: last %ld, recvd %ld\n", (long) last_seq_num, (long) sequence);
             sequence_errors++;
+            metric_inc(METRIC_SEQUENCE_ERRORS, 0);
           }
 
           last_seq_num = sequence;
@@ -1567,6 +1575,7 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
     memcpy((void *)(&RXRINGBUF[rxring_inptr + 512]), buf2, 512);
     MEMORY_BARRIER;
     rxring_inptr = nptr;
+    metric_ring(METRIC_RING_P1_RX, nptr, rxring_outptr, RXRINGBUFLEN);
 #ifdef __APPLE__
     sem_post(rxring_sem);
 #else
@@ -1574,6 +1583,7 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
 #endif
   } else {
     t_print("%s: input buffer overflow.\n", __FUNCTION__);
+    metric_inc(METRIC_RING_DROPS, METRIC_RING_P1_RX);
     // if an overflow is encountered, skip the next 256 input buffers
     // to allow a "fresh start"
     rxring_count = -256;
@@ -1582,6 +1592,10 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
 
 static gpointer process_ozy_input_buffer_thread(gpointer arg) {
   ASSERT_SERVER(NULL);
+  //
+  // All receivers are fed from one thread, it goes into the RX1 slot
+  //
+  thread_setup(THREAD_RX1, "P1 process");
 
   //
   // This thread constantly monitors the input ring buffer and
@@ -1683,8 +1697,10 @@ void old_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
 #endif
         txring_inptr = nptr;
         txring_count = 0;
+        metric_ring(METRIC_RING_P1_TX, nptr, txring_outptr, TXRINGBUFLEN);
       } else {
         t_print("%s: output buffer overflow.\n", __FUNCTION__);
+        metric_inc(METRIC_RING_DROPS, METRIC_RING_P1_TX);
         txring_count = -1260;
       }
     }
@@ -1773,8 +1789,10 @@ void old_protocol_iq_samples(int isample, int qsample, int side) {
 #endif
         txring_inptr = nptr;
         txring_count = 0;
+        metric_ring(METRIC_RING_P1_TX, nptr, txring_outptr, TXRINGBUFLEN);
       } else {
         t_print("%s: output buffer overflow.\n", __FUNCTION__);
+        metric_inc(METRIC_RING_DROPS, METRIC_RING_P1_TX);
         txring_count = -1260;
       }
     }
@@ -0,0 +1,79 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <string.h>
+
+#include "pan_layer.h"
+
+void pan_layer_init(PAN_LAYER *layer) {
+  layer->surface = NULL;
+  layer->width = 0;
+  layer->height = 0;
+  layer->valid = 0;
+  layer->nkey = 0;
+}
+
+void pan_layer_invalidate(PAN_LAYER *layer) {
+  layer->valid = 0;
+}
+
+void pan_layer_destroy(PAN_LAYER *layer) {
+  if (layer->surface) {
+    cairo_surface_destroy(layer->surface);
+  }
+
+  pan_layer_init(layer);
+}
+
+cairo_t *pan_layer_begin(PAN_LAYER *layer, cairo_surface_t *target, int width, int height,
+                         const double *key, int nkey) {
+  if (nkey > PAN_LAYER_KEYS) { nkey = PAN_LAYER_KEYS; }
+
+  if (layer->surface == NULL || layer->width != width || layer->height != height) {
+    if (layer->surface) {
+      cairo_surface_destroy(layer->surface);
+    }
+
+    //
+    // A "similar" surface has the same backend as the panadapter surface,
+    // so copying the layer there is a plain blit (no format conversion,
+    // no upload to the X server).
+    //
+    layer->surface = cairo_surface_create_similar(target, CAIRO_CONTENT_COLOR, width, height);
+    layer->width = width;
+    layer->height = height;
+    layer->valid = 0;
+  }
+
+  if (layer->valid && layer->nkey == nkey && memcmp(layer->key, key, nkey * sizeof(double)) == 0) {
+    return NULL;
+  }
+
+  memcpy(layer->key, key, nkey * sizeof(double));
+  layer->nkey = nkey;
+  layer->valid = 1;
+  return cairo_create(layer->surface);
+}
+
+void pan_layer_paint(const PAN_LAYER *layer, cairo_t *cr) {
+  cairo_save(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface(cr, layer->surface, 0.0, 0.0);
+  cairo_paint(cr);
+  cairo_restore(cr);
+}
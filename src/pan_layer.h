@@ -0,0 +1,62 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _PAN_LAYER_H_
+#define _PAN_LAYER_H_
+
+#include <cairo.h>
+
+//
+// A cached "static" layer of a panadapter (background, filter passband,
+// dBm grid, frequency markers and labels, band edges). It is drawn into
+// an offscreen surface and copied to the panadapter surface in each
+// frame, only the spectrum trace and the fast-changing decorations are
+// drawn on top of it.
+//
+// The layer is re-drawn if it has been invalidated explicitly, or if one
+// of the parameters it has been drawn with (the "key") has changed.
+//
+#define PAN_LAYER_KEYS 24
+
+typedef struct _pan_layer {
+  cairo_surface_t *surface;
+  int width;
+  int height;
+  int valid;
+  int nkey;
+  double key[PAN_LAYER_KEYS];
+} PAN_LAYER;
+
+extern void pan_layer_init(PAN_LAYER *layer);
+extern void pan_layer_invalidate(PAN_LAYER *layer);
+extern void pan_layer_destroy(PAN_LAYER *layer);
+
+//
+// Returns a cairo context for re-drawing the layer, or NULL if the cached
+// layer is still valid. The caller draws the static content and destroys
+// the context.
+//
+extern cairo_t *pan_layer_begin(PAN_LAYER *layer, cairo_surface_t *target, int width, int height,
+                                const double *key, int nkey);
+
+//
+// Copy the layer to cr, this replaces everything drawn there before.
+//
+extern void pan_layer_paint(const PAN_LAYER *layer, cairo_t *cr);
+
+#endif
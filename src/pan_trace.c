@@ -0,0 +1,213 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <string.h>
+
+#include "pan_trace.h"
+
+void pan_trace_init(PAN_TRACE *trace) {
+  trace->surface = NULL;
+  trace->width = 0;
+  trace->height = 0;
+}
+
+void pan_trace_destroy(PAN_TRACE *trace) {
+  if (trace->surface) {
+    cairo_surface_destroy(trace->surface);
+  }
+
+  pan_trace_init(trace);
+}
+
+void pan_trace_scale(const float *samples, int n, double offset, int panhi, int panlo,
+                     int width, int height, int *ytop, int *ybot) {
+  //
+  // y = floor((panhi - sample - offset) * height / (panhi - panlo)),
+  // with the scale factor and the constant part computed only once.
+  // The values are limited to -1 ... height (one pixel outside the
+  // drawing area), so the conversion to int is a floor operation.
+  //
+  const double k = (double)height / (double)(panhi - panlo);
+  const double c = ((double)panhi - offset) * k;
+  const double ymax = (double)height;
+
+  for (int x = 0; x < width; x++) {
+    int i0 = (int)(((long)x * n) / width);
+    int i1 = (int)(((long)(x + 1) * n) / width);
+    int top = height;
+    int bot = -1;
+
+    if (i1 <= i0) { i1 = i0 + 1; }
+
+    for (int i = i0; i < i1; i++) {
+      double v = c - (double)samples[i] * k;
+      int y;
+
+      if (!(v > -1.0)) { v = -1.0; }
+
+      if (v > ymax) { v = ymax; }
+
+      y = (int)(v + 1.0) - 1;
+
+      if (y < top) { top = y; }
+
+      if (y > bot) { bot = y; }
+    }
+
+    ytop[x] = top;
+    ybot[x] = bot;
+  }
+}
+
+void pan_trace_path(cairo_t *cr, const int *ytop, const int *ybot, int width) {
+  //
+  // Points inside a horizontal run are not needed, so only the first
+  // and the last point of a run are added to the path. "ey" is the y
+  // coordinate of the last point added, a pending point (qx, ey) ends
+  // the current run.
+  //
+  int ey = ytop[0];
+  int qx = 0;
+  int pending = 0;
+  cairo_move_to(cr, 0.0, (double)ey);
+
+  for (int x = 0; x < width; x++) {
+    int y[2];
+    int npt = 1;
+
+    if (ytop[x] == ybot[x]) {
+      y[0] = ytop[x];
+    } else if (ey <= ytop[x]) {
+      y[0] = ytop[x];
+      y[1] = ybot[x];
+      npt = 2;
+    } else {
+      y[0] = ybot[x];
+      y[1] = ytop[x];
+      npt = 2;
+    }
+
+    for (int j = 0; j < npt; j++) {
+      if (y[j] == ey) {
+        qx = x;
+        pending = 1;
+      } else {
+        if (pending) {
+          cairo_line_to(cr, (double)qx, (double)ey);
+          pending = 0;
+        }
+
+        cairo_line_to(cr, (double)x, (double)y[j]);
+        ey = y[j];
+      }
+    }
+  }
+
+  if (pending) {
+    cairo_line_to(cr, (double)qx, (double)ey);
+  }
+}
+
+static uint32_t pan_trace_pixel(double r, double g, double b, double a) {
+  uint32_t ia = (uint32_t)(a * 255.0 + 0.5);
+  uint32_t ir = (uint32_t)(r * a * 255.0 + 0.5);
+  uint32_t ig = (uint32_t)(g * a * 255.0 + 0.5);
+  uint32_t ib = (uint32_t)(b * a * 255.0 + 0.5);
+  return (ia << 24) | (ir << 16) | (ig << 8) | ib;
+}
+
+void pan_trace_colours(uint32_t *colours, int height, int nstops,
+                       const double *offsets, const double (*rgba)[4]) {
+  for (int row = 0; row < height; row++) {
+    //
+    // same geometry as a cairo linear gradient from (0, height) to (0, 0),
+    // evaluated at the pixel centre, with the colours extended beyond
+    // the first and last stop.
+    //
+    double t = ((double)height - (double)row - 0.5) / (double)height;
+    int j = 0;
+
+    while (j < nstops && offsets[j] < t) { j++; }
+
+    if (j == 0) {
+      colours[row] = pan_trace_pixel(rgba[0][0], rgba[0][1], rgba[0][2], rgba[0][3]);
+    } else if (j == nstops) {
+      const double *c = rgba[nstops - 1];
+      colours[row] = pan_trace_pixel(c[0], c[1], c[2], c[3]);
+    } else {
+      const double *c0 = rgba[j - 1];
+      const double *c1 = rgba[j];
+      double w = offsets[j] - offsets[j - 1];
+      double f = w > 0.0 ? (t - offsets[j - 1]) / w : 1.0;
+      colours[row] = pan_trace_pixel(c0[0] + f * (c1[0] - c0[0]), c0[1] + f * (c1[1] - c0[1]),
+                                     c0[2] + f * (c1[2] - c0[2]), c0[3] + f * (c1[3] - c0[3]));
+    }
+  }
+}
+
+void pan_trace_raster(PAN_TRACE *trace, cairo_t *cr, const int *ytop, const int *ybot,
+                      int width, int height, const uint32_t *colours, int filled) {
+  if (width <= 0 || height <= 0) { return; }
+
+  if (trace->surface == NULL || trace->width != width || trace->height != height) {
+    if (trace->surface) {
+      cairo_surface_destroy(trace->surface);
+    }
+
+    trace->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    trace->width = width;
+    trace->height = height;
+  }
+
+  cairo_surface_flush(trace->surface);
+  unsigned char *data = cairo_image_surface_get_data(trace->surface);
+  int stride = cairo_image_surface_get_stride(trace->surface);
+  memset(data, 0, (size_t)stride * height);
+
+  for (int x = 0; x < width; x++) {
+    int lo = ytop[x];
+    int hi = ybot[x];
+
+    //
+    // Connect to the previous column, such that steep parts of
+    // the trace have no gaps
+    //
+    if (x > 0) {
+      if (ybot[x - 1] < lo) { lo = ybot[x - 1] + 1; }
+
+      if (ytop[x - 1] > hi) { hi = ytop[x - 1] - 1; }
+    }
+
+    if (filled) { hi = height - 1; }
+
+    if (lo < 0) { lo = 0; }
+
+    if (hi > height - 1) { hi = height - 1; }
+
+    unsigned char *p = data + (size_t)lo * stride + 4 * x;
+
+    for (int row = lo; row <= hi; row++) {
+      *(uint32_t *)p = colours[row];
+      p += stride;
+    }
+  }
+
+  cairo_surface_mark_dirty(trace->surface);
+  cairo_set_source_surface(cr, trace->surface, 0.0, 0.0);
+  cairo_paint(cr);
+}
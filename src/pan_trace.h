@@ -0,0 +1,68 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _PAN_TRACE_H_
+#define _PAN_TRACE_H_
+
+#include <stdint.h>
+#include <cairo.h>
+
+//
+// Spectrum trace of a panadapter.
+//
+// pan_trace_scale() maps the samples (in dBm) to y coordinates (in pixels)
+// once per frame. If there are more samples than columns, each column
+// gets the min/max envelope of its samples. The trace can then either be
+// drawn as a cairo path (pan_trace_path), where points in horizontal runs
+// are omitted, or be rasterized directly into an image surface
+// (pan_trace_raster) which bypasses the cairo path tessellation.
+//
+typedef struct _pan_trace {
+  cairo_surface_t *surface;  // ARGB32 overlay used by pan_trace_raster
+  int width;
+  int height;
+} PAN_TRACE;
+
+extern void pan_trace_init(PAN_TRACE *trace);
+extern void pan_trace_destroy(PAN_TRACE *trace);
+
+//
+// ytop[x], ybot[x] is the vertical extent of the trace in column x.
+// "offset" is added to all samples.
+//
+extern void pan_trace_scale(const float *samples, int n, double offset, int panhi, int panlo,
+                            int width, int height, int *ytop, int *ybot);
+
+extern void pan_trace_path(cairo_t *cr, const int *ytop, const int *ybot, int width);
+
+//
+// Colour table with one (premultiplied ARGB32) entry per row, obtained from
+// the colour stops of a vertical gradient (offset 0.0 is the bottom, 1.0
+// the top row). With a single stop, all rows have the same colour.
+//
+extern void pan_trace_colours(uint32_t *colours, int height, int nstops,
+                              const double *offsets, const double (*rgba)[4]);
+
+//
+// Draw the trace (filled to the bottom, if "filled" is set) with the row
+// colours, and paint it onto cr.
+//
+extern void pan_trace_raster(PAN_TRACE *trace, cairo_t *cr, const int *ytop, const int *ybot,
+                             int width, int height, const uint32_t *colours, int filled);
+
+#endif
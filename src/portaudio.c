@@ -41,6 +41,7 @@
 #include "audio.h"
 #include "client_server.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "radio.h"
 #include "receiver.h"
@@ -284,12 +285,14 @@ static int pa_out_cb(const void *inputBuffer, void *outputBuffer, unsigned long
     // util callback is completed
     //
     int newpt = rx->local_audio_buffer_outpt;
+    int underrun = 0;
 
     for (unsigned int i = 0; i < framesPerBuffer; i++) {
       if (rx->local_audio_buffer_inpt == newpt) {
         // Ring buffer empty, send zero sample
         *out++ = 0.0;
         *out++ = 0.0;
+        underrun = 1;
       } else {
         *out++ = rx->local_audio_buffer[2 * newpt];
         *out++ = rx->local_audio_buffer[2 * newpt + 1];
@@ -301,6 +304,8 @@ static int pa_out_cb(const void *inputBuffer, void *outputBuffer, unsigned long
         rx->local_audio_buffer_outpt = newpt;
       }
     }
+
+    if (underrun) { metric_inc(METRIC_AUDIO_UNDERRUNS, rx->id); }
   }
 
   g_mutex_unlock(&rx->local_audio_mutex);
@@ -384,6 +389,8 @@ static int pa_mic_cb(const void *inputBuffer, void *outputBuffer, unsigned long
         MEMORY_BARRIER;
         // atomic update of mic_ring_inpt
         mic_ring_inpt = newpt;
+      } else {
+        metric_inc(METRIC_MIC_OVERRUNS, 0);
       }
     }
   }
@@ -40,8 +40,11 @@ gboolean enable_soapy_protocol;
 gboolean enable_stemlab;
 gboolean enable_usbozy;
 gboolean enable_saturn_xdma;
+gboolean enable_file_playback;
 gboolean autostart;
 
+char playback_directory[256] = ".";
+
 static void protocolsSaveState() {
   clearProperties();
   SetPropI0("enable_protocol_1",     enable_protocol_1);
@@ -50,6 +53,8 @@ static void protocolsSaveState() {
   SetPropI0("enable_stemlab",        enable_stemlab);
   SetPropI0("enable_usbozy",         enable_usbozy);
   SetPropI0("enable_saturn_xdma",    enable_saturn_xdma);
+  SetPropI0("enable_file_playback",  enable_file_playback);
+  SetPropS0("playback_directory",    playback_directory);
   SetPropI0("autostart",             autostart);
   saveProperties("protocols.props");
 }
@@ -65,6 +70,7 @@ void protocolsRestoreState() {
   enable_usbozy = TRUE;
   enable_soapy_protocol = TRUE;
   enable_saturn_xdma = TRUE;
+  enable_file_playback = FALSE;
   autostart = FALSE;
   GetPropI0("enable_protocol_1",     enable_protocol_1);
   GetPropI0("enable_protocol_2",     enable_protocol_2);
@@ -72,6 +78,8 @@ void protocolsRestoreState() {
   GetPropI0("enable_stemlab",        enable_stemlab);
   GetPropI0("enable_usbozy",         enable_usbozy);
   GetPropI0("enable_saturn_xdma",    enable_saturn_xdma);
+  GetPropI0("enable_file_playback",  enable_file_playback);
+  GetPropS0("playback_directory",    playback_directory);
   GetPropI0("autostart",             autostart);
   clearProperties();
 }
@@ -125,6 +133,14 @@ static void usbozy_cb(GtkToggleButton *widget, gpointer data) {
 
 #endif
 
+static void file_playback_cb(GtkToggleButton *widget, gpointer data) {
+  enable_file_playback = gtk_toggle_button_get_active(widget);
+}
+
+static void playback_directory_cb(GtkWidget *widget, gpointer data) {
+  snprintf(playback_directory, sizeof(playback_directory), "%s", gtk_entry_get_text(GTK_ENTRY(widget)));
+}
+
 static void autostart_cb(GtkToggleButton *widget, gpointer data) {
   autostart = gtk_toggle_button_get_active(widget);
 }
@@ -191,6 +207,17 @@ void configure_protocols(GtkWidget *parent) {
   gtk_grid_attach(GTK_GRID(grid), b_enable_stemlab, 0, row, 1, 1);
   row++;
 #endif
+  GtkWidget *b_file_playback = gtk_check_button_new_with_label("Enable IQ file playback from");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (b_file_playback), enable_file_playback);
+  gtk_widget_show(b_file_playback);
+  g_signal_connect(b_file_playback, "toggled", G_CALLBACK(file_playback_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), b_file_playback, 0, row, 1, 1);
+  GtkWidget *e_playback_directory = gtk_entry_new();
+  gtk_entry_set_text(GTK_ENTRY(e_playback_directory), playback_directory);
+  gtk_widget_show(e_playback_directory);
+  g_signal_connect(e_playback_directory, "changed", G_CALLBACK(playback_directory_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), e_playback_directory, 1, row, 1, 1);
+  row++;
   GtkWidget *b_autostart = gtk_check_button_new_with_label("Auto start if only one device");
   gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (b_autostart), autostart);
   gtk_widget_show(b_autostart);
@@ -25,6 +25,8 @@ extern gboolean enable_saturn_xdma;
 extern gboolean enable_soapy_protocol;
 extern gboolean enable_stemlab;
 extern gboolean enable_usbozy;
+extern gboolean enable_file_playback;
+extern char playback_directory[256];
 extern gboolean autostart;
 
 extern void protocolsRestoreState(void);
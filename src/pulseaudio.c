@@ -25,9 +25,11 @@
 #include "audio.h"
 #include "client_server.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "radio.h"
 #include "receiver.h"
+#include "threads.h"
 #include "transmitter.h"
 #include "vfo.h"
 
@@ -203,6 +205,7 @@ int audio_open_output(RECEIVER *rx) {
 static void *mic_read_thread(gpointer arg) {
   int err;
   t_print("%s: running=%d\n", __FUNCTION__, running);
+  thread_setup(THREAD_AUDIO, "Pulse mic");
 
   while (running) {
     //
@@ -241,6 +244,8 @@ static void *mic_read_thread(gpointer arg) {
           mic_ring_buffer[mic_ring_write_pt] = local_microphone_buffer[i];
           // atomic update of mic_ring_write_pt
           mic_ring_write_pt = newpt;
+        } else {
+          metric_inc(METRIC_MIC_OVERRUNS, 0);
         }
       }
     }
@@ -27,6 +27,8 @@
 #include <netdb.h>
 #include <termios.h>
 
+#include <wdsp.h>    // only needed for SetChannelThreadCallback() and SetWDSPFastMath()
+
 #include "actions.h"
 #include "adc.h"
 #include "agc.h"
@@ -38,6 +40,7 @@
 #include "css.h"
 #include "discovered.h"
 #include "ext.h"
+#include "file_protocol.h"
 #include "filter.h"
 #include "g2panel.h"
 #include "gpio.h"
@@ -45,6 +48,7 @@
 #include "main.h"
 #include "meter.h"
 #include "message.h"
+#include "metrics.h"
 #ifdef MIDI
   #include "midi.h"
 #endif
@@ -55,11 +59,14 @@
 #include "property.h"
 #include "radio.h"
 #include "receiver.h"
+#include "recorder.h"
 #include "rigctl.h"
 #include "rx_panadapter.h"
+#include "send_queue.h"
 #include "sliders.h"
 #include "tci.h"
 #include "test_menu.h"
+#include "threads.h"
 #include "toolbar.h"
 #include "transmitter.h"
 #ifdef TTS
@@ -93,6 +100,7 @@ static int TOOLBAR_HEIGHT = 30;   // dynamically adjusted to the display height
 
 int rx_stack_horizontal = 0;
 int suppress_popup_sliders = 0;
+int wdsp_fast_math = 0;           // use the approximate log/exp functions in WDSP
 
 int controller = NO_CONTROLLER;
 
@@ -619,6 +627,15 @@ static int set_full_screen(gpointer data) {
 }
 
 void radio_reconfigure_screen() {
+  if (headless) {
+    //
+    // There is no screen, but the width of the spectrum data
+    // follows display_width[display_size] (set by the client)
+    //
+    radio_reconfigure();
+    return;
+  }
+
   GdkWindow *gw = gtk_widget_get_window(top_window);
   GdkWindowState ws = gdk_window_get_state(GDK_WINDOW(gw));
   int last_fullscreen = SET(ws & GDK_WINDOW_STATE_FULLSCREEN);
@@ -739,10 +756,13 @@ void radio_reconfigure() {
       g_mutex_lock(&rx->display_mutex);
       rx->width = my_width / receivers;
       rx_update_width(rx);
-      rx_reconfigure(rx, rx_height);
 
-      if (!radio_is_transmitting() || duplex) {
-        gtk_fixed_move(GTK_FIXED(fixed), rx->panel, x, y);
+      if (!headless) {
+        rx_reconfigure(rx, rx_height);
+
+        if (!radio_is_transmitting() || duplex) {
+          gtk_fixed_move(GTK_FIXED(fixed), rx->panel, x, y);
+        }
       }
 
       g_mutex_unlock(&rx->display_mutex);
@@ -758,10 +778,13 @@ void radio_reconfigure() {
       g_mutex_lock(&rx->display_mutex);
       rx->width = my_width;
       rx_update_width(rx);
-      rx_reconfigure(rx, rx_height / receivers);
 
-      if (!radio_is_transmitting() || duplex) {
-        gtk_fixed_move(GTK_FIXED(fixed), rx->panel, 0, y);
+      if (!headless) {
+        rx_reconfigure(rx, rx_height / receivers);
+
+        if (!radio_is_transmitting() || duplex) {
+          gtk_fixed_move(GTK_FIXED(fixed), rx->panel, 0, y);
+        }
       }
 
       g_mutex_unlock(&rx->display_mutex);
@@ -771,19 +794,21 @@ void radio_reconfigure() {
     }
   }
 
-  if (slider_rows > 0) {
-    sliders_create(my_width, SLIDERS_HEIGHT, slider_rows);
-    sliders_show_sliders(y);
-    y += SLIDERS_HEIGHT * slider_rows;
-  } else {
-    sliders_destroy();
-  }
+  if (!headless) {
+    if (slider_rows > 0) {
+      sliders_create(my_width, SLIDERS_HEIGHT, slider_rows);
+      sliders_show_sliders(y);
+      y += SLIDERS_HEIGHT * slider_rows;
+    } else {
+      sliders_destroy();
+    }
 
-  if (toolbar_rows > 0) {
-    toolbar_create(my_width, TOOLBAR_HEIGHT, toolbar_rows);
-    toolbar_show(y);
-  } else {
-    toolbar_destroy();
+    if (toolbar_rows > 0) {
+      toolbar_create(my_width, TOOLBAR_HEIGHT, toolbar_rows);
+      toolbar_show(y);
+    } else {
+      toolbar_destroy();
+    }
   }
 
   if (can_transmit && !duplex) {
@@ -842,29 +867,44 @@ static gboolean menu_cb (GtkWidget *widget, GdkEventButton *event, gpointer data
 
 static void radio_create_visual() {
   int y = 0;
-  fixed = gtk_fixed_new();
-  g_object_ref(topgrid);  // so it does not get deleted
-  gtk_container_remove(GTK_CONTAINER(top_window), topgrid);
-  gtk_container_add(GTK_CONTAINER(top_window), fixed);
+  //
+  // This is the GTK main thread. Register it, and make WDSP report
+  // its channel threads, before the receivers and the transmitter
+  // are created.
+  //
+  thread_setup(THREAD_DISPLAY, "GTK main");
+  SetChannelThreadCallback(thread_wdsp_callback);
+  SetWDSPFastMath(wdsp_fast_math);
   int my_height = display_height[display_size];
   int my_width  = display_width[display_size];
   VFO_WIDTH = my_width - MENU_WIDTH - METER_WIDTH;
-  vfo_panel = vfo_init(VFO_WIDTH, VFO_HEIGHT);
-  gtk_fixed_put(GTK_FIXED(fixed), vfo_panel, 0, y);
-  meter = meter_init(METER_WIDTH, VFO_HEIGHT);
-  gtk_fixed_put(GTK_FIXED(fixed), meter, VFO_WIDTH, y);
-  hide_b = gtk_button_new_with_label("Hide");
-  gtk_widget_set_name(hide_b, "boldlabel");
-  gtk_widget_set_size_request (hide_b, MENU_WIDTH, VFO_HEIGHT / 2);
-  g_signal_connect(hide_b, "button-press-event", G_CALLBACK(hideall_cb), NULL);
-  gtk_fixed_put(GTK_FIXED(fixed), hide_b, VFO_WIDTH + METER_WIDTH, y);
-  y += VFO_HEIGHT / 2;
-  menu_b = gtk_button_new_with_label("Menu");
-  gtk_widget_set_name(menu_b, "boldlabel");
-  gtk_widget_set_size_request (menu_b, MENU_WIDTH, VFO_HEIGHT / 2);
-  g_signal_connect (menu_b, "button-press-event", G_CALLBACK(menu_cb), NULL) ;
-  gtk_fixed_put(GTK_FIXED(fixed), menu_b, VFO_WIDTH + METER_WIDTH, y);
-  y += VFO_HEIGHT / 2;
+
+  //
+  // When running headless, the receivers and the transmitter
+  // are created, but no widgets.
+  //
+  if (!headless) {
+    fixed = gtk_fixed_new();
+    g_object_ref(topgrid);  // so it does not get deleted
+    gtk_container_remove(GTK_CONTAINER(top_window), topgrid);
+    gtk_container_add(GTK_CONTAINER(top_window), fixed);
+    vfo_panel = vfo_init(VFO_WIDTH, VFO_HEIGHT);
+    gtk_fixed_put(GTK_FIXED(fixed), vfo_panel, 0, y);
+    meter = meter_init(METER_WIDTH, VFO_HEIGHT);
+    gtk_fixed_put(GTK_FIXED(fixed), meter, VFO_WIDTH, y);
+    hide_b = gtk_button_new_with_label("Hide");
+    gtk_widget_set_name(hide_b, "boldlabel");
+    gtk_widget_set_size_request (hide_b, MENU_WIDTH, VFO_HEIGHT / 2);
+    g_signal_connect(hide_b, "button-press-event", G_CALLBACK(hideall_cb), NULL);
+    gtk_fixed_put(GTK_FIXED(fixed), hide_b, VFO_WIDTH + METER_WIDTH, y);
+    menu_b = gtk_button_new_with_label("Menu");
+    gtk_widget_set_name(menu_b, "boldlabel");
+    gtk_widget_set_size_request (menu_b, MENU_WIDTH, VFO_HEIGHT / 2);
+    g_signal_connect (menu_b, "button-press-event", G_CALLBACK(menu_cb), NULL) ;
+    gtk_fixed_put(GTK_FIXED(fixed), menu_b, VFO_WIDTH + METER_WIDTH, y + VFO_HEIGHT / 2);
+  }
+
+  y += VFO_HEIGHT;
   rx_height = my_height - VFO_HEIGHT;
   rx_height -= SLIDERS_HEIGHT * slider_rows;
   rx_height -= TOOLBAR_HEIGHT * toolbar_rows;
@@ -891,8 +931,11 @@ static void radio_create_visual() {
       rx_set_offset(receiver[i]);
     }
 
-    gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, 0, y);
-    g_object_ref((gpointer)receiver[i]->panel);
+    if (!headless) {
+      gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, 0, y);
+      g_object_ref((gpointer)receiver[i]->panel);
+    }
+
     y += rx_height / RECEIVERS;
   }
 
@@ -992,16 +1035,20 @@ static void radio_create_visual() {
       soapy_protocol_init(FALSE);
 #endif
       break;
+
+    case FILE_PROTOCOL:
+      file_protocol_init();
+      break;
     }
   }
 
-  if (slider_rows > 0) {
+  if (slider_rows > 0 && !headless) {
     sliders_create(my_width, SLIDERS_HEIGHT, slider_rows);
     sliders_show_sliders(y);
     y += SLIDERS_HEIGHT * slider_rows;
   }
 
-  if (toolbar_rows > 0) {
+  if (toolbar_rows > 0 && !headless) {
     toolbar_create(my_width, TOOLBAR_HEIGHT, toolbar_rows);
     toolbar_show(y);
   }
@@ -1025,8 +1072,10 @@ static void radio_create_visual() {
     }
   }
 
-  gtk_widget_show_all (top_window);             // ... this shows both the HPSDR and C25 preamp/att sliders
-  g_idle_add(sliders_att_type_changed, NULL);   // ... and this hides the „wrong“ ones.
+  if (!headless) {
+    gtk_widget_show_all (top_window);             // ... this shows both the HPSDR and C25 preamp/att sliders
+    g_idle_add(sliders_att_type_changed, NULL);   // ... and this hides the „wrong“ ones.
+  }
 }
 
 void radio_stop_program() {
@@ -1036,6 +1085,7 @@ void radio_stop_program() {
 #endif
 
   if (!radio_is_remote) {
+    recorder_close();
     radio_protocol_stop();
     t_print("%s: protocol stopped\n", __FUNCTION__);
     radio_stop_radio();
@@ -1050,6 +1100,7 @@ void radio_stop_program() {
 
   radio_save_state();
   t_print("%s: radio state saved\n", __FUNCTION__);
+  t_print_flush();
 }
 
 void radio_exit_program() {
@@ -1097,7 +1148,10 @@ void radio_start_radio() {
     }
   }
 
-  gdk_window_set_cursor(gtk_widget_get_window(top_window), gdk_cursor_new(GDK_WATCH));
+  if (!headless) {
+    gdk_window_set_cursor(gtk_widget_get_window(top_window), gdk_cursor_new(GDK_WATCH));
+  }
+
   //
   // The behaviour of pop-up menus (Combo-Boxes) can be set to
   // "mouse friendly" (standard case) and "touchscreen friendly"
@@ -1315,6 +1369,7 @@ void radio_start_radio() {
     break;
 
   case DEVICE_STEMLAB:
+  case FILE_DEVICE:
     break;
 
   default:
@@ -1367,6 +1422,11 @@ void radio_start_radio() {
              (radio->software_version % 100) / 10,
              radio->software_version % 10);
     break;
+
+  case FILE_PROTOCOL:
+    snprintf(p, sizeof(p), "IQ file");
+    snprintf(version, sizeof(version), "%d kHz", radio->playback.sample_rate / 1000);
+    break;
   }
 
   //
@@ -1414,6 +1474,7 @@ void radio_start_radio() {
     break;
 
   case SOAPYSDR_PROTOCOL:
+  case FILE_PROTOCOL:
     snprintf(text, sizeof(text), "piHPSDR: %s (%s %s)",
              radio->name,
              p,
@@ -1421,7 +1482,9 @@ void radio_start_radio() {
     break;
   }
 
-  gtk_window_set_title (GTK_WINDOW (top_window), text);
+  if (!headless) {
+    gtk_window_set_title (GTK_WINDOW (top_window), text);
+  }
 
   //
   // determine name of the props file
@@ -1448,6 +1511,13 @@ void radio_start_radio() {
 
     break;
 
+  case FILE_DEVICE:
+    //
+    // All recordings share one props file
+    //
+    snprintf(property_path, sizeof(property_path), "playback.props");
+    break;
+
   default:
     if (have_saturn_xdma) {
       snprintf(property_path, sizeof(property_path), "saturn.xdma.props");
@@ -1501,6 +1571,10 @@ void radio_start_radio() {
 
     break;
 
+  case FILE_DEVICE:
+    n_adc = radio->supported_receivers;
+    break;
+
   default:
     n_adc = 2;
     break;
@@ -1577,6 +1651,10 @@ void radio_start_radio() {
     filter_board = NO_FILTER_BOARD;
     break;
 
+  case FILE_DEVICE:
+    filter_board = NO_FILTER_BOARD;
+    break;
+
   default:
     filter_board = ALEX;
     break;
@@ -1595,6 +1673,13 @@ void radio_start_radio() {
     t_print("%s: setup %d receivers for SoapySDR\n", __FUNCTION__, RECEIVERS);
     break;
 
+  case FILE_PROTOCOL:
+    RECEIVERS = radio->supported_receivers;
+    PS_TX_FEEDBACK = RECEIVERS;
+    PS_RX_FEEDBACK = RECEIVERS + 1;
+    t_print("%s: setup %d receivers for IQ file playback\n", __FUNCTION__, RECEIVERS);
+    break;
+
   default:
     t_print("%s: default setup for 2 receivers\n", __FUNCTION__);
     RECEIVERS = 2;
@@ -1617,6 +1702,10 @@ void radio_start_radio() {
     launch_tcp_rigctl();
   }
 
+  if (metrics_http_enable) {
+    metrics_http_start();
+  }
+
   for (int id = 0; id < MAX_SERIAL; id++) {
     //
     // If serial port is enabled but no success, clear "enable" flag
@@ -1713,7 +1802,15 @@ void radio_start_radio() {
   }  // protocol == SOAPYSDR
 
 #endif
-  gdk_window_set_cursor(gtk_widget_get_window(top_window), gdk_cursor_new(GDK_ARROW));
+
+  if (protocol == FILE_PROTOCOL) {
+    file_protocol_run();
+  }
+
+  if (!headless) {
+    gdk_window_set_cursor(gtk_widget_get_window(top_window), gdk_cursor_new(GDK_ARROW));
+  }
+
 #ifdef MIDI
 
   for (int i = 0; i < n_midi_devices; i++) {
@@ -1742,7 +1839,7 @@ void radio_start_radio() {
     create_hpsdr_server();
   }
 
-  if (open_test_menu) {
+  if (open_test_menu && !headless) {
     test_menu(top_window);
   }
 
@@ -1764,8 +1861,11 @@ void radio_start_radio() {
   //
   // Now the radio is up and running. Connect "Radio" keyboard interceptor
   //
-  g_signal_handler_disconnect(top_window, keypress_signal_id);
-  keypress_signal_id = g_signal_connect(top_window, "key_press_event", G_CALLBACK(radio_keypress_cb), NULL);
+  if (!headless) {
+    g_signal_handler_disconnect(top_window, keypress_signal_id);
+    keypress_signal_id = g_signal_connect(top_window, "key_press_event", G_CALLBACK(radio_keypress_cb), NULL);
+  }
+
   //
   // mark radio as "running"
   //
@@ -1821,12 +1921,19 @@ void radio_change_receivers(int r) {
   case 1:
     receiver[1]->displaying = 0;
     rx_set_displaying(receiver[1]);
-    gtk_container_remove(GTK_CONTAINER(fixed), receiver[1]->panel);
+
+    if (!headless) {
+      gtk_container_remove(GTK_CONTAINER(fixed), receiver[1]->panel);
+    }
+
     receivers = 1;
     break;
 
   case 2:
-    gtk_fixed_put(GTK_FIXED(fixed), receiver[1]->panel, 0, 0);
+    if (!headless) {
+      gtk_fixed_put(GTK_FIXED(fixed), receiver[1]->panel, 0, 0);
+    }
+
     receiver[1]->displaying = 1;
     rx_set_displaying(receiver[1]);
     receivers = 2;
@@ -1928,6 +2035,8 @@ static void rxtx(int state) {
           send_startstop_rxspectrum(client_socket, i, 0);
         }
 
+        if (headless) { continue; }
+
         g_object_ref((gpointer)receiver[i]->panel);
 
         if (receiver[i]->panadapter != NULL) {
@@ -1942,7 +2051,9 @@ static void rxtx(int state) {
       }
     }
 
-    if (transmitter->dialog) {
+    if (headless) {
+      // no TX panel
+    } else if (transmitter->dialog) {
       gtk_widget_show_all(transmitter->dialog);
 
       if (transmitter->dialog_x != -1 && transmitter->dialog_y != -1) {
@@ -2017,7 +2128,9 @@ static void rxtx(int state) {
       send_startstop_txspectrum(client_socket, 0);
     }
 
-    if (transmitter->dialog) {
+    if (headless) {
+      // no TX panel
+    } else if (transmitter->dialog) {
       gtk_window_get_position(GTK_WINDOW(transmitter->dialog), &transmitter->dialog_x, &transmitter->dialog_y);
       gtk_widget_hide(transmitter->dialog);
     } else {
@@ -2067,7 +2180,10 @@ static void rxtx(int state) {
       }
 
       for (i = 0; i < receivers; i++) {
-        gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, receiver[i]->x, receiver[i]->y);
+        if (!headless) {
+          gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, receiver[i]->x, receiver[i]->y);
+        }
+
         receiver[i]->displaying = 1;
 
         if (!radio_is_remote) {
@@ -2260,7 +2376,15 @@ void radio_set_duplex(int state) {
 
   duplex = state;
 
-  if (duplex) {
+  if (headless) {
+    int width = display_width[display_size];
+
+    if (duplex) {
+      tx_reconfigure(transmitter, 4 * tx_dialog_width, tx_dialog_width,  tx_dialog_height);
+    } else {
+      tx_reconfigure(transmitter, width, width, rx_height);
+    }
+  } else if (duplex) {
     // TX is in separate window, also in full-screen mode
     gtk_container_remove(GTK_CONTAINER(fixed), transmitter->panel);
     tx_reconfigure(transmitter, 4 * tx_dialog_width, tx_dialog_width,  tx_dialog_height);
@@ -3190,8 +3314,8 @@ void radio_apply_band_settings(int flag, int id) {
   //
   // If a client is connected, update ADC0 data on the client side
   //
-  if (remoteclient.running) {
-    send_adc_data(remoteclient.socket, rxadc);
+  if (remoteclients > 0) {
+    send_adc_data(SEND_ALL, rxadc);
   }
 
   schedule_high_priority();         // possibly update RX/TX antennas
@@ -3292,6 +3416,7 @@ static void radio_restore_state() {
   GetPropI0("display_width",                                 display_width[1]);
   GetPropI0("display_height",                                display_height[1]);
   GetPropI0("rx_stack_horizontal",                           rx_stack_horizontal);
+  GetPropI0("wdsp_fast_math",                                wdsp_fast_math);
   GetPropI0("display_size",                                  display_size);
   GetPropI0("optimize_touchscreen",                          optimize_for_touchscreen);
   GetPropI0("which_css_font",                                which_css_font);
@@ -3409,6 +3534,15 @@ static void radio_restore_state() {
   sliders_restore_state();
   gpioRestoreActions();
   rigctlRestoreState();
+  metrics_restore_state();
+  threads_restore_state();
+  recorder_restore_state();
+
+  if (protocol == FILE_PROTOCOL) {
+    file_protocol_restore_state();
+  }
+
+  thread_apply_all();
 #ifdef MIDI
   midiRestoreState();
 #endif
@@ -3423,12 +3557,14 @@ static void radio_restore_state() {
   // (GDK_GRAVITY_NORTH_WEST) where the "position" refers to the top left corner
   // of the window.
   //
-  if ((window_x_pos < display_width[0] - 100) && (window_y_pos < display_height[0] - 100)) {
+  if (!headless && (window_x_pos < display_width[0] - 100) && (window_y_pos < display_height[0] - 100)) {
     gtk_window_move(GTK_WINDOW(top_window), window_x_pos, window_y_pos);
   }
 
   //
-  if (!radio_is_remote) {
+  // There is no screen when running headless
+  //
+  if (!radio_is_remote && !headless) {
     //
     // Assert that the custom size does not exceed the screen size
     //
@@ -3451,7 +3587,7 @@ static void radio_restore_state() {
   // (GDK_GRAVITY_NORTH_WEST) where the "position" refers to the top left corner
   // of the window.
   //
-  if ((window_x_pos < display_width[0] - 100) && (window_y_pos < display_height[0] - 100)) {
+  if (!headless && (window_x_pos < display_width[0] - 100) && (window_y_pos < display_height[0] - 100)) {
     gtk_window_move(GTK_WINDOW(top_window), window_x_pos, window_y_pos);
   }
 
@@ -3501,13 +3637,17 @@ void radio_save_state() {
   //
   // Obtain window position and save in props file
   //
-  gtk_window_get_position(GTK_WINDOW(top_window), &window_x_pos, &window_y_pos);
+  if (!headless) {
+    gtk_window_get_position(GTK_WINDOW(top_window), &window_x_pos, &window_y_pos);
+  }
+
   SetPropI0("WindowPositionX",                               window_x_pos);
   SetPropI0("WindowPositionY",                               window_y_pos);
   SetPropI0("slider_rows",                                   hide_status ? old_slid : slider_rows);
   SetPropI0("toolbar_rows",                                  hide_status ? old_tool : toolbar_rows);
   SetPropI0("display_height",                                display_height[1]);
   SetPropI0("rx_stack_horizontal",                           rx_stack_horizontal);
+  SetPropI0("wdsp_fast_math",                                wdsp_fast_math);
   SetPropI0("display_size",                                  display_size);
   SetPropI0("display_width",                                 display_width[1]);
   SetPropI0("optimize_touchscreen",                          optimize_for_touchscreen);
@@ -3622,6 +3762,14 @@ void radio_save_state() {
   sliders_save_state();
   gpioSaveActions();
   rigctlSaveState();
+  metrics_save_state();
+  threads_save_state();
+  recorder_save_state();
+
+  if (protocol == FILE_PROTOCOL) {
+    file_protocol_save_state();
+  }
+
 #ifdef MIDI
   midiSaveState();
 #endif
@@ -3659,6 +3807,10 @@ int radio_remote_start(void *data) {
     launch_tcp_rigctl();
   }
 
+  if (metrics_http_enable) {
+    metrics_http_start();
+  }
+
   for (int id = 0; id < MAX_SERIAL; id++) {
     //
     // If serial port is enabled but no success, clear "enable" flag
@@ -3840,6 +3992,10 @@ void radio_protocol_stop() {
     soapy_protocol_stop_receivers();
 #endif
     break;
+
+  case FILE_PROTOCOL:
+    file_protocol_stop();
+    break;
   }
 
   radio_protocol_running = 0;
@@ -3882,6 +4038,10 @@ void radio_protocol_run() {
 
 #endif
     break;
+
+  case FILE_PROTOCOL:
+    file_protocol_run();
+    break;
   }
 
   radio_protocol_running = 1;
@@ -4005,18 +4165,3 @@ void radio_start_playback() {
 void radio_end_playback() {
   tx_playback_end(transmitter);
 }
-
-//
-// utility function needed e.g. for qsort
-//
-int compare_doubles(const void *a, const void *b) {
-  double arg1 = *(const double *)a;
-  double arg2 = *(const double *)b;
-
-  if (arg1 < arg2) { return -1; }
-
-  if (arg1 > arg2) { return 1; }
-
-  return 0;
-}
-
@@ -279,6 +279,7 @@ extern const int MENU_WIDTH;
 
 extern int rx_stack_horizontal;
 extern int suppress_popup_sliders;
+extern int wdsp_fast_math;
 extern const int tx_dialog_width;
 extern const int tx_dialog_height;
 
@@ -356,8 +357,6 @@ extern void   radio_set_linein_gain(double value);
 extern void   radio_set_zoom(int id, int value);
 extern void   radio_set_pan(int id, int value);
 
-extern int compare_doubles(const void *a, const void *b);
-
 extern int  radio_remote_change_receivers(gpointer data);
 extern int  radio_remote_start(gpointer data);
 extern int  radio_remote_set_mox(gpointer data);
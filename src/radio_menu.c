@@ -23,6 +23,7 @@
 #include "client_server.h"
 #include "discovered.h"
 #include "ext.h"
+#include "file_protocol.h"
 #include "main.h"
 #include "new_menu.h"
 #include "new_protocol.h"
@@ -201,6 +202,14 @@ static void duplex_cb(GtkWidget *widget, gpointer data) {
   radio_set_duplex(val);
 }
 
+static void playback_mode_cb(GtkWidget *widget, gpointer data) {
+  playback_mode = gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
+}
+
+static void playback_loop_cb(GtkWidget *widget, gpointer data) {
+  playback_loop = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+}
+
 static void sat_cb(GtkWidget *widget, gpointer data) {
   sat_mode = gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
 
@@ -478,6 +487,31 @@ void radio_menu(GtkWidget *parent) {
 
   row++;
   break;
+
+  case FILE_PROTOCOL:
+    if (!radio_is_remote) {
+      label = gtk_label_new("Playback:");
+      gtk_widget_set_name(label, "boldlabel");
+      gtk_widget_set_halign(label, GTK_ALIGN_START);
+      gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
+      row++;
+      GtkWidget *playback_combo = gtk_combo_box_text_new();
+      gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(playback_combo), NULL, "Real time");
+      gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(playback_combo), NULL, "Free running");
+      gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(playback_combo), NULL, "As fast as possible");
+      gtk_combo_box_set_active(GTK_COMBO_BOX(playback_combo), playback_mode);
+      my_combo_attach(GTK_GRID(grid), playback_combo, 0, row, 1, 1);
+      g_signal_connect(playback_combo, "changed", G_CALLBACK(playback_mode_cb), NULL);
+      row++;
+      GtkWidget *loop_b = gtk_check_button_new_with_label("Loop");
+      gtk_widget_set_name(loop_b, "boldlabel");
+      gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(loop_b), playback_loop);
+      gtk_grid_attach(GTK_GRID(grid), loop_b, 0, row, 1, 1);
+      g_signal_connect(loop_b, "toggled", G_CALLBACK(playback_loop_cb), NULL);
+      row++;
+    }
+
+    break;
   }
 
   max_row = row;
@@ -34,6 +34,7 @@
 #include "main.h"
 #include "meter.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "new_menu.h"
 #include "new_protocol.h"
@@ -41,6 +42,7 @@
 #include "property.h"
 #include "radio.h"
 #include "receiver.h"
+#include "recorder.h"
 #include "rx_panadapter.h"
 #include "sliders.h"
 #ifdef SOAPYSDR
@@ -262,6 +264,7 @@ void rx_save_state(const RECEIVER *rx) {
   SetPropI1("receiver.%d.display_panadapter", rx->id,           rx->display_panadapter);
   SetPropI1("receiver.%d.display_filled", rx->id,               rx->display_filled);
   SetPropI1("receiver.%d.display_gradient", rx->id,             rx->display_gradient);
+  SetPropI1("receiver.%d.display_raster", rx->id,               rx->display_raster);
   SetPropI1("receiver.%d.waterfall_low", rx->id,                rx->waterfall_low);
   SetPropI1("receiver.%d.waterfall_high", rx->id,               rx->waterfall_high);
   SetPropI1("receiver.%d.waterfall_automatic", rx->id,          rx->waterfall_automatic);
@@ -352,6 +355,7 @@ void rx_restore_state(RECEIVER *rx) {
   GetPropI1("receiver.%d.display_panadapter", rx->id,           rx->display_panadapter);
   GetPropI1("receiver.%d.display_filled", rx->id,               rx->display_filled);
   GetPropI1("receiver.%d.display_gradient", rx->id,             rx->display_gradient);
+  GetPropI1("receiver.%d.display_raster", rx->id,               rx->display_raster);
   GetPropI1("receiver.%d.waterfall_low", rx->id,                rx->waterfall_low);
   GetPropI1("receiver.%d.waterfall_high", rx->id,               rx->waterfall_high);
   GetPropI1("receiver.%d.waterfall_automatic", rx->id,          rx->waterfall_automatic);
@@ -480,6 +484,7 @@ void rx_reconfigure(RECEIVER *rx, int height) {
   }
 
   gtk_widget_show_all(rx->panel);
+  rx_spectrum_local(rx);
 }
 
 static int rx_update_display(gpointer data) {
@@ -516,21 +521,26 @@ static int rx_update_display(gpointer data) {
       meter_update(rx, SMETER, rx->meter, 0.0, 0.0);
     }
 
+    if (rx->analyzer_fps == 0) {
+      // nobody wants to see the spectrum
+      return TRUE;
+    }
+
     g_mutex_lock(&rx->display_mutex);
     rx_get_pixels(rx);
 
     if (rx->pixels_available || rx->analyzer_initializing) {
       rx->analyzer_initializing = 0;
 
-      if (remoteclient.running) {
+      if (remoteclients > 0) {
         send_rxspectrum(rx->id);
       }
 
-      if (rx->display_panadapter) {
+      if (rx->display_panadapter && !headless) {
         rx_panadapter_update(rx);
       }
 
-      if (rx->display_waterfall) {
+      if (rx->display_waterfall && !headless) {
         waterfall_update(rx);
       }
     }
@@ -587,6 +597,7 @@ static void rx_create_visual(RECEIVER *rx) {
   }
 
   gtk_widget_show_all(rx->panel);
+  rx_spectrum_local(rx);
 }
 
 RECEIVER *rx_create_pure_signal_receiver(int id, int sample_rate, int width, int fps) {
@@ -767,6 +778,7 @@ RECEIVER *rx_create_receiver(int id, int width, int height) {
   rx->waterfall_percent = 25;
   rx->display_filled = 1;
   rx->display_gradient = 1;
+  rx->display_raster = 0;
   rx->display_detector_mode = DET_AVERAGE;
   rx->display_average_mode = AVG_LOGRECURSIVE;
   rx->display_average_time = 120.0;
@@ -870,6 +882,13 @@ RECEIVER *rx_create_receiver(int id, int width, int height) {
     rx->sample_rate = receiver[0]->sample_rate;
   }
 
+  //
+  // When playing back an IQ file, the sample rate is that of the recording
+  //
+  if (protocol == FILE_PROTOCOL) {
+    rx->sample_rate = radio->playback.sample_rate;
+  }
+
   //
   // allocate buffers
   //
@@ -928,7 +947,10 @@ RECEIVER *rx_create_receiver(int id, int width, int height) {
   rx_create_analyzer(rx);
   rx_set_detector(rx);
   rx_set_average(rx);
-  rx_create_visual(rx);
+
+  if (!headless) {
+    rx_create_visual(rx);
+  }
 
   if (rx->local_audio) {
     if (audio_open_output(rx) < 0) {
@@ -1126,7 +1148,7 @@ static void rx_process_buffer(RECEIVER *rx) {
       audio_write(rx, (float)left_sample, (float)right_sample);
     }
 
-    if (remoteclient.running) {
+    if (remoteclients > 0) {
       remote_rxaudio(rx, left_audio_sample, right_audio_sample);
     }
 
@@ -1150,8 +1172,17 @@ static void rx_process_buffer(RECEIVER *rx) {
 static void rx_full_buffer(RECEIVER *rx) {
   ASSERT_SERVER();
   int error;
+  int64_t t;
 
   //t_print("%s: rx=%p\n",__FUNCTION__,rx);
+  //
+  // The IQ samples are recorded before the noise blanker modifies them
+  //
+  if (recording) {
+    recorder_samples(rx->id, RECORD_IQ, rx->iq_input_buffer, rx->buffer_size, rx->sample_rate,
+                     vfo[rx->id].frequency);
+  }
+
   //
   // rx->mutex is locked if a sample rate change is currently going on,
   // in this case we should not block the receiver thread
@@ -1174,15 +1205,26 @@ static void rx_full_buffer(RECEIVER *rx) {
       break;
     }
 
+    metric_add(METRIC_RX_SAMPLES, rx->id, rx->buffer_size);
+    t = metric_start();
     fexchange0(rx->id, rx->iq_input_buffer, rx->audio_output_buffer, &error);
+    metric_observe(METRIC_RX_EXCHANGE_TIME, rx->id, t);
 
     if (error != 0) {
       t_print("%s: id=%d fexchange0: error=%d\n", __FUNCTION__, rx->id, error);
+      metric_inc(METRIC_RX_EXCHANGE_ERRORS, rx->id);
+    }
+
+    if (recording) {
+      recorder_samples(rx->id, RECORD_AUDIO, rx->audio_output_buffer, rx->output_samples, 48000,
+                       vfo[rx->id].ctun ? vfo[rx->id].ctun_frequency : vfo[rx->id].frequency);
     }
 
-    if (rx->displaying) {
+    if (rx->displaying && rx->analyzer_fps > 0) {
       g_mutex_lock(&rx->display_mutex);
+      t = metric_start();
       Spectrum0(1, rx->id, 0, 0, rx->iq_input_buffer);
+      metric_observe(METRIC_RX_SPECTRUM_TIME, rx->id, t);
       g_mutex_unlock(&rx->display_mutex);
     }
 
@@ -1253,6 +1295,8 @@ void rx_update_pan(RECEIVER *rx) {
   //
   // This is called when the pan value changes
   //
+  pan_layer_invalidate(&rx->panadapter_layer);
+
   if (radio_is_remote) {
     send_pan(client_socket, rx);
   } else {
@@ -1289,6 +1333,7 @@ void rx_update_zoom(RECEIVER *rx) {
   //
   // This is called whenever rx->zoom changes,
   //
+  pan_layer_invalidate(&rx->panadapter_layer);
   g_idle_add(sliders_zoom, GINT_TO_POINTER(100  + rx->id));
   g_idle_add(ext_vfo_update, NULL);
   rx_adjust_pan(rx);
@@ -1353,6 +1398,25 @@ void rx_set_filter(RECEIVER *rx) {
   rx_set_agc(rx);
 }
 
+//
+// The frame rate at which the analyzer should run is the highest rate
+// requested by a spectrum consumer, but not more than fps. The analyzer
+// parameters (and the averaging) depend on the rate it actually runs at.
+//
+static int rx_spectrum_rate(const RECEIVER *rx) {
+  int fps = 0;
+
+  for (int i = 0; i < SPECTRUM_CONSUMERS; i++) {
+    fps = max(fps, rx->spectrum_fps[i]);
+  }
+
+  return min(fps, rx->fps);
+}
+
+static int rx_analyzer_rate(const RECEIVER *rx) {
+  return rx->analyzer_fps > 0 ? rx->analyzer_fps : rx->fps;
+}
+
 void rx_set_framerate(RECEIVER *rx) {
   ASSERT_SERVER();
 
@@ -1366,10 +1430,118 @@ void rx_set_framerate(RECEIVER *rx) {
   }
 
   rx_set_displaying(rx);
+  rx->analyzer_fps = rx_spectrum_rate(rx);
   rx_set_average(rx);
   rx_set_analyzer(rx);
 }
 
+static int rx_spectrum_update(gpointer data) {
+  RECEIVER *rx = (RECEIVER *)data;
+  int fps = rx_spectrum_rate(rx);
+
+  if (fps != rx->analyzer_fps) {
+    t_print("%s: RX%d analyzer %d --> %d fps\n", __FUNCTION__, rx->id + 1, rx->analyzer_fps, fps);
+    rx->analyzer_fps = fps;
+
+    //
+    // When stopping, leave the analyzer alone. Spectrum0() is
+    // no longer called, and GetPixels() reports no new data.
+    //
+    if (fps > 0) {
+      rx_set_average(rx);
+      rx_set_analyzer(rx);
+    }
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+void rx_spectrum_demand(RECEIVER *rx, int consumer, int fps) {
+  //
+  // A spectrum consumer tells at which frame rate it needs the spectrum.
+  // This may be called from any thread, the analyzer is re-configured
+  // in the GTK queue.
+  //
+  if (rx == NULL || radio_is_remote || rx->spectrum_fps[consumer] == fps) {
+    return;
+  }
+
+  rx->spectrum_fps[consumer] = fps;
+  g_idle_add(rx_spectrum_update, rx);
+}
+
+static int rx_pixout_update(gpointer data) {
+  RECEIVER *rx = (RECEIVER *)data;
+  int n = 0;
+  int changed = 0;
+  g_mutex_lock(&rx->display_mutex);
+
+  for (int i = 1; i < RX_PIXOUTS; i++) {
+    int width = rx->pixout_want[i];
+
+    if (width > 0) { n = i; }
+
+    if (width != rx->pixout_width[i]) {
+      g_free(rx->pixout_samples[i]);
+      rx->pixout_samples[i] = width > 0 ? g_new(float, width) : NULL;
+      rx->pixout_width[i] = width;
+      rx->pixout_available[i] = 0;
+      changed = 1;
+    }
+  }
+
+  if (changed) {
+    t_print("%s: RX%d %d extra pixel outputs\n", __FUNCTION__, rx->id + 1, n);
+    rx->pixouts = n;
+    rx_set_analyzer(rx);
+  }
+
+  g_mutex_unlock(&rx->display_mutex);
+
+  if (changed) {
+    rx_set_detector(rx);
+    rx_set_average(rx);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+void rx_spectrum_widths(RECEIVER *rx, const int *widths, int n) {
+  //
+  // Remote clients tell at which widths, other than rx->pixels, they need
+  // the spectrum. The analyzer makes these from the same FFT, so this
+  // costs no extra FFTs. Widths that do not fit are re-sampled by the
+  // caller. This may be called from any thread, the analyzer is
+  // re-configured in the GTK queue.
+  //
+  int changed = 0;
+
+  if (rx == NULL || radio_is_remote) {
+    return;
+  }
+
+  for (int i = 1; i < RX_PIXOUTS; i++) {
+    int width = (i <= n) ? widths[i - 1] : 0;
+
+    if (rx->pixout_want[i] != width) {
+      rx->pixout_want[i] = width;
+      changed = 1;
+    }
+  }
+
+  if (changed) { g_idle_add(rx_pixout_update, rx); }
+}
+
+void rx_spectrum_local(RECEIVER *rx) {
+  //
+  // The local screen needs the spectrum if there is a panadapter or
+  // waterfall, and the main window is not minimized.
+  //
+  int visible = (rx->panel != NULL) && !top_window_iconified &&
+                (rx->display_panadapter || rx->display_waterfall);
+  rx_spectrum_demand(rx, SPECTRUM_LOCAL, visible ? SPECTRUM_FULL_RATE : 0);
+}
+
 ///////////////////////////////////////////////////////
 //
 // WDSP wrappers.
@@ -1460,6 +1632,11 @@ void rx_get_pixels(RECEIVER *rx) {
   int rc;
   GetPixels(rx->id, 0, rx->pixel_samples, &rc);
   rx->pixels_available = rc;
+
+  for (int i = 1; i <= rx->pixouts; i++) {
+    GetPixels(rx->id, i, rx->pixout_samples[i], &rc);
+    rx->pixout_available[i] = rc;
+  }
 }
 
 double rx_get_smeter(const RECEIVER *rx) {
@@ -1507,7 +1684,7 @@ void rx_set_analyzer(RECEIVER *rx) {
   //
   int flp[] = {0};
   const double keep_time = 0.1;
-  const int n_pixout = 1;
+  const int n_pixout = 1 + rx->pixouts;
   const int spur_elimination_ffts = 1;
   const int data_type = 1;
   const double kaiser_pi = 14.0;
@@ -1520,6 +1697,7 @@ void rx_set_analyzer(RECEIVER *rx) {
   const int clip = 0;
   const int window_type = 5;
   const int pixels = rx->pixels;
+  const int fps = rx_analyzer_rate(rx);
   int overlap;
   int max_w;
 
@@ -1569,8 +1747,8 @@ void rx_set_analyzer(RECEIVER *rx) {
   }
 
   max_w = rx->afft_size + (int) min(keep_time * (double) rx->sample_rate,
-                                    keep_time * (double) rx->afft_size * (double) rx->fps);
-  overlap = (int)fmax(0.0, ceil(rx->afft_size - (double)rx->sample_rate / (double)rx->fps));
+                                    keep_time * (double) rx->afft_size * (double) fps);
+  overlap = (int)fmax(0.0, ceil(rx->afft_size - (double)rx->sample_rate / (double)fps));
   SetAnalyzer(rx->id,
               n_pixout,
               spur_elimination_ffts,                // number of LO frequencies = number of ffts used in elimination
@@ -1592,6 +1770,13 @@ void rx_set_analyzer(RECEIVER *rx) {
               max_w                                 // max samples to hold in input ring buffers
              );
 
+  //
+  // The further pixel outputs cover the same span with a different width
+  //
+  for (int i = 1; i < RX_PIXOUTS; i++) {
+    SetDisplayPixout(rx->id, i, i <= rx->pixouts ? rx->pixout_width[i] : 0, 0.0, 0.0);
+  }
+
   //
   // The spectrum is normalized to a "bin width" of sample_rate / afft_size,
   // which is smaller than the frequency width of one pixel which is sample_rate / (width * zoom).
@@ -1606,7 +1791,10 @@ void rx_set_analyzer(RECEIVER *rx) {
   // normally means the spectrum is down-shifted quite a bit.
   //
   if (rx->id != PS_RX_FEEDBACK) {
-    SetDisplayNormOneHz(rx->id, 0, 1);
+    for (int i = 0; i < n_pixout; i++) {
+      SetDisplayNormOneHz(rx->id, i, 1);
+    }
+
     SetDisplaySampleRate(rx->id, rx->width * rx->zoom);
   }
 
@@ -1734,10 +1922,14 @@ void rx_set_average(const RECEIVER *rx) {
   //
   int wdspmode;
   double t = 0.001 * rx->display_average_time;
-  double display_avb = exp(-1.0 / ((double)rx->fps * t));
-  int display_average = max(2, (int)fmin(60, (double)rx->fps * t));
-  SetDisplayAvBackmult(rx->id, 0, display_avb);
-  SetDisplayNumAverage(rx->id, 0, display_average);
+  int fps = rx_analyzer_rate(rx);
+  double display_avb = exp(-1.0 / ((double)fps * t));
+  int display_average = max(2, (int)fmin(60, (double)fps * t));
+
+  for (int i = 0; i <= rx->pixouts; i++) {
+    SetDisplayAvBackmult(rx->id, i, display_avb);
+    SetDisplayNumAverage(rx->id, i, display_average);
+  }
 
   switch (rx->display_average_mode) {
   case AVG_NONE:
@@ -1763,9 +1955,15 @@ void rx_set_average(const RECEIVER *rx) {
   // to "Time Window", so I generally switch to NONE first, and then
   // to the target averaging mode
   //
-  SetDisplayAverageMode(rx->id, 0, AVERAGE_MODE_NONE);
+  for (int i = 0; i <= rx->pixouts; i++) {
+    SetDisplayAverageMode(rx->id, i, AVERAGE_MODE_NONE);
+  }
+
   usleep(50000);
-  SetDisplayAverageMode(rx->id, 0, wdspmode);
+
+  for (int i = 0; i <= rx->pixouts; i++) {
+    SetDisplayAverageMode(rx->id, i, wdspmode);
+  }
 }
 
 void rx_set_bandpass(const RECEIVER *rx) {
@@ -1817,7 +2015,9 @@ void rx_set_detector(const RECEIVER *rx) {
     break;
   }
 
-  SetDisplayDetectorMode(rx->id, 0, wdspmode);
+  for (int i = 0; i <= rx->pixouts; i++) {
+    SetDisplayDetectorMode(rx->id, i, wdspmode);
+  }
 }
 
 void rx_set_deviation(const RECEIVER *rx) {
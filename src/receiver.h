@@ -31,12 +31,35 @@
   #include <pulse/simple.h>
 #endif
 
+#include "pan_layer.h"
+#include "pan_trace.h"
+
 enum _audio_channel_enum {
   STEREO = 0,
   LEFT,
   RIGHT
 };
 
+//
+// Consumers of the RX spectrum. Each of them tells the receiver
+// at which frame rate it needs the spectrum (0: not at all,
+// SPECTRUM_FULL_RATE: the frame rate of the receiver)
+//
+enum _spectrum_consumer_enum {
+  SPECTRUM_LOCAL = 0,      // panadapter/waterfall on the screen
+  SPECTRUM_REMOTE,         // remote clients
+  SPECTRUM_CONSUMERS
+};
+
+#define SPECTRUM_FULL_RATE 1000
+
+//
+// Besides the pixels for the local display (pixel output 0), the analyzer
+// makes the spectrum at up to RX_PIXOUTS-1 further widths from the same FFT.
+// RX_PIXOUTS must not exceed dMAX_PIXOUTS of WDSP.
+//
+#define RX_PIXOUTS 4
+
 typedef struct _receiver {
   int id;
   GMutex mutex;
@@ -177,6 +200,8 @@ typedef struct _receiver {
   int waterfall_automatic;
   int waterfall_percent;
   cairo_surface_t *panadapter_surface;
+  PAN_LAYER panadapter_layer;
+  PAN_TRACE panadapter_trace;
   GdkPixbuf *pixbuf;
   int local_audio;
   int mute_when_not_active;
@@ -263,6 +288,22 @@ typedef struct _receiver {
   // drawn (without a spectrum) once after the analyzer changes.
   int analyzer_initializing;
   int pixels_available;
+  //
+  // The analyzer runs at the highest frame rate requested by the
+  // spectrum consumers (at most fps), and not at all if nobody
+  // wants to see the spectrum (analyzer_fps == 0)
+  //
+  int spectrum_fps[SPECTRUM_CONSUMERS];
+  int analyzer_fps;
+  //
+  // Further widths at which the spectrum is needed (pixel outputs
+  // 1 ... pixouts, index 0 is not used since this is pixel_samples)
+  //
+  int pixout_want[RX_PIXOUTS];
+  int pixout_width[RX_PIXOUTS];
+  float *pixout_samples[RX_PIXOUTS];
+  int pixout_available[RX_PIXOUTS];
+  int pixouts;
 
   int x;
   int y;
@@ -277,6 +318,7 @@ typedef struct _receiver {
 
   int display_gradient;
   int display_filled;
+  int display_raster;
   int display_detector_mode;
   int display_average_mode;
   double display_average_time;
@@ -339,6 +381,9 @@ extern void   rx_set_mode(const RECEIVER* rx);
 extern void   rx_set_noise(const RECEIVER *rx);
 extern void   rx_set_offset(const RECEIVER *rx);
 extern void   rx_set_squelch(const RECEIVER *rx);
+extern void   rx_spectrum_demand(RECEIVER *rx, int consumer, int fps);
+extern void   rx_spectrum_local(RECEIVER *rx);
+extern void   rx_spectrum_widths(RECEIVER *rx, const int *widths, int n);
 
 extern void   rx_vfo_changed(RECEIVER *rx);
 extern void   rx_update_zoom(RECEIVER *rx);
@@ -0,0 +1,516 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "message.h"
+#include "metrics.h"
+#include "property.h"
+#include "radio.h"
+#include "receiver.h"
+#include "recorder.h"
+
+int recording = 0;
+int record_what = RECORD_IQ;
+char record_directory[256] = ".";
+
+enum _rec_state {
+  REC_IDLE = 0,
+  REC_RUNNING,
+  REC_CLOSING
+};
+
+#define REC_HEADER      4096                // file offset of the sample data
+#define REC_CHUNK       (256 * 1024)        // bytes per write()
+#define REC_SECONDS     2                   // capacity of the ring buffer
+#define REC_SLEEP       20000               // usec between two writer passes
+#define REC_HDR_UPDATE  100                 // passes between two header updates
+
+//
+// A new capture segment (in the sense of SigMF) begins at the start of the
+// recording, whenever the frequency changes, and after dropped samples.
+// sample_start is the index in the file, global_index is the index in
+// the sample stream including the dropped samples.
+//
+typedef struct _rec_capture {
+  int64_t sample_start;
+  int64_t global_index;
+  long long frequency;
+} REC_CAPTURE;
+
+typedef struct _rec_stream {
+  int state;                                // REC_IDLE, REC_RUNNING, REC_CLOSING
+  int busy;                                 // the producer is active
+  int rate_changed;                         // sample rate of the receiver has changed
+  int type;                                 // RECORD_IQ or RECORD_AUDIO
+  int rx;                                   // receiver id
+  int rate;                                 // sample rate
+  int fd;
+  char name[512];                           // file name without extension
+  struct timespec start;                    // time of the first sample
+  //
+  // ring buffer (floats), its size is a multiple of REC_CHUNK
+  //
+  float *ring;
+  size_t mask;
+  size_t inpt;                              // only changed by the producer
+  size_t outpt;                             // only changed by the writer
+  //
+  // producer data
+  //
+  int64_t offered;                          // samples offered
+  int64_t stored;                           // samples put into the ring buffer
+  int64_t dropped;                          // samples dropped
+  int new_segment;
+  long long frequency;
+  GMutex meta_mutex;                        // protects captures
+  GArray *captures;
+  //
+  // writer data
+  //
+  uint64_t written;                         // bytes of sample data in the file
+  int error;
+} REC_STREAM;
+
+static REC_STREAM streams[RECORD_STREAMS];
+static GThread *writer_thread_id = NULL;
+
+static void put16(unsigned char *p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+}
+
+static void put32(unsigned char *p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+static void put64(unsigned char *p, uint64_t v) {
+  put32(p, v & 0xFFFFFFFF);
+  put32(p + 4, v >> 32);
+}
+
+//
+// The WAV header occupies the first REC_HEADER bytes of the file, such that
+// the sample data is page-aligned. It consists of
+//
+//     0: RIFF/RF64 chunk header
+//    12: JUNK/ds64 chunk (28 bytes payload)
+//    48: fmt chunk (32-bit IEEE float, 2 channels)
+//    74: JUNK chunk (padding)
+//  4088: data chunk header
+//
+// As long as the file is smaller than 4 GByte, this is a standard WAV file.
+// Above, the RIFF and data chunk sizes are set to 0xFFFFFFFF, the JUNK
+// chunk becomes a ds64 chunk containing the 64-bit sizes (EBU Tech 3306).
+//
+static void rec_header(REC_STREAM *s) {
+  unsigned char h[REC_HEADER];
+  uint64_t data = s->written;
+  uint64_t riff = data + REC_HEADER - 8;
+  int rf64 = riff > 0xFFFFFFFFULL;
+  memset(h, 0, sizeof(h));
+  memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+  put32(h + 4, rf64 ? 0xFFFFFFFF : (uint32_t) riff);
+  memcpy(h + 8, "WAVE", 4);
+  memcpy(h + 12, rf64 ? "ds64" : "JUNK", 4);
+  put32(h + 16, 28);
+  put64(h + 20, riff);
+  put64(h + 28, data);
+  put64(h + 36, data / 8);
+  put32(h + 44, 0);
+  memcpy(h + 48, "fmt ", 4);
+  put32(h + 52, 18);
+  put16(h + 56, 3);                         // WAVE_FORMAT_IEEE_FLOAT
+  put16(h + 58, 2);                         // channels
+  put32(h + 60, s->rate);
+  put32(h + 64, s->rate * 8);               // bytes per second
+  put16(h + 68, 8);                         // block align
+  put16(h + 70, 32);                        // bits per sample
+  put16(h + 72, 0);                         // cbSize
+  memcpy(h + 74, "JUNK", 4);
+  put32(h + 78, REC_HEADER - 8 - 82);
+  memcpy(h + REC_HEADER - 8, "data", 4);
+  put32(h + REC_HEADER - 4, rf64 ? 0xFFFFFFFF : (uint32_t) data);
+
+  if (pwrite(s->fd, h, REC_HEADER, 0) != REC_HEADER) {
+    t_print("%s: %s.wav: %s\n", __FUNCTION__, s->name, g_strerror(errno));
+  }
+}
+
+static void rec_datetime(const REC_STREAM *s, int64_t index, char *buf, size_t len) {
+  struct tm tm;
+  int64_t ns = (int64_t) s->start.tv_nsec + (index * 1000000000LL) / s->rate;
+  time_t t = s->start.tv_sec + ns / 1000000000LL;
+  char stamp[32];
+  gmtime_r(&t, &tm);
+  strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tm);
+  snprintf(buf, len, "%s.%03dZ", stamp, (int) ((ns % 1000000000LL) / 1000000));
+}
+
+//
+// SigMF meta data. The WAV file is referenced as a non-conforming
+// dataset, the WAV header is skipped via core:header_bytes.
+//
+static void rec_meta(REC_STREAM *s) {
+  char path[600];
+  char *wav;
+  FILE *fp;
+  snprintf(path, sizeof(path), "%s.sigmf-meta", s->name);
+
+  if ((fp = fopen(path, "w")) == NULL) {
+    t_print("%s: %s: %s\n", __FUNCTION__, path, g_strerror(errno));
+    return;
+  }
+
+  snprintf(path, sizeof(path), "%s.wav", s->name);
+  wav = g_path_get_basename(path);
+  fprintf(fp, "{\n  \"global\": {\n");
+  fprintf(fp, "    \"core:datatype\": \"%s\",\n", s->type == RECORD_IQ ? "cf32_le" : "rf32_le");
+
+  if (s->type == RECORD_AUDIO) {
+    fprintf(fp, "    \"core:num_channels\": 2,\n");
+  }
+
+  fprintf(fp, "    \"core:sample_rate\": %d,\n", s->rate);
+  fprintf(fp, "    \"core:version\": \"1.0.0\",\n");
+  fprintf(fp, "    \"core:recorder\": \"piHPSDR\",\n");
+  fprintf(fp, "    \"core:description\": \"RX%d %s\",\n", s->rx + 1, s->type == RECORD_IQ ? "IQ" : "audio");
+  fprintf(fp, "    \"core:dataset\": \"%s\",\n", wav);
+  fprintf(fp, "    \"core:extensions\": [{\"name\": \"pihpsdr\", \"version\": \"1.0.0\", \"optional\": true}],\n");
+  fprintf(fp, "    \"pihpsdr:dropped_samples\": %lld\n", (long long) s->dropped);
+  fprintf(fp, "  },\n  \"captures\": [\n");
+  g_mutex_lock(&s->meta_mutex);
+
+  for (guint i = 0; i < s->captures->len; i++) {
+    const REC_CAPTURE *c = &g_array_index(s->captures, REC_CAPTURE, i);
+    char dt[48];
+    rec_datetime(s, c->global_index, dt, sizeof(dt));
+    fprintf(fp, "    {\"core:sample_start\": %lld, \"core:global_index\": %lld, \"core:frequency\": %lld, \"core:datetime\": \"%s\"",
+            (long long) c->sample_start, (long long) c->global_index, c->frequency, dt);
+
+    if (i == 0) {
+      fprintf(fp, ", \"core:header_bytes\": %d", REC_HEADER);
+    }
+
+    fprintf(fp, "}%s\n", i + 1 < s->captures->len ? "," : "");
+  }
+
+  g_mutex_unlock(&s->meta_mutex);
+  fprintf(fp, "  ],\n  \"annotations\": []\n}\n");
+  fclose(fp);
+  g_free(wav);
+}
+
+static int rec_open(REC_STREAM *s, int id, int type, int rate, const char *stamp) {
+  size_t size = REC_CHUNK / sizeof(float);
+  char path[600];
+
+  while (size < (size_t) rate * 2 * REC_SECONDS) { size <<= 1; }
+
+  snprintf(s->name, sizeof(s->name), "%s/pihpsdr-%s-rx%d-%s", record_directory, stamp, id + 1,
+           type == RECORD_IQ ? "iq" : "audio");
+  snprintf(path, sizeof(path), "%s.wav", s->name);
+  s->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  if (s->fd < 0) {
+    t_print("%s: %s: %s\n", __FUNCTION__, path, g_strerror(errno));
+    return -1;
+  }
+
+  s->type = type;
+  s->rx = id;
+  s->rate = rate;
+  s->ring = g_new(float, size);
+  s->mask = size - 1;
+  s->inpt = s->outpt = 0;
+  s->offered = s->stored = s->dropped = 0;
+  s->new_segment = 1;
+  s->frequency = 0;
+  s->written = 0;
+  s->error = 0;
+  s->rate_changed = 0;
+  g_mutex_init(&s->meta_mutex);
+  s->captures = g_array_new(FALSE, FALSE, sizeof(REC_CAPTURE));
+  rec_header(s);
+
+  if (lseek(s->fd, REC_HEADER, SEEK_SET) < 0) {
+    t_print("%s: lseek: %s\n", __FUNCTION__, g_strerror(errno));
+  }
+
+  t_print("%s: recording to %s (%d Hz)\n", __FUNCTION__, path, rate);
+  __atomic_store_n(&s->state, REC_RUNNING, __ATOMIC_SEQ_CST);
+  return 0;
+}
+
+static void rec_close(REC_STREAM *s) {
+  rec_header(s);
+  close(s->fd);
+  rec_meta(s);
+  t_print("%s: %s.wav: %llu bytes, %lld samples dropped\n", __FUNCTION__, s->name,
+          (unsigned long long) s->written, (long long) s->dropped);
+  g_free(s->ring);
+  s->ring = NULL;
+  g_array_free(s->captures, TRUE);
+  s->captures = NULL;
+  g_mutex_clear(&s->meta_mutex);
+  __atomic_store_n(&s->state, REC_IDLE, __ATOMIC_SEQ_CST);
+}
+
+static int rec_write(int fd, const char *p, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+
+    if (n < 0) {
+      if (errno == EINTR) { continue; }
+
+      return -1;
+    }
+
+    p += n;
+    len -= n;
+  }
+
+  return 0;
+}
+
+//
+// Write the ring buffer contents to disk, in chunks of REC_CHUNK bytes.
+// Since the ring buffer size is a multiple of REC_CHUNK, all writes
+// except the last one (final != 0) are aligned to REC_CHUNK in the file.
+//
+static void rec_drain(REC_STREAM *s, int k, int final) {
+  const size_t chunk = REC_CHUNK / sizeof(float);
+  size_t inpt = __atomic_load_n(&s->inpt, __ATOMIC_ACQUIRE);
+  size_t outpt = s->outpt;
+
+  while (inpt - outpt >= chunk || (final && inpt != outpt)) {
+    size_t off = outpt & s->mask;
+    size_t len = inpt - outpt;
+
+    if (len > chunk) { len = chunk; }
+
+    if (len > s->mask + 1 - off) { len = s->mask + 1 - off; }
+
+    if (!s->error && rec_write(s->fd, (const char *) (s->ring + off), len * sizeof(float)) < 0) {
+      t_print("%s: %s.wav: %s\n", __FUNCTION__, s->name, g_strerror(errno));
+      s->error = 1;
+    }
+
+    if (s->error) {
+      metric_add(METRIC_RECORD_DROPS, k, len / 2);
+    } else {
+      s->written += len * sizeof(float);
+      metric_add(METRIC_RECORD_BYTES, k, len * sizeof(float));
+    }
+
+    outpt += len;
+    __atomic_store_n(&s->outpt, outpt, __ATOMIC_RELEASE);
+  }
+}
+
+static gpointer rec_writer_thread(gpointer arg) {
+  int pass = 0;
+
+  for (;;) {
+    int active = 0;
+
+    for (int k = 0; k < RECORD_STREAMS; k++) {
+      REC_STREAM *s = &streams[k];
+      int state = __atomic_load_n(&s->state, __ATOMIC_SEQ_CST);
+
+      if (state == REC_RUNNING && __atomic_load_n(&s->rate_changed, __ATOMIC_ACQUIRE)) {
+        t_print("%s: sample rate of RX%d changed, %s.wav closed\n", __FUNCTION__, s->rx + 1, s->name);
+        __atomic_store_n(&s->state, REC_CLOSING, __ATOMIC_SEQ_CST);
+        state = REC_CLOSING;
+      }
+
+      if (state == REC_CLOSING) {
+        //
+        // Wait until the RX thread has left recorder_samples()
+        //
+        while (__atomic_load_n(&s->busy, __ATOMIC_SEQ_CST)) { g_usleep(1000); }
+
+        rec_drain(s, k, 1);
+        rec_close(s);
+      } else if (state == REC_RUNNING) {
+        rec_drain(s, k, 0);
+
+        if (pass % REC_HDR_UPDATE == 0) {
+          //
+          // Keep the header up-to-date such that the file can be
+          // read if the program terminates abnormally
+          //
+          rec_header(s);
+        }
+
+        active++;
+      }
+    }
+
+    if (!active) { break; }
+
+    pass++;
+    g_usleep(REC_SLEEP);
+  }
+
+  __atomic_store_n(&recording, 0, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+void recorder_samples(int id, int type, const double *buf, int n, int rate, long long frequency) {
+  int k = 2 * id + (type == RECORD_AUDIO ? 1 : 0);
+  REC_STREAM *s;
+  size_t count, inpt;
+
+  if (id < 0 || k >= RECORD_STREAMS) { return; }
+
+  s = &streams[k];
+  //
+  // The busy flag tells the writer thread that the ring buffer is in use.
+  // Both busy and state use sequentially consistent atomics, such that either
+  // the writer sees "busy", or this thread sees that the stream is closing.
+  //
+  __atomic_store_n(&s->busy, 1, __ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&s->state, __ATOMIC_SEQ_CST) != REC_RUNNING) {
+    __atomic_store_n(&s->busy, 0, __ATOMIC_RELEASE);
+    return;
+  }
+
+  if (rate != s->rate) {
+    __atomic_store_n(&s->rate_changed, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&s->busy, 0, __ATOMIC_RELEASE);
+    return;
+  }
+
+  count = 2 * n;
+  inpt = s->inpt;
+
+  if (count > s->mask + 1 - (inpt - __atomic_load_n(&s->outpt, __ATOMIC_ACQUIRE))) {
+    //
+    // The disk does not keep up
+    //
+    s->dropped += n;
+    s->offered += n;
+    s->new_segment = 1;
+    metric_add(METRIC_RECORD_DROPS, k, n);
+    __atomic_store_n(&s->busy, 0, __ATOMIC_RELEASE);
+    return;
+  }
+
+  if (s->new_segment || frequency != s->frequency) {
+    REC_CAPTURE c;
+
+    if (s->offered == 0) { clock_gettime(CLOCK_REALTIME, &s->start); }
+
+    c.sample_start = s->stored;
+    c.global_index = s->offered;
+    c.frequency = frequency;
+    g_mutex_lock(&s->meta_mutex);
+    g_array_append_val(s->captures, c);
+    g_mutex_unlock(&s->meta_mutex);
+    s->frequency = frequency;
+    s->new_segment = 0;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    s->ring[(inpt + i) & s->mask] = (float) buf[i];
+  }
+
+  __atomic_store_n(&s->inpt, inpt + count, __ATOMIC_RELEASE);
+  s->offered += n;
+  s->stored += n;
+  __atomic_store_n(&s->busy, 0, __ATOMIC_RELEASE);
+}
+
+void recorder_start() {
+  char stamp[32];
+  time_t t = time(NULL);
+  struct tm tm;
+  int n = 0;
+
+  if (recording || radio_is_remote) { return; }
+
+  if (writer_thread_id != NULL) {
+    //
+    // The writer of the previous recording may still be closing the files
+    //
+    g_thread_join(writer_thread_id);
+    writer_thread_id = NULL;
+  }
+
+  localtime_r(&t, &tm);
+  strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+  for (int i = 0; i < receivers && 2 * i + 1 < RECORD_STREAMS; i++) {
+    if ((record_what & RECORD_IQ) && rec_open(&streams[2 * i], i, RECORD_IQ, receiver[i]->sample_rate, stamp) == 0) {
+      n++;
+    }
+
+    if ((record_what & RECORD_AUDIO) && rec_open(&streams[2 * i + 1], i, RECORD_AUDIO, 48000, stamp) == 0) {
+      n++;
+    }
+  }
+
+  if (n == 0) { return; }
+
+  recording = 1;
+  writer_thread_id = g_thread_new("recorder", rec_writer_thread, NULL);
+}
+
+void recorder_stop() {
+  //
+  // Just tell the writer thread to close the files. It terminates
+  // after all data has been written, so the GTK thread does not wait
+  // for the disk here.
+  //
+  for (int k = 0; k < RECORD_STREAMS; k++) {
+    int running = REC_RUNNING;
+    __atomic_compare_exchange_n(&streams[k].state, &running, REC_CLOSING, FALSE,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  }
+}
+
+void recorder_close() {
+  recorder_stop();
+
+  if (writer_thread_id != NULL) {
+    g_thread_join(writer_thread_id);
+    writer_thread_id = NULL;
+  }
+}
+
+void recorder_save_state() {
+  SetPropI0("recorder.what",                                 record_what);
+  SetPropS0("recorder.directory",                            record_directory);
+}
+
+void recorder_restore_state() {
+  GetPropI0("recorder.what",                                 record_what);
+  GetPropS0("recorder.directory",                            record_directory);
+}
@@ -0,0 +1,63 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _RECORDER_H_
+#define _RECORDER_H_
+
+//
+// Recording of RX IQ samples (at the DDC sample rate) and/or RX audio
+// to disk, for an unlimited time.
+//
+// The RX threads put the samples into a lock-free ring buffer per stream,
+// which is emptied by a writer thread in large chunks. The files are
+// WAV files with 32-bit float stereo samples (I/Q or left/right), which
+// automatically become RF64 files when exceeding 4 GByte. For each file,
+// there is a SigMF meta data file (.sigmf-meta) that contains the
+// frequency, sample rate, and time stamps of the recording. If the disk
+// cannot keep up, samples are dropped and counted.
+//
+// There is one stream for the IQ and one for the audio samples of each
+// receiver.
+//
+#define RECORD_IQ      1
+#define RECORD_AUDIO   2
+
+#define RECORD_STREAMS 4                       // 2 receivers, IQ and audio
+
+extern int recording;                          // recording is in progress
+extern int record_what;                        // RECORD_IQ and/or RECORD_AUDIO
+extern char record_directory[256];             // where the files go
+
+extern void recorder_start(void);
+extern void recorder_stop(void);
+
+//
+// Stop recording, and wait until all files are closed
+//
+extern void recorder_close(void);
+
+//
+// Called from the RX engine: n samples (complex, or stereo) for
+// receiver id. type is RECORD_IQ or RECORD_AUDIO.
+//
+extern void recorder_samples(int id, int type, const double *buf, int n, int rate, long long frequency);
+
+extern void recorder_save_state(void);
+extern void recorder_restore_state(void);
+
+#endif
@@ -51,6 +51,7 @@
 #include "iambic.h"
 #include "main.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
@@ -3122,6 +3123,35 @@ static gboolean parse_extended_cmd (const char *command, CLIENT *client) {
     //      }
     //
     //      break;
+    //
+    case 'M': //ZZXM
+
+      //CATDEF    ZZXM
+      //DESCR     Read runtime metrics
+      //READ      ZZXM;|ZZXMxxx;
+      //RESP      ZZXMyyy;|ZZXMxxxs;
+      //NOTE      Without a parameter, the number y of available metrics is reported.
+      //NOTE      With x = 0 ... y-1, metric number x is reported in the text s
+      //NOTE      which contains the name of the metric, its label and its value
+      //NOTE      (in the same format used in the Prometheus HTTP endpoint).
+      //ENDDEF
+      if (command[4] == ';') {
+        snprintf(reply,  sizeof(reply), "ZZXM%03d;", metric_get_num());
+        send_resp(client->fd, reply);
+      } else if (command[7] == ';') {
+        char line[200];
+        int n = atoi(&command[4]);
+
+        if (metric_get_line(n, line, sizeof(line))) {
+          snprintf(reply,  sizeof(reply), "ZZXM%03d%s;", n, line);
+          send_resp(client->fd, reply);
+        } else {
+          implemented = FALSE;
+        }
+      }
+
+      break;
+
     //
     //    case 'N': //ZZXN
     //
@@ -3583,6 +3613,7 @@ static int parse_cmd(void *data) {
   char reply[256];
   reply[0] = '\0';
   gboolean implemented = TRUE;
+  metric_inc(METRIC_RIGCTL_COMMANDS, 0);
 
   switch (command[0]) {
   case '#':
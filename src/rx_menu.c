@@ -33,6 +33,7 @@
 #include "new_protocol.h"
 #include "radio.h"
 #include "receiver.h"
+#include "recorder.h"
 #include "rx_menu.h"
 #include "sliders.h"
 
@@ -115,6 +116,20 @@ static void squelch_value_cb(GtkWidget *widget, gpointer data) {
   suppress_popup_sliders--;
 }
 
+static void record_what_cb(GtkWidget *widget, gpointer data) {
+  int bit = GPOINTER_TO_INT(data);
+
+  if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget))) {
+    record_what |= bit;
+  } else {
+    record_what &= ~bit;
+  }
+}
+
+static void record_directory_cb(GtkWidget *widget, gpointer data) {
+  snprintf(record_directory, sizeof(record_directory), "%s", gtk_entry_get_text(GTK_ENTRY(widget)));
+}
+
 static void squelch_enable_cb(GtkWidget *widget, gpointer data) {
   int val = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget));
   radio_set_squelch_enable(myid, val);
@@ -396,6 +411,29 @@ void rx_menu(GtkWidget *parent) {
   gtk_range_set_value (GTK_RANGE(btn), myrx->squelch);
   gtk_grid_attach(GTK_GRID(grid), btn, 1, row, 3, 1);
   g_signal_connect(G_OBJECT(btn), "value_changed", G_CALLBACK(squelch_value_cb), NULL);
+  row++;
+
+  if (!radio_is_remote) {
+    //
+    // The recorder settings apply to all receivers. They take effect
+    // when the next recording is started.
+    //
+    btn = gtk_check_button_new_with_label("Record IQ");
+    gtk_widget_set_name(btn, "boldlabel");
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (btn), (record_what & RECORD_IQ) != 0);
+    gtk_grid_attach(GTK_GRID(grid), btn, 0, row, 1, 1);
+    g_signal_connect(btn, "toggled", G_CALLBACK(record_what_cb), GINT_TO_POINTER(RECORD_IQ));
+    btn = gtk_check_button_new_with_label("Record Audio");
+    gtk_widget_set_name(btn, "boldlabel");
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (btn), (record_what & RECORD_AUDIO) != 0);
+    gtk_grid_attach(GTK_GRID(grid), btn, 1, row, 1, 1);
+    g_signal_connect(btn, "toggled", G_CALLBACK(record_what_cb), GINT_TO_POINTER(RECORD_AUDIO));
+    btn = gtk_entry_new();
+    gtk_entry_set_text(GTK_ENTRY(btn), record_directory);
+    gtk_widget_set_tooltip_text(btn, "Directory for recordings");
+    gtk_grid_attach(GTK_GRID(grid), btn, 2, row, 2, 1);
+    g_signal_connect(btn, "changed", G_CALLBACK(record_directory_cb), NULL);
+  }
 
   if (n_output_devices > 0) {
     local_audio_b = gtk_check_button_new_with_label("Local Audio Output:");
@@ -35,12 +35,14 @@
 #include "gpio.h"
 #include "message.h"
 #include "mode.h"
+#include "pan_trace.h"
 #include "radio.h"
 #ifdef USBOZY
   #include "ozyio.h"
 #endif
 #include "receiver.h"
 #include "rx_panadapter.h"
+#include "spectrum_stats.h"
 #include "transmitter.h"
 #include "vfo.h"
 
@@ -57,6 +59,8 @@ panadapter_configure_event_cb (GtkWidget         *widget,
     cairo_surface_destroy (rx->panadapter_surface);
   }
 
+  pan_layer_destroy(&rx->panadapter_layer);
+  pan_trace_destroy(&rx->panadapter_trace);
   rx->panadapter_surface = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
                            CAIRO_CONTENT_COLOR,
                            mywidth, myheight);
@@ -102,65 +106,20 @@ static gboolean panadapter_scroll_event_cb(GtkWidget *widget, GdkEventScroll *ev
   return rx_scroll_event(widget, event, data);
 }
 
-void rx_panadapter_update(RECEIVER *rx) {
-  float *samples;
+//
+// Draw the static layer: background, 60m channels, filter passband,
+// dBm grid, frequency markers and band edges. This only changes with
+// the frequency, zoom, pan, filter, display range or size of the panadapter.
+//
+static void rx_panadapter_static(const RECEIVER *rx, cairo_t *cr, int mywidth, int myheight,
+                                 long long frequency, int vfoband, const BAND *band,
+                                 double filter_left, double filter_right, int active) {
   cairo_text_extents_t extents;
   long long f;
   long long divisor;
-  double soffset;
-  int active = (active_receiver == rx);
-  int mywidth = gtk_widget_get_allocated_width (rx->panadapter);
-  int myheight = gtk_widget_get_allocated_height (rx->panadapter);
-  samples = rx->pixel_samples;
-  cairo_t *cr;
-  cr = cairo_create (rx->panadapter_surface);
   cairo_set_source_rgba(cr, COLOUR_PAN_BACKGND);
   cairo_rectangle(cr, 0, 0, mywidth, myheight);
   cairo_fill(cr);
-  int mode = vfo[rx->id].mode;
-  long long frequency = vfo[rx->id].frequency;
-  int vfoband = vfo[rx->id].band;
-  double xoffset;
-  //
-  // soffset contains all corrections for attenuation and preamps
-  // Perhaps some adjustment is necessary for those old radios which have
-  // switchable preamps.
-  //
-  const BAND *band = band_get_band(vfoband);
-  int calib = rx_gain_calibration - band->gaincalib;
-  soffset = (double) calib + (double)adc[rx->adc].attenuation - adc[rx->adc].gain;
-
-  if (filter_board == ALEX && rx->adc == 0) {
-    soffset += (double)(10 * adc[0].alex_attenuation);
-  }
-
-  if (filter_board == CHARLY25 && rx->adc == 0) {
-    soffset += (double)(12 * adc[0].alex_attenuation - 18 * (adc[0].preamp + adc[0].dither));
-  }
-
-  if (have_preamp && filter_board != CHARLY25) {
-    soffset -= (double)(20 * adc[rx->adc].preamp);
-  }
-
-  // In diversity mode, the RX2 frequency tracks the RX1 frequency
-  if (diversity_enabled && rx->id == 1) {
-    frequency = vfo[0].frequency;
-    vfoband = vfo[0].band;
-    mode = vfo[0].mode;
-  }
-
-  xoffset = rx->cAp * vfo[rx->id].offset;
-  double rxpos = rx->cBp + xoffset;
-  double filter_left  = rx->cAp * rx->filter_low  + xoffset + rx->cBp;
-  double filter_right = rx->cAp * rx->filter_high + xoffset + rx->cBp;
-
-  if (mode == modeCWU) {
-    filter_left  -= cw_keyer_sidetone_frequency * rx->cAp;
-    filter_right -= cw_keyer_sidetone_frequency * rx->cAp;
-  } else if (mode == modeCWL) {
-    filter_left  += cw_keyer_sidetone_frequency * rx->cAp;
-    filter_right += cw_keyer_sidetone_frequency * rx->cAp;
-  }
 
   if (vfoband == band60) {
     for (int i = 0; i < channel_entries; i++) {
@@ -312,16 +271,114 @@ void rx_panadapter_update(RECEIVER *rx) {
     }
   }
 
-  if (remoteclient.running && rx->id == 0) {
+  const REMOTE_CLIENT *client = remote_control_client();
+
+  if (client && rx->id == 0) {
+    //
+    // Show the address of the controlling client, and the number
+    // of additional listen-only clients
+    //
+    char addr[32];
     char text[64];
     cairo_select_font_face(cr, DISPLAY_FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
     cairo_set_source_rgba(cr, COLOUR_SHADE);
     cairo_set_font_size(cr, DISPLAY_FONT_SIZE4);
-    inet_ntop(AF_INET, &(((struct sockaddr_in *)&remoteclient.address)->sin_addr), text, 64);
+    inet_ntop(AF_INET, &(((const struct sockaddr_in *)&client->address)->sin_addr), addr, sizeof(addr));
+
+    if (remoteclients > 1) {
+      snprintf(text, sizeof(text), "%s (+%d)", addr, remoteclients - 1);
+    } else {
+      snprintf(text, sizeof(text), "%s", addr);
+    }
+
     cairo_text_extents(cr, text, &extents);
     cairo_move_to(cr, ((double)mywidth / 2.0) - (extents.width / 2.0), (double)myheight / 2.0);
     cairo_show_text(cr, text);
   }
+}
+
+void rx_panadapter_update(RECEIVER *rx) {
+  float *samples;
+  cairo_text_extents_t extents;
+  double soffset;
+  int active = (active_receiver == rx);
+  int mywidth = gtk_widget_get_allocated_width (rx->panadapter);
+  int myheight = gtk_widget_get_allocated_height (rx->panadapter);
+  samples = rx->pixel_samples;
+  cairo_t *cr;
+  int mode = vfo[rx->id].mode;
+  long long frequency = vfo[rx->id].frequency;
+  int vfoband = vfo[rx->id].band;
+  double xoffset;
+  //
+  // soffset contains all corrections for attenuation and preamps
+  // Perhaps some adjustment is necessary for those old radios which have
+  // switchable preamps.
+  //
+  const BAND *band = band_get_band(vfoband);
+  int calib = rx_gain_calibration - band->gaincalib;
+  soffset = (double) calib + (double)adc[rx->adc].attenuation - adc[rx->adc].gain;
+
+  if (filter_board == ALEX && rx->adc == 0) {
+    soffset += (double)(10 * adc[0].alex_attenuation);
+  }
+
+  if (filter_board == CHARLY25 && rx->adc == 0) {
+    soffset += (double)(12 * adc[0].alex_attenuation - 18 * (adc[0].preamp + adc[0].dither));
+  }
+
+  if (have_preamp && filter_board != CHARLY25) {
+    soffset -= (double)(20 * adc[rx->adc].preamp);
+  }
+
+  // In diversity mode, the RX2 frequency tracks the RX1 frequency
+  if (diversity_enabled && rx->id == 1) {
+    frequency = vfo[0].frequency;
+    vfoband = vfo[0].band;
+    mode = vfo[0].mode;
+  }
+
+  xoffset = rx->cAp * vfo[rx->id].offset;
+  double rxpos = rx->cBp + xoffset;
+  double filter_left  = rx->cAp * rx->filter_low  + xoffset + rx->cBp;
+  double filter_right = rx->cAp * rx->filter_high + xoffset + rx->cBp;
+
+  if (mode == modeCWU) {
+    filter_left  -= cw_keyer_sidetone_frequency * rx->cAp;
+    filter_right -= cw_keyer_sidetone_frequency * rx->cAp;
+  } else if (mode == modeCWL) {
+    filter_left  += cw_keyer_sidetone_frequency * rx->cAp;
+    filter_right += cw_keyer_sidetone_frequency * rx->cAp;
+  }
+
+  int panhi = rx->panadapter_high;
+  int panlo = rx->panadapter_low;
+  const REMOTE_CLIENT *client = remote_control_client();
+  int remote_shown = (client && rx->id == 0) ? 1 + client->seqno * (MAX_REMOTE_CLIENTS + 1) + remoteclients : 0;
+  //
+  // Re-draw the static layer only if one of the parameters it
+  // depends on has changed, otherwise just copy it.
+  //
+  const double key[] = {
+    mywidth, myheight, frequency, vfoband, channel_entries,
+    band->frequencyMin, band->frequencyMax,
+    rx->width, rx->pixels, rx->sample_rate, rx->cA, rx->cB, rx->cAp, rx->cBp,
+    filter_left, filter_right, panhi, panlo, rx->panadapter_step,
+    active, remote_shown, which_css_font
+  };
+  cr = pan_layer_begin(&rx->panadapter_layer, rx->panadapter_surface, mywidth, myheight,
+                       key, G_N_ELEMENTS(key));
+
+  if (cr) {
+    rx_panadapter_static(rx, cr, mywidth, myheight, frequency, vfoband, band,
+                         filter_left, filter_right, active);
+    cairo_destroy(cr);
+  }
+
+  cr = cairo_create (rx->panadapter_surface);
+  pan_layer_paint(&rx->panadapter_layer, cr);
+  cairo_select_font_face(cr, DISPLAY_FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+  cairo_set_font_size(cr, DISPLAY_FONT_SIZE2);
 
   // agc
   if (rx->agc != AGC_OFF) {
@@ -386,32 +443,19 @@ void rx_panadapter_update(RECEIVER *rx) {
     //
     // draw spectrum
     //
-    double s1;
+    int ytop[mywidth];
+    int ybot[mywidth];
+    int nstops;
+    double offsets[4];
+    double colours[4][4];
     samples[0] = -200.0;
     samples[mywidth - 1] = -200.0;
     //
     // most HPSDR only have attenuation (no gain), while HermesLite-II and SOAPY use gain (no attenuation)
     //
-    s1 = (double)samples[0] + soffset;
-    s1 = floor((panhi - s1)
-               * (double) myheight
-               / (double) (panhi - panlo));
-    cairo_move_to(cr, 0.0, s1);
-
-    for (int i = 1; i < mywidth; i++) {
-      double s2;
-      s2 = (double)samples[i] + soffset;
-      s2 = floor((panhi - s2)
-                 * (double) myheight
-                 / (double) (panhi - panlo));
-      cairo_line_to(cr, i, s2);
-    }
-
-    cairo_pattern_t *gradient;
-    gradient = NULL;
+    pan_trace_scale(samples, mywidth, soffset, panhi, panlo, mywidth, myheight, ytop, ybot);
 
     if (rx->display_gradient) {
-      gradient = cairo_pattern_create_linear(0.0, myheight, 0.0, 0.0);
       // calculate where S9 is
       double S9 = -73;
 
@@ -423,50 +467,82 @@ void rx_panadapter_update(RECEIVER *rx) {
                  * (double) myheight
                  / (double) (panhi - panlo));
       S9 = 1.0 - (S9 / (double)myheight);
+      nstops = 4;
+      offsets[0] = 0.0;
+      offsets[1] = S9 / 3.0;
+      offsets[2] = (S9 / 3.0) * 2.0;
+      offsets[3] = S9;
 
       if (active) {
-        cairo_pattern_add_color_stop_rgba(gradient, 0.0,         COLOUR_GRAD1);
-        cairo_pattern_add_color_stop_rgba(gradient, S9 / 3.0,      COLOUR_GRAD2);
-        cairo_pattern_add_color_stop_rgba(gradient, (S9 / 3.0) * 2.0, COLOUR_GRAD3);
-        cairo_pattern_add_color_stop_rgba(gradient, S9,          COLOUR_GRAD4);
+        const double grad[4][4] = {{COLOUR_GRAD1}, {COLOUR_GRAD2}, {COLOUR_GRAD3}, {COLOUR_GRAD4}};
+        memcpy(colours, grad, sizeof(grad));
       } else {
-        cairo_pattern_add_color_stop_rgba(gradient, 0.0,         COLOUR_GRAD1_WEAK);
-        cairo_pattern_add_color_stop_rgba(gradient, S9 / 3.0,      COLOUR_GRAD2_WEAK);
-        cairo_pattern_add_color_stop_rgba(gradient, (S9 / 3.0) * 2.0, COLOUR_GRAD3_WEAK);
-        cairo_pattern_add_color_stop_rgba(gradient, S9,          COLOUR_GRAD4_WEAK);
+        const double grad[4][4] = {{COLOUR_GRAD1_WEAK}, {COLOUR_GRAD2_WEAK}, {COLOUR_GRAD3_WEAK}, {COLOUR_GRAD4_WEAK}};
+        memcpy(colours, grad, sizeof(grad));
       }
-
-      cairo_set_source(cr, gradient);
     } else {
       //
       // Different shades of gray
       //
+      const double fill1[4] = {COLOUR_PAN_FILL1};
+      const double fill2[4] = {COLOUR_PAN_FILL2};
+      const double fill3[4] = {COLOUR_PAN_FILL3};
+      nstops = 1;
+      offsets[0] = 0.0;
+
       if (active) {
         if (!rx->display_filled) {
-          cairo_set_source_rgba(cr, COLOUR_PAN_FILL3);
+          memcpy(colours[0], fill3, sizeof(fill3));
         } else {
-          cairo_set_source_rgba(cr, COLOUR_PAN_FILL2);
+          memcpy(colours[0], fill2, sizeof(fill2));
         }
       } else {
-        cairo_set_source_rgba(cr, COLOUR_PAN_FILL1);
+        memcpy(colours[0], fill1, sizeof(fill1));
       }
     }
 
-    if (rx->display_filled) {
-      cairo_close_path (cr);
-      cairo_fill_preserve (cr);
-      cairo_set_line_width(cr, PAN_LINE_THIN);
-    } else {
+    if (rx->display_raster) {
       //
-      // if not filling, use thicker line
+      // Write the trace directly into an image, without cairo paths
       //
-      cairo_set_line_width(cr, PAN_LINE_THICK);
-    }
+      uint32_t rowcolours[myheight];
+      pan_trace_colours(rowcolours, myheight, nstops, offsets, (const double (*)[4])colours);
+      pan_trace_raster(&rx->panadapter_trace, cr, ytop, ybot, mywidth, myheight, rowcolours,
+                       rx->display_filled);
+    } else {
+      cairo_pattern_t *gradient;
+      gradient = NULL;
+      pan_trace_path(cr, ytop, ybot, mywidth);
 
-    cairo_stroke(cr);
+      if (nstops > 1) {
+        gradient = cairo_pattern_create_linear(0.0, myheight, 0.0, 0.0);
+
+        for (int i = 0; i < nstops; i++) {
+          cairo_pattern_add_color_stop_rgba(gradient, offsets[i],
+                                            colours[i][0], colours[i][1], colours[i][2], colours[i][3]);
+        }
 
-    if (gradient) {
-      cairo_pattern_destroy(gradient);
+        cairo_set_source(cr, gradient);
+      } else {
+        cairo_set_source_rgba(cr, colours[0][0], colours[0][1], colours[0][2], colours[0][3]);
+      }
+
+      if (rx->display_filled) {
+        cairo_close_path (cr);
+        cairo_fill_preserve (cr);
+        cairo_set_line_width(cr, PAN_LINE_THIN);
+      } else {
+        //
+        // if not filling, use thicker line
+        //
+        cairo_set_line_width(cr, PAN_LINE_THICK);
+      }
+
+      cairo_stroke(cr);
+
+      if (gradient) {
+        cairo_pattern_destroy(gradient);
+      }
     }
 
     if (rx->panadapter_peaks_on != 0) {
@@ -485,90 +561,17 @@ void rx_panadapter_update(RECEIVER *rx) {
       }
 
       // Calculate the noise level if needed
-      double noise_level = 0.0;
+      double noise_level = -1.0E30;
 
       if (hide_noise) {
-        // Dynamically allocate a copy of samples for sorting
-        double *sorted_samples = malloc(mywidth * sizeof(double));
-
-        if (sorted_samples != NULL) {
-          for (int i = 0; i < mywidth; i++) {
-            sorted_samples[i] = (double)samples[i] + soffset;
-          }
-
-          qsort(sorted_samples, mywidth, sizeof(double), compare_doubles);
-          int index = (int)((noise_percentile / 100.0) * mywidth);
-          noise_level = sorted_samples[index] + 3.0;
-          free(sorted_samples); // Free memory after use
-        }
+        noise_level = spectrum_percentile(samples, mywidth, soffset, noise_percentile) + 3.0;
       }
 
-      // Detect peaks
-      double filter_left_bound = peaks_in_passband ? filter_left : 0;
-      double filter_right_bound = peaks_in_passband ? filter_right : mywidth;
-
-      for (int i = 1; i < mywidth - 1; i++) {
-        if (i >= filter_left_bound && i <= filter_right_bound) {
-          double s = (double)samples[i] + soffset;
-
-          // Check if the point is a peak
-          if ((!hide_noise || s >= noise_level) && s > samples[i - 1] && s > samples[i + 1]) {
-            int replace_index = -1;
-            int start_range = i - ignore_range;
-            int end_range = i + ignore_range;
-
-            // Check if the peak is within the ignore range of any existing peak
-            for (int j = 0; j < num_peaks; j++) {
-              if (peak_positions[j] >= start_range && peak_positions[j] <= end_range) {
-                if (s > peaks[j]) {
-                  replace_index = j;
-                  break;
-                } else {
-                  replace_index = -2;
-                  break;
-                }
-              }
-            }
-
-            // Replace the existing peak if a higher peak is found within the ignore range
-            if (replace_index >= 0) {
-              peaks[replace_index] = s;
-              peak_positions[replace_index] = i;
-            }
-            // Add the peak if no peaks are found within the ignore range
-            else if (replace_index == -1) {
-              // Find the index of the lowest peak
-              int lowest_peak_index = 0;
-
-              for (int j = 1; j < num_peaks; j++) {
-                if (peaks[j] < peaks[lowest_peak_index]) {
-                  lowest_peak_index = j;
-                }
-              }
-
-              // Replace the lowest peak if the current peak is higher
-              if (s > peaks[lowest_peak_index]) {
-                peaks[lowest_peak_index] = s;
-                peak_positions[lowest_peak_index] = i;
-              }
-            }
-          }
-        }
-      }
-
-      // Sort peaks in descending order
-      for (int i = 0; i < num_peaks - 1; i++) {
-        for (int j = i + 1; j < num_peaks; j++) {
-          if (peaks[i] < peaks[j]) {
-            double temp_peak = peaks[i];
-            peaks[i] = peaks[j];
-            peaks[j] = temp_peak;
-            int temp_pos = peak_positions[i];
-            peak_positions[i] = peak_positions[j];
-            peak_positions[j] = temp_pos;
-          }
-        }
-      }
+      // Detect peaks, sorted in descending order
+      int peaks_left = peaks_in_passband ? (int)ceil(filter_left) : 0;
+      int peaks_right = peaks_in_passband ? (int)floor(filter_right) : mywidth;
+      spectrum_peaks(samples, mywidth, soffset, peaks_left, peaks_right, noise_level,
+                     ignore_range, num_peaks, peaks, peak_positions);
 
       // Draw peak values on the chart
       cairo_set_source_rgba(cr, COLOUR_PAN_TEXT); // Set text color
@@ -664,6 +667,8 @@ void rx_panadapter_update(RECEIVER *rx) {
 
 void rx_panadapter_init(RECEIVER *rx, int width, int height) {
   rx->panadapter_surface = NULL;
+  pan_layer_init(&rx->panadapter_layer);
+  pan_trace_init(&rx->panadapter_trace);
   rx->panadapter = gtk_drawing_area_new ();
   gtk_widget_set_size_request (rx->panadapter, width, height);
   /* Signals used to handle the backing surface */
@@ -693,7 +698,7 @@ void rx_panadapter_init(RECEIVER *rx, int width, int height) {
 void display_panadapter_messages(cairo_t *cr, int width, unsigned int fps) {
   char text[64];
 
-  if (display_warnings || remoteclient.running) {
+  if (display_warnings || remoteclients > 0) {
     //
     // Sequence errors
     // ADC overloads
@@ -704,8 +709,8 @@ void display_panadapter_messages(cairo_t *cr, int width, unsigned int fps) {
     //
     // If we are the server and there is a client, we must
     // do the display otherwise the indicators will not be
-    // cleared after two seconds (remoteclient.running
-    // will be FALSE if we are the client)
+    // cleared after two seconds (remoteclients
+    // will be zero if we are the client)
     //
     cairo_set_source_rgba(cr, COLOUR_ALARM);
     cairo_set_font_size(cr, DISPLAY_FONT_SIZE2);
@@ -59,6 +59,7 @@
 #include "saturnmain.h"
 #include "saturnregisters.h"              // register I/O for Saturn
 #include "saturnserver.h"
+#include "threads.h"
 
 extern sem_t DDCInSelMutex;                 // protect access to shared DDC input select register
 extern sem_t DDCResetFIFOMutex;             // protect access to FIFO reset register
@@ -445,6 +446,7 @@ void saturn_discovery() {
     discovered[devices].use_tcp = 0;
     discovered[devices].use_routing = 0;
     discovered[devices].supported_receivers = 2;
+    discovered[devices].ddcs = 4;                  // DDC6...9 of the FPGA
     t_print("discovery: found saturn device min=%0.3f MHz max=%0.3f MHz\n",
             discovered[devices].frequency_min * 1E-6,
             discovered[devices].frequency_max * 1E-6);
@@ -831,6 +833,7 @@ static void start_saturn_micaudio_thread() {
 
 static gpointer saturn_micaudio_thread(gpointer arg) {
   t_print( "%s\n", __FUNCTION__);
+  thread_setup(THREAD_TX, "Saturn mic");
   //
   // variables for DMA buffer
   //
@@ -1000,6 +1003,7 @@ extern struct sockaddr_in reply_addr;
 
 static gpointer saturn_rx_thread(gpointer arg) {
   t_print( "%s\n", __FUNCTION__);
+  thread_setup(THREAD_NET, "Saturn RX");
   //
   // memory buffers
   //
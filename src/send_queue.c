@@ -0,0 +1,531 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * On the server side, packets to the client are sent from the GTK queue,
+ * from the RX threads (audio) and from the display timers (spectrum).
+ * Formerly, these all did a blocking send(), such that a slow link to the
+ * client directly stalled the RX engine.
+ *
+ * Now each connection has a writer thread, and send_bytes() only puts the
+ * packet into one of three queues (control, audio, spectrum). The writer
+ * always takes packets from the queue with the highest priority first, and
+ * sends a bunch of them with a single (scatter/gather) sendmsg() call. The
+ * audio and spectrum queues are bounded: if they grow too long, the oldest
+ * packets are dropped.
+ * Audio that has been waiting for too long is dropped as well, since it would
+ * only increase the latency at the client side. Control packets are never
+ * dropped, but if too much of them pile up, the client is considered dead.
+ *
+ * Since each packet is self-contained, re-ordering packets of different
+ * priority is harmless. Within one queue, the order is preserved.
+ *
+ * Each connection also has a table of the state packets that have been sent
+ * (see remote_state_update()). A state packet that has not changed since it
+ * was last sent to a client is not queued again.
+ */
+
+#include <gtk/gtk.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "client_server.h"
+#include "message.h"
+#include "metrics.h"
+#include "send_queue.h"
+
+#define SEND_QUEUE_MAX     8             // max. number of connections
+#define SEND_IOV_MAX       16            // max. number of packets per sendmsg()
+#define SEND_AUDIO_MAX     48            // max. number of audio packets queued (about 0.5 sec)
+#define SEND_AUDIO_MAXAGE  500000        // audio older than this (usec) is dropped
+#define SEND_SPECTRUM_MAX  4             // max. number of spectrum packets queued
+#define SEND_CONTROL_BYTES 4000000       // max. size of the control queue
+#define SEND_RTT_INTERVAL  1000000       // how often (usec) the round trip time is probed
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+//
+// A packet can be queued for several connections (fan-out to several
+// clients), so it is reference-counted.
+//
+struct _send_packet {
+  int refs;
+  int prio;
+  int len;
+  char data[];
+};
+
+typedef struct _send_entry {
+  struct _send_entry *next;
+  int64_t queued;                        // time stamp (usec)
+  SEND_PACKET *packet;
+} SEND_ENTRY;
+
+typedef struct _send_fifo {
+  SEND_ENTRY *head;
+  SEND_ENTRY *tail;
+  int count;
+  long bytes;
+} SEND_FIFO;
+
+typedef struct _send_queue {
+  int socket;
+  int running;
+  int dead;
+  GMutex mutex;
+  GCond cond;
+  GThread *thread;
+  SEND_FIFO fifo[SEND_PRIO_NUM];
+  GHashTable *state;                     // state packets known to the client
+} SEND_QUEUE;
+
+static SEND_QUEUE *queues[SEND_QUEUE_MAX];
+static GMutex queues_mutex;              // static so correctly initialised
+
+static const int fifo_max[SEND_PRIO_NUM] = { 0, SEND_AUDIO_MAX, SEND_SPECTRUM_MAX };
+
+static int send_prio(const char *buffer, int bytes) {
+  const HEADER *header = (const HEADER *) buffer;
+
+  if (bytes < (int) sizeof(HEADER)) { return SEND_PRIO_CONTROL; }
+
+  switch (from_short(header->data_type)) {
+  case INFO_RXAUDIO:
+    return SEND_PRIO_AUDIO;
+
+  case INFO_RX_SPECTRUM:
+  case INFO_TX_SPECTRUM:
+    return SEND_PRIO_SPECTRUM;
+  }
+
+  return SEND_PRIO_CONTROL;
+}
+
+SEND_PACKET *send_packet_new(const char *buffer, int bytes) {
+  SEND_PACKET *p = g_malloc(sizeof(SEND_PACKET) + bytes);
+  p->refs = 1;
+  p->prio = send_prio(buffer, bytes);
+  p->len = bytes;
+  memcpy(p->data, buffer, bytes);
+  return p;
+}
+
+void send_packet_unref(SEND_PACKET *p) {
+  if (p && __atomic_sub_fetch(&p->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    g_free(p);
+  }
+}
+
+const char *send_packet_data(const SEND_PACKET *p, int *bytes) {
+  *bytes = p->len;
+  return p->data;
+}
+
+static void entry_free(SEND_ENTRY *e) {
+  send_packet_unref(e->packet);
+  g_free(e);
+}
+
+static void fifo_push(SEND_FIFO *f, SEND_ENTRY *p) {
+  p->next = NULL;
+
+  if (f->tail) {
+    f->tail->next = p;
+  } else {
+    f->head = p;
+  }
+
+  f->tail = p;
+  f->count++;
+  f->bytes += p->packet->len;
+}
+
+static SEND_ENTRY *fifo_pop(SEND_FIFO *f) {
+  SEND_ENTRY *p = f->head;
+
+  if (p) {
+    f->head = p->next;
+
+    if (f->head == NULL) { f->tail = NULL; }
+
+    f->count--;
+    f->bytes -= p->packet->len;
+  }
+
+  return p;
+}
+
+static void fifo_flush(SEND_FIFO *f) {
+  SEND_ENTRY *p;
+
+  while ((p = fifo_pop(f))) { entry_free(p); }
+}
+
+static void send_metrics(const SEND_QUEUE *q) {
+  for (int i = 0; i < SEND_PRIO_NUM; i++) {
+    metric_set(METRIC_REMOTE_QUEUED, i, q->fifo[i].bytes);
+  }
+}
+
+//
+// The connection is dead: discard everything and make the server loop
+// (which is waiting in recv()) terminate. Called with the queue locked.
+//
+static void send_dead(SEND_QUEUE *q) {
+  if (q->dead) { return; }
+
+  q->dead = 1;
+
+  for (int i = 0; i < SEND_PRIO_NUM; i++) {
+    fifo_flush(&q->fifo[i]);
+  }
+
+  send_metrics(q);
+
+  remote_client_gone(q->socket);
+  shutdown(q->socket, SHUT_RDWR);
+}
+
+//
+// Read the smoothed round trip time from the kernel
+//
+static void send_rtt(int sock) {
+#ifdef __linux__
+  struct tcp_info info;
+  socklen_t len = sizeof(info);
+
+  if (getsockopt(sock, IPPROTO_TCP, TCP_INFO, &info, &len) == 0) {
+    metric_set(METRIC_REMOTE_RTT, 0, info.tcpi_rtt);
+  }
+
+#endif
+}
+
+static gpointer send_writer_thread(gpointer arg) {
+  SEND_QUEUE *q = (SEND_QUEUE *) arg;
+  SEND_ENTRY *batch[SEND_IOV_MAX];
+  struct iovec iov[SEND_IOV_MAX];
+  int nbatch = 0;                        // packets taken from the queues but not yet (fully) sent
+  int offset = 0;                        // bytes of batch[0] already sent
+  int64_t last_rtt = 0;
+  g_mutex_lock(&q->mutex);
+
+  while (q->running && !q->dead) {
+    //
+    // Fill up the batch, highest priority first
+    //
+    for (int i = 0; i < SEND_PRIO_NUM && nbatch < SEND_IOV_MAX; i++) {
+      SEND_FIFO *f = &q->fifo[i];
+
+      while (nbatch < SEND_IOV_MAX && f->head) {
+        SEND_ENTRY *p = fifo_pop(f);
+
+        if (i == SEND_PRIO_AUDIO && metric_start() - p->queued > SEND_AUDIO_MAXAGE) {
+          metric_inc(METRIC_REMOTE_DROPS, i);
+          entry_free(p);
+          continue;
+        }
+
+        batch[nbatch++] = p;
+      }
+    }
+
+    send_metrics(q);
+
+    if (nbatch == 0) {
+      g_cond_wait(&q->cond, &q->mutex);
+      continue;
+    }
+
+    g_mutex_unlock(&q->mutex);
+
+    for (int i = 0; i < nbatch; i++) {
+      iov[i].iov_base = batch[i]->packet->data + (i == 0 ? offset : 0);
+      iov[i].iov_len = batch[i]->packet->len - (i == 0 ? offset : 0);
+    }
+
+    //
+    // sendmsg() is writev() with flags, and we do not want to get a SIGPIPE
+    // if the client has gone
+    //
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = nbatch;
+    ssize_t rc = sendmsg(q->socket, &msg, MSG_NOSIGNAL);
+    int64_t now = metric_start();
+
+    if (rc < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        //
+        // Note the client's death
+        //
+        t_perror("send_writer");
+        g_mutex_lock(&q->mutex);
+        send_dead(q);
+        continue;
+      }
+
+      rc = 0;
+    }
+
+    metric_add(METRIC_REMOTE_BYTES, 0, rc);
+
+    //
+    // Remove completely sent packets from the batch
+    //
+    int done = 0;
+    rc += offset;
+
+    while (done < nbatch && rc >= batch[done]->packet->len) {
+      rc -= batch[done]->packet->len;
+      metric_observe_usec(METRIC_REMOTE_LATENCY, 0, now - batch[done]->queued);
+      entry_free(batch[done]);
+      done++;
+    }
+
+    offset = rc;
+
+    for (int i = done; i < nbatch; i++) {
+      batch[i - done] = batch[i];
+    }
+
+    nbatch -= done;
+
+    if (now - last_rtt > SEND_RTT_INTERVAL) {
+      send_rtt(q->socket);
+      last_rtt = now;
+    }
+
+    g_mutex_lock(&q->mutex);
+  }
+
+  g_mutex_unlock(&q->mutex);
+
+  for (int i = 0; i < nbatch; i++) {
+    entry_free(batch[i]);
+  }
+
+  return NULL;
+}
+
+void send_queue_start(int sock) {
+  SEND_QUEUE *q = g_new0(SEND_QUEUE, 1);
+  q->socket = sock;
+  q->running = 1;
+  q->state = remote_state_new();
+  g_mutex_init(&q->mutex);
+  g_cond_init(&q->cond);
+  g_mutex_lock(&queues_mutex);
+
+  for (int i = 0; i < SEND_QUEUE_MAX; i++) {
+    if (queues[i] == NULL) {
+      queues[i] = q;
+      q->thread = g_thread_new("send queue", send_writer_thread, q);
+      break;
+    }
+  }
+
+  g_mutex_unlock(&queues_mutex);
+
+  if (q->thread == NULL) {
+    //
+    // All slots in use, fall back to blocking send()
+    //
+    t_print("%s: no free slot for socket %d\n", __FUNCTION__, sock);
+    g_hash_table_destroy(q->state);
+    g_mutex_clear(&q->mutex);
+    g_cond_clear(&q->cond);
+    g_free(q);
+  }
+}
+
+void send_queue_stop(int sock) {
+  SEND_QUEUE *q = NULL;
+  g_mutex_lock(&queues_mutex);
+
+  for (int i = 0; i < SEND_QUEUE_MAX; i++) {
+    if (queues[i] && queues[i]->socket == sock) {
+      q = queues[i];
+      queues[i] = NULL;
+      break;
+    }
+  }
+
+  g_mutex_unlock(&queues_mutex);
+
+  if (q == NULL) { return; }
+
+  g_mutex_lock(&q->mutex);
+  q->running = 0;
+  g_cond_signal(&q->cond);
+  g_mutex_unlock(&q->mutex);
+  g_thread_join(q->thread);
+
+  for (int i = 0; i < SEND_PRIO_NUM; i++) {
+    fifo_flush(&q->fifo[i]);
+  }
+
+  send_metrics(q);
+  g_hash_table_destroy(q->state);
+  g_mutex_clear(&q->mutex);
+  g_cond_clear(&q->cond);
+  g_free(q);
+}
+
+//
+// Put a packet into the queue of a connection. Called with the connection
+// list locked. Returns -1 if the connection is dead, else the packet length.
+//
+static int send_queue_add(SEND_QUEUE *q, SEND_PACKET *p) {
+  int rc;
+  g_mutex_lock(&q->mutex);
+
+  if (q->dead) {
+    rc = -1;
+  } else if (p->prio == SEND_PRIO_CONTROL && !remote_state_update(q->state, p->data, p->len)) {
+    rc = p->len;
+  } else {
+    SEND_FIFO *f = &q->fifo[p->prio];
+    SEND_ENTRY *e = g_new(SEND_ENTRY, 1);
+    __atomic_add_fetch(&p->refs, 1, __ATOMIC_RELAXED);
+    e->packet = p;
+    e->queued = metric_start();
+    fifo_push(f, e);
+
+    if (p->prio == SEND_PRIO_CONTROL) {
+      if (f->bytes > SEND_CONTROL_BYTES) {
+        t_print("%s: client does not accept data, giving up.\n", __FUNCTION__);
+        send_dead(q);
+      }
+    } else {
+      while (f->count > fifo_max[p->prio]) {
+        entry_free(fifo_pop(f));
+        metric_inc(METRIC_REMOTE_DROPS, p->prio);
+      }
+    }
+
+    g_cond_signal(&q->cond);
+    rc = q->dead ? -1 : p->len;
+  }
+
+  g_mutex_unlock(&q->mutex);
+  return rc;
+}
+
+int send_queue_put_packet(int sock, SEND_PACKET *p) {
+  int rc = 0;
+  g_mutex_lock(&queues_mutex);
+
+  for (int i = 0; i < SEND_QUEUE_MAX; i++) {
+    SEND_QUEUE *q = queues[i];
+
+    if (q == NULL) { continue; }
+
+    if (sock == SEND_ALL) {
+      if (send_queue_add(q, p) > 0) { rc = p->len; }
+    } else if (q->socket == sock) {
+      rc = send_queue_add(q, p);
+      break;
+    }
+  }
+
+  g_mutex_unlock(&queues_mutex);
+  return rc;
+}
+
+int send_queue_put(int sock, const char *buffer, int bytes) {
+  SEND_PACKET *p = send_packet_new(buffer, bytes);
+  int rc = send_queue_put_packet(sock, p);
+  send_packet_unref(p);
+  return rc;
+}
+
+static SEND_QUEUE *find_queue(int sock) {
+  for (int i = 0; i < SEND_QUEUE_MAX; i++) {
+    if (queues[i] && queues[i]->socket == sock) {
+      return queues[i];
+    }
+  }
+
+  return NULL;
+}
+
+int send_queue_changed(int sock, const char *buffer, int bytes) {
+  int rc = TRUE;
+  g_mutex_lock(&queues_mutex);
+  SEND_QUEUE *q = find_queue(sock);
+
+  if (q) {
+    g_mutex_lock(&q->mutex);
+    rc = remote_state_update(q->state, buffer, bytes);
+    g_mutex_unlock(&q->mutex);
+  }
+
+  g_mutex_unlock(&queues_mutex);
+  return rc;
+}
+
+void send_queue_seed(int sock, uint32_t key, uint64_t hash) {
+  g_mutex_lock(&queues_mutex);
+  SEND_QUEUE *q = find_queue(sock);
+
+  if (q) {
+    uint64_t *h = g_new(uint64_t, 1);
+    *h = hash;
+    g_mutex_lock(&q->mutex);
+    g_hash_table_insert(q->state, GUINT_TO_POINTER(key), h);
+    g_mutex_unlock(&q->mutex);
+  }
+
+  g_mutex_unlock(&queues_mutex);
+}
+
+void send_queue_command(int sock, const char *buffer, int bytes) {
+  g_mutex_lock(&queues_mutex);
+  SEND_QUEUE *q = find_queue(sock);
+
+  if (q) {
+    g_mutex_lock(&q->mutex);
+    remote_state_command(q->state, buffer, bytes);
+    g_mutex_unlock(&q->mutex);
+  }
+
+  g_mutex_unlock(&queues_mutex);
+}
+
+void send_queue_forget(int sock) {
+  g_mutex_lock(&queues_mutex);
+  SEND_QUEUE *q = find_queue(sock);
+
+  if (q) {
+    g_mutex_lock(&q->mutex);
+    g_hash_table_remove_all(q->state);
+    g_mutex_unlock(&q->mutex);
+  }
+
+  g_mutex_unlock(&queues_mutex);
+}
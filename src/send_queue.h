@@ -0,0 +1,85 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _SEND_QUEUE_H_
+#define _SEND_QUEUE_H_
+
+#include <stdint.h>
+
+//
+// Asynchronous, prioritized output queue for a TCP connection of the
+// client/server model. Packets are classified by their header:
+// everything that is neither audio nor spectrum data is "control" and
+// is never dropped. Audio and spectrum data is dropped (oldest first)
+// if the queues grow too long, that is, if the link to the client
+// cannot keep up.
+//
+enum _send_prio {
+  SEND_PRIO_CONTROL = 0,
+  SEND_PRIO_AUDIO,
+  SEND_PRIO_SPECTRUM,
+  SEND_PRIO_NUM
+};
+
+//
+// Start/stop the writer thread for a socket. While the writer is running,
+// send_bytes() on this socket queues the data and returns immediately.
+//
+extern void send_queue_start(int sock);
+extern void send_queue_stop(int sock);
+
+//
+// "Socket" for sending a packet to all connections
+//
+#define SEND_ALL -2
+
+//
+// Queue a packet. The function value is
+//  0 if there is no writer for this socket (caller must send the data itself)
+// -1 if the connection is dead
+// the number of bytes otherwise
+//
+extern int send_queue_put(int sock, const char *buffer, int bytes);
+
+//
+// A packet that is to be sent to several connections (but not to all of them)
+// is only made once, and then queued for each of them. The packet is freed
+// when it has been sent everywhere, and the producer has dropped its
+// reference with send_packet_unref().
+//
+typedef struct _send_packet SEND_PACKET;
+
+extern SEND_PACKET *send_packet_new(const char *buffer, int bytes);
+extern void send_packet_unref(SEND_PACKET *p);
+extern const char *send_packet_data(const SEND_PACKET *p, int *bytes);
+extern int send_queue_put_packet(int sock, SEND_PACKET *p);
+
+//
+// State tables for delta updates:
+// send_queue_changed() records a state packet that is sent by other means
+// and returns FALSE if the client already has it. send_queue_seed() enters
+// state reported by the client, and send_queue_command() notes a command
+// received from the client (see remote_state_command()).
+// send_queue_forget() empties the table if the client's state is unknown.
+//
+extern int send_queue_changed(int sock, const char *buffer, int bytes);
+extern void send_queue_seed(int sock, uint32_t key, uint64_t hash);
+extern void send_queue_command(int sock, const char *buffer, int bytes);
+extern void send_queue_forget(int sock);
+
+#endif
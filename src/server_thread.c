@@ -63,9 +63,11 @@
 #include "filter.h"
 #include "iambic.h"
 #include "main.h"
+#include "media.h"
 #include "message.h"
 #include "new_protocol.h"
 #include "radio.h"
+#include "send_queue.h"
 #ifdef SOAPYSDR
   #include "soapy_protocol.h"
 #endif
@@ -76,15 +78,25 @@ char hpsdr_pwd[HPSDR_PWD_LEN];
 int  hpsdr_server = 0;
 int  listen_port = 50000;
 int  server_stops_protocol = 0;
-REMOTE_CLIENT remoteclient = { 0 };
+REMOTE_CLIENT remoteclient[MAX_REMOTE_CLIENTS];
+int remoteclients = 0;                   // number of clients connected
+
+static GMutex clients_mutex;             // static so correctly initialised
+static GMutex snapshot_mutex;            // guards snapshot_sent/snapshot_source
+static GCond snapshot_cond;
+#define SNAPSHOT_TIMEOUT 10              // seconds
+static int client_seqno = 0;
+static guint periodic_timer_id = 0;
 
 //
 // Audio
 //
 #define MIC_RING_BUFFER_SIZE 9600
 #define MIC_RING_LOW         3000
+#define MEDIA_MIC_LOW        1440        // less cushion needed with UDP
 
 static short *mic_ring_buffer;
+static int mic_ring_low = MIC_RING_LOW;
 static volatile short  mic_ring_outpt = 0;
 static volatile short  mic_ring_inpt = 0;
 
@@ -93,12 +105,13 @@ static int server_running = 0;
 static int listen_socket = -1;
 
 static int server_command(void * data);
+static int server_refresh(void * data);
 
 static int send_periodic_data(gpointer arg) {
   //
   // Use this periodic function to update PS and display info
   //
-  if (!remoteclient.running) {
+  if (remoteclients == 0) {
     return TRUE;
   }
 
@@ -116,7 +129,7 @@ static int send_periodic_data(gpointer arg) {
       ps_data.attenuation = to_short(transmitter->attenuation);
       tx_ps_getmx(transmitter);
       ps_data.ps_getmx = to_double(transmitter->ps_getmx);
-      send_bytes(remoteclient.socket, (char *)&ps_data, sizeof(PS_DATA));
+      send_bytes(SEND_ALL, (char *)&ps_data, sizeof(PS_DATA));
     }
   }
 
@@ -143,7 +156,7 @@ static int send_periodic_data(gpointer arg) {
   disp_data.sequence_errors = to_short(sequence_errors);
   disp_data.capture_record_pointer = to_int(capture_record_pointer);
   disp_data.capture_replay_pointer = to_int(capture_replay_pointer);
-  send_bytes(remoteclient.socket, (char *)&disp_data, sizeof(DISPLAY_DATA));
+  send_bytes(SEND_ALL, (char *)&disp_data, sizeof(DISPLAY_DATA));
   //
   // if sending the data failed due to an interrupted connection,
   // server_loop() will terminate and this source ID be removed
@@ -152,150 +165,360 @@ static int send_periodic_data(gpointer arg) {
   return TRUE;
 }
 
+//
+// Spectrum frames are encoded only once. Clients whose panadapter has a
+// different width get a copy made by the analyzer at that width if there
+// is one, else a re-sampled copy. Either is made once per width.
+//
+typedef struct _spectrum_frame {
+  SPECTRUM_DATA data;                    // VFO and meter data already filled in
+  uint8_t pixels[SPECTRUM_DATA_SIZE];    // pixels at the server's width
+  int numpixels;
+  int nvariant;
+  int width[MAX_REMOTE_CLIENTS];
+  SEND_PACKET *packet[MAX_REMOTE_CLIENTS];
+} SPECTRUM_FRAME;
+
+static void spectrum_encode(uint8_t *pixels, const float *samples, int numsamples) {
+  for (int i = 0; i < numsamples; i++) {
+    int s = ((int) samples[i]) + 200;  // -200dBm ... 55dBm maps to 0 ... 55
+
+    if (s < 0) { s = 0; }
+
+    if (s > 255) { s = 255; }
+
+    pixels[i] = (uint8_t) s;
+  }
+}
+
+static void spectrum_frame_init(SPECTRUM_FRAME *frame, int type, const float *samples, int numsamples) {
+  SPECTRUM_DATA *data = &frame->data;
+  SYNC(data->header.sync);
+  data->header.data_type = to_short(type);
+  data->vfo_a_freq = to_ll(vfo[VFO_A].frequency);
+  data->vfo_b_freq = to_ll(vfo[VFO_B].frequency);
+  data->vfo_a_ctun_freq = to_ll(vfo[VFO_A].ctun_frequency);
+  data->vfo_b_ctun_freq = to_ll(vfo[VFO_B].ctun_frequency);
+  data->vfo_a_offset = to_ll(vfo[VFO_A].offset);
+  data->vfo_b_offset = to_ll(vfo[VFO_B].offset);
+
+  if (numsamples > SPECTRUM_DATA_SIZE) { numsamples = SPECTRUM_DATA_SIZE; }
+
+  spectrum_encode(frame->pixels, samples, numsamples);
+  frame->numpixels = numsamples;
+  frame->nvariant = 0;
+}
+
+//
+// Make the packet from the pixels in data->sample and store it as the
+// variant for the given width
+//
+static SEND_PACKET *spectrum_frame_variant(SPECTRUM_FRAME *frame, int width) {
+  SPECTRUM_DATA *data = &frame->data;
+
+  //
+  // spectrum commands have a variable length, since this depends on the
+  // width of the screen. To this end, calculate the total number of bytes
+  // in THIS command (xferlen) and the length  of the payload.
+  //
+  int xferlen = sizeof(SPECTRUM_DATA) - (SPECTRUM_DATA_SIZE - width) * sizeof(uint8_t);
+  int payload = xferlen - sizeof(HEADER);
+
+  //cppcheck-suppress knownConditionTrueFalse
+  if (payload > 32000) { fatal_error("FATAL: Spectrum payload too large"); }
+
+  data->width = to_short(width);
+  data->header.s1 = to_short(payload);
+  int v = frame->nvariant++;
+  frame->width[v] = width;
+  frame->packet[v] = send_packet_new((char *)data, xferlen);
+  return frame->packet[v];
+}
+
+//
+// Add a variant the analyzer has made at another width
+//
+static void spectrum_frame_pixout(SPECTRUM_FRAME *frame, const float *samples, int width) {
+  if (width <= 0 || width > SPECTRUM_DATA_SIZE || frame->nvariant >= MAX_REMOTE_CLIENTS) { return; }
+
+  spectrum_encode(frame->data.sample, samples, width);
+  spectrum_frame_variant(frame, width);
+}
+
+//
+// Return the packet with the spectrum data re-sampled to the given width.
+// When reducing the width, the strongest signal of each group of pixels
+// is taken such that narrow peaks do not get lost.
+//
+static SEND_PACKET *spectrum_frame_packet(SPECTRUM_FRAME *frame, int width) {
+  SPECTRUM_DATA *data = &frame->data;
+  int n = frame->numpixels;
+
+  if (width <= 0 || width > SPECTRUM_DATA_SIZE) { width = n; }
+
+  for (int v = 0; v < frame->nvariant; v++) {
+    if (frame->width[v] == width) { return frame->packet[v]; }
+  }
+
+  if (frame->nvariant >= MAX_REMOTE_CLIENTS) { return NULL; }
+
+  for (int i = 0; i < width; i++) {
+    int first = (int) ((long) i * n / width);
+    int last = (int) ((long) (i + 1) * n / width);
+    uint8_t max = frame->pixels[first];
+
+    for (int k = first + 1; k < last; k++) {
+      if (frame->pixels[k] > max) { max = frame->pixels[k]; }
+    }
+
+    data->sample[i] = max;
+  }
+
+  return spectrum_frame_variant(frame, width);
+}
+
+static void spectrum_frame_done(SPECTRUM_FRAME *frame) {
+  for (int v = 0; v < frame->nvariant; v++) {
+    send_packet_unref(frame->packet[v]);
+  }
+}
+
+//
+// Clients with a UDP media channel get the spectrum data through UDP,
+// if this fails it goes through the TCP connection
+//
+static void spectrum_send(REMOTE_CLIENT *client, int stream, SEND_PACKET *packet) {
+  if (packet == NULL) { return; }
+
+  if (client->media) {
+    int bytes;
+    const char *data = send_packet_data(packet, &bytes);
+
+    if (media_send(client, stream, 0, data, bytes) > 0) { return; }
+  }
+
+  send_queue_put_packet(client->socket, packet);
+}
+
+//
+// Listen-only clients may ask for a lower frame rate than the
+// one of the server. Then, only every n-th frame is sent.
+//
+static int spectrum_due(double *credit, int want, int have) {
+  if (want <= 0 || want >= have) { return 1; }
+
+  *credit += (double) want / (double) have;
+
+  if (*credit >= 1.0) {
+    *credit -= 1.0;
+    return 1;
+  }
+
+  return 0;
+}
+
+//
+// The controlling client determines the width of the server's
+// panadapters, for the others the width is calculated from their
+// screen width (0: server's width)
+//
+static int client_rx_width(const REMOTE_CLIENT *client) {
+  if (client->control || client->width <= 0) { return 0; }
+
+  return client->stack_horizontal ? client->width / receivers : client->width;
+}
+
+//
+// Tell the receivers at which frame rate and width the remote clients
+// want their spectrum. The controlling client gets the full rate, the
+// others the rate they have asked for (0: full rate).
+// Call this whenever a subscription, a requested rate, a screen width,
+// or the set of clients changes.
+//
+static void server_spectrum_demand() {
+  g_mutex_lock(&clients_mutex);
+
+  for (int id = 0; id < RECEIVERS && id < 8; id++) {
+    int fps = 0;
+    int widths[RX_PIXOUTS - 1];
+    int n = 0;
+
+    for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+      const REMOTE_CLIENT *client = &remoteclient[c];
+
+      if (!client->running || !client->send_rx_spectrum[id]) { continue; }
+
+      if (client->control || client->rx_fps[id] <= 0) {
+        fps = SPECTRUM_FULL_RATE;
+      } else if (client->rx_fps[id] > fps) {
+        fps = client->rx_fps[id];
+      }
+
+      int width = client_rx_width(client);
+      int k = 0;
+
+      if (width <= 0 || width > SPECTRUM_DATA_SIZE || receiver[id] == NULL || width == receiver[id]->pixels) { continue; }
+
+      while (k < n && widths[k] != width) { k++; }
+
+      if (k == n && n < RX_PIXOUTS - 1) { widths[n++] = width; }
+    }
+
+    rx_spectrum_demand(receiver[id], SPECTRUM_REMOTE, fps);
+    rx_spectrum_widths(receiver[id], widths, n);
+  }
+
+  g_mutex_unlock(&clients_mutex);
+}
+
 //
 // Note that this is now only called when
 // - display mutex is locked
 // - displaying is set and a pixel_samples contain valid data
 //
 void send_rxspectrum(int id) {
-  const float *samples;
-  SPECTRUM_DATA spectrum_data;
-  int numsamples = 0;
+  static SPECTRUM_FRAME frames[8];  // only used from the RX thread of receiver id
 
-  if (!remoteclient.send_rx_spectrum[id] || id >= receivers || !remoteclient.running) {
+  if (id >= receivers || remoteclients == 0) {
     return;
   }
 
-  SYNC(spectrum_data.header.sync);
-  spectrum_data.header.data_type = to_short(INFO_RX_SPECTRUM);
-  spectrum_data.vfo_a_freq = to_ll(vfo[VFO_A].frequency);
-  spectrum_data.vfo_b_freq = to_ll(vfo[VFO_B].frequency);
-  spectrum_data.vfo_a_ctun_freq = to_ll(vfo[VFO_A].ctun_frequency);
-  spectrum_data.vfo_b_ctun_freq = to_ll(vfo[VFO_B].ctun_frequency);
-  spectrum_data.vfo_a_offset = to_ll(vfo[VFO_A].offset);
-  spectrum_data.vfo_b_offset = to_ll(vfo[VFO_B].offset);
-  //
-  spectrum_data.id = id;
+  SPECTRUM_FRAME *f = &frames[id];
   const RECEIVER *rx = receiver[id];
-  spectrum_data.avail = rx->pixels_available;
-  spectrum_data.cA = to_double(rx->cA);
-  spectrum_data.cB = to_double(rx->cB);
-  spectrum_data.cAp = to_double(rx->cAp);
-  spectrum_data.cBp = to_double(rx->cBp);
-  spectrum_data.meter = to_double(rx->meter);
-  spectrum_data.width = to_short(rx->width);
-  samples = rx->pixel_samples;
-  numsamples = rx->width;
+  int done = 0;
 
-  if (numsamples > SPECTRUM_DATA_SIZE) { numsamples = SPECTRUM_DATA_SIZE; }
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    REMOTE_CLIENT *client = &remoteclient[c];
 
-  for (int i = 0; i < numsamples; i++) {
-    int s = ((int) samples[i]) + 200;  // -200dBm ... 55dBm maps to 0 ... 55
+    if (!client->running || !client->send_rx_spectrum[id]) { continue; }
 
-    if (s < 0) { s = 0; }
+    if (!client->control && !spectrum_due(&client->rx_credit[id], client->rx_fps[id], rx->analyzer_fps)) { continue; }
 
-    if (s > 255) { s = 255; }
+    if (!done) {
+      spectrum_frame_init(f, INFO_RX_SPECTRUM, rx->pixel_samples, rx->width);
+      f->data.id = id;
+      f->data.avail = rx->pixels_available;
+      f->data.cA = to_double(rx->cA);
+      f->data.cB = to_double(rx->cB);
+      f->data.cAp = to_double(rx->cAp);
+      f->data.cBp = to_double(rx->cBp);
+      f->data.meter = to_double(rx->meter);
 
-    spectrum_data.sample[i] = (uint8_t) s;
-  }
+      for (int i = 1; i <= rx->pixouts; i++) {
+        if (rx->pixout_available[i]) { spectrum_frame_pixout(f, rx->pixout_samples[i], rx->pixout_width[i]); }
+      }
 
-  if (numsamples > 0) {
-    //
-    // spectrum commands have a variable length, since this depends on the
-    // width of the screen. To this end, calculate the total number of bytes
-    // in THIS command (xferlen) and the length  of the payload.
-    //
-    int xferlen = sizeof(spectrum_data) - (SPECTRUM_DATA_SIZE - numsamples) * sizeof(uint8_t);
-    int payload = xferlen - sizeof(HEADER);
+      done = 1;
+    }
 
-    //cppcheck-suppress knownConditionTrueFalse
-    if (payload > 32000) { fatal_error("FATAL: Spectrum payload too large"); }
+    if (f->numpixels <= 0) { break; }
 
-    spectrum_data.header.s1 = to_short(payload);
-    send_bytes(remoteclient.socket, (char *)&spectrum_data, xferlen);
+    int width = client_rx_width(client);
+    spectrum_send(client, MEDIA_STREAM_RXSPECTRUM(id), spectrum_frame_packet(f, width > 0 ? width : f->numpixels));
   }
+
+  if (done) { spectrum_frame_done(f); }
 }
 
 void send_txspectrum() {
-  const float *samples;
-  SPECTRUM_DATA spectrum_data;
-  int numsamples = 0;
+  static SPECTRUM_FRAME frame;
+  const TRANSMITTER *tx = transmitter;
+  int done = 0;
 
-  if (!remoteclient.send_tx_spectrum || !can_transmit || !remoteclient.running) {
+  if (!can_transmit || remoteclients == 0) {
     return;
   }
 
-  SYNC(spectrum_data.header.sync);
-  spectrum_data.header.data_type = to_short(INFO_TX_SPECTRUM);
-  spectrum_data.vfo_a_freq = to_ll(vfo[VFO_A].frequency);
-  spectrum_data.vfo_b_freq = to_ll(vfo[VFO_B].frequency);
-  spectrum_data.vfo_a_ctun_freq = to_ll(vfo[VFO_A].ctun_frequency);
-  spectrum_data.vfo_b_ctun_freq = to_ll(vfo[VFO_B].ctun_frequency);
-  spectrum_data.vfo_a_offset = to_ll(vfo[VFO_A].offset);
-  spectrum_data.vfo_b_offset = to_ll(vfo[VFO_B].offset);
-  //
-  const TRANSMITTER *tx = transmitter;
-  spectrum_data.alc   = to_double(tx->alc);
-  spectrum_data.fwd   = to_double(tx->fwd);
-  spectrum_data.swr   = to_double(tx->swr);
-  spectrum_data.width = to_short(tx->width);
-  samples = tx->pixel_samples;
-  numsamples = tx->width;
-
-  if (numsamples > SPECTRUM_DATA_SIZE) { numsamples = SPECTRUM_DATA_SIZE; }
-
-  //
-  // When running duplex, tx->pixels > tx->width, so transfer only central part
-  //
-  int offset = (tx->pixels - tx->width) / 2;
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    REMOTE_CLIENT *client = &remoteclient[c];
 
-  for (int i = 0; i < numsamples; i++) {
-    int s = ((int) samples[i + offset]) + 200;  // -200dBm ... 55dBm maps to 0 ... 55
+    if (!client->running || !client->send_tx_spectrum) { continue; }
 
-    if (s < 0) { s = 0; }
+    if (!done) {
+      //
+      // When running duplex, tx->pixels > tx->width, so transfer only central part
+      //
+      int offset = (tx->pixels - tx->width) / 2;
+      spectrum_frame_init(&frame, INFO_TX_SPECTRUM, tx->pixel_samples + offset, tx->width);
+      frame.data.alc   = to_double(tx->alc);
+      frame.data.fwd   = to_double(tx->fwd);
+      frame.data.swr   = to_double(tx->swr);
+      done = 1;
+    }
 
-    if (s > 255) { s = 255; }
+    if (frame.numpixels <= 0) { break; }
 
-    spectrum_data.sample[i] = (uint8_t) s;
+    int width = (!client->control && client->width > 0) ? client->width : frame.numpixels;
+    spectrum_send(client, MEDIA_STREAM_TXSPECTRUM, spectrum_frame_packet(&frame, width));
   }
 
-  if (numsamples > 0) {
-    //
-    // spectrum commands have a variable length, since this depends on the
-    // width of the screen. To this end, calculate the total number of bytes
-    // in THIS command (xferlen) and the length  of the payload.
-    //
-    int xferlen = sizeof(spectrum_data) - (SPECTRUM_DATA_SIZE - numsamples) * sizeof(uint8_t);
-    int payload = xferlen - sizeof(HEADER);
+  if (done) { spectrum_frame_done(&frame); }
+}
 
-    //cppcheck-suppress knownConditionTrueFalse
-    if (payload > 32000) { fatal_error("FATAL: Spectrum payload too large"); }
+//
+// Clients with a UDP media channel get smaller audio packets, these are
+// time-stamped with the number of their first sample
+//
+static void remote_rxaudio_media(int id, uint32_t timestamp, const uint16_t *samples) {
+  RXAUDIO_DATA data;
+  int bytes = sizeof(RXAUDIO_DATA) - 2 * (AUDIO_DATA_SIZE - MEDIA_AUDIO_FRAMES) * sizeof(uint16_t);
+  memset(&data.header, 0, sizeof(HEADER));
+  SYNC(data.header.sync);
+  data.header.data_type = to_short(INFO_RXAUDIO);
+  data.rx = id;
+  data.numsamples = to_short(MEDIA_AUDIO_FRAMES);
+  memcpy(data.samples, samples, 2 * MEDIA_AUDIO_FRAMES * sizeof(uint16_t));
 
-    spectrum_data.header.s1 = to_short(payload);
-    send_bytes(remoteclient.socket, (char *)&spectrum_data, xferlen);
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    REMOTE_CLIENT *client = &remoteclient[c];
+
+    if (client->running && client->media && client->send_rx_audio[id]) {
+      media_send(client, MEDIA_STREAM_RXAUDIO(id), timestamp, (char *)&data, bytes);
+    }
   }
 }
 
 void remote_rxaudio(const RECEIVER *rx, short left_sample, short right_sample) {
   static int rxaudio_buffer_index[2] = { 0, 0};
   static RXAUDIO_DATA rxaudio_data[2];  // for up to 2 receivers
+  static uint32_t rxaudio_timestamp[2] = { 0, 0};
   int id = rx->id;
   int i = rxaudio_buffer_index[id] * 2;
 
-  if (!remoteclient.running) {
+  if (remoteclients == 0) {
     return;
   }
 
   rxaudio_data[id].samples[i] = to_short(left_sample);
   rxaudio_data[id].samples[i + 1] = to_short(right_sample);
   rxaudio_buffer_index[id]++;
+  rxaudio_timestamp[id]++;
+
+  if (rxaudio_buffer_index[id] % MEDIA_AUDIO_FRAMES == 0) {
+    remote_rxaudio_media(id, rxaudio_timestamp[id] - MEDIA_AUDIO_FRAMES,
+                         rxaudio_data[id].samples + 2 * (rxaudio_buffer_index[id] - MEDIA_AUDIO_FRAMES));
+  }
 
   if (rxaudio_buffer_index[id] >= AUDIO_DATA_SIZE) {
     SYNC(rxaudio_data[id].header.sync);
     rxaudio_data[id].header.data_type = to_short(INFO_RXAUDIO);
     rxaudio_data[id].rx = id;
     rxaudio_data[id].numsamples = to_short(rxaudio_buffer_index[id]);
-    send_bytes(remoteclient.socket, (char *)&rxaudio_data[id], sizeof(RXAUDIO_DATA));
+    //
+    // The packet is made once and then queued for all clients
+    // that want to hear this receiver
+    //
+    SEND_PACKET *packet = send_packet_new((char *)&rxaudio_data[id], sizeof(RXAUDIO_DATA));
+
+    for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+      const REMOTE_CLIENT *client = &remoteclient[c];
+
+      if (client->running && client->send_rx_audio[id] && !client->media) {
+        send_queue_put_packet(client->socket, packet);
+      }
+    }
+
+    send_packet_unref(packet);
     rxaudio_buffer_index[id] = 0;
   }
 }
@@ -304,7 +527,7 @@ short remote_get_mic_sample() {
   //
   // return one sample from the  microphone audio ring buffer
   // If it is empty, return a zero, and continue to return
-  // zero until it is at least filled with  MIC_RING_LOW samples
+  // zero until it is at least filled with mic_ring_low samples
   //
   short sample;
   static int is_empty = 1;
@@ -314,7 +537,7 @@ short remote_get_mic_sample() {
 
   if (numsamples <= 0) { is_empty = 1; }
 
-  if (is_empty && numsamples < MIC_RING_LOW) {
+  if (is_empty && numsamples < mic_ring_low) {
     return 0;
   }
 
@@ -332,38 +555,142 @@ short remote_get_mic_sample() {
 }
 
 //
-// server_loop is running on the "local" computer
-// (with direct cable connection to the radio hardware)
+// Put microphone samples from the controlling client into the ring buffer.
+// They arrive either through the TCP connection or through the UDP media
+// channel, and with the latter, a smaller cushion is kept.
 //
-static void server_loop() {
-  HEADER header;
-  t_print("%s: Client connected on port %d\n", __FUNCTION__, remoteclient.address.sin_port);
-  //
-  // Allocate ring buffer for TX mic data
-  //
-  mic_ring_buffer = g_new(short, MIC_RING_BUFFER_SIZE);
-  mic_ring_outpt = 0;
-  mic_ring_inpt = 0;
-  //
-  // The server starts with sending  a lot of data to initialise
-  // the data on the client side.
-  //
+void server_mic_audio(const short *samples, int numsamples, int udp) {
+  mic_ring_low = udp ? MEDIA_MIC_LOW : MIC_RING_LOW;
+
+  for (int i = 0; i < numsamples; i++) {
+    int newpt = mic_ring_inpt + 1;
+
+    if (newpt == MIC_RING_BUFFER_SIZE) { newpt = 0; }
+
+    if (newpt != mic_ring_outpt) {
+      MEMORY_BARRIER;
+      // buffer space available, do the write
+      mic_ring_buffer[mic_ring_inpt] = samples[i];
+      MEMORY_BARRIER;
+      // atomic update of mic_ring_inpt
+      mic_ring_inpt = newpt;
+    }
+  }
+}
+
+//
+// Commands from the controlling client are executed in the GTK queue.
+// Listen-only clients can only change their own subscriptions, all
+// other commands from them are discarded.
+//
+typedef struct _refresh {
+  const REMOTE_CLIENT *client;
+  int socket;
+  gpointer data;
+} REFRESH;
+
+static void server_submit(REMOTE_CLIENT *client, gpointer data) {
+  const HEADER *header = (const HEADER *)data;
+
+  switch (from_short(header->data_type)) {
+  case CMD_SCREEN:
+    client->stack_horizontal = header->b1;
+    client->width = from_short(header->s1);
+    server_spectrum_demand();
+    break;
+
+  case CMD_RX_FPS:
+    if (!client->control && header->b1 < 8) {
+      client->rx_fps[header->b1] = header->b2;
+      client->rx_credit[header->b1] = 0.0;
+      server_spectrum_demand();
+    }
+
+    break;
+  }
+
+  if (client->control) {
+    g_idle_add(server_command, data);
+  } else {
+    //
+    // A listen-only client has already changed its own state, so it
+    // gets the state of the server again. The socket is noted since
+    // the client slot may be re-used before the refresh runs.
+    //
+    switch (from_short(header->data_type)) {
+    case CMD_SCREEN:
+    case CMD_RX_FPS:
+      g_free(data);
+      break;
+
+    default: {
+      REFRESH *refresh = g_new(REFRESH, 1);
+      refresh->client = client;
+      refresh->socket = client->socket;
+      refresh->data = data;
+      g_idle_add(server_refresh, refresh);
+    }
+    break;
+    }
+  }
+}
+
+//
+// The state packets that make up a snapshot are collected here. Only
+// state that the client does not already have is included.
+//
+static GByteArray *snapshot = NULL;
+static int snapshot_socket = -1;
+
+void server_snapshot_add(const char *buffer, int bytes) {
+  if (snapshot && send_queue_changed(snapshot_socket, buffer, bytes)) {
+    g_byte_array_append(snapshot, (const guint8 *)buffer, bytes);
+  }
+}
+
+//
+// Send the state that commands usually change (radio, ADC, receiver,
+// VFO and transmitter data). The send queue knows which state the
+// client already has, so only the parts that have changed go out.
+//
+static void server_send_state(int sock) {
+  send_radio_data(sock);
+  send_adc_data(sock, 0);
+  send_adc_data(sock, 1);
+
+  for (int i = 0; i < RECEIVERS; i++) {
+    send_rx_data(sock, i);
+  }
+
+  if (protocol == ORIGINAL_PROTOCOL || protocol == NEW_PROTOCOL) {
+    send_rx_data(sock, PS_RX_FEEDBACK);
+  }
+
+  send_vfo_data(sock, VFO_A);
+  send_vfo_data(sock, VFO_B);
+  send_tx_data(sock);
+}
+
+//
+// Send the complete state
+//
+static void server_send_all_state(int sock) {
   //
   // Send global variables
   //
-  send_radio_data(remoteclient.socket);
+  send_radio_data(sock);
   //
   // send ADC data structure
   //
-  send_adc_data(remoteclient.socket, 0);
-  send_adc_data(remoteclient.socket, 1);
+  send_adc_data(sock, 0);
+  send_adc_data(sock, 1);
 
   //
   // Send filter edges of the Var1 and Var2 filters
   //
   for (int m = 0; m < MODES;  m++) {
-    send_filter_var(remoteclient.socket, m, filterVar1);
-    send_filter_var(remoteclient.socket, m, filterVar2);
+    send_filter_var(sock, m, filterVar1);
+    send_filter_var(sock, m, filterVar2);
   }
 
   //
@@ -372,28 +699,28 @@ static void server_loop() {
   // can be changed through the GUI
   //
   for (int i = 0; i < RECEIVERS; i++) {
-    send_rx_data(remoteclient.socket, i);
+    send_rx_data(sock, i);
   }
 
   if (protocol == ORIGINAL_PROTOCOL || protocol == NEW_PROTOCOL) {
-    send_rx_data(remoteclient.socket, PS_RX_FEEDBACK);
+    send_rx_data(sock, PS_RX_FEEDBACK);
   }
 
   //
   // Send VFO data
   //
-  send_vfo_data(remoteclient.socket, VFO_A);    // send INFO_VFO packet
-  send_vfo_data(remoteclient.socket, VFO_B);    // send INFO_VFO packet
+  send_vfo_data(sock, VFO_A);    // send INFO_VFO packet
+  send_vfo_data(sock, VFO_B);    // send INFO_VFO packet
 
   //
   // Send Band and Bandstack data
   //
   for (int b = 0; b < BANDS + XVTRS; b++) {
-    send_band_data(remoteclient.socket, b);
+    send_band_data(sock, b);
     const BAND *band = band_get_band(b);
 
     for (int s = 0; s < band->bandstack->entries; s++) {
-      send_bandstack_data(remoteclient.socket, b, s);
+      send_bandstack_data(sock, b, s);
     }
   }
 
@@ -401,17 +728,212 @@ static void server_loop() {
   // Send memory slots
   //
   for (int i = 0; i < NUM_MEMORIES; i++) {
-    send_memory_data(remoteclient.socket, i);
+    send_memory_data(sock, i);
   }
 
   //
   // Send transmitter data
   //
-  send_tx_data(remoteclient.socket);
+  send_tx_data(sock);
+}
+
+//
+// Send the state that a command may have changed. Most commands only
+// change the receiver, transmitter, VFO or radio state, band data
+// and filter edges are sent explicitly.
+//
+static void server_update_client(int sock, const HEADER *header) {
+  server_send_state(sock);
+
+  switch (from_short(header->data_type)) {
+  case INFO_BAND: {
+    const BAND_DATA *band_data = (const BAND_DATA *)header;
+
+    if (band_data->band < BANDS + XVTRS) {
+      send_band_data(sock, band_data->band);
+    }
+  }
+  break;
+
+  case INFO_BANDSTACK: {
+    const BANDSTACK_DATA *bandstack_data = (const BANDSTACK_DATA *)header;
+
+    if (bandstack_data->band < BANDS + XVTRS &&
+        bandstack_data->stack < band_get_band(bandstack_data->band)->bandstack->entries) {
+      send_bandstack_data(sock, bandstack_data->band, bandstack_data->stack);
+    }
+  }
+  break;
+
+  case CMD_FILTER_VAR:
+    if (header->b1 < MODES) {
+      send_filter_var(sock, header->b1, header->b2);
+    }
+
+    break;
+  }
+}
+
+//
+// After a command from the controlling client has been executed,
+// the listen-only clients get the state it has changed.
+//
+static void server_update_listeners(const HEADER *header) {
+  g_mutex_lock(&clients_mutex);
+
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    const REMOTE_CLIENT *client = &remoteclient[c];
+
+    if (!client->running || client->control || !client->snapshot_sent) { continue; }
+
+    server_update_client(client->socket, header);
+  }
+
+  g_mutex_unlock(&clients_mutex);
+}
+
+//
+// The command of a listen-only client has been ignored. Its state table
+// no longer has the volatile state (see send_queue_command()), so the
+// state of the server is sent to it again.
+//
+static int server_refresh(gpointer data) {
+  REFRESH *refresh = (REFRESH *)data;
+  const REMOTE_CLIENT *client = refresh->client;
+  g_mutex_lock(&clients_mutex);
+
+  if (client->running && client->socket == refresh->socket && !client->control && client->snapshot_sent) {
+    server_update_client(refresh->socket, (const HEADER *)refresh->data);
+  }
+
+  g_mutex_unlock(&clients_mutex);
+  g_free(refresh->data);
+  g_free(refresh);
+  return G_SOURCE_REMOVE;
+}
+
+static int server_snapshot(gpointer data) {
+  REMOTE_CLIENT *client = (REMOTE_CLIENT *)data;
+  g_mutex_lock(&snapshot_mutex);
+
+  //
+  // server_loop() may have given up waiting and removed this source
+  // while it was already dispatched.
+  //
+  if (client->snapshot_source != g_source_get_id(g_main_current_source())) {
+    g_mutex_unlock(&snapshot_mutex);
+    return G_SOURCE_REMOVE;
+  }
+
+  snapshot = g_byte_array_new();
+  snapshot_socket = client->socket;
+  server_send_all_state(SEND_SNAPSHOT);
+  GByteArray *zdata = remote_zlib(TRUE, snapshot->data, snapshot->len);
+
+  if (zdata) {
+    int bytes = sizeof(SNAPSHOT_DATA) + zdata->len;
+    SNAPSHOT_DATA *packet = g_malloc(bytes);
+    memset(packet, 0, sizeof(SNAPSHOT_DATA));
+    SYNC(packet->header.sync);
+    packet->header.data_type = to_short(INFO_SNAPSHOT);
+    packet->header.s1 = to_short(SNAPSHOT_VERSION);
+    packet->length = to_int(snapshot->len);
+    packet->compressed = to_int(zdata->len);
+    memcpy((char *)packet + sizeof(SNAPSHOT_DATA), zdata->data, zdata->len);
+    t_print("%s: %u bytes of state, %u bytes compressed\n", __FUNCTION__, snapshot->len, zdata->len);
+    send_bytes(client->socket, (char *)packet, bytes);
+    g_free(packet);
+    g_byte_array_free(zdata, TRUE);
+    g_byte_array_free(snapshot, TRUE);
+    snapshot = NULL;
+  } else {
+    //
+    // The state table already has the contents of the snapshot that has
+    // not been sent. Forget it and send the state packet by packet.
+    //
+    t_print("%s: compression failed, sending state uncompressed\n", __FUNCTION__);
+    g_byte_array_free(snapshot, TRUE);
+    snapshot = NULL;
+    send_queue_forget(client->socket);
+    server_send_all_state(client->socket);
+  }
+
   //
   // If everything has been sent, start the radio
   //
-  send_start_radio(remoteclient.socket);
+  send_start_radio(client->socket);
+  client->snapshot_sent = TRUE;
+  client->snapshot_source = 0;
+  g_cond_broadcast(&snapshot_cond);
+  g_mutex_unlock(&snapshot_mutex);
+  return G_SOURCE_REMOVE;
+}
+
+//
+// Read the state the client has from an earlier connection
+//
+static int server_read_digest(REMOTE_CLIENT *client) {
+  STATE_DIGEST digest;
+  STATE_DIGEST_ENTRY entry;
+
+  if (recv_bytes(client->socket, (char *)&digest, sizeof(STATE_DIGEST)) <= 0 ||
+      memcmp(digest.header.sync, syncbytes, sizeof(syncbytes)) != 0 ||
+      from_short(digest.header.data_type) != CMD_STATE_DIGEST) {
+    t_print("%s: no state digest from client\n", __FUNCTION__);
+    return -1;
+  }
+
+  unsigned int count = from_int(digest.count);
+
+  if (count > MAX_STATE_DIGESTS) {
+    t_print("%s: too many digests (%u)\n", __FUNCTION__, count);
+    return -1;
+  }
+
+  for (unsigned int i = 0; i < count; i++) {
+    if (recv_bytes(client->socket, (char *)&entry, sizeof(STATE_DIGEST_ENTRY)) <= 0) { return -1; }
+
+    send_queue_seed(client->socket, from_int(entry.key), (uint64_t) from_ll(entry.hash));
+  }
+
+  if (count > 0) {
+    t_print("%s: client resumes with %u state entries\n", __FUNCTION__, count);
+  }
+
+  return 0;
+}
+
+//
+// server_loop is running on the "local" computer
+// (with direct cable connection to the radio hardware)
+//
+static void server_loop(REMOTE_CLIENT *client) {
+  HEADER header;
+  t_print("%s: Client connected on port %d\n", __FUNCTION__, from_short(client->address.sin_port));
+  //
+  // The complete state is sent in a single compressed packet. It is
+  // put together in the GTK queue since this is where the state changes.
+  // If the GTK queue does not get to it within SNAPSHOT_TIMEOUT seconds,
+  // or the client or server stops meanwhile, the connection is closed.
+  //
+  gint64 end_time = g_get_monotonic_time() + SNAPSHOT_TIMEOUT * G_TIME_SPAN_SECOND;
+  g_mutex_lock(&snapshot_mutex);
+  client->snapshot_sent = FALSE;
+  client->snapshot_source = g_idle_add(server_snapshot, client);
+
+  while (!client->snapshot_sent && client->running && server_running && g_get_monotonic_time() < end_time) {
+    g_cond_wait_until(&snapshot_cond, &snapshot_mutex, MIN(end_time, g_get_monotonic_time() + G_TIME_SPAN_SECOND / 10));
+  }
+
+  if (!client->snapshot_sent) {
+    g_source_remove(client->snapshot_source);
+    client->snapshot_source = 0;
+    g_mutex_unlock(&snapshot_mutex);
+    t_print("%s: snapshot not sent, closing connection\n", __FUNCTION__);
+    return;
+  }
+
+  g_mutex_unlock(&snapshot_mutex);
 
   //
   // Now, enter an "inifinte" loop, get and parse commands from the client.
@@ -419,18 +941,18 @@ static void server_loop() {
   // If a complete command has been received, put a "server_command()" with that
   // command into the GTK idle queue.
   //
-  while (remoteclient.running) {
+  while (client->running) {
     //
     // Getting out-of-sync data is a very rare event with TCP
     // (I am not sure whether this can happen unless there is a program error)
     // so try first to read a complete header in one shot, and if this files,
     // do a re-sync
     //
-    int bytes_read = recv_bytes(remoteclient.socket, (char *)&header, sizeof(HEADER));
+    int bytes_read = recv_bytes(client->socket, (char *)&header, sizeof(HEADER));
 
     if (bytes_read <= 0) {
       t_print("%s: ReadErr for HEADER SYNC\n", __FUNCTION__);
-      remoteclient.running = FALSE;
+      client->running = FALSE;
       continue;
     }
 
@@ -443,12 +965,12 @@ static void server_loop() {
       int syncs = 0;
       uint8_t c;
 
-      while (syncs != sizeof(syncbytes) && remoteclient.running) {
-        bytes_read = recv_bytes(remoteclient.socket, (char *)&c, 1);
+      while (syncs != sizeof(syncbytes) && client->running) {
+        bytes_read = recv_bytes(client->socket, (char *)&c, 1);
 
         if (bytes_read <= 0) {
           t_print("%s: ReadErr for HEADER RESYNC\n", __FUNCTION__);
-          remoteclient.running = FALSE;
+          client->running = FALSE;
           break;
         }
 
@@ -459,18 +981,18 @@ static void server_loop() {
         }
       }
 
-      if (recv_bytes(remoteclient.socket, (char *)&header + sizeof(header.sync), sizeof(header) - sizeof(header.sync)) <= 0) {
-        remoteclient.running = FALSE;
+      if (recv_bytes(client->socket, (char *)&header + sizeof(header.sync), sizeof(header) - sizeof(header.sync)) <= 0) {
+        client->running = FALSE;
       }
 
-      if (remoteclient.running) {
+      if (client->running) {
         t_print("%s: Re-SYNC was successful!\n", __FUNCTION__);
       } else {
         t_print("%s: Re-SYNC failed.\n", __FUNCTION__);
       }
     }
 
-    if (!remoteclient.running) { break; }
+    if (!client->running) { break; }
 
     //
     // Now we have a valid header
@@ -478,6 +1000,16 @@ static void server_loop() {
     int data_type = from_short(header.data_type);
     //t_print("%s: received header: type=%d\n", __FUNCTION__, data_type);
 
+    //
+    // Keep the state table of the client up to date. This is also done
+    // for listen-only clients: their commands are not executed, but they
+    // have changed the state on the client side. State packets are noted
+    // when they have been received completely.
+    //
+    if (data_type != INFO_BAND && data_type != INFO_BANDSTACK && data_type != INFO_ADC) {
+      send_queue_command(client->socket, (char *)&header, sizeof(HEADER));
+    }
+
     switch (data_type) {
     case CMD_HEARTBEAT:
       // periodically sent to  keep  connection alive
@@ -490,24 +1022,34 @@ static void server_loop() {
       //
       TXAUDIO_DATA txaudio_data;
 
-      if (recv_bytes(remoteclient.socket, (char *)&txaudio_data + sizeof(HEADER),
+      if (recv_bytes(client->socket, (char *)&txaudio_data + sizeof(HEADER),
                      sizeof(TXAUDIO_DATA) - sizeof(HEADER)) > 0) {
+        short samples[AUDIO_DATA_SIZE];
         unsigned int numsamples = from_short(txaudio_data.numsamples);
 
+        //
+        // Only the controlling client can transmit
+        //
+        if (!client->control || numsamples > AUDIO_DATA_SIZE) { numsamples = 0; }
+
         for (unsigned int i = 0; i < numsamples; i++) {
-          int newpt = mic_ring_inpt + 1;
-
-          if (newpt == MIC_RING_BUFFER_SIZE) { newpt = 0; }
-
-          if (newpt != mic_ring_outpt) {
-            MEMORY_BARRIER;
-            // buffer space available, do the write
-            mic_ring_buffer[mic_ring_inpt] = from_short(txaudio_data.samples[i]);
-            MEMORY_BARRIER;
-            // atomic update of mic_ring_inpt
-            mic_ring_inpt = newpt;
-          }
+          samples[i] = from_short(txaudio_data.samples[i]);
         }
+
+        server_mic_audio(samples, numsamples, FALSE);
+      }
+    }
+    break;
+
+    case CMD_MEDIA: {
+      //
+      // The client asks for (b1=1) or gives up (b1=0) the UDP media channel
+      //
+      U64_COMMAND command;
+      command.header = header;
+
+      if (recv_bytes(client->socket, (char *)&command + sizeof(HEADER), sizeof(U64_COMMAND) - sizeof(HEADER)) > 0) {
+        media_offer(client, command.header.b1);
       }
     }
     break;
@@ -516,8 +1058,10 @@ static void server_loop() {
       BAND_DATA *command = g_new(BAND_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(BAND_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(BAND_DATA) - sizeof(HEADER)) > 0) {
+        send_queue_command(client->socket, (char *)command, sizeof(BAND_DATA));
+
+        server_submit(client, command);
       }
     }
     break;
@@ -526,8 +1070,10 @@ static void server_loop() {
       BANDSTACK_DATA *command = g_new(BANDSTACK_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(BANDSTACK_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(BANDSTACK_DATA) - sizeof(HEADER)) > 0) {
+        send_queue_command(client->socket, (char *)command, sizeof(BANDSTACK_DATA));
+
+        server_submit(client, command);
       }
     }
     break;
@@ -540,8 +1086,10 @@ static void server_loop() {
       ADC_DATA *command = g_new(ADC_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(ADC_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(ADC_DATA) - sizeof(HEADER)) > 0) {
+        send_queue_command(client->socket, (char *)command, sizeof(ADC_DATA));
+
+        server_submit(client, command);
       }
     }
     break;
@@ -549,13 +1097,24 @@ static void server_loop() {
     case CMD_RX_SPECTRUM: {
       int id = header.b1;
       int state = header.b2;
-      remoteclient.send_rx_spectrum[id] = state;
+      client->send_rx_spectrum[id] = state;
+      server_spectrum_demand();
     }
     break;
 
     case CMD_TX_SPECTRUM: {
       int state = header.b2;
-      remoteclient.send_tx_spectrum = state;
+      client->send_tx_spectrum = state;
+    }
+    break;
+
+    case CMD_RX_AUDIO: {
+      //
+      // This only affects the audio stream to this client
+      //
+      int id = header.b1;
+
+      if (id < 8) { client->send_rx_audio[id] = header.b2; }
     }
     break;
 
@@ -563,8 +1122,8 @@ static void server_loop() {
       AGC_GAIN_COMMAND *command = g_new(AGC_GAIN_COMMAND, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(AGC_GAIN_COMMAND) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(AGC_GAIN_COMMAND) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -573,8 +1132,8 @@ static void server_loop() {
       NOISE_COMMAND *command = g_new(NOISE_COMMAND, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(NOISE_COMMAND) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(NOISE_COMMAND) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -584,8 +1143,8 @@ static void server_loop() {
       EQUALIZER_COMMAND *command = g_new(EQUALIZER_COMMAND, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(EQUALIZER_COMMAND) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(EQUALIZER_COMMAND) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -594,8 +1153,8 @@ static void server_loop() {
       RADIOMENU_DATA *command = g_new(RADIOMENU_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(RADIOMENU_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(RADIOMENU_DATA) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -604,8 +1163,8 @@ static void server_loop() {
       RXMENU_DATA *command = g_new(RXMENU_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(RXMENU_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(RXMENU_DATA) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -614,8 +1173,8 @@ static void server_loop() {
       DIVERSITY_COMMAND *command = g_new(DIVERSITY_COMMAND, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(DIVERSITY_COMMAND) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(DIVERSITY_COMMAND) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -624,8 +1183,8 @@ static void server_loop() {
       DEXP_DATA *command = g_new(DEXP_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(DEXP_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(DEXP_DATA) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -634,8 +1193,8 @@ static void server_loop() {
       COMPRESSOR_DATA *command = g_new(COMPRESSOR_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(COMPRESSOR_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(COMPRESSOR_DATA) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -644,8 +1203,8 @@ static void server_loop() {
       TXMENU_DATA *command = g_new(TXMENU_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(TXMENU_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(TXMENU_DATA) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -654,8 +1213,8 @@ static void server_loop() {
       PS_PARAMS *command = g_new(PS_PARAMS, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(PS_PARAMS) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(PS_PARAMS) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -664,8 +1223,8 @@ static void server_loop() {
       PATRIM_DATA *command = g_new(PATRIM_DATA, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(PATRIM_DATA) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(PATRIM_DATA) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -685,8 +1244,8 @@ static void server_loop() {
       DOUBLE_COMMAND *command = g_new(DOUBLE_COMMAND, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(DOUBLE_COMMAND) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(DOUBLE_COMMAND) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -704,8 +1263,8 @@ static void server_loop() {
       U64_COMMAND *command = g_new(U64_COMMAND, 1);
       command->header = header;
 
-      if (recv_bytes(remoteclient.socket, (char *)command + sizeof(HEADER), sizeof(U64_COMMAND) - sizeof(HEADER)) > 0) {
-        g_idle_add(server_command, command);
+      if (recv_bytes(client->socket, (char *)command + sizeof(HEADER), sizeof(U64_COMMAND) - sizeof(HEADER)) > 0) {
+        server_submit(client, command);
       }
     }
     break;
@@ -776,13 +1335,13 @@ static void server_loop() {
     case CMD_ZOOM: {
       HEADER *command = g_new(HEADER, 1);
       *command = header;
-      g_idle_add(server_command, command);
+      server_submit(client, command);
     }
     break;
 
     default:
       t_print("%s: UNKNOWN command: %d\n", __FUNCTION__, from_short(header.data_type));
-      remoteclient.running = FALSE;
+      client->running = FALSE;
       break;
     }
   }
@@ -790,179 +1349,311 @@ static void server_loop() {
   t_print("%s: Terminating\n", __FUNCTION__);
 }
 
+void remote_client_gone(int sock) {
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    if (remoteclient[c].socket == sock) {
+      remoteclient[c].running = FALSE;
+    }
+  }
+}
+
+const REMOTE_CLIENT *remote_control_client() {
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    if (remoteclient[c].running && remoteclient[c].control) {
+      return &remoteclient[c];
+    }
+  }
+
+  return NULL;
+}
+
 //
-// listen_thread runs on the server side, waits for connections,
-// and starts the server loop
+// The controlling client determines the size of the panadapters.
+// In order to be prepeared for varying screen dimensions,
+// we switch the display to "custom" geometry.
 //
-static void *listen_thread(void *arg) {
-  struct sockaddr_in address;
-  struct timeval timeout;
-  int on = 1;
-  t_print("%s: listening on port %d\n", __FUNCTION__, listen_port);
+static void server_take_control(const REMOTE_CLIENT *client, int wait) {
+  mic_ring_outpt = 0;
+  mic_ring_inpt = 0;
 
-  if (server_stops_protocol) {
-    g_idle_add(radio_remote_protocol_stop, NULL);
+  if (wait) {
+    display_width[1] = display_width[display_size];
+    display_height[1] = display_height[display_size];
+    display_size = 1;
+    rx_stack_horizontal = 0;
+  } else if (client->width > 0) {
+    display_size = 1;
+    display_width[1] = client->width;
+    rx_stack_horizontal = client->stack_horizontal;
   }
 
-  while (server_running) {
-    if (listen_socket >= 0) { close(listen_socket); }
-
-    // create TCP socket to listen on
-    listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+  radio_reconfigure_screen_done = 0;
+  g_idle_add(ext_radio_reconfigure_screen, NULL);
 
-    if (listen_socket < 0) {
-      t_print("%s: socket() failed\n", __FUNCTION__);
-      break;
-    }
+  while (wait && !radio_reconfigure_screen_done) { usleep(100000); }
+}
 
-    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
-    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
-    // bind to listening port
-    memset(&address, 0, sizeof(address));
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = to_short(listen_port);
+//
+// client_thread runs on the server side, one for each connection.
+// It does the authentication and then runs the server loop.
+//
+static gpointer client_thread(gpointer arg) {
+  REMOTE_CLIENT *client = (REMOTE_CLIENT *)arg;
+  struct timeval timeout;
+  static int old_cwi;
+  //
+  // Set a time-out of 30 seconds. The client is supposed to send a heart-beat packet at least
+  // every 15 sec
+  //
+  timeout.tv_sec = 30;
+  timeout.tv_usec = 0;
+  setsockopt(client->socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  timeout.tv_sec =  1;
+  setsockopt(client->socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  unsigned char s[2 * SHA512_DIGEST_LENGTH];
+  unsigned char sha[SHA512_DIGEST_LENGTH];
+  inet_ntop(AF_INET, &(((struct sockaddr_in *)&client->address)->sin_addr), (char *)s, 2 * SHA512_DIGEST_LENGTH);
+  t_print("%s: client connected from %s\n", __FUNCTION__, s);
+  //
+  // send version number to the client
+  //
+  s[0] = (CLIENT_SERVER_VERSION >> 24) & 0xFF;
+  s[1] = (CLIENT_SERVER_VERSION >> 16) & 0xFF;
+  s[2] = (CLIENT_SERVER_VERSION >>  8) & 0xFF;
+  s[3] = (CLIENT_SERVER_VERSION      ) & 0xFF;
+  send_bytes(client->socket, (char *)s, 4);
+  int ok = (RAND_bytes(s, SHA512_DIGEST_LENGTH) == 1);
+  send_bytes(client->socket, (char *)s, SHA512_DIGEST_LENGTH);
+  generate_pwd_hash(s, sha, hpsdr_pwd);
 
-    if (bind(listen_socket, (struct sockaddr * )&address, sizeof(address)) < 0) {
-      t_print("%s: bind() failed\n", __FUNCTION__);
-      break;
-    }
+  if (recv_bytes(client->socket, (char *)s, SHA512_DIGEST_LENGTH) < 0) {
+    t_print("%s: could not receive Passwd Response\n", __FUNCTION__);
+    ok = 0;
+  }
 
-    // listen for connections
-    if (listen(listen_socket, 5) < 0) {
-      t_print("%s: listen() failed\n", __FUNCTION__);
-      break;
-    }
+  //
+  // Handle too-short server passwords as if the passwords did not match
+  //
+  if (!ok || memcmp(sha, s, SHA512_DIGEST_LENGTH)  != 0 || strlen(hpsdr_pwd) < 5) {
+    t_print("%s: ATTENTION: Wrong Password from Client.\n", __FUNCTION__);
+    sleep(1);
+    *s = 0xF7;
+  } else {
+    *s = 0x7F;
+  }
 
-    remoteclient.address_length = sizeof(remoteclient.address);
-    t_print("%s: accepting connections...\n", __FUNCTION__);
+  send_bytes(client->socket, (char *)s, 1);
 
-    if ((remoteclient.socket = accept(listen_socket, (struct sockaddr * )&remoteclient.address,
-                                      &remoteclient.address_length)) < 0) {
-      //
-      // We arrive here if either the internet connection failed, or destroy_hpsdr_server()
-      // has been invoked which closes the listen socket
-      //
-      t_print("%s: accept() failed\n", __FUNCTION__);
-      break;
-    }
+  ok = (*s == 0x7F && server_running);
 
+  if (ok) {
     //
-    // Set a time-out of 30 seconds. The client is supposed to send a heart-beat packet at least
-    // every 15 sec
-    //
-    timeout.tv_sec = 30;
-    timeout.tv_usec = 0;
-    setsockopt(remoteclient.socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    timeout.tv_sec =  1;
-    setsockopt(remoteclient.socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
-    unsigned char s[2 * SHA512_DIGEST_LENGTH];
-    unsigned char sha[SHA512_DIGEST_LENGTH];
-    inet_ntop(AF_INET, &(((struct sockaddr_in *)&remoteclient.address)->sin_addr), (char *)s, 2 * SHA512_DIGEST_LENGTH);
-    t_print("%s: client connected from %s\n", __FUNCTION__, s);
+    // From now on, packets to the client are queued and sent
+    // by a separate thread
     //
-    // send version number to the client
-    //
-    s[0] = (CLIENT_SERVER_VERSION >> 24) & 0xFF;
-    s[1] = (CLIENT_SERVER_VERSION >> 16) & 0xFF;
-    s[2] = (CLIENT_SERVER_VERSION >>  8) & 0xFF;
-    s[3] = (CLIENT_SERVER_VERSION      ) & 0xFF;
-    send_bytes(remoteclient.socket, (char *)s, 4);
-
-    if (RAND_bytes(s, SHA512_DIGEST_LENGTH) != 1) {
-      remoteclient.running = FALSE;
-    }
-
-    send_bytes(remoteclient.socket, (char *)s, SHA512_DIGEST_LENGTH);
-    generate_pwd_hash(s, sha, hpsdr_pwd);
+    send_queue_start(client->socket);
+    ok = (server_read_digest(client) == 0);
+  }
 
-    if (recv_bytes(remoteclient.socket, (char *)s, SHA512_DIGEST_LENGTH) < 0) {
-      t_print("%s: could not receive Passwd Response\n", __FUNCTION__);
-      remoteclient.running = FALSE;
+  if (ok) {
+    for (int id = 0; id < 8; id++) {
+      client->send_rx_spectrum[id] = FALSE;
+      client->send_rx_audio[id] = TRUE;
+      client->rx_fps[id] = 0;
+      client->rx_credit[id] = 0.0;
     }
 
+    client->send_tx_spectrum = FALSE;
+    client->width = 0;
+    client->stack_horizontal = 0;
+    client->media = FALSE;
+    client->media_token = 0;
     //
-    // Handle too-short server passwords as if the passwords did not match
+    // The first client controls the radio, all others are listen-only.
     //
-    if (memcmp(sha, s, SHA512_DIGEST_LENGTH)  != 0 || strlen(hpsdr_pwd) < 5) {
-      t_print("%s: ATTENTION: Wrong Password from Client.\n", __FUNCTION__);
-      sleep(1);
-      *s = 0xF7;
-    } else {
-      *s = 0x7F;
-    }
-
-    send_bytes(remoteclient.socket, (char *)s, 1);
-
-    if (*s == 0x7F) {
+    g_mutex_lock(&clients_mutex);
+    int first = (remoteclients == 0);
+    client->seqno = client_seqno++;
+    client->control = first;
+    remoteclients++;
+    g_mutex_unlock(&clients_mutex);
+
+    if (first) {
       //
       // If the protocol is not running, start it!
       // A non-running protocol results when a client disconnects.
       //
       g_idle_add(radio_remote_protocol_run, NULL);
-      // Setting this has to be post-poned until HERE, since now
-      // the RX thread starts to send audio data. If we were TXing
-      // when the client successfully connects, go RX.
-      //
-      g_idle_add(ext_radio_set_mox, GINT_TO_POINTER(0));
-      remoteclient.running = TRUE;
       //
-      // In order to be prepeared for varying screen dimensions,
-      // we switch the display to "custom" geometry.
+      // If we were TXing when the client successfully connects, go RX.
       //
-      display_width[1] = display_width[display_size];
-      display_height[1] = display_height[display_size];
-      display_size = 1;
-      rx_stack_horizontal = 0;
-      radio_reconfigure_screen_done = 0;
-      g_idle_add(ext_radio_reconfigure_screen, NULL);
-
-      while (!radio_reconfigure_screen_done) { usleep(100000); }
-
-      for (int id = 0; id < RECEIVERS; id++) {
-        remoteclient.send_rx_spectrum[id] = FALSE;
-      }
-
-      remoteclient.send_tx_spectrum = FALSE;
+      g_idle_add(ext_radio_set_mox, GINT_TO_POINTER(0));
+      server_take_control(client, 1);
       //
       // Send PS and on-display data periodically
       //
-      remoteclient.timer_id = gdk_threads_add_timeout_full(G_PRIORITY_HIGH_IDLE, 150, send_periodic_data, NULL, NULL);
+      periodic_timer_id = gdk_threads_add_timeout_full(G_PRIORITY_HIGH_IDLE, 150, send_periodic_data, NULL, NULL);
       //
       // We disable "CW handled in Radio" since this makes no sense
       // for remote operation.
       //
-      int old_cwi = cw_keyer_internal;
+      old_cwi = cw_keyer_internal;
       cw_keyer_internal = 1;
       keyer_update();  // shut down iambic keyer
       cw_keyer_internal = 0;
       schedule_transmit_specific();
-      server_loop();
-      cw_keyer_internal = old_cwi;
-      keyer_update();  // possibly restart iambic keyer
-      schedule_transmit_specific();
+    }
+
+    t_print("%s: client #%d is %s\n", __FUNCTION__, client->seqno, client->control ? "in control" : "listen-only");
+    //
+    // Setting this has to be post-poned until HERE, since now
+    // the RX thread starts to send audio data.
+    //
+    client->running = TRUE;
+    server_loop(client);
+    //
+    // The client has gone. If it was in control, pass control
+    // on to the client that has been connected for the longest time.
+    //
+    REMOTE_CLIENT *next = NULL;
+    int was_control = client->control;
+    g_mutex_lock(&clients_mutex);
+    client->running = FALSE;
+    client->control = FALSE;
+    remoteclients--;
+    int last = (remoteclients == 0);
+
+    if (was_control) {
+      for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+        REMOTE_CLIENT *other = &remoteclient[c];
+
+        if (other->running && (next == NULL || other->seqno < next->seqno)) {
+          next = other;
+        }
+      }
+
+      if (next) { next->control = TRUE; }
+    }
+
+    g_mutex_unlock(&clients_mutex);
+
+    if (was_control) {
       //
       // If the connection breaks while transmitting, go RX
       //
       g_idle_add(ext_radio_set_mox, GINT_TO_POINTER(0));
+    }
 
+    if (next) {
+      t_print("%s: client #%d now in control\n", __FUNCTION__, next->seqno);
+      server_take_control(next, 0);
+    }
+
+    server_spectrum_demand();
+
+    if (last) {
       //
       // Stop sending periodic data
       //
-      if (remoteclient.timer_id != 0) {
-        g_source_remove(remoteclient.timer_id);
-        remoteclient.timer_id = 0;
+      if (periodic_timer_id != 0) {
+        g_source_remove(periodic_timer_id);
+        periodic_timer_id = 0;
       }
 
+      cw_keyer_internal = old_cwi;
+      keyer_update();  // possibly restart iambic keyer
+      schedule_transmit_specific();
+
       if (server_stops_protocol) {
         g_idle_add(radio_remote_protocol_stop, NULL);
       }
     }
+  }
+
+  send_queue_stop(client->socket);
+
+  g_mutex_lock(&clients_mutex);
+  close(client->socket);
+  client->socket = -1;
+  g_mutex_unlock(&clients_mutex);
+  return NULL;
+}
+
+//
+// listen_thread runs on the server side, waits for connections,
+// and starts a client thread for each of them
+//
+static void *listen_thread(void *arg) {
+  struct sockaddr_in address;
+  int on = 1;
+  t_print("%s: listening on port %d\n", __FUNCTION__, listen_port);
+
+  if (server_stops_protocol) {
+    g_idle_add(radio_remote_protocol_stop, NULL);
+  }
+
+  // create TCP socket to listen on
+  listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (listen_socket < 0) {
+    t_print("%s: socket() failed\n", __FUNCTION__);
+    server_running = FALSE;
+  } else {
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    // bind to listening port
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = to_short(listen_port);
+
+    if (bind(listen_socket, (struct sockaddr * )&address, sizeof(address)) < 0) {
+      t_print("%s: bind() failed\n", __FUNCTION__);
+      server_running = FALSE;
+    } else if (listen(listen_socket, 5) < 0) {
+      // listen for connections
+      t_print("%s: listen() failed\n", __FUNCTION__);
+      server_running = FALSE;
+    }
+  }
+
+  while (server_running) {
+    struct sockaddr_in client_address;
+    socklen_t client_address_length = sizeof(client_address);
+    t_print("%s: accepting connections...\n", __FUNCTION__);
+    int sock = accept(listen_socket, (struct sockaddr * )&client_address, &client_address_length);
+
+    if (sock < 0) {
+      //
+      // We arrive here if either the internet connection failed, or destroy_hpsdr_server()
+      // has been invoked which closes the listen socket
+      //
+      t_print("%s: accept() failed\n", __FUNCTION__);
+      break;
+    }
+
+    REMOTE_CLIENT *client = NULL;
+    g_mutex_lock(&clients_mutex);
+
+    for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+      if (remoteclient[c].socket < 0) {
+        client = &remoteclient[c];
+        client->socket = sock;
+        client->address = client_address;
+        client->address_length = client_address_length;
+        break;
+      }
+    }
+
+    g_mutex_unlock(&clients_mutex);
 
-    if (remoteclient.socket != -1) {
-      close(remoteclient.socket);
-      remoteclient.socket = -1;
+    if (client == NULL) {
+      t_print("%s: too many clients, connection refused\n", __FUNCTION__);
+      close(sock);
+      continue;
     }
+
+    g_thread_unref(g_thread_new("HPSDR_client", client_thread, client));
   }
 
   //
@@ -975,20 +1666,47 @@ static void *listen_thread(void *arg) {
 }
 
 int create_hpsdr_server() {
+  if (mic_ring_buffer == NULL) {
+    //
+    // First call: allocate ring buffer for TX mic data,
+    // and mark all client slots as free
+    //
+    mic_ring_buffer = g_new0(short, MIC_RING_BUFFER_SIZE);
+
+    for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+      remoteclient[c].socket = -1;
+    }
+  }
+
   server_running = TRUE;
   listen_thread_id = g_thread_new( "HPSDR_listen", listen_thread, NULL);
+  media_server_start(listen_port);
   return 0;
 }
 
 int destroy_hpsdr_server() {
   server_running = FALSE;
-  remoteclient.running = FALSE;
+  g_mutex_lock(&clients_mutex);
+
+  for (int c = 0; c < MAX_REMOTE_CLIENTS; c++) {
+    remoteclient[c].running = FALSE;
+
+    if (remoteclient[c].socket >= 0) {
+      //
+      // This makes the client thread leave the server loop
+      //
+      shutdown(remoteclient[c].socket, SHUT_RDWR);
+    }
+  }
+
+  g_mutex_unlock(&clients_mutex);
 
   if (listen_socket >= 0) {
     close(listen_socket);
     listen_socket = -1;
   }
 
+  media_server_stop();
   return 0;
 }
 
@@ -1105,11 +1823,11 @@ static int server_command(void *data) {
     long long f = from_ll(command->u64);
     vfo_id_set_frequency(v, f);
     vfo_update();
-    send_vfo_data(remoteclient.socket, VFO_A);  // need both in case of SAT/RSAT
-    send_vfo_data(remoteclient.socket, VFO_B);  // need both in case of SAT/RSAT
+    send_vfo_data(SEND_ALL, VFO_A);  // need both in case of SAT/RSAT
+    send_vfo_data(SEND_ALL, VFO_B);  // need both in case of SAT/RSAT
 
     if (pan != active_receiver->pan) {
-      send_pan(remoteclient.socket, active_receiver);
+      send_pan(SEND_ALL, active_receiver);
     }
   }
   break;
@@ -1118,9 +1836,9 @@ static int server_command(void *data) {
     int id = header->b1;
     int steps = from_short(header->s1);
     vfo_id_step(id, steps);
-    send_rx_data(remoteclient.socket, id);
-    send_vfo_data(remoteclient.socket, VFO_A);  // need both in case of SAT/RSAT
-    send_vfo_data(remoteclient.socket, VFO_B);  // need both in case of SAT/RSAT
+    send_rx_data(SEND_ALL, id);
+    send_vfo_data(SEND_ALL, VFO_A);  // need both in case of SAT/RSAT
+    send_vfo_data(SEND_ALL, VFO_B);  // need both in case of SAT/RSAT
   }
   break;
 
@@ -1129,11 +1847,11 @@ static int server_command(void *data) {
     int pan = active_receiver->pan;
     long long hz = from_ll(command->u64);
     vfo_id_move(command->header.b1, hz, command->header.b2);
-    send_vfo_data(remoteclient.socket, VFO_A);  // need both in case of SAT/RSAT
-    send_vfo_data(remoteclient.socket, VFO_B);  // need both in case of SAT/RSAT
+    send_vfo_data(SEND_ALL, VFO_A);  // need both in case of SAT/RSAT
+    send_vfo_data(SEND_ALL, VFO_B);  // need both in case of SAT/RSAT
 
     if (pan != active_receiver->pan) {
-      send_pan(remoteclient.socket, active_receiver);
+      send_pan(SEND_ALL, active_receiver);
     }
   }
   break;
@@ -1143,11 +1861,11 @@ static int server_command(void *data) {
     int pan = active_receiver->pan;
     long long hz = from_ll(command->u64);
     vfo_id_move_to(command->header.b1, hz, command->header.b2);
-    send_vfo_data(remoteclient.socket, VFO_A);  // need both in case of SAT/RSAT
-    send_vfo_data(remoteclient.socket, VFO_B);  // need both in case of SAT/RSAT
+    send_vfo_data(SEND_ALL, VFO_A);  // need both in case of SAT/RSAT
+    send_vfo_data(SEND_ALL, VFO_B);  // need both in case of SAT/RSAT
 
     if (pan != active_receiver->pan) {
-      send_pan(remoteclient.socket, active_receiver);
+      send_pan(SEND_ALL, active_receiver);
     }
   }
   break;
@@ -1156,7 +1874,7 @@ static int server_command(void *data) {
     int id = header->b1;
     int zoom = header->b2;
     radio_set_zoom(id, zoom);
-    send_pan (remoteclient.socket, receiver[id]);
+    send_pan (SEND_ALL, receiver[id]);
   }
   break;
 
@@ -1186,7 +1904,7 @@ static int server_command(void *data) {
   case CMD_STORE: {
     int index = header->b1;
     store_memory_slot(index);
-    send_memory_data(remoteclient.socket, index);
+    send_memory_data(SEND_ALL, index);
   }
   break;
 
@@ -1199,9 +1917,9 @@ static int server_command(void *data) {
     int index = header->b1;
     int id = active_receiver->id;
     recall_memory_slot(index);
-    send_vfo_data(remoteclient.socket, id);
-    send_rx_data(remoteclient.socket, id);
-    send_tx_data(remoteclient.socket);
+    send_vfo_data(SEND_ALL, id);
+    send_rx_data(SEND_ALL, id);
+    send_tx_data(SEND_ALL);
   }
   break;
 
@@ -1263,7 +1981,7 @@ static int server_command(void *data) {
       memory_tune = from_short(header->s2);
       radio_toggle_tune();
       g_idle_add(ext_vfo_update, NULL);
-      send_tune(remoteclient.socket, transmitter->tune);
+      send_tune(SEND_ALL, transmitter->tune);
     }
   }
   break;
@@ -1271,14 +1989,14 @@ static int server_command(void *data) {
   case CMD_TOGGLE_MOX: {
     radio_toggle_mox();
     g_idle_add(ext_vfo_update, NULL);
-    send_mox(remoteclient.socket, mox);
+    send_mox(SEND_ALL, mox);
   }
   break;
 
   case CMD_MOX: {
     radio_set_mox(header->b1);
     g_idle_add(ext_vfo_update, NULL);
-    send_mox(remoteclient.socket, mox);
+    send_mox(SEND_ALL, mox);
   }
   break;
 
@@ -1291,7 +2009,7 @@ static int server_command(void *data) {
     g_idle_add(ext_vfo_update, NULL);
 
     if (mox != header->b1) {
-      send_vox(remoteclient.socket, mox);
+      send_vox(SEND_ALL, mox);
     }
   }
   break;
@@ -1304,7 +2022,7 @@ static int server_command(void *data) {
       g_idle_add(ext_vfo_update, NULL);
 
       if (transmitter->tune != header->b1) {
-        send_tune(remoteclient.socket, transmitter->tune);
+        send_tune(SEND_ALL, transmitter->tune);
       }
     }
   }
@@ -1314,7 +2032,7 @@ static int server_command(void *data) {
     if (can_transmit) {
       radio_set_twotone(transmitter, header->b1);
       g_idle_add(ext_vfo_update, NULL);
-      send_twotone(remoteclient.socket, transmitter->twotone);
+      send_twotone(SEND_ALL, transmitter->twotone);
     }
   }
   break;
@@ -1336,7 +2054,7 @@ static int server_command(void *data) {
       //
       // Now hang and thresh have been calculated and need be sent back
       //
-      send_agc_gain(remoteclient.socket, rx);
+      send_agc_gain(SEND_ALL, rx);
     }
   }
   break;
@@ -1399,7 +2117,7 @@ static int server_command(void *data) {
       rx->nr4_post_threshold     = from_double(command->nr4_post_threshold);
 #endif
       rx_set_noise(rx);
-      send_rx_data(remoteclient.socket, id);
+      send_rx_data(SEND_ALL, id);
     }
   }
   break;
@@ -1425,10 +2143,10 @@ static int server_command(void *data) {
     // The "old" bandstack may have changed.
     // The mode, and thus all mode settings, may have changed
     //
-    send_bandstack_data(remoteclient.socket, b, old);
-    send_vfo_data(remoteclient.socket, id);
-    send_rx_data(remoteclient.socket, id);
-    send_tx_data(client_socket);
+    send_bandstack_data(SEND_ALL, b, old);
+    send_vfo_data(SEND_ALL, id);
+    send_rx_data(SEND_ALL, id);
+    send_tx_data(SEND_ALL);
   }
   break;
 
@@ -1443,7 +2161,7 @@ static int server_command(void *data) {
     const BAND *band = band_get_band(oldband);
 
     for (int s = 0; s < band->bandstack->entries; s++) {
-      send_bandstack_data(remoteclient.socket, oldband, s);
+      send_bandstack_data(SEND_ALL, oldband, s);
     }
 
     //
@@ -1452,12 +2170,12 @@ static int server_command(void *data) {
     // transmitter, and VFO data
     //
     for (int id = 0; id < RECEIVERS; id++) {
-      send_rx_data(remoteclient.socket, id);
+      send_rx_data(SEND_ALL, id);
     }
 
-    send_tx_data(remoteclient.socket);
-    send_vfo_data(remoteclient.socket, VFO_A);
-    send_vfo_data(remoteclient.socket, VFO_B);
+    send_tx_data(SEND_ALL);
+    send_vfo_data(SEND_ALL, VFO_A);
+    send_vfo_data(SEND_ALL, VFO_B);
   }
   break;
 
@@ -1470,9 +2188,9 @@ static int server_command(void *data) {
     // those "stored with the mode" are changed as well. So we need
     // to send back VFO, receiver, and transmitter data
     //
-    send_vfo_data(remoteclient.socket, v);
-    send_rx_data(remoteclient.socket, v);
-    send_tx_data(remoteclient.socket);
+    send_vfo_data(SEND_ALL, v);
+    send_rx_data(SEND_ALL, v);
+    send_tx_data(SEND_ALL);
   }
   break;
 
@@ -1495,12 +2213,12 @@ static int server_command(void *data) {
     for (int v = 0; v < receivers; v++) {
       if ((vfo[v].mode == m) && (vfo[v].filter == f)) {
         vfo_id_filter_changed(v, f);
-        send_rx_filter_cut(remoteclient.socket, v);
+        send_rx_filter_cut(SEND_ALL, v);
       }
     }
 
     if (can_transmit) {
-      send_tx_filter_cut(remoteclient.socket);
+      send_tx_filter_cut(SEND_ALL);
     }
   }
   break;
@@ -1518,12 +2236,12 @@ static int server_command(void *data) {
     // filter edges in receiver(s) may have changed
     //
     for (int id = 0; id < receivers; id++) {
-      send_rx_filter_cut(remoteclient.socket, id);
-      send_agc_gain(remoteclient.socket, receiver[id]);
+      send_rx_filter_cut(SEND_ALL, id);
+      send_agc_gain(SEND_ALL, receiver[id]);
     }
 
     if (can_transmit) {
-      send_tx_filter_cut(remoteclient.socket);
+      send_tx_filter_cut(SEND_ALL);
     }
 
     g_idle_add(ext_vfo_update, NULL);
@@ -1536,12 +2254,12 @@ static int server_command(void *data) {
 
     if (id < receivers) {
       rx_set_filter(receiver[id]);
-      send_rx_filter_cut(remoteclient.socket, id);
+      send_rx_filter_cut(SEND_ALL, id);
     }
 
     if (can_transmit) {
       tx_set_filter(transmitter);
-      send_tx_filter_cut(remoteclient.socket);
+      send_tx_filter_cut(SEND_ALL);
     }
 
     g_idle_add(ext_vfo_update, NULL);
@@ -1590,8 +2308,8 @@ static int server_command(void *data) {
       split = header->b1;
       tx_set_mode(transmitter, vfo_get_tx_mode());
       g_idle_add(ext_vfo_update, NULL);
-      send_tx_data(remoteclient.socket);
-      send_rx_data(remoteclient.socket, 0);
+      send_tx_data(SEND_ALL);
+      send_rx_data(SEND_ALL, 0);
     }
   }
   break;
@@ -1612,7 +2330,7 @@ static int server_command(void *data) {
   case CMD_SAT: {
     sat_mode = header->b1;
     g_idle_add(ext_vfo_update, NULL);
-    send_sat(remoteclient.socket, sat_mode);
+    send_sat(SEND_ALL, sat_mode);
   }
   break;
 
@@ -1625,7 +2343,7 @@ static int server_command(void *data) {
   case CMD_LOCK: {
     locked = header->b1;
     g_idle_add(ext_vfo_update, NULL);
-    send_lock(remoteclient.socket, locked);
+    send_lock(SEND_ALL, locked);
   }
   break;
 
@@ -1640,7 +2358,7 @@ static int server_command(void *data) {
     vfo[v].ctun_frequency = vfo[v].frequency;
     rx_set_offset(active_receiver);
     g_idle_add(ext_vfo_update, NULL);
-    send_vfo_data(remoteclient.socket, v);
+    send_vfo_data(SEND_ALL, v);
   }
   break;
 
@@ -1673,41 +2391,41 @@ static int server_command(void *data) {
 
   case CMD_VFO_A_TO_B: {
     vfo_a_to_b();
-    send_vfo_data(remoteclient.socket, VFO_B);
+    send_vfo_data(SEND_ALL, VFO_B);
 
     if (receivers > 1) {
-      send_rx_data(remoteclient.socket, 1);
+      send_rx_data(SEND_ALL, 1);
     }
 
     if (can_transmit) {
-      send_tx_data(remoteclient.socket);
+      send_tx_data(SEND_ALL);
     }
   }
   break;
 
   case CMD_VFO_B_TO_A: {
     vfo_b_to_a();
-    send_vfo_data(remoteclient.socket, VFO_A);
-    send_rx_data(remoteclient.socket, 0);
+    send_vfo_data(SEND_ALL, VFO_A);
+    send_rx_data(SEND_ALL, 0);
 
     if (can_transmit) {
-      send_tx_data(remoteclient.socket);
+      send_tx_data(SEND_ALL);
     }
   }
   break;
 
   case CMD_VFO_SWAP: {
     vfo_a_swap_b();
-    send_vfo_data(remoteclient.socket, VFO_A);
-    send_vfo_data(remoteclient.socket, VFO_B);
-    send_rx_data(remoteclient.socket, 0);
+    send_vfo_data(SEND_ALL, VFO_A);
+    send_vfo_data(SEND_ALL, VFO_B);
+    send_rx_data(SEND_ALL, 0);
 
     if (receivers > 1) {
-      send_rx_data(remoteclient.socket, 1);
+      send_rx_data(SEND_ALL, 1);
     }
 
     if (can_transmit) {
-      send_tx_data(remoteclient.socket);
+      send_tx_data(SEND_ALL);
     }
   }
   break;
@@ -1716,7 +2434,7 @@ static int server_command(void *data) {
     int id = header->b1;
     vfo_id_rit_value(id, from_short(header->s1));
     vfo_id_rit_onoff(id, header->b2);
-    send_vfo_data(remoteclient.socket, id);
+    send_vfo_data(SEND_ALL, id);
   }
   break;
 
@@ -1724,7 +2442,7 @@ static int server_command(void *data) {
     int id = header->b1;
     vfo_id_xit_value(id, from_short(header->s1));
     vfo_id_xit_onoff(id, header->b2);
-    send_vfo_data(remoteclient.socket, id);
+    send_vfo_data(SEND_ALL, id);
   }
   break;
 
@@ -1743,7 +2461,7 @@ static int server_command(void *data) {
 
       // If the sample rate was illegal, the actual sample rate is
       // not what has been sent. So return the actual value.
-      send_sample_rate(remoteclient.socket, id, receiver[id]->sample_rate);
+      send_sample_rate(SEND_ALL, id, receiver[id]->sample_rate);
     }
   }
   break;
@@ -1751,11 +2469,11 @@ static int server_command(void *data) {
   case CMD_RECEIVERS: {
     int r = header->b1;
     radio_change_receivers(r);
-    send_receivers(remoteclient.socket, receivers);
+    send_receivers(SEND_ALL, receivers);
 
     // In P1, activating RX2 aligns its sample rate with RX1
     if (receivers == 2) {
-      send_rx_data(remoteclient.socket, 1);
+      send_rx_data(SEND_ALL, 1);
     }
   }
   break;
@@ -1764,18 +2482,18 @@ static int server_command(void *data) {
     int v = header->b1;
     int step = from_short(header->s1);
     vfo_id_set_rit_step(v, step);
-    send_vfo_data(remoteclient.socket, v);
+    send_vfo_data(SEND_ALL, v);
   }
   break;
 
   case CMD_FILTER_BOARD: {
     radio_load_filters(header->b1);
-    send_radio_data(remoteclient.socket);
+    send_radio_data(SEND_ALL);
 
     if (filter_board == N2ADR) {
       // OC settings for 160m ... 10m have been set
       for (int b = band160; b <= band10; b++) {
-        send_band_data(remoteclient.socket, b);
+        send_band_data(SEND_ALL, b);
       }
     }
   }
@@ -1787,7 +2505,7 @@ static int server_command(void *data) {
     const BAND *band = band_get_band(band60);
 
     for (int s = 0; s < band->bandstack->entries; s++) {
-      send_bandstack_data(remoteclient.socket, band60, s);
+      send_bandstack_data(SEND_ALL, band60, s);
     }
   }
   break;
@@ -1799,7 +2517,7 @@ static int server_command(void *data) {
 
   case CMD_ANAN10E: {
     radio_set_anan10E(header->b1);
-    send_radio_data(remoteclient.socket);
+    send_radio_data(SEND_ALL);
   }
   break;
 
@@ -1955,7 +2673,7 @@ static int server_command(void *data) {
       transmitter->ctcss_enabled = header->b1;
       transmitter->ctcss = header->b2;
       tx_set_ctcss(transmitter);
-      send_tx_data(remoteclient.socket);
+      send_tx_data(SEND_ALL);
       g_idle_add(ext_vfo_update, NULL);
     }
   }
@@ -1966,7 +2684,7 @@ static int server_command(void *data) {
       const DOUBLE_COMMAND *command = (DOUBLE_COMMAND *)data;
       transmitter->am_carrier_level = from_double(command->dbl);
       tx_set_am_carrier_level(transmitter);
-      send_tx_data(remoteclient.socket);
+      send_tx_data(SEND_ALL);
     }
   }
   break;
@@ -1995,7 +2713,7 @@ static int server_command(void *data) {
       mic_linein = command->mic_linein;
       linein_gain = from_double(command->linein_gain);
       schedule_transmit_specific();
-      send_tx_data(remoteclient.socket);
+      send_tx_data(SEND_ALL);
     }
   }
   break;
@@ -2134,7 +2852,7 @@ static int server_command(void *data) {
       rx->filter_high = from_short(header->s2);
       rx_set_bandpass(rx);
       rx_set_agc(rx);
-      send_agc_gain(remoteclient.socket, rx);
+      send_agc_gain(SEND_ALL, rx);
       g_idle_add(ext_vfo_update, NULL);
     }
   }
@@ -2160,6 +2878,7 @@ static int server_command(void *data) {
   break;
   }
 
+  server_update_listeners(header);
   g_free(data);
   return G_SOURCE_REMOVE;
 }
@@ -254,6 +254,10 @@ static void show_popup_slider(enum ACTION action, int rx, double min, double max
   static double scale_wid;
   char title[128];
 
+  if (headless) {
+    return;
+  }
+
   if (rx >= 0) {
     snprintf(title, sizeof(title), "%s%d", what, rx);
   } else {
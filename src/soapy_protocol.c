@@ -43,6 +43,7 @@
 #include "radio.h"
 #include "receiver.h"
 #include "soapy_protocol.h"
+#include "threads.h"
 #include "transmitter.h"
 #include "vfo.h"
 
@@ -651,6 +652,7 @@ static void *soapy_receive_single_thread(void *arg) {
   void *buffs[1] = {rxbuff};
   int id = rx->id;
   running = TRUE;
+  thread_setup(thread_rx_slot(id), "Soapy receive");
   t_print("%s started, id=%d\n", __FUNCTION__, id);
 
   while (running) {
@@ -686,6 +688,7 @@ static gpointer soapy_receive_dual_thread(gpointer data) {
   float *rx2buff = g_new(float, max_rx_samples * 2);
   void *buffs[2] = {rx1buff, rx2buff};
   running = TRUE;
+  thread_setup(THREAD_RX1, "Soapy receive");
   t_print("%s started\n", __FUNCTION__);
 
   while (running) {
@@ -0,0 +1,182 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <string.h>
+
+#include "spectrum_stats.h"
+
+#define SPECTRUM_BINS ((int)((SPECTRUM_MAX_DB - SPECTRUM_MIN_DB) / SPECTRUM_BIN_DB))
+
+//
+// Percentile from a histogram: one pass over the samples, one pass over
+// the bins. Within the bin that contains the requested rank, the value
+// is interpolated linearly.
+//
+double spectrum_percentile(const float *samples, int n, double offset, double percentile) {
+  int hist[SPECTRUM_BINS];
+  const double scale = 1.0 / SPECTRUM_BIN_DB;
+  const double base = offset - SPECTRUM_MIN_DB;
+  int target, cum;
+
+  if (n <= 0) { return SPECTRUM_MIN_DB; }
+
+  memset(hist, 0, sizeof(hist));
+
+  for (int i = 0; i < n; i++) {
+    int b = (int)((samples[i] + base) * scale);
+
+    if (b < 0) { b = 0; }
+
+    if (b >= SPECTRUM_BINS) { b = SPECTRUM_BINS - 1; }
+
+    hist[b]++;
+  }
+
+  target = (int)(percentile * 0.01 * n);
+
+  if (target < 0) { target = 0; }
+
+  if (target >= n) { target = n - 1; }
+
+  cum = 0;
+
+  for (int b = 0; b < SPECTRUM_BINS; b++) {
+    if (cum + hist[b] > target) {
+      return SPECTRUM_MIN_DB + (b + (target - cum + 0.5) / hist[b]) * SPECTRUM_BIN_DB;
+    }
+
+    cum += hist[b];
+  }
+
+  return SPECTRUM_MAX_DB;
+}
+
+//
+// Peak search: the peaks found so far are kept in a min-heap, such that
+// the lowest one can be replaced in O(log max_peaks).
+//
+// Since the spectrum is scanned from left to right, and two peaks kept
+// are always more than ignore_range apart, only the rightmost peak kept
+// can be within ignore_range of the current position. This is always the
+// peak added or replaced last, its heap slot is tracked in "last".
+//
+typedef struct _peak {
+  double val;
+  int pos;
+} PEAK;
+
+static void peak_swap(PEAK *heap, int i, int j, int *last) {
+  PEAK tmp = heap[i];
+  heap[i] = heap[j];
+  heap[j] = tmp;
+
+  if (*last == i) {
+    *last = j;
+  } else if (*last == j) {
+    *last = i;
+  }
+}
+
+static void peak_sift_down(PEAK *heap, int size, int i, int *last) {
+  for (;;) {
+    int l = 2 * i + 1;
+    int r = l + 1;
+    int m = i;
+
+    if (l < size && heap[l].val < heap[m].val) { m = l; }
+
+    if (r < size && heap[r].val < heap[m].val) { m = r; }
+
+    if (m == i) { break; }
+
+    peak_swap(heap, i, m, last);
+    i = m;
+  }
+}
+
+static void peak_sift_up(PEAK *heap, int i, int *last) {
+  while (i > 0) {
+    int p = (i - 1) / 2;
+
+    if (heap[p].val <= heap[i].val) { break; }
+
+    peak_swap(heap, i, p, last);
+    i = p;
+  }
+}
+
+int spectrum_peaks(const float *samples, int n, double offset, int left, int right,
+                   double threshold, int ignore_range, int max_peaks,
+                   double *peaks, int *positions) {
+  int size = 0;
+  int last = -1;
+
+  if (max_peaks <= 0 || n < 3) { return 0; }
+
+  PEAK heap[max_peaks];
+
+  if (left < 1) { left = 1; }
+
+  if (right > n - 2) { right = n - 2; }
+
+  for (int i = left; i <= right; i++) {
+    double s;
+
+    if (samples[i] <= samples[i - 1] || samples[i] <= samples[i + 1]) { continue; }
+
+    s = (double)samples[i] + offset;
+
+    if (s < threshold) { continue; }
+
+    if (last >= 0 && i - heap[last].pos <= ignore_range) {
+      //
+      // Too close to the previous peak: keep the higher one
+      //
+      if (s > heap[last].val) {
+        heap[last].val = s;
+        heap[last].pos = i;
+        peak_sift_down(heap, size, last, &last);
+      }
+    } else if (size < max_peaks) {
+      heap[size].val = s;
+      heap[size].pos = i;
+      last = size++;
+      peak_sift_up(heap, last, &last);
+    } else if (s > heap[0].val) {
+      heap[0].val = s;
+      heap[0].pos = i;
+      last = 0;
+      peak_sift_down(heap, size, 0, &last);
+    }
+  }
+
+  //
+  // Removing the minimum repeatedly yields the peaks in ascending order,
+  // so they are stored from the end.
+  //
+  int count = size;
+
+  for (int k = count - 1; k >= 0; k--) {
+    peaks[k] = heap[0].val;
+    positions[k] = heap[0].pos;
+    heap[0] = heap[--size];
+    peak_sift_down(heap, size, 0, &last);
+  }
+
+  return count;
+}
@@ -0,0 +1,47 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _SPECTRUM_STATS_H_
+#define _SPECTRUM_STATS_H_
+
+//
+// Statistics of a spectrum (pixel samples in dB), in linear time and
+// without memory allocation. "offset" is added to all samples.
+//
+
+//
+// Value below which "percentile" percent of the samples are, with a
+// resolution of SPECTRUM_BIN_DB.
+//
+#define SPECTRUM_MIN_DB  -250.0
+#define SPECTRUM_MAX_DB   100.0
+#define SPECTRUM_BIN_DB     0.25
+
+extern double spectrum_percentile(const float *samples, int n, double offset, double percentile);
+
+//
+// The max_peaks highest local maxima within [left, right] that are not below
+// threshold. Of two peaks closer than ignore_range, only the higher one
+// is reported. The peaks are returned in descending order, the function
+// value is the number of peaks found.
+//
+extern int spectrum_peaks(const float *samples, int n, double offset, int left, int right,
+                          double threshold, int ignore_range, int max_peaks,
+                          double *peaks, int *positions);
+
+#endif
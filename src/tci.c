@@ -33,6 +33,7 @@
 #include <openssl/evp.h>
 
 #include "message.h"
+#include "metrics.h"
 #include "radio.h"
 #include "rigctl.h"
 #include "vfo.h"
@@ -912,6 +913,7 @@ static gpointer tci_listener(gpointer data) {
         // accepted but not processed. Since we only report data but do not perform any
         // "actions", this need not be done in the GTK queue.
         //
+        metric_inc(METRIC_TCI_MESSAGES, 0);
         argc = 1;
         arg[0] = msg;
 
@@ -0,0 +1,247 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// CPU affinity and real-time scheduling of the time-critical threads.
+//
+// Each of these threads calls thread_setup() when it starts (or, in
+// case of the P2 iq_thread, when its DDC is assigned to a different
+// receiver). The thread is then registered with its Linux thread id,
+// such that it can be re-configured when the settings are changed
+// in the menu, and the thread/core map can be displayed.
+//
+// WDSP channel threads are set up through a call-back that WDSP invokes
+// when the channel thread starts (SetChannelThreadCallback).
+//
+// On systems other than Linux, this is a no-op.
+//
+
+#ifdef __linux__
+  #define _GNU_SOURCE           // for sched_setaffinity() and CPU_SET()
+#endif
+
+#include <gtk/gtk.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+  #include <sys/syscall.h>
+#endif
+
+#include "message.h"
+#include "property.h"
+#include "radio.h"
+#include "threads.h"
+
+int thread_core[THREAD_SLOTS] = { -1, -1, -1, -1, -1, -1 };
+int thread_rt = 0;
+
+const char *thread_slot_name[THREAD_SLOTS] = {
+  "Network", "RX1", "RX2", "TX", "Audio", "Display"
+};
+
+//
+// SCHED_FIFO priorities. Network threads must drain the socket buffers
+// and the audio threads must not underrun, so they get a higher priority
+// than the DSP threads. All values are well below those of the kernel
+// IRQ threads on a PREEMPT_RT kernel (50).
+//
+static const int thread_prio[THREAD_SLOTS] = { 40, 30, 30, 32, 35, 0 };
+
+#define MAX_THREADS 64
+
+static THREAD_INFO thread_table[MAX_THREADS];
+static int thread_count = 0;
+static GMutex thread_mutex;
+
+int thread_num_cores() {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (n < 1) { n = 1; }
+
+  return (int) n;
+}
+
+//
+// Slot for a WDSP channel or receiver id.
+// The PS feedback receivers belong to the TX slot.
+//
+int thread_rx_slot(int id) {
+  if (id == 0) { return THREAD_RX1; }
+
+  if (id == 1 && RECEIVERS > 1) { return THREAD_RX2; }
+
+  return THREAD_TX;
+}
+
+#ifdef __linux__
+static void thread_apply(int tid, int slot) {
+  static int affinity_warned = 0;
+  static int sched_warned = 0;
+  cpu_set_t set;
+  struct sched_param param;
+  int policy;
+  int ncores = thread_num_cores();
+  int core = thread_core[slot];
+  CPU_ZERO(&set);
+
+  if (core >= 0 && core < ncores) {
+    CPU_SET(core, &set);
+  } else {
+    for (int i = 0; i < ncores; i++) { CPU_SET(i, &set); }
+  }
+
+  if (sched_setaffinity(tid, sizeof(set), &set) < 0 && !affinity_warned) {
+    t_perror("thread_apply: sched_setaffinity");
+    affinity_warned = 1;
+  }
+
+  memset(&param, 0, sizeof(param));
+
+  if (thread_rt && thread_prio[slot] > 0) {
+    policy = SCHED_FIFO;
+    param.sched_priority = thread_prio[slot];
+  } else {
+    policy = SCHED_OTHER;
+  }
+
+  if (sched_setscheduler(tid, policy, &param) < 0 && !sched_warned) {
+    //
+    // Typically, this fails because RLIMIT_RTPRIO does not allow real-time
+    // priorities for this user. Report once, and continue with
+    // the normal scheduler.
+    //
+    t_perror("thread_apply: sched_setscheduler");
+    sched_warned = 1;
+  }
+}
+
+//
+// Remove threads that have terminated from the table.
+// Must be called with the mutex locked.
+//
+static void thread_purge() {
+  int j = 0;
+
+  for (int i = 0; i < thread_count; i++) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d", thread_table[i].tid);
+
+    if (access(path, F_OK) == 0) {
+      thread_table[j++] = thread_table[i];
+    }
+  }
+
+  thread_count = j;
+}
+#endif
+
+void thread_setup(int slot, const char *name) {
+#ifdef __linux__
+  int tid = (int) syscall(SYS_gettid);
+  int i;
+
+  if (slot < 0 || slot >= THREAD_SLOTS) { return; }
+
+  g_mutex_lock(&thread_mutex);
+
+  for (i = 0; i < thread_count; i++) {
+    if (thread_table[i].tid == tid) { break; }
+  }
+
+  if (i == thread_count && thread_count == MAX_THREADS) {
+    thread_purge();
+    i = thread_count;
+  }
+
+  if (i < MAX_THREADS) {
+    thread_table[i].tid = tid;
+    thread_table[i].slot = slot;
+    snprintf(thread_table[i].name, sizeof(thread_table[i].name), "%s", name);
+
+    if (i == thread_count) { thread_count++; }
+  }
+
+  g_mutex_unlock(&thread_mutex);
+  thread_apply(tid, slot);
+#endif
+}
+
+//
+// Re-apply the current settings to all registered threads,
+// called when the settings have been changed.
+//
+void thread_apply_all() {
+#ifdef __linux__
+  g_mutex_lock(&thread_mutex);
+  thread_purge();
+
+  for (int i = 0; i < thread_count; i++) {
+    thread_apply(thread_table[i].tid, thread_table[i].slot);
+  }
+
+  g_mutex_unlock(&thread_mutex);
+#endif
+}
+
+int thread_get_map(THREAD_INFO *info, int max) {
+  int n = 0;
+#ifdef __linux__
+  g_mutex_lock(&thread_mutex);
+  thread_purge();
+
+  for (int i = 0; i < thread_count && n < max; i++) {
+    info[n++] = thread_table[i];
+  }
+
+  g_mutex_unlock(&thread_mutex);
+#endif
+  return n;
+}
+
+//
+// Call-back from WDSP, invoked by each channel thread when it starts.
+// type is 0 for RX and 1 for TX channels.
+//
+void thread_wdsp_callback(int channel, int type) {
+  char name[32];
+
+  if (type == 1) {
+    thread_setup(THREAD_TX, "WDSP TX");
+  } else {
+    snprintf(name, sizeof(name), "WDSP RX%d", channel);
+    thread_setup(thread_rx_slot(channel), name);
+  }
+}
+
+void threads_save_state() {
+  for (int i = 0; i < THREAD_SLOTS; i++) {
+    SetPropI1("threads.core[%d]", i,                         thread_core[i]);
+  }
+
+  SetPropI0("threads.rt",                                    thread_rt);
+}
+
+void threads_restore_state() {
+  for (int i = 0; i < THREAD_SLOTS; i++) {
+    GetPropI1("threads.core[%d]", i,                         thread_core[i]);
+  }
+
+  GetPropI0("threads.rt",                                    thread_rt);
+}
@@ -0,0 +1,62 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _THREADS_H_
+#define _THREADS_H_
+
+//
+// Threading model: the time-critical threads are grouped into
+// "slots", and for each slot the CPU core can be chosen to which
+// its threads are pinned. Optionally, all threads except the
+// display (GTK) thread use the SCHED_FIFO real-time scheduler.
+//
+// Slots for the receivers contain the thread that feeds the IQ
+// samples into the RX engine (P2: the iq_thread of the DDC) as well
+// as the WDSP channel thread of that receiver.
+//
+enum _thread_slot {
+  THREAD_NET = 0,        // network (or USB, or Saturn) receive threads
+  THREAD_RX1,            // RX engine of receiver #1
+  THREAD_RX2,            // RX engine of receiver #2
+  THREAD_TX,             // TX engine, PureSignal feedback, TX IQ output
+  THREAD_AUDIO,          // local audio (microphone, speaker) threads
+  THREAD_DISPLAY,        // GTK main thread
+  THREAD_SLOTS
+};
+
+typedef struct _thread_info {
+  int tid;               // Linux thread id
+  int slot;              // thread slot
+  char name[32];         // name given in thread_setup()
+} THREAD_INFO;
+
+extern int thread_core[THREAD_SLOTS];     // -1: any core
+extern int thread_rt;                      // use SCHED_FIFO
+
+extern const char *thread_slot_name[THREAD_SLOTS];
+
+extern int  thread_num_cores(void);
+extern int  thread_rx_slot(int id);
+extern void thread_setup(int slot, const char *name);
+extern void thread_apply_all(void);
+extern int  thread_get_map(THREAD_INFO *info, int max);
+extern void thread_wdsp_callback(int channel, int type);
+extern void threads_save_state(void);
+extern void threads_restore_state(void);
+
+#endif
@@ -19,6 +19,7 @@
 
 #include <gtk/gtk.h>
 #include <math.h>
+#include <limits.h>
 
 #include <wdsp.h>
 
@@ -28,9 +29,11 @@
 #include "channel.h"
 #include "ext.h"
 #include "filter.h"
+#include "gpio.h"
 #include "main.h"
 #include "meter.h"
 #include "message.h"
+#include "metrics.h"
 #include "mode.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
@@ -69,6 +72,21 @@ static int     cw_ring_wait[CW_RING_SIZE];
 static volatile int cw_ring_inpt = 0;
 static volatile int cw_ring_outpt = 0;
 
+//
+// Time base for CW: cw_clock counts the microphone samples (48 kHz)
+// processed by tx_add_mic_sample(), this is the position in the TX IQ
+// and side tone streams where the CW ring buffer is executed. The keyer
+// sleeps until the clock reaches a given value (cw_clock_alarm), and is
+// then woken up by the thread that feeds the microphone samples.
+// Waits for a paddle change also end when tx_cw_wakeup() sets
+// cw_paddle_woken, waits for the end of an element or space do not.
+//
+static long long cw_clock = 0;
+static long long cw_clock_alarm = LLONG_MAX;
+static int cw_paddle_woken = 0;
+static GMutex cw_clock_mutex;
+static GCond cw_clock_cond;
+
 
 double ctcss_frequencies[CTCSS_FREQUENCIES] = {
   67.0,  71.9,  74.4,  77.0,  79.7,  82.5,  85.4,  88.5,  91.5,  94.8,
@@ -286,7 +304,11 @@ void tx_reconfigure(TRANSMITTER *tx, int pixels, int width, int height) {
     t_print("%s: width=%d height=%d\n", __FUNCTION__, width, height);
     tx->width = width;
     tx->height = height;
-    gtk_widget_set_size_request(tx->panel, width, height);
+
+    if (tx->panel != NULL) {
+      gtk_widget_set_size_request(tx->panel, width, height);
+    }
+
     //
     // In duplex mode, pixels = 4*width, else pixels equals width
     //
@@ -310,7 +332,9 @@ void tx_reconfigure(TRANSMITTER *tx, int pixels, int width, int height) {
     }
   }
 
-  gtk_widget_set_size_request(tx->panadapter, width, height);
+  if (tx->panadapter != NULL) {
+    gtk_widget_set_size_request(tx->panadapter, width, height);
+  }
 }
 
 void tx_save_state(const TRANSMITTER *tx) {
@@ -791,7 +815,7 @@ static gboolean tx_update_display(gpointer data) {
     }
 
     if (rc) {
-      if (remoteclient.running) {
+      if (remoteclients > 0) {
         send_txspectrum();
       }
 
@@ -1270,7 +1294,10 @@ TRANSMITTER *tx_create_transmitter(int id, int pixels, int width, int height) {
   tx_create_analyzer(tx);
   tx_set_detector(tx);
   tx_set_average(tx);
-  tx_create_visual(tx);
+
+  if (!headless) {
+    tx_create_visual(tx);
+  }
 
   if (protocol == NEW_PROTOCOL || protocol == ORIGINAL_PROTOCOL) {
     tx_ps_setparams(tx);
@@ -1295,6 +1322,7 @@ static void tx_full_buffer(TRANSMITTER *tx) {
   int j;
   int error;
   int cwmode;
+  int64_t t;
   static int txflag = 0;
   // It is important to query the TX mode and tune only *once* within this function, to assure that
   // the two "if (cwmode)" clauses give the same result.
@@ -1334,7 +1362,9 @@ static void tx_full_buffer(TRANSMITTER *tx) {
     // signal to generate the RF pulse is that we do not want MicGain
     // and equaliser settings to interfere.
     //
+    t = metric_start();
     fexchange0(tx->id, tx->mic_input_buffer, tx->iq_output_buffer, &error);
+    metric_observe(METRIC_TX_EXCHANGE_TIME, 0, t);
     //
     // Construct our CW TX signal in tx->iq_output_buffer for the sole
     // purpose of displaying them in the TX panadapter
@@ -1398,10 +1428,13 @@ static void tx_full_buffer(TRANSMITTER *tx) {
     // the downward expander also offers VOX capabilities.
     //
     xdexp(0);
+    t = metric_start();
     fexchange0(tx->id, tx->mic_input_buffer, tx->iq_output_buffer, &error);
+    metric_observe(METRIC_TX_EXCHANGE_TIME, 0, t);
 
     if (error != 0) {
       t_print("%s: id=%d fexchange0: error=%d\n", __FUNCTION__, tx->id, error);
+      metric_inc(METRIC_TX_EXCHANGE_ERRORS, 0);
     }
   }
 
@@ -1573,7 +1606,7 @@ void tx_queue_cw_event(int down, int wait) {
 
   newpt = cw_ring_inpt + 1;
 
-  if (newpt == CW_RING_SIZE) { newpt = 1; }
+  if (newpt == CW_RING_SIZE) { newpt = 0; }
 
   if (newpt != cw_ring_outpt) {
     cw_ring_state[cw_ring_inpt] = down;
@@ -1585,6 +1618,69 @@ void tx_queue_cw_event(int down, int wait) {
   }
 }
 
+long long tx_cw_clock() {
+  //
+  // On the client, there is no TX sample stream, and the
+  // CW time is derived from the monotonic clock (48 ticks per msec).
+  //
+  if (radio_is_remote) {
+    return g_get_monotonic_time() * 6 / 125;
+  }
+
+  return __atomic_load_n(&cw_clock, __ATOMIC_ACQUIRE);
+}
+
+static void tx_cw_sleep(long long t, int paddle) {
+  //
+  // Sleep until the CW clock reaches t or, if paddle is set, until
+  // tx_cw_wakeup() is called. If the microphone samples stop, the wall
+  // clock time corresponding to t (plus a 20 msec margin) ends the wait.
+  //
+  long long now = tx_cw_clock();
+  gint64 deadline;
+
+  if (t <= now) { return; }
+
+  deadline = g_get_monotonic_time() + (t - now) * 125 / 6;
+
+  if (!radio_is_remote) { deadline += 20000; }
+
+  g_mutex_lock(&cw_clock_mutex);
+  __atomic_store_n(&cw_clock_alarm, t, __ATOMIC_RELEASE);
+
+  while (!(paddle && cw_paddle_woken) && tx_cw_clock() < t) {
+    if (!g_cond_wait_until(&cw_clock_cond, &cw_clock_mutex, deadline)) { break; }
+  }
+
+  __atomic_store_n(&cw_clock_alarm, LLONG_MAX, __ATOMIC_RELEASE);
+  g_mutex_unlock(&cw_clock_mutex);
+}
+
+void tx_cw_wait(long long t) {
+  tx_cw_sleep(t, 0);
+}
+
+void tx_cw_paddle_arm() {
+  //
+  // Called before the paddle state is looked at. A paddle change from now
+  // on ends the next tx_cw_wait_paddle(), an earlier one does not.
+  //
+  g_mutex_lock(&cw_clock_mutex);
+  cw_paddle_woken = 0;
+  g_mutex_unlock(&cw_clock_mutex);
+}
+
+void tx_cw_wait_paddle(long long t) {
+  tx_cw_sleep(t, 1);
+}
+
+void tx_cw_wakeup() {
+  g_mutex_lock(&cw_clock_mutex);
+  cw_paddle_woken = 1;
+  g_cond_signal(&cw_clock_cond);
+  g_mutex_unlock(&cw_clock_mutex);
+}
+
 void tx_add_mic_sample(TRANSMITTER *tx, short next_mic_sample) {
   ASSERT_SERVER();
   int txmode = vfo_get_tx_mode();
@@ -1611,7 +1707,7 @@ void tx_add_mic_sample(TRANSMITTER *tx, short next_mic_sample) {
   //
   // If we have a client, it overwrites 'local' microphone data.
   //
-  if (remoteclient.running) {
+  if (remoteclients > 0) {
     mic_sample_double = remote_get_mic_sample() * 0.00003051;  // divide by 32768;
   }
 
@@ -1654,6 +1750,16 @@ void tx_add_mic_sample(TRANSMITTER *tx, short next_mic_sample) {
     cw_delay_time++;
   }
 
+  long long clock = cw_clock + 1;
+  __atomic_store_n(&cw_clock, clock, __ATOMIC_RELEASE);
+
+  if (clock >= __atomic_load_n(&cw_clock_alarm, __ATOMIC_ACQUIRE)) {
+    g_mutex_lock(&cw_clock_mutex);
+    __atomic_store_n(&cw_clock_alarm, LLONG_MAX, __ATOMIC_RELEASE);
+    g_cond_signal(&cw_clock_cond);
+    g_mutex_unlock(&cw_clock_mutex);
+  }
+
   int xmit = radio_is_transmitting();
 
   if (xmit && tx->tune && tx->swrtune && g_mutex_trylock(&tx->cw_ramp_mutex)) {
@@ -1758,25 +1864,32 @@ void tx_add_mic_sample(TRANSMITTER *tx, short next_mic_sample) {
     //
     if (keydown && cw_delay_time > 960000) {
       keydown = 0;
+      gpio_set_cw(0);
     }
 
-    if (cw_ring_inpt != cw_ring_outpt) {
+    while (cw_ring_inpt != cw_ring_outpt && cw_delay_time >= cw_ring_wait[cw_ring_outpt]) {
       //
-      // There is data in the ring buffer
+      // Next event in the ring buffer ready to be executed. Events with
+      // zero wait time are executed at the same sample, such that a key-down
+      // queued after an inter-element pause starts exactly when the pause ends.
       //
-      if (cw_delay_time >= cw_ring_wait[cw_ring_outpt]) {
+      cw_delay_time = 0;
+
+      if (keydown != cw_ring_state[cw_ring_outpt]) {
         //
-        // Next event ready to be executed
+        // GPIO side tone output, switched at the same sample
+        // as the TX signal
         //
-        cw_delay_time = 0;
-        keydown = cw_ring_state[cw_ring_outpt];
-        int newpt = cw_ring_outpt + 1;
+        gpio_set_cw(cw_ring_state[cw_ring_outpt]);
+      }
 
-        if (newpt >= CW_RING_SIZE) { newpt -= CW_RING_SIZE; }
+      keydown = cw_ring_state[cw_ring_outpt];
+      int newpt = cw_ring_outpt + 1;
 
-        MEMORY_BARRIER;
-        cw_ring_outpt = newpt;
-      }
+      if (newpt >= CW_RING_SIZE) { newpt -= CW_RING_SIZE; }
+
+      MEMORY_BARRIER;
+      cw_ring_outpt = newpt;
     }
 
     //
@@ -1900,7 +2013,11 @@ void tx_add_mic_sample(TRANSMITTER *tx, short next_mic_sample) {
     //  If no longer transmitting, or no longer doing CW: reset pulse shaper.
     //  This will also swallow any pending CW and wipe out the buffers
     //
-    keydown = 0;
+    if (keydown) {
+      keydown = 0;
+      gpio_set_cw(0);
+    }
+
     cw_ring_inpt = cw_ring_outpt = 0;
     tx->cw_ramp_audio_ptr = 0;
     tx->cw_ramp_rf_ptr = 0;
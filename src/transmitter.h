@@ -22,6 +22,8 @@
 
 #include <gtk/gtk.h>
 
+#include "pan_layer.h"
+
 #define CTCSS_FREQUENCIES 38
 extern double ctcss_frequencies[CTCSS_FREQUENCIES];
 
@@ -77,6 +79,7 @@ typedef struct _transmitter {
   int panadapter_peaks_in_passband_filled;
 
   cairo_surface_t *panadapter_surface;
+  PAN_LAYER panadapter_layer;
 
   int local_microphone;
   gchar microphone_name[128];
@@ -245,6 +248,11 @@ extern void   tx_set_ramps(TRANSMITTER *tx);
 extern void   tx_set_singletone(const TRANSMITTER *tx, int state, double freq);
 extern void   tx_set_twotone(TRANSMITTER *tx, int state);
 extern void   tx_queue_cw_event(int state, int wait);
+extern long long tx_cw_clock(void);
+extern void   tx_cw_wait(long long t);
+extern void   tx_cw_paddle_arm(void);
+extern void   tx_cw_wait_paddle(long long t);
+extern void   tx_cw_wakeup(void);
 
 extern void tx_create_remote(TRANSMITTER *rx);
 extern int  tx_remote_update_display(gpointer data);
@@ -34,9 +34,11 @@
 #include "gpio.h"
 #include "message.h"
 #include "mode.h"
+#include "pan_trace.h"
 #include "radio.h"
 #include "receiver.h"
 #include "rx_panadapter.h"
+#include "spectrum_stats.h"
 #include "transmitter.h"
 #include "tx_panadapter.h"
 #include "vfo.h"
@@ -54,6 +56,7 @@ tx_panadapter_configure_event_cb (GtkWidget         *widget,
     cairo_surface_destroy (tx->panadapter_surface);
   }
 
+  pan_layer_destroy(&tx->panadapter_layer);
   tx->panadapter_surface = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
                            CAIRO_CONTENT_COLOR,
                            mywidth,
@@ -98,6 +101,136 @@ static gboolean tx_panadapter_button_press_event_cb (GtkWidget *widget, GdkEvent
   return TRUE;
 }
 
+//
+// Draw the static layer: background, filter passband, dBm grid,
+// frequency markers and band edges.
+//
+static void tx_panadapter_static(const TRANSMITTER *tx, cairo_t *cr, int mywidth, int myheight,
+                                 long long frequency, const BAND *band, int txmode,
+                                 double filter_left, double filter_right) {
+  double hz_per_pixel = 24000.0 / (double)tx->pixels;
+  cairo_set_source_rgba(cr, COLOUR_PAN_BACKGND);
+  cairo_paint (cr);
+
+  if (txmode != modeCWU && txmode != modeCWL) {
+    cairo_set_source_rgba(cr, COLOUR_PAN_FILTER);
+    cairo_rectangle(cr, filter_left, 0.0, filter_right - filter_left, (double)myheight);
+    cairo_fill(cr);
+  }
+
+  // plot the levels   0, -20,  40, ... dBm (bright turquoise line with label)
+  // additionally, plot the levels in steps of the chosen panadapter step size
+  // (dark turquoise line without label)
+  double dbm_per_line = (double)myheight / ((double)tx->panadapter_high - (double)tx->panadapter_low);
+  cairo_set_source_rgba(cr, COLOUR_PAN_LINE);
+  cairo_set_line_width(cr, PAN_LINE_THICK);
+  cairo_select_font_face(cr, DISPLAY_FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+  cairo_set_font_size(cr, DISPLAY_FONT_SIZE2);
+
+  for (int i = tx->panadapter_high; i >= tx->panadapter_low; i--) {
+    if ((abs(i) % tx->panadapter_step) == 0) {
+      double y = (double)(tx->panadapter_high - i) * dbm_per_line;
+
+      if ((abs(i) % 20) == 0) {
+        char v[32];
+        cairo_set_source_rgba(cr, COLOUR_PAN_LINE_WEAK);
+        cairo_move_to(cr, 0.0, y);
+        cairo_line_to(cr, (double)mywidth, y);
+        snprintf(v, sizeof(v), "%d dBm", i);
+        cairo_move_to(cr, 1, y);
+        cairo_show_text(cr, v);
+        cairo_stroke(cr);
+      } else {
+        cairo_set_source_rgba(cr, COLOUR_PAN_LINE_WEAK);
+        cairo_move_to(cr, 0.0, y);
+        cairo_line_to(cr, (double)mywidth, y);
+        cairo_stroke(cr);
+      }
+    }
+  }
+
+  // plot frequency markers
+  long long half = tx->dialog ? 3000LL : 12000LL; //(long long)(tx->output_rate/2);
+  long long min_display = frequency - half;
+  long long max_display = frequency + half;
+
+  if (tx->dialog == NULL) {
+    long long f;
+    const long long divisor = 5000;
+    //
+    // in DUPLEX, space in the TX window is so limited
+    // that we cannot print the frequencies
+    //
+    cairo_set_source_rgba(cr, COLOUR_PAN_LINE);
+    cairo_select_font_face(cr, DISPLAY_FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, DISPLAY_FONT_SIZE2);
+    cairo_set_line_width(cr, PAN_LINE_THIN);
+    cairo_text_extents_t extents;
+    f = ((min_display / divisor) * divisor) + divisor;
+
+    while (f < max_display) {
+      double x = (double)(f - min_display) / hz_per_pixel;
+
+      //
+      // Skip vertical line if it is in the filter area, since
+      // one might want to see a PureSignal Feedback there
+      // without any distraction.
+      //
+      if (x < filter_left || x > filter_right) {
+        cairo_move_to(cr, x, 10.0);
+        cairo_line_to(cr, x, (double)myheight);
+      }
+
+      //
+      // For frequency marker lines very close to the left or right
+      // edge, do not print a frequency since this probably won't fit
+      // on the screen
+      //
+      if ((f >= min_display + divisor / 2) && (f <= max_display - divisor / 2)) {
+        char v[32];
+
+        //
+        // For frequencies larger than 10 GHz, we cannot
+        // display all digits here
+        //
+        if (f > 10000000000LL) {
+          snprintf(v, sizeof(v), "...%03lld.%03lld", (f / 1000000) % 1000, (f % 1000000) / 1000);
+        } else {
+          snprintf(v, sizeof(v), "%0lld.%03lld", f / 1000000, (f % 1000000) / 1000);
+        }
+
+        cairo_text_extents(cr, v, &extents);
+        cairo_move_to(cr, x - (extents.width / 2.0), 10.0);
+        cairo_show_text(cr, v);
+      }
+
+      f += divisor;
+    }
+
+    cairo_stroke(cr);
+  }
+
+  // band edges
+  if (band->frequencyMin != 0LL) {
+    cairo_set_source_rgba(cr, COLOUR_ALARM);
+    cairo_set_line_width(cr, PAN_LINE_EXTRA);
+
+    if ((min_display < band->frequencyMin) && (max_display > band->frequencyMin)) {
+      int i = (band->frequencyMin - min_display) / (long long)hz_per_pixel;
+      cairo_move_to(cr, (double)i, 0.0);
+      cairo_line_to(cr, (double)i, (double)myheight);
+      cairo_stroke(cr);
+    }
+
+    if ((min_display < band->frequencyMax) && (max_display > band->frequencyMax)) {
+      int i = (band->frequencyMax - min_display) / (long long)hz_per_pixel;
+      cairo_move_to(cr, (double)i, 0.0);
+      cairo_line_to(cr, (double)i, (double)myheight);
+      cairo_stroke(cr);
+    }
+  }
+}
+
 void tx_panadapter_update(TRANSMITTER *tx) {
   if (tx->panadapter_surface) {
     int mywidth = gtk_widget_get_allocated_width (tx->panadapter);
@@ -108,15 +241,11 @@ void tx_panadapter_update(TRANSMITTER *tx) {
     float *samples = tx->pixel_samples;
     double hz_per_pixel = 24000.0 / (double)tx->pixels;
     cairo_t *cr;
-    cr = cairo_create (tx->panadapter_surface);
-    cairo_set_source_rgba(cr, COLOUR_PAN_BACKGND);
-    cairo_paint (cr);
+    long long frequency;
     // filter
     filter_left = filter_right = 0.5 * mywidth;
 
     if (txmode != modeCWU && txmode != modeCWL) {
-      cairo_set_source_rgba(cr, COLOUR_PAN_FILTER);
-
       if (txmode == modeFMN) {
         //
         // The bandpass filter used in FM  is applied *before* the FM
@@ -128,46 +257,8 @@ void tx_panadapter_update(TRANSMITTER *tx) {
         filter_left = (double)mywidth / 2.0 + ((double)tx->filter_low / hz_per_pixel);
         filter_right = (double)mywidth / 2.0 + ((double)tx->filter_high / hz_per_pixel);
       }
-
-      cairo_rectangle(cr, filter_left, 0.0, filter_right - filter_left, (double)myheight);
-      cairo_fill(cr);
-    }
-
-    // plot the levels   0, -20,  40, ... dBm (bright turquoise line with label)
-    // additionally, plot the levels in steps of the chosen panadapter step size
-    // (dark turquoise line without label)
-    double dbm_per_line = (double)myheight / ((double)tx->panadapter_high - (double)tx->panadapter_low);
-    cairo_set_source_rgba(cr, COLOUR_PAN_LINE);
-    cairo_set_line_width(cr, PAN_LINE_THICK);
-    cairo_select_font_face(cr, DISPLAY_FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-    cairo_set_font_size(cr, DISPLAY_FONT_SIZE2);
-
-    for (int i = tx->panadapter_high; i >= tx->panadapter_low; i--) {
-      if ((abs(i) % tx->panadapter_step) == 0) {
-        double y = (double)(tx->panadapter_high - i) * dbm_per_line;
-
-        if ((abs(i) % 20) == 0) {
-          char v[32];
-          cairo_set_source_rgba(cr, COLOUR_PAN_LINE_WEAK);
-          cairo_move_to(cr, 0.0, y);
-          cairo_line_to(cr, (double)mywidth, y);
-          snprintf(v, sizeof(v), "%d dBm", i);
-          cairo_move_to(cr, 1, y);
-          cairo_show_text(cr, v);
-          cairo_stroke(cr);
-        } else {
-          cairo_set_source_rgba(cr, COLOUR_PAN_LINE_WEAK);
-          cairo_move_to(cr, 0.0, y);
-          cairo_line_to(cr, (double)mywidth, y);
-          cairo_stroke(cr);
-        }
-      }
     }
 
-    // plot frequency markers
-    long long half = tx->dialog ? 3000LL : 12000LL; //(long long)(tx->output_rate/2);
-    long long frequency;
-
     if (vfo[txvfo].ctun) {
       frequency = vfo[txvfo].ctun_frequency;
     } else {
@@ -175,88 +266,28 @@ void tx_panadapter_update(TRANSMITTER *tx) {
     }
 
     double vfofreq = (double)mywidth * 0.5;
-    long long min_display = frequency - half;
-    long long max_display = frequency + half;
-
-    if (tx->dialog == NULL) {
-      long long f;
-      const long long divisor = 5000;
-      //
-      // in DUPLEX, space in the TX window is so limited
-      // that we cannot print the frequencies
-      //
-      cairo_set_source_rgba(cr, COLOUR_PAN_LINE);
-      cairo_select_font_face(cr, DISPLAY_FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-      cairo_set_font_size(cr, DISPLAY_FONT_SIZE2);
-      cairo_set_line_width(cr, PAN_LINE_THIN);
-      cairo_text_extents_t extents;
-      f = ((min_display / divisor) * divisor) + divisor;
-
-      while (f < max_display) {
-        double x = (double)(f - min_display) / hz_per_pixel;
-
-        //
-        // Skip vertical line if it is in the filter area, since
-        // one might want to see a PureSignal Feedback there
-        // without any distraction.
-        //
-        if (x < filter_left || x > filter_right) {
-          cairo_move_to(cr, x, 10.0);
-          cairo_line_to(cr, x, (double)myheight);
-        }
-
-        //
-        // For frequency marker lines very close to the left or right
-        // edge, do not print a frequency since this probably won't fit
-        // on the screen
-        //
-        if ((f >= min_display + divisor / 2) && (f <= max_display - divisor / 2)) {
-          char v[32];
-
-          //
-          // For frequencies larger than 10 GHz, we cannot
-          // display all digits here
-          //
-          if (f > 10000000000LL) {
-            snprintf(v, sizeof(v), "...%03lld.%03lld", (f / 1000000) % 1000, (f % 1000000) / 1000);
-          } else {
-            snprintf(v, sizeof(v), "%0lld.%03lld", f / 1000000, (f % 1000000) / 1000);
-          }
-
-          cairo_text_extents(cr, v, &extents);
-          cairo_move_to(cr, x - (extents.width / 2.0), 10.0);
-          cairo_show_text(cr, v);
-        }
-
-        f += divisor;
-      }
-
-      cairo_stroke(cr);
-    }
-
-    // band edges
-    int b = vfo[txvfo].band;
-    const BAND *band = band_get_band(b);
-
-    if (band->frequencyMin != 0LL) {
-      cairo_set_source_rgba(cr, COLOUR_ALARM);
-      cairo_set_line_width(cr, PAN_LINE_EXTRA);
-
-      if ((min_display < band->frequencyMin) && (max_display > band->frequencyMin)) {
-        int i = (band->frequencyMin - min_display) / (long long)hz_per_pixel;
-        cairo_move_to(cr, (double)i, 0.0);
-        cairo_line_to(cr, (double)i, (double)myheight);
-        cairo_stroke(cr);
-      }
-
-      if ((min_display < band->frequencyMax) && (max_display > band->frequencyMax)) {
-        int i = (band->frequencyMax - min_display) / (long long)hz_per_pixel;
-        cairo_move_to(cr, (double)i, 0.0);
-        cairo_line_to(cr, (double)i, (double)myheight);
-        cairo_stroke(cr);
-      }
+    const BAND *band = band_get_band(vfo[txvfo].band);
+    //
+    // Re-draw the static layer only if one of the parameters it
+    // depends on has changed, otherwise just copy it.
+    //
+    const double key[] = {
+      mywidth, myheight, frequency, txmode, tx->pixels,
+      band->frequencyMin, band->frequencyMax,
+      filter_left, filter_right, tx->panadapter_high, tx->panadapter_low, tx->panadapter_step,
+      tx->dialog != NULL, which_css_font
+    };
+    cr = pan_layer_begin(&tx->panadapter_layer, tx->panadapter_surface, mywidth, myheight,
+                         key, G_N_ELEMENTS(key));
+
+    if (cr) {
+      tx_panadapter_static(tx, cr, mywidth, myheight, frequency, band, txmode, filter_left, filter_right);
+      cairo_destroy(cr);
     }
 
+    cr = cairo_create (tx->panadapter_surface);
+    pan_layer_paint(&tx->panadapter_layer, cr);
+    cairo_select_font_face(cr, DISPLAY_FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
     // cursor
     cairo_set_source_rgba(cr, COLOUR_ALARM);
     cairo_set_line_width(cr, PAN_LINE_THIN);
@@ -264,7 +295,6 @@ void tx_panadapter_update(TRANSMITTER *tx) {
     cairo_line_to(cr, vfofreq, (double)myheight);
     cairo_stroke(cr);
     // signal
-    double s1;
     int offset;
 
     if (radio_is_remote) {
@@ -275,20 +305,11 @@ void tx_panadapter_update(TRANSMITTER *tx) {
 
     samples[offset] = -200.0;
     samples[offset + mywidth - 1] = -200.0;
-    s1 = (double)samples[offset];
-    s1 = floor((tx->panadapter_high - s1)
-               * (double) myheight
-               / (tx->panadapter_high - tx->panadapter_low));
-    cairo_move_to(cr, 0.0, s1);
-
-    for (int i = 1; i < mywidth; i++) {
-      double s2;
-      s2 = (double)samples[i + offset];
-      s2 = floor((tx->panadapter_high - s2)
-                 * (double) myheight
-                 / (tx->panadapter_high - tx->panadapter_low));
-      cairo_line_to(cr, (double)i, s2);
-    }
+    int ytop[mywidth];
+    int ybot[mywidth];
+    pan_trace_scale(samples + offset, mywidth, 0.0, tx->panadapter_high, tx->panadapter_low,
+                    mywidth, myheight, ytop, ybot);
+    pan_trace_path(cr, ytop, ybot, mywidth);
 
     if (tx->display_filled) {
       cairo_set_source_rgba(cr, COLOUR_PAN_FILL2);
@@ -378,90 +399,17 @@ void tx_panadapter_update(TRANSMITTER *tx) {
       }
 
       // Calculate the noise level if needed
-      double noise_level = 0.0;
+      double noise_level = -1.0E30;
 
       if (hide_noise) {
-        // Dynamically allocate a copy of samples for sorting
-        double *sorted_samples = malloc(mywidth * sizeof(double));
-
-        if (sorted_samples != NULL) {
-          for (int i = 0; i < mywidth; i++) {
-            sorted_samples[i] = (double)samples[i + offset];
-          }
-
-          qsort(sorted_samples, mywidth, sizeof(double), compare_doubles);
-          int index = (int)((noise_percentile / 100.0) * mywidth);
-          noise_level = sorted_samples[index] + 3.0;
-          free(sorted_samples); // Free memory after use
-        }
+        noise_level = spectrum_percentile(samples + offset, mywidth, 0.0, noise_percentile) + 3.0;
       }
 
-      // Detect peaks
-      double filter_left_bound = peaks_in_passband ? filter_left : 0;
-      double filter_right_bound = peaks_in_passband ? filter_right : mywidth;
-
-      for (int i = 1; i < mywidth - 1; i++) {
-        if (i >= filter_left_bound && i <= filter_right_bound) {
-          double s = (double)samples[i + offset];
-
-          // Check if the point is a peak
-          if ((!hide_noise || s >= noise_level) && s > samples[i - 1 + offset] && s > samples[i + 1 + offset]) {
-            int replace_index = -1;
-            int start_range = i - ignore_range;
-            int end_range = i + ignore_range;
-
-            // Check if the peak is within the ignore range of any existing peak
-            for (int j = 0; j < num_peaks; j++) {
-              if (peak_positions[j] >= start_range && peak_positions[j] <= end_range) {
-                if (s > peaks[j]) {
-                  replace_index = j;
-                  break;
-                } else {
-                  replace_index = -2;
-                  break;
-                }
-              }
-            }
-
-            // Replace the existing peak if a higher peak is found within the ignore range
-            if (replace_index >= 0) {
-              peaks[replace_index] = s;
-              peak_positions[replace_index] = i;
-            }
-            // Add the peak if no peaks are found within the ignore range
-            else if (replace_index == -1) {
-              // Find the index of the lowest peak
-              int lowest_peak_index = 0;
-
-              for (int j = 1; j < num_peaks; j++) {
-                if (peaks[j] < peaks[lowest_peak_index]) {
-                  lowest_peak_index = j;
-                }
-              }
-
-              // Replace the lowest peak if the current peak is higher
-              if (s > peaks[lowest_peak_index]) {
-                peaks[lowest_peak_index] = s;
-                peak_positions[lowest_peak_index] = i;
-              }
-            }
-          }
-        }
-      }
-
-      // Sort peaks in descending order
-      for (int i = 0; i < num_peaks - 1; i++) {
-        for (int j = i + 1; j < num_peaks; j++) {
-          if (peaks[i] < peaks[j]) {
-            double temp_peak = peaks[i];
-            peaks[i] = peaks[j];
-            peaks[j] = temp_peak;
-            int temp_pos = peak_positions[i];
-            peak_positions[i] = peak_positions[j];
-            peak_positions[j] = temp_pos;
-          }
-        }
-      }
+      // Detect peaks, sorted in descending order
+      int peaks_left = peaks_in_passband ? (int)ceil(filter_left) : 0;
+      int peaks_right = peaks_in_passband ? (int)floor(filter_right) : mywidth;
+      spectrum_peaks(samples + offset, mywidth, 0.0, peaks_left, peaks_right, noise_level,
+                     ignore_range, num_peaks, peaks, peak_positions);
 
       // Draw peak values on the chart
       cairo_set_source_rgba(cr, COLOUR_PAN_TEXT); // Set text color
@@ -540,6 +488,7 @@ void tx_panadapter_update(TRANSMITTER *tx) {
 void tx_panadapter_init(TRANSMITTER *tx, int width, int height) {
   t_print("%s: %d x %d\n", __FUNCTION__, width, height);
   tx->panadapter_surface = NULL;
+  pan_layer_init(&tx->panadapter_layer);
   tx->panadapter = gtk_drawing_area_new ();
   gtk_widget_set_size_request (tx->panadapter, width, height);
   /* Signals used to handle the backing surface */
@@ -56,7 +56,7 @@ void vox_update(double lvl) {
   //
   // As long as a client controls us, VOX is done there
   //
-  if (remoteclient.running) { return; }
+  if (remoteclients > 0) { return; }
 
   if (!can_transmit) { return; }
 
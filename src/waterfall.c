@@ -27,6 +27,7 @@
 #include "vfo.h"
 #include "band.h"
 #include "message.h"
+#include "spectrum_stats.h"
 #include "waterfall.h"
 
 static int colorLowR = 0; // black
@@ -183,7 +184,6 @@ void waterfall_update(RECEIVER *rx) {
     if (!freq_changed) {
       memmove(&pixels[rowstride], pixels, (height - 1)*rowstride);
       float soffset;
-      float average;
       unsigned char *p;
       p = pixels;
       samples = rx->pixel_samples;
@@ -209,14 +209,12 @@ void waterfall_update(RECEIVER *rx) {
         soffset -= (float)(20 * adc[rx->adc].preamp);
       }
 
-      average = 0.0F;
-
-      for (int i = 0; i < width; i++) {
-        average += (samples[i] + soffset);
-      }
-
       if (rx->waterfall_automatic) {
-        wf_low = average / (float)width;
+        //
+        // The median is a better estimate of the noise floor than the
+        // mean, since it is not pulled up by strong signals
+        //
+        wf_low = (float) spectrum_percentile(samples, width, soffset, 50.0);
         wf_high = wf_low + 50.0F;
       } else {
         wf_low  = (float) rx->waterfall_low;
@@ -560,41 +560,78 @@ void flush_rxa (int channel)
 
 void xrxa (int channel)
 {
+	profile_begin (channel);
 	xshift (rxa[channel].shift.p);
+	profile_stage (channel, RXA_ST_SHIFT);
 	xresample (rxa[channel].rsmpin.p);
+	profile_stage (channel, RXA_ST_RSMPIN);
 	xgen (rxa[channel].gen0.p);
+	profile_stage (channel, RXA_ST_GEN0);
 	xmeter (rxa[channel].adcmeter.p);
+	profile_stage (channel, RXA_ST_ADCMETER);
 	xbpsnbain (rxa[channel].bpsnba.p, 0);
+	profile_stage (channel, RXA_ST_BPSNBAIN0);
 	xnbp (rxa[channel].nbp0.p, 0);
+	profile_stage (channel, RXA_ST_NBP0);
 	xmeter (rxa[channel].smeter.p);
+	profile_stage (channel, RXA_ST_SMETER);
 	xsender (rxa[channel].sender.p);
+	profile_stage (channel, RXA_ST_SENDER);
 	xamsqcap (rxa[channel].amsq.p);
+	profile_stage (channel, RXA_ST_AMSQCAP);
 	xbpsnbaout (rxa[channel].bpsnba.p, 0);
+	profile_stage (channel, RXA_ST_BPSNBAOUT0);
 	xamd (rxa[channel].amd.p);
+	profile_stage (channel, RXA_ST_AMD);
 	xfmd (rxa[channel].fmd.p);
+	profile_stage (channel, RXA_ST_FMD);
 	xfmsq (rxa[channel].fmsq.p);
+	profile_stage (channel, RXA_ST_FMSQ);
 	xbpsnbain (rxa[channel].bpsnba.p, 1);
+	profile_stage (channel, RXA_ST_BPSNBAIN1);
 	xbpsnbaout (rxa[channel].bpsnba.p, 1);
+	profile_stage (channel, RXA_ST_BPSNBAOUT1);
 	xsnba (rxa[channel].snba.p);
+	profile_stage (channel, RXA_ST_SNBA);
 	xeqp (rxa[channel].eqp.p);
+	profile_stage (channel, RXA_ST_EQP);
 	xanf (rxa[channel].anf.p, 0);
+	profile_stage (channel, RXA_ST_ANF0);
 	xanr (rxa[channel].anr.p, 0);
+	profile_stage (channel, RXA_ST_ANR0);
 	xemnr (rxa[channel].emnr.p, 0);
+	profile_stage (channel, RXA_ST_EMNR0);
 	xbandpass (rxa[channel].bp1.p, 0);
+	profile_stage (channel, RXA_ST_BP10);
 	xwcpagc (rxa[channel].agc.p);
+	profile_stage (channel, RXA_ST_AGC);
 	xanf (rxa[channel].anf.p, 1);
+	profile_stage (channel, RXA_ST_ANF1);
 	xanr (rxa[channel].anr.p, 1);
+	profile_stage (channel, RXA_ST_ANR1);
 	xemnr (rxa[channel].emnr.p, 1);
+	profile_stage (channel, RXA_ST_EMNR1);
 	xbandpass (rxa[channel].bp1.p, 1);
+	profile_stage (channel, RXA_ST_BP11);
 	xmeter (rxa[channel].agcmeter.p);
+	profile_stage (channel, RXA_ST_AGCMETER);
 	xsiphon (rxa[channel].sip1.p, 0);
+	profile_stage (channel, RXA_ST_SIP1);
 	xcbl (rxa[channel].cbl.p);
+	profile_stage (channel, RXA_ST_CBL);
 	xspeak (rxa[channel].speak.p);
+	profile_stage (channel, RXA_ST_SPEAK);
 	xmpeak (rxa[channel].mpeak.p);
+	profile_stage (channel, RXA_ST_MPEAK);
 	xssql (rxa[channel].ssql.p);
+	profile_stage (channel, RXA_ST_SSQL);
 	xpanel (rxa[channel].panel.p);
+	profile_stage (channel, RXA_ST_PANEL);
 	xamsq (rxa[channel].amsq.p);
+	profile_stage (channel, RXA_ST_AMSQ);
 	xresample (rxa[channel].rsmpout.p);
+	profile_stage (channel, RXA_ST_RSMPOUT);
+	profile_end (channel);
 }
 
 void setInputSamplerate_rxa (int channel)
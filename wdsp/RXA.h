@@ -56,6 +56,47 @@ enum rxaMeterType
 	RXA_METERTYPE_LAST
 };
 
+// stages of xrxa(), in calling order, for the profiler
+enum rxaStage
+{
+	RXA_ST_SHIFT,
+	RXA_ST_RSMPIN,
+	RXA_ST_GEN0,
+	RXA_ST_ADCMETER,
+	RXA_ST_BPSNBAIN0,
+	RXA_ST_NBP0,
+	RXA_ST_SMETER,
+	RXA_ST_SENDER,
+	RXA_ST_AMSQCAP,
+	RXA_ST_BPSNBAOUT0,
+	RXA_ST_AMD,
+	RXA_ST_FMD,
+	RXA_ST_FMSQ,
+	RXA_ST_BPSNBAIN1,
+	RXA_ST_BPSNBAOUT1,
+	RXA_ST_SNBA,
+	RXA_ST_EQP,
+	RXA_ST_ANF0,
+	RXA_ST_ANR0,
+	RXA_ST_EMNR0,
+	RXA_ST_BP10,
+	RXA_ST_AGC,
+	RXA_ST_ANF1,
+	RXA_ST_ANR1,
+	RXA_ST_EMNR1,
+	RXA_ST_BP11,
+	RXA_ST_AGCMETER,
+	RXA_ST_SIP1,
+	RXA_ST_CBL,
+	RXA_ST_SPEAK,
+	RXA_ST_MPEAK,
+	RXA_ST_SSQL,
+	RXA_ST_PANEL,
+	RXA_ST_AMSQ,
+	RXA_ST_RSMPOUT,
+	RXA_STAGE_LAST
+};
+
 struct _rxa
 {
 	double* inbuff;
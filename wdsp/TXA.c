@@ -556,39 +556,73 @@ void flush_txa (int channel)
 
 void xtxa (int channel)
 {
+	profile_begin (channel);
 	xresample (txa[channel].rsmpin.p);				// input resampler
+	profile_stage (channel, TXA_ST_RSMPIN);
 	xgen (txa[channel].gen0.p);						// input signal generator
+	profile_stage (channel, TXA_ST_GEN0);
 	xpanel (txa[channel].panel.p);					// includes MIC gain
+	profile_stage (channel, TXA_ST_PANEL);
 	xphrot (txa[channel].phrot.p);					// phase rotator
+	profile_stage (channel, TXA_ST_PHROT);
 	xmeter (txa[channel].micmeter.p);				// MIC meter
+	profile_stage (channel, TXA_ST_MICMETER);
 	xamsqcap (txa[channel].amsq.p);					// downward expander capture
+	profile_stage (channel, TXA_ST_AMSQCAP);
 	xamsq (txa[channel].amsq.p);					// downward expander action
+	profile_stage (channel, TXA_ST_AMSQ);
 	xeqp (txa[channel].eqp.p);						// pre-EQ
+	profile_stage (channel, TXA_ST_EQP);
 	xmeter (txa[channel].eqmeter.p);				// EQ meter
+	profile_stage (channel, TXA_ST_EQMETER);
 	xemphp (txa[channel].preemph.p, 0);				// FM pre-emphasis (first option)
+	profile_stage (channel, TXA_ST_PREEMPH0);
 	xwcpagc (txa[channel].leveler.p);				// Leveler
+	profile_stage (channel, TXA_ST_LEVELER);
 	xmeter (txa[channel].lvlrmeter.p);				// Leveler Meter
+	profile_stage (channel, TXA_ST_LVLRMETER);
 	xcfcomp (txa[channel].cfcomp.p, 0);				// Continuous Frequency Compressor with post-EQ
+	profile_stage (channel, TXA_ST_CFCOMP);
 	xmeter (txa[channel].cfcmeter.p);				// CFC+PostEQ Meter
+	profile_stage (channel, TXA_ST_CFCMETER);
 	xbandpass (txa[channel].bp0.p, 0);				// primary bandpass filter
+	profile_stage (channel, TXA_ST_BP0);
 	xcompressor (txa[channel].compressor.p);		// COMP compressor
+	profile_stage (channel, TXA_ST_COMPRESSOR);
 	xbandpass (txa[channel].bp1.p, 0);				// aux bandpass (runs if COMP)
+	profile_stage (channel, TXA_ST_BP1);
 	xosctrl (txa[channel].osctrl.p);				// CESSB Overshoot Control
+	profile_stage (channel, TXA_ST_OSCTRL);
 	xbandpass (txa[channel].bp2.p, 0);				// aux bandpass (runs if CESSB)
+	profile_stage (channel, TXA_ST_BP2);
 	xmeter (txa[channel].compmeter.p);				// COMP meter
+	profile_stage (channel, TXA_ST_COMPMETER);
 	xwcpagc (txa[channel].alc.p);					// ALC
+	profile_stage (channel, TXA_ST_ALC);
 	xammod (txa[channel].ammod.p);					// AM Modulator
+	profile_stage (channel, TXA_ST_AMMOD);
 	xemphp (txa[channel].preemph.p, 1);				// FM pre-emphasis (second option)
+	profile_stage (channel, TXA_ST_PREEMPH1);
 	xfmmod (txa[channel].fmmod.p);					// FM Modulator
+	profile_stage (channel, TXA_ST_FMMOD);
 	xgen (txa[channel].gen1.p);						// output signal generator (TUN and Two-tone)
+	profile_stage (channel, TXA_ST_GEN1);
 	xuslew (txa[channel].uslew.p);					// up-slew for AM, FM, and gens
+	profile_stage (channel, TXA_ST_USLEW);
 	xmeter (txa[channel].alcmeter.p);				// ALC Meter
+	profile_stage (channel, TXA_ST_ALCMETER);
 	xsiphon (txa[channel].sip1.p, 0);				// siphon data for display
+	profile_stage (channel, TXA_ST_SIP1);
 	xiqc (txa[channel].iqc.p0);						// PureSignal correction
+	profile_stage (channel, TXA_ST_IQC);
 	xcfir(txa[channel].cfir.p);						// compensating FIR filter (used Protocol_2 only)
+	profile_stage (channel, TXA_ST_CFIR);
 	xresample (txa[channel].rsmpout.p);				// output resampler
+	profile_stage (channel, TXA_ST_RSMPOUT);
 	xmeter (txa[channel].outmeter.p);				// output meter
+	profile_stage (channel, TXA_ST_OUTMETER);
 	// print_peak_env ("env_exception.txt", ch[channel].dsp_outsize, txa[channel].outbuff, 0.7);
+	profile_end (channel);
 }
 
 void setInputSamplerate_txa (int channel)
@@ -68,6 +68,44 @@ enum txaMeterType
 	TXA_METERTYPE_LAST
 };
 
+// stages of xtxa(), in calling order, for the profiler
+enum txaStage
+{
+	TXA_ST_RSMPIN,
+	TXA_ST_GEN0,
+	TXA_ST_PANEL,
+	TXA_ST_PHROT,
+	TXA_ST_MICMETER,
+	TXA_ST_AMSQCAP,
+	TXA_ST_AMSQ,
+	TXA_ST_EQP,
+	TXA_ST_EQMETER,
+	TXA_ST_PREEMPH0,
+	TXA_ST_LEVELER,
+	TXA_ST_LVLRMETER,
+	TXA_ST_CFCOMP,
+	TXA_ST_CFCMETER,
+	TXA_ST_BP0,
+	TXA_ST_COMPRESSOR,
+	TXA_ST_BP1,
+	TXA_ST_OSCTRL,
+	TXA_ST_BP2,
+	TXA_ST_COMPMETER,
+	TXA_ST_ALC,
+	TXA_ST_AMMOD,
+	TXA_ST_PREEMPH1,
+	TXA_ST_FMMOD,
+	TXA_ST_GEN1,
+	TXA_ST_USLEW,
+	TXA_ST_ALCMETER,
+	TXA_ST_SIP1,
+	TXA_ST_IQC,
+	TXA_ST_CFIR,
+	TXA_ST_RSMPOUT,
+	TXA_ST_OUTMETER,
+	TXA_STAGE_LAST
+};
+
 struct _txa
 {
 	double* inbuff;
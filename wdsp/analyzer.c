@@ -429,13 +429,13 @@ void detector (	int det_type,			// detector type
 				}
 				else
 				{
-					pixels[last_pix_count] = sqrt (psum / (double)bcount) * inv_enb;
+					pixels[last_pix_count] = FM_SQRT (psum / (double)bcount) * inv_enb;
 					psum = bins[i] * bins[i];
 					bcount = 1;
 				}
 				if (i == ilim - 1)
 				{
-					pixels[pix_count] = sqrt (psum / (double)bcount) * inv_enb;
+					pixels[pix_count] = FM_SQRT (psum / (double)bcount) * inv_enb;
 				}
 			}
 			break;
@@ -553,6 +553,37 @@ void avenger (  int av_mode,				// averaging mode
 			pixels[i] += (dOUTREAL)norm_oneHz;
 }
 
+void calc_pixout (DP a, int i)
+{
+	// geometry of pixel output 'i', computed the same way as for the total span
+	double span = (double)(a->num_stitch * (a->out_size - 1 - 2 * a->clip));
+	double L = a->fsclipL + a->po_clipL[i];
+	double H = a->fsclipH + a->po_clipH[i];
+	int n = a->po_num_pixels[i] > 0 ? a->po_num_pixels[i] : a->num_pixels;
+	if (n > dMAX_PIXELS) n = dMAX_PIXELS;
+	if (span - L - H < 2.0)		// nothing left to display, use the total span
+	{
+		L = a->fsclipL;
+		H = a->fsclipH;
+	}
+	a->po_pixels[i] = n;
+	a->po_fsclipL[i] = L;
+	a->po_fsclipH[i] = H;
+	a->po_first[i] = (int)L - (int)a->fsclipL;
+	a->po_skip[i] = (int)H - (int)a->fsclipH;
+	a->po_pix_per_bin[i] = (double)n / (span - L - H - 1.0);
+	a->po_det_offset[i] = -a->po_pix_per_bin[i] * (L - floor(L));
+	a->po_bin_per_pix[i] = (span - 1.0 - L - H) / ((double)n - 1.0);
+}
+
+int same_pixout (DP a, int i, int j)
+{
+	return (a->det_type[i] == a->det_type[j])
+		&& (a->po_pixels[i] == a->po_pixels[j])
+		&& (a->po_fsclipL[i] == a->po_fsclipL[j])
+		&& (a->po_fsclipH[i] == a->po_fsclipH[j]);
+}
+
 void stitch(int disp)
 {
 	DP a = pdisp[disp];
@@ -571,23 +602,23 @@ void stitch(int disp)
 	for (i = 0; i < a->num_pixout; i++)	// for each output
 	{
 		EnterCriticalSection(&a->ResampleSection);
-		// if a detection of the same 'det_type' has already been done, use that result
+		// if a detection of the same 'det_type' and geometry has already been done, use that result
 		j = i - 1;
 		k = i;
 		while (j >= 0)
 		{
-			if (a->det_type[i] == a->det_type[j])
+			if (same_pixout (a, i, j))
 				k = j;
 			j--;
 		}
 		if (k == i)
-			// detect
-			detector (a->det_type[i], m, a->num_pixels, a->pix_per_bin, a->bin_per_pix, a->pre_av_out, 
-				a->t_pixels[i], a->inv_enb, a->fsclipL, a->fsclipH, a->det_offset);
+			// detect, using the part of the stitched bins that belongs to this output
+			detector (a->det_type[i], m - a->po_first[i] - a->po_skip[i], a->po_pixels[i], a->po_pix_per_bin[i], a->po_bin_per_pix[i],
+				a->pre_av_out + a->po_first[i], a->t_pixels[i], a->inv_enb, a->po_fsclipL[i], a->po_fsclipH[i], a->po_det_offset[i]);
 		else
-			memcpy (a->t_pixels[i], a->t_pixels[k], a->num_pixels * sizeof (double));
+			memcpy (a->t_pixels[i], a->t_pixels[k], a->po_pixels[i] * sizeof (double));
 		// average & convert to dBm
-		avenger (a->av_mode[i], a->num_pixels, &a->avail_frames[i], a->num_average[i], &a->av_in_idx[i], &a->av_out_idx[i],
+		avenger (a->av_mode[i], a->po_pixels[i], &a->avail_frames[i], a->num_average[i], &a->av_in_idx[i], &a->av_out_idx[i],
 			a->av_backmult[i], a->scale, a->t_pixels[i], a->av_sum[i], a->av_buff[i], a->cd, a->normalize[i], a->norm_oneHz,
 			a->pixels[i][a->w_pix_buff[i]]);
 		LeaveCriticalSection(&a->ResampleSection);
@@ -1283,6 +1314,8 @@ void SetAnalyzer (	int disp,			// display identifier
 	a->pix_per_bin = (double)a->num_pixels / ((double)(a->num_stitch * (a->out_size - 1 - 2 * a->clip)) - a->fsclipL - a->fsclipH - 1.0);
 	a->det_offset = -a->pix_per_bin * (a->fsclipL - floor(a->fsclipL));
 	a->bin_per_pix = ((double)(a->num_stitch * (a->out_size - 1 - 2 * a->clip)) - 1.0 - a->fsclipL - a->fsclipH) / ((double)a->num_pixels - 1.0);
+	for (i = 0; i < dMAX_PIXOUTS; i++)
+		calc_pixout (a, i);
 
 	for (i = 0; i < dMAX_STITCH; i++)
 		for (j = 0; j < dMAX_NUM_FFT; j++)
@@ -1515,7 +1548,7 @@ void GetPixels	(	int disp,
 
 	if (_InterlockedAnd(&(a->pb_ready[pixout][a->r_pix_buff[pixout]]), 1))
 	{
-		memcpy (pix, a->pixels[pixout][a->r_pix_buff[pixout]], a->num_pixels * sizeof(dOUTREAL));
+		memcpy (pix, a->pixels[pixout][a->r_pix_buff[pixout]], a->po_pixels[pixout] * sizeof(dOUTREAL));
 		*flag = 1;
 		InterlockedBitTestAndReset(&(a->pb_ready[pixout][a->r_pix_buff[pixout]]), 0);
 	}
@@ -1852,6 +1885,30 @@ void SetDisplaySampleRate (int disp, int rate)
 	}
 }
 
+PORT
+void SetDisplayPixout (int disp, int pixout, int num_pixels, double clipL, double clipH)
+{
+	// Pixel output 'pixout' delivers 'num_pixels' values (0: the number given to SetAnalyzer())
+	// for the total span, reduced by 'clipL' and 'clipH' bins at its ends.  All outputs are
+	// made from the same fft results.  NOTE:  amplitude calibration assumes the total span.
+	DP a = pdisp[disp];
+	int j;
+	EnterCriticalSection (&a->ResampleSection);
+	a->po_num_pixels[pixout] = num_pixels;
+	a->po_clipL[pixout] = max (clipL, 0.0);
+	a->po_clipH[pixout] = max (clipH, 0.0);
+	if (a->num_pixels > 0)
+		calc_pixout (a, pixout);
+	a->avail_frames[pixout] = 0;
+	a->av_in_idx[pixout] = 0;
+	a->av_out_idx[pixout] = 0;
+	LeaveCriticalSection (&a->ResampleSection);
+	EnterCriticalSection (&a->PB_ControlsSection[pixout]);
+	for (j = 0; j < dNUM_PIXEL_BUFFS; j++)
+		a->pb_ready[pixout][j] = 0;
+	LeaveCriticalSection (&a->PB_ControlsSection[pixout]);
+}
+
 PORT
 void SetDisplayNormOneHz (int disp, int pixout, int norm)
 {
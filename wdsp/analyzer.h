@@ -136,6 +136,19 @@ typedef struct _dp
 	int sample_rate;										// sample rate; used for normalization calculations
 	int normalize[dMAX_PIXOUTS];
 
+	// per-output pixel geometry, all outputs are fed from the same fft bins
+	int po_num_pixels[dMAX_PIXOUTS];						// requested number of pixels, 0 to use num_pixels
+	double po_clipL[dMAX_PIXOUTS];							// bins to clip from the low end, in addition to fsclipL
+	double po_clipH[dMAX_PIXOUTS];							// bins to clip from the high end, in addition to fsclipH
+	int po_pixels[dMAX_PIXOUTS];							// current number of pixels of the output
+	int po_first[dMAX_PIXOUTS];								// index of the first stitched bin used by the output
+	int po_skip[dMAX_PIXOUTS];								// number of stitched bins skipped at the high end
+	double po_fsclipL[dMAX_PIXOUTS];						// total clip of the low end of the output
+	double po_fsclipH[dMAX_PIXOUTS];						// total clip of the high end of the output
+	double po_pix_per_bin[dMAX_PIXOUTS];
+	double po_det_offset[dMAX_PIXOUTS];
+	double po_bin_per_pix[dMAX_PIXOUTS];
+
 	// BEGIN CODE TO GET MAX FFT_BIN WITHIN A FREQUENCY RANGE
 	int dmb_run;
 	int dmb_disp;
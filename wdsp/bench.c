@@ -0,0 +1,565 @@
+/* Copyright (C)
+* 2026 - Christoph van Wüllen, DL1YCF
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/********************************************************************************************************
+*                                                                                                       *
+*  wdsp-bench: offline benchmark of the WDSP library                                                   *
+*                                                                                                       *
+*  Usage:  wdsp-bench config-file [config-file ...]                                                     *
+*          wdsp-bench -compare reference-file test-file [min-snr-db]                                    *
+*                                                                                                       *
+*  Each config file describes one benchmark run. IQ samples (either synthetic, or from a file with     *
+*  raw interleaved 32-bit float I/Q samples) are pushed through a RXA channel with fexchange0 as fast    *
+*  as possible, and optionally a synthetic two-tone microphone signal through a TXA channel.            *
+*  The synthetic signal is generated with a fixed seed, so results are reproducible. One result line   *
+*  per channel is printed to stdout, in a format that is easy to compare between runs.                  *
+*                                                                                                       *
+*  Config file format: "key = value" lines, '#' starts a comment. Keys and defaults:                   *
+*                                                                                                       *
+*  input   = synthetic      IQ source: "synthetic" or name of a raw float32 I/Q file (looped if short) *
+*  rate    = 192000         RX input sample rate                                                        *
+*  buffer  = 1024           fexchange0 buffer size (complex samples)                                    *
+*  dsp     = 2048           WDSP dsp buffer size                                                        *
+*  seconds = 60             amount of signal (in seconds) to process                                    *
+*  mode    = USB            LSB, USB, DSB, CWL, CWU, FM, AM, DIGU, SPEC, DIGL, SAM, DRM                 *
+*  low     = (mode)         filter low edge (Hz), default depends on mode                               *
+*  high    = (mode)         filter high edge (Hz), default depends on mode                              *
+*  agc     = 3              AGC mode (0=off, 1=long, 2=slow, 3=med, 4=fast)                             *
+*  nb      = 0              noise blanker (0=off, 1=NB, 2=NB2)                                          *
+*  nr      = 0              noise reduction (0=off, 1=NR, 2=NR2)                                        *
+*  anf     = 0              automatic notch filter (0/1)                                                *
+*  snb     = 0              spectral noise blanker (0/1)                                                *
+*  tx      = 0              also run the TX chain (0/1)                                                 *
+*  txrate  = 192000         TX IQ output sample rate                                                    *
+*  txbuffer= 1024           TX fexchange0 buffer size (microphone samples at 48 kHz)                    *
+*  comp    = 0              TX speech compressor (0/1)                                                  *
+*  wisdom  = ./             directory of the FFTW wisdom file                                           *
+*  profile = 1              print the time spent in each stage of xrxa/xtxa (0/1)                      *
+*  output  = (none)         write the RX audio (float32, L/R interleaved) to this file                  *
+*  fastmath= 0              use the approximate log/exp/sqrt functions (SetWDSPFastMath, 0/1)           *
+*                                                                                                       *
+*  With -compare, two RX audio output files (e.g. from a double and a WDSP_REAL=float build) are       *
+*  compared, and the SNR of the reference against the difference is printed. The exit code is 1 if     *
+*  the SNR is below min-snr-db (default: 60 dB).                                                       *
+*                                                                                                       *
+*  The average S-meter and AGC gain readings are printed with the RX results, such that the meter      *
+*  deviation of a fastmath=1 run against a fastmath=0 run can be checked along with the audio.          *
+*                                                                                                       *
+********************************************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "wdsp.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define CH_RX 0
+#define CH_TX 1
+
+typedef struct _bench
+{
+	char input[256];
+	int rate;
+	int buffer;
+	int dsp;
+	double seconds;
+	int mode;
+	double low;
+	double high;
+	int have_filter;
+	int agc;
+	int nb;
+	int nr;
+	int anf;
+	int snb;
+	int tx;
+	int txrate;
+	int txbuffer;
+	int comp;
+	char wisdom[256];
+	int profile;
+	char output[256];
+	int fastmath;
+} bench, *BENCH;
+
+// same numbering as enum rxaMode in RXA.h
+static const char *mode_names[] = { "LSB", "USB", "DSB", "CWL", "CWU", "FM", "AM", "DIGU", "SPEC", "DIGL", "SAM", "DRM" };
+
+static double now_usec (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return 1.0e6 * ts.tv_sec + 1.0e-3 * ts.tv_nsec;
+}
+
+static void set_defaults (BENCH b)
+{
+	memset (b, 0, sizeof (bench));
+	strcpy (b->input, "synthetic");
+	b->rate = 192000;
+	b->buffer = 1024;
+	b->dsp = 2048;
+	b->seconds = 60.0;
+	b->mode = 1;
+	b->agc = 3;
+	b->txrate = 192000;
+	b->txbuffer = 1024;
+	strcpy (b->wisdom, "./");
+	b->profile = 1;
+}
+
+static void default_filter (BENCH b)
+{
+	switch (b->mode)
+	{
+	case 0:  b->low = -2850.0; b->high = -150.0; break;	// LSB
+	case 1:  b->low =   150.0; b->high = 2850.0; break;	// USB
+	case 3:  b->low =  -850.0; b->high = -350.0; break;	// CWL
+	case 4:  b->low =   350.0; b->high =  850.0; break;	// CWU
+	case 5:  b->low = -8000.0; b->high = 8000.0; break;	// FM
+	case 7:  b->low =     0.0; b->high = 3000.0; break;	// DIGU
+	case 9:  b->low = -3000.0; b->high =    0.0; break;	// DIGL
+	default: b->low = -4000.0; b->high = 4000.0; break;	// DSB, AM, SAM, SPEC, DRM
+	}
+}
+
+static int read_config (const char *filename, BENCH b)
+{
+	FILE *fp;
+	char line[512], key[64], value[256];
+	int lineno = 0;
+	set_defaults (b);
+	if ((fp = fopen (filename, "r")) == NULL)
+	{
+		perror (filename);
+		return -1;
+	}
+	while (fgets (line, sizeof (line), fp) != NULL)
+	{
+		char *p;
+		lineno++;
+		if ((p = strchr (line, '#')) != NULL) *p = 0;
+		if ((p = strchr (line, '=')) != NULL) *p = ' ';
+		if (sscanf (line, "%63s %255s", key, value) != 2) continue;
+		if      (!strcmp (key, "input"))    snprintf (b->input, sizeof (b->input), "%s", value);
+		else if (!strcmp (key, "rate"))     b->rate = atoi (value);
+		else if (!strcmp (key, "buffer"))   b->buffer = atoi (value);
+		else if (!strcmp (key, "dsp"))      b->dsp = atoi (value);
+		else if (!strcmp (key, "seconds"))  b->seconds = atof (value);
+		else if (!strcmp (key, "low"))      { b->low = atof (value); b->have_filter |= 1; }
+		else if (!strcmp (key, "high"))     { b->high = atof (value); b->have_filter |= 2; }
+		else if (!strcmp (key, "agc"))      b->agc = atoi (value);
+		else if (!strcmp (key, "nb"))       b->nb = atoi (value);
+		else if (!strcmp (key, "nr"))       b->nr = atoi (value);
+		else if (!strcmp (key, "anf"))      b->anf = atoi (value);
+		else if (!strcmp (key, "snb"))      b->snb = atoi (value);
+		else if (!strcmp (key, "tx"))       b->tx = atoi (value);
+		else if (!strcmp (key, "txrate"))   b->txrate = atoi (value);
+		else if (!strcmp (key, "txbuffer")) b->txbuffer = atoi (value);
+		else if (!strcmp (key, "comp"))     b->comp = atoi (value);
+		else if (!strcmp (key, "wisdom"))   snprintf (b->wisdom, sizeof (b->wisdom), "%s", value);
+		else if (!strcmp (key, "profile"))  b->profile = atoi (value);
+		else if (!strcmp (key, "fastmath")) b->fastmath = atoi (value);
+		else if (!strcmp (key, "output"))   snprintf (b->output, sizeof (b->output), "%s", value);
+		else if (!strcmp (key, "mode"))
+		{
+			int i, n = sizeof (mode_names) / sizeof (mode_names[0]);
+			for (i = 0; i < n; i++)
+				if (!strcasecmp (value, mode_names[i])) break;
+			if (i == n)
+			{
+				fprintf (stderr, "%s:%d: unknown mode %s\n", filename, lineno, value);
+				fclose (fp);
+				return -1;
+			}
+			b->mode = i;
+		}
+		else
+		{
+			fprintf (stderr, "%s:%d: unknown key %s\n", filename, lineno, key);
+			fclose (fp);
+			return -1;
+		}
+	}
+	fclose (fp);
+	if (b->have_filter != 3)
+	{
+		double low = b->low, high = b->high;
+		int have = b->have_filter;
+		default_filter (b);
+		if (have & 1) b->low = low;
+		if (have & 2) b->high = high;
+	}
+	if (b->rate < 48000 || b->rate % 48000 || b->buffer < 64 || b->dsp < 64 ||
+		b->txrate < 48000 || b->txrate % 48000 || b->txbuffer < 64 || b->seconds <= 0.0)
+	{
+		fprintf (stderr, "%s: invalid sample rate, buffer size or duration\n", filename);
+		return -1;
+	}
+	return 0;
+}
+
+/********************************************************************************************************
+*                                                                                                       *
+*                                          Signal Sources                                              *
+*                                                                                                       *
+********************************************************************************************************/
+
+typedef struct _source
+{
+	FILE *fp;
+	float *fbuff;
+	unsigned int seed;
+	double phase[3];
+	double dphase[3];
+	double amp[3];
+	long count;
+	int pulse;
+} source, *SOURCE;
+
+// deterministic pseudo-random numbers, uniform in [-1, 1)
+static double noise (SOURCE s)
+{
+	s->seed = 1664525u * s->seed + 1013904223u;
+	return (double)(s->seed >> 8) / 8388608.0 - 1.0;
+}
+
+static int open_source (SOURCE s, BENCH b)
+{
+	memset (s, 0, sizeof (source));
+	s->seed = 12345;
+	if (strcmp (b->input, "synthetic"))
+	{
+		if ((s->fp = fopen (b->input, "rb")) == NULL)
+		{
+			perror (b->input);
+			return -1;
+		}
+		s->fbuff = (float *) malloc (b->buffer * 2 * sizeof (float));
+	}
+	else
+	{
+		// an S9 carrier and two weak ones in the passband, plus noise and
+		// impulses every 10 msec to give the noise blankers some work.
+		s->dphase[0] = 2.0 * M_PI * 1000.0 / b->rate;
+		s->dphase[1] = 2.0 * M_PI * 1700.0 / b->rate;
+		s->dphase[2] = 2.0 * M_PI * -2300.0 / b->rate;
+		s->amp[0] = 0.01;
+		s->amp[1] = 0.0001;
+		s->amp[2] = 0.0003;
+		s->pulse = b->rate / 100;
+	}
+	return 0;
+}
+
+static void close_source (SOURCE s)
+{
+	if (s->fp) fclose (s->fp);
+	free (s->fbuff);
+}
+
+static int fill_source (SOURCE s, double *iq, int n)
+{
+	int i, j, got;
+	if (s->fp)
+	{
+		got = (int) fread (s->fbuff, 2 * sizeof (float), n, s->fp);
+		if (got < n)
+		{
+			rewind (s->fp);
+			got += (int) fread (s->fbuff + 2 * got, 2 * sizeof (float), n - got, s->fp);
+			if (got < n) return -1;
+		}
+		for (i = 0; i < 2 * n; i++)
+			iq[i] = (double) s->fbuff[i];
+		return 0;
+	}
+	for (i = 0; i < n; i++)
+	{
+		double I = 1.0e-5 * noise (s);
+		double Q = 1.0e-5 * noise (s);
+		for (j = 0; j < 3; j++)
+		{
+			I += s->amp[j] * cos (s->phase[j]);
+			Q += s->amp[j] * sin (s->phase[j]);
+			s->phase[j] += s->dphase[j];
+			if (s->phase[j] >  M_PI) s->phase[j] -= 2.0 * M_PI;
+			if (s->phase[j] < -M_PI) s->phase[j] += 2.0 * M_PI;
+		}
+		if (s->count++ % s->pulse < 3)
+		{
+			I += 0.5;
+			Q -= 0.5;
+		}
+		iq[2 * i + 0] = I;
+		iq[2 * i + 1] = Q;
+	}
+	return 0;
+}
+
+/********************************************************************************************************
+*                                                                                                       *
+*                                            Benchmarks                                                *
+*                                                                                                       *
+********************************************************************************************************/
+
+typedef struct _result
+{
+	long samples;
+	long calls;
+	long errors;
+	double total;		// usec
+	double max;			// usec
+	double s_meter;		// sum of the S-meter readings (dB)
+	double agc_gain;	// sum of the AGC gain readings (dB)
+} result;
+
+static void report (const char *name, const char *what, int rate, result *r)
+{
+	double sec = 1.0e-6 * r->total;
+	double signal = (double) r->samples / rate;
+	printf ("%s %s: %ld samples in %.3f s, %.0f samples/s, realtime factor %.1f, "
+		"fexchange0 avg %.1f us max %.1f us, errors %ld\n",
+		name, what, r->samples, sec, sec > 0.0 ? r->samples / sec : 0.0,
+		sec > 0.0 ? signal / sec : 0.0, r->calls ? r->total / r->calls : 0.0, r->max, r->errors);
+}
+
+static void report_stages (const char *name, const char *what, int channel, int tx)
+{
+	double avg[64], peak[64], sum = 0.0;
+	int i, n;
+	n = tx ? GetTXAStageTimes (channel, avg, peak, 64) : GetRXAStageTimes (channel, avg, peak, 64);
+	for (i = 0; i < n; i++)
+		sum += avg[i];
+	for (i = 0; i < n; i++)
+		printf ("%s %s stage %-24s avg %9.2f us  max %9.2f us  %5.1f%%\n", name, what,
+			tx ? GetTXAStageName (i) : GetRXAStageName (i), avg[i], peak[i],
+			sum > 0.0 ? 100.0 * avg[i] / sum : 0.0);
+}
+
+static void exchange (int channel, double *in, double *out, result *r, int n)
+{
+	int error;
+	double t0 = now_usec ();
+	fexchange0 (channel, in, out, &error);
+	double dt = now_usec () - t0;
+	r->total += dt;
+	if (dt > r->max) r->max = dt;
+	if (error) r->errors++;
+	r->calls++;
+	r->samples += n;
+}
+
+static int bench_rx (const char *name, BENCH b)
+{
+	source src;
+	result r;
+	double *iq, *audio;
+	float *fout = NULL;
+	FILE *out = NULL;
+	long total = (long)(b->seconds * b->rate);
+	int i, outsize = b->buffer / (b->rate / 48000);
+	if (open_source (&src, b) < 0) return -1;
+	if (b->output[0])
+	{
+		if ((out = fopen (b->output, "wb")) == NULL)
+		{
+			perror (b->output);
+			close_source (&src);
+			return -1;
+		}
+		fout = (float *) malloc (outsize * 2 * sizeof (float));
+	}
+	iq    = (double *) malloc (b->buffer * 2 * sizeof (double));
+	audio = (double *) malloc (b->buffer * 2 * sizeof (double));
+	OpenChannel (CH_RX, b->buffer, b->dsp, b->rate, 48000, 48000, 0, 1, 0.010, 0.025, 0.0, 0.010, 1);
+	create_anbEXT (CH_RX, b->nb == 1, b->buffer, b->rate, 0.0001, 0.0001, 0.0001, 0.05, 20);
+	create_nobEXT (CH_RX, b->nb == 2, 0, b->buffer, b->rate, 0.0001, 0.0001, 0.0001, 0.05, 20);
+	SetRXABandpassWindow (CH_RX, 1);
+	SetRXABandpassRun (CH_RX, 1);
+	SetRXAPanelRun (CH_RX, 1);
+	SetRXAPanelSelect (CH_RX, 3);
+	SetRXAMode (CH_RX, b->mode);
+	RXASetPassband (CH_RX, b->low, b->high);
+	SetRXAAGCMode (CH_RX, b->agc);
+	SetRXAANRRun (CH_RX, b->nr == 1);
+	SetRXAEMNRRun (CH_RX, b->nr == 2);
+	SetRXAANFRun (CH_RX, b->anf);
+	SetRXASNBARun (CH_RX, b->snb);
+	SetChannelProfileRun (CH_RX, b->profile);
+	memset (&r, 0, sizeof (r));
+	while (r.samples < total)
+	{
+		if (fill_source (&src, iq, b->buffer) < 0)
+		{
+			fprintf (stderr, "%s: input file %s too short\n", name, b->input);
+			break;
+		}
+		// the noise blankers run outside the channel, as in piHPSDR
+		if (b->nb == 1) xanbEXT (CH_RX, iq, iq);
+		if (b->nb == 2) xnobEXT (CH_RX, iq, iq);
+		exchange (CH_RX, iq, audio, &r, b->buffer);
+		r.s_meter  += GetRXAMeter (CH_RX, RXA_S_AV);
+		r.agc_gain += GetRXAMeter (CH_RX, RXA_AGC_GAIN);
+		if (out)
+		{
+			for (i = 0; i < 2 * outsize; i++)
+				fout[i] = (float) audio[i];
+			fwrite (fout, sizeof (float), 2 * outsize, out);
+		}
+	}
+	SetChannelState (CH_RX, 0, 1);
+	SetChannelProfileRun (CH_RX, 0);
+	report (name, "RX", b->rate, &r);
+	if (r.calls)
+		printf ("%s RX meters: S-meter avg %.4f dB, AGC gain avg %.4f dB\n",
+			name, r.s_meter / r.calls, r.agc_gain / r.calls);
+	if (b->profile) report_stages (name, "RX", CH_RX, 0);
+	destroy_anbEXT (CH_RX);
+	destroy_nobEXT (CH_RX);
+	CloseChannel (CH_RX);
+	if (out)
+	{
+		fclose (out);
+		free (fout);
+	}
+	free (iq);
+	free (audio);
+	close_source (&src);
+	return 0;
+}
+
+static int compare (const char *ref, const char *test, double min_snr)
+{
+	FILE *f1, *f2;
+	float x, y;
+	double sig = 0.0, err = 0.0, snr;
+	long n = 0;
+	f1 = fopen (ref, "rb");
+	f2 = fopen (test, "rb");
+	if (f1 == NULL || f2 == NULL)
+	{
+		perror (f1 == NULL ? ref : test);
+		if (f1) fclose (f1);
+		if (f2) fclose (f2);
+		return 1;
+	}
+	while (fread (&x, sizeof (float), 1, f1) == 1 && fread (&y, sizeof (float), 1, f2) == 1)
+	{
+		sig += (double)x * x;
+		err += (double)(x - y) * (x - y);
+		n++;
+	}
+	fclose (f1);
+	fclose (f2);
+	if (n == 0 || sig == 0.0)
+	{
+		fprintf (stderr, "compare: no signal in %s\n", ref);
+		return 1;
+	}
+	snr = err > 0.0 ? 10.0 * log10 (sig / err) : 999.0;
+	printf ("compare: %ld samples, SNR %.1f dB (minimum %.1f dB): %s\n", n, snr, min_snr,
+		snr >= min_snr ? "PASS" : "FAIL");
+	return snr >= min_snr ? 0 : 1;
+}
+
+static int bench_tx (const char *name, BENCH b)
+{
+	result r;
+	double *mic, *iq;
+	double phase1 = 0.0, phase2 = 0.0;
+	long total = (long)(b->seconds * 48000);
+	int i, outsize = b->txbuffer * (b->txrate / 48000);
+	mic = (double *) malloc (b->txbuffer * 2 * sizeof (double));
+	iq  = (double *) malloc (outsize * 2 * sizeof (double));
+	OpenChannel (CH_TX, b->txbuffer, b->dsp, 48000, 96000, b->txrate, 1, 0, 0.010, 0.025, 0.0, 0.010, 1);
+	SetTXAMode (CH_TX, b->mode);
+	SetTXABandpassFreqs (CH_TX, b->low, b->high);
+	SetTXABandpassWindow (CH_TX, 1);
+	SetTXABandpassRun (CH_TX, 1);
+	SetTXAPanelRun (CH_TX, 1);
+	SetTXACompressorRun (CH_TX, b->comp);
+	SetChannelProfileRun (CH_TX, b->profile);
+	SetChannelState (CH_TX, 1, 0);
+	memset (&r, 0, sizeof (r));
+	while (r.samples < total)
+	{
+		// two-tone microphone signal (700 Hz and 1900 Hz)
+		for (i = 0; i < b->txbuffer; i++)
+		{
+			mic[2 * i + 0] = 0.25 * (sin (phase1) + sin (phase2));
+			mic[2 * i + 1] = 0.0;
+			phase1 += 2.0 * M_PI * 700.0 / 48000.0;
+			phase2 += 2.0 * M_PI * 1900.0 / 48000.0;
+			if (phase1 > M_PI) phase1 -= 2.0 * M_PI;
+			if (phase2 > M_PI) phase2 -= 2.0 * M_PI;
+		}
+		exchange (CH_TX, mic, iq, &r, b->txbuffer);
+	}
+	SetChannelState (CH_TX, 0, 1);
+	SetChannelProfileRun (CH_TX, 0);
+	report (name, "TX", 48000, &r);
+	if (b->profile) report_stages (name, "TX", CH_TX, 1);
+	CloseChannel (CH_TX);
+	free (mic);
+	free (iq);
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	bench b;
+	int i, rc = 0;
+	if (argc >= 4 && !strcmp (argv[1], "-compare"))
+		return compare (argv[2], argv[3], argc > 4 ? atof (argv[4]) : 60.0);
+	if (argc < 2)
+	{
+		fprintf (stderr, "Usage: %s config-file [config-file ...]\n", argv[0]);
+		fprintf (stderr, "       %s -compare reference-file test-file [min-snr-db]\n", argv[0]);
+		return 1;
+	}
+	for (i = 1; i < argc; i++)
+	{
+		if (read_config (argv[i], &b) < 0)
+		{
+			rc = 1;
+			continue;
+		}
+		// FFTW planning is done once and is not part of the measurement
+		WDSPwisdom (b.wisdom);
+		SetWDSPFastMath (b.fastmath);
+		printf ("%s config: input=%s rate=%d buffer=%d dsp=%d mode=%s filter=%.0f:%.0f agc=%d nb=%d nr=%d anf=%d snb=%d fastmath=%d\n",
+			argv[i], b.input, b.rate, b.buffer, b.dsp, mode_names[b.mode], b.low, b.high,
+			b.agc, b.nb, b.nr, b.anf, b.snb, b.fastmath);
+		if (bench_rx (argv[i], &b) < 0) rc = 1;
+		if (b.tx)
+		{
+			printf ("%s config: txrate=%d txbuffer=%d comp=%d\n", argv[i], b.txrate, b.txbuffer, b.comp);
+			if (bench_tx (argv[i], &b) < 0) rc = 1;
+		}
+		fflush (stdout);
+	}
+	return rc;
+}
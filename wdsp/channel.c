@@ -28,6 +28,25 @@ warren@wpratt.com
 
 struct _ch ch[MAX_CHANNELS];
 
+//
+// Optional call-back, invoked by each channel thread when it starts,
+// such that the application can set CPU affinity and scheduling
+// priority of the DSP threads.
+//
+static void (*thread_callback)(int channel, int type) = NULL;
+
+PORT
+void SetChannelThreadCallback (void (*callback)(int channel, int type))
+{
+	thread_callback = callback;
+}
+
+void channel_thread_start (int channel)
+{
+	if (thread_callback != NULL)
+		(*thread_callback)(channel, ch[channel].type);
+}
+
 void start_thread (int channel)
 {
 	HANDLE handle = (HANDLE) _beginthread(wdspmain, 0, (void *)(uintptr_t)channel);
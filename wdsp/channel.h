@@ -81,4 +81,8 @@ PORT void SetAllRates (int channel, int in_rate, int dsp_rate, int out_rate);
 
 PORT int SetChannelState (int channel, int state, int dmode);
 
+PORT void SetChannelThreadCallback (void (*callback)(int channel, int type));
+
+extern void channel_thread_start (int channel);
+
 #endif
\ No newline at end of file
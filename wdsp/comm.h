@@ -45,6 +45,18 @@ warren@wpratt.com
 #endif
 #include "fftw3.h"
 
+// Precision of the fast-convolution filters (fircore). With WDSP_REAL=float
+// in the Makefile, these use single-precision buffers and FFTs (fftw3f),
+// everything else (and all interfaces) stays double.
+#ifdef WDSP_REAL_FLOAT
+typedef float real;
+#define FFTW(name)						fftwf_##name
+#else
+typedef double real;
+#define FFTW(name)						fftw_##name
+#endif
+typedef real rcomplex[2];
+
 #include "amd.h"
 #include "ammod.h"
 #include "amsq.h"
@@ -65,6 +77,7 @@ warren@wpratt.com
 #include "emnr.h"
 #include "emph.h"
 #include "eq.h"
+#include "fastmath.h"
 #include "fcurve.h"
 #include "fir.h"
 #include "firmin.h"
@@ -83,10 +96,12 @@ warren@wpratt.com
 #include "meter.h"
 #include "meterlog10.h"
 #include "nbp.h"
+#include "nco.h"
 #include "nob.h"
 #include "nobII.h"
 #include "osctrl.h"
 #include "patchpanel.h"
+#include "profile.h"
 #include "resample.h"
 #include "rmatch.h"
 #include "RXA.h"
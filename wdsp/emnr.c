@@ -63,7 +63,7 @@ double bessI0 (double x)
 		else
 		{
 			p = 3.75 / x;
-			res = exp (x) / sqrt (x)
+			res = FM_EXP (x) / FM_SQRT (x)
 				  * (((((((( + 0.00392377  * p
 						     - 0.01647633) * p
 						     + 0.02635537) * p
@@ -103,7 +103,7 @@ double bessI1 (double x)
 		else
 		{
 			p = 3.75 / x;
-			res = exp (x) / sqrt (x)
+			res = FM_EXP (x) / FM_SQRT (x)
 				  * (((((((( - 0.00420059  * p
 						     + 0.01787654) * p
 						     - 0.02895312) * p
@@ -144,7 +144,7 @@ double e1xb (double x)
         }
 
         ga = 0.5772156649015328;
-        e1 = - ga - log (x) + x * e1;
+        e1 = - ga - FM_LN (x) + x * e1;
 	}
       else
 	{
@@ -153,7 +153,7 @@ double e1xb (double x)
         for (k = m; k >= 1; k--)
 			t0 = (double)k / (1.0 + k / (x + t0));
         t = 1.0 / (x + t0);
-        e1 = exp (- x) * t;
+        e1 = FM_EXP (- x) * t;
 	}
     return e1;
 }
@@ -689,7 +689,7 @@ void LambdaD(EMNR a)
 		a->np.alphaOptHat[k] = 1.0 / (1.0 + f0 * f0);
 	}
 	SNR = sum_prev_p / sum_prev_sigma2N;
-	alphaMin = min (a->np.alphaMin_max_value, pow (SNR, a->np.snrq));
+	alphaMin = min (a->np.alphaMin_max_value, FM_POW (SNR, a->np.snrq));
 	for (k = 0; k < a->np.msize; k++)
 		if (a->np.alphaOptHat[k] < alphaMin) a->np.alphaOptHat[k] = alphaMin;
 	f1 = sum_prev_p / sum_lambda_y - 1.0;
@@ -787,9 +787,21 @@ void LambdaD(EMNR a)
 void LambdaDs (EMNR a)
 {
 	int k;
+	if (wdsp_fastmath)
+	{
+		for (k = 0; k < a->nps.msize; k++)
+			a->nps.PH1y[k] = - a->nps.epsH1r * a->nps.lambda_y[k] / a->nps.sigma2N[k];
+		mexpv (a->nps.msize, a->nps.PH1y, a->nps.PH1y);
+		for (k = 0; k < a->nps.msize; k++)
+			a->nps.PH1y[k] = 1.0 / (1.0 + (1.0 + a->nps.epsH1) * a->nps.PH1y[k]);
+	}
+	else
+	{
+		for (k = 0; k < a->nps.msize; k++)
+			a->nps.PH1y[k] = 1.0 / (1.0 + (1.0 + a->nps.epsH1) * exp (- a->nps.epsH1r * a->nps.lambda_y[k] / a->nps.sigma2N[k]));
+	}
 	for (k = 0; k < a->nps.msize; k++)
 	{
-		a->nps.PH1y[k] = 1.0 / (1.0 + (1.0 + a->nps.epsH1) * exp (- a->nps.epsH1r * a->nps.lambda_y[k] / a->nps.sigma2N[k]));
 		a->nps.Pbar[k] = a->nps.alpha_Pbar * a->nps.Pbar[k] + (1.0 - a->nps.alpha_Pbar) * a->nps.PH1y[k];
 		if (a->nps.Pbar[k] > 0.99)
 			a->nps.PH1y[k] = min (a->nps.PH1y[k], 0.99);
@@ -891,7 +903,7 @@ double getKey(double* type, double gamma, double xi)
 	}
 	else
 	{
-		tg = 10.0 * log10(gamma / dmin);
+		tg = 10.0 * FM_LOG10(gamma / dmin);
 		ngamma1 = (int)(4.0 * tg);
 		ngamma2 = ngamma1 + 1;
 	}
@@ -907,7 +919,7 @@ double getKey(double* type, double gamma, double xi)
 	}
 	else
 	{
-		tx = 10.0 * log10(xi / dmin);
+		tx = 10.0 * FM_LOG10(xi / dmin);
 		nxi1 = (int)(4.0 * tx);
 		nxi2 = nxi1 + 1;
 	}
@@ -972,13 +984,13 @@ void calc_gain (EMNR a)
 					+ (1.0 - a->g.alpha) * max (gamma - 1.0, a->g.eps_floor);
 				eps_hat = max(eps_hat, a->g.xi_min);
 				v = (eps_hat / (1.0 + eps_hat)) * gamma;
-				a->g.mask[k] = a->g.gf1p5 * sqrt (v) / gamma * exp (- 0.5 * v)
+				a->g.mask[k] = a->g.gf1p5 * FM_SQRT (v) / gamma * FM_EXP (- 0.5 * v)
 					* ((1.0 + v) * bessI0 (0.5 * v) + v * bessI1 (0.5 * v));
 				{
 					double v2 = min (v, 700.0);
 					double eta = a->g.mask[k] * a->g.mask[k] * a->g.lambda_y[k] / a->g.lambda_d[k];
 					double eps = eta / (1.0 - a->g.q);
-					double witchHat = (1.0 - a->g.q) / a->g.q * exp (v2) / (1.0 + eps);
+					double witchHat = (1.0 - a->g.q) / a->g.q * FM_EXP (v2) / (1.0 + eps);
 					a->g.mask[k] *= witchHat / (1.0 + witchHat);
 				}
 				if (a->g.mask[k] > a->g.gmax) a->g.mask[k] = a->g.gmax;
@@ -998,7 +1010,7 @@ void calc_gain (EMNR a)
 					+ (1.0 - a->g.alpha) * max (gamma - 1.0, a->g.eps_floor);
 				ehr = eps_hat / (1.0 + eps_hat);
 				v = ehr * gamma;
-				if((a->g.mask[k] = ehr * exp (min (700.0, 0.5 * e1xb(v)))) > a->g.gmax) a->g.mask[k] = a->g.gmax;
+				if((a->g.mask[k] = ehr * FM_EXP (min (700.0, 0.5 * e1xb(v)))) > a->g.gmax) a->g.mask[k] = a->g.gmax;
 				if (a->g.mask[k] != a->g.mask[k])a->g.mask[k] = 0.01;
 				a->g.prev_gamma[k] = gamma;
 				a->g.prev_mask[k] = a->g.mask[k];
@@ -1030,13 +1042,13 @@ void calc_gain (EMNR a)
 					+ (1.0 - a->g.alpha) * max(gamma - 1.0, a->g.eps_floor);
 				xi_hat = max(xi_hat, a->g.xi_min);
 				v = (xi_hat / (1.0 + xi_hat)) * gamma;
-				a->g.mask[k] = a->g.gf1p5 * sqrt(v) / gamma * exp(-0.5 * v)
+				a->g.mask[k] = a->g.gf1p5 * FM_SQRT(v) / gamma * FM_EXP(-0.5 * v)
 					* ((1.0 + v) * bessI0(0.5 * v) + v * bessI1(0.5 * v));
 				{
 					double v2 = min(v, 700.0);
 					double eta = a->g.mask[k] * a->g.mask[k] * a->g.lambda_y[k] / a->g.lambda_d[k];
 					double eps = eta / (1.0 - a->g.q);
-					double witchHat = (1.0 - a->g.q) / a->g.q * exp(v2) / (1.0 + eps);
+					double witchHat = (1.0 - a->g.q) / a->g.q * FM_EXP(v2) / (1.0 + eps);
 					a->g.mask[k] *= witchHat / (1.0 + witchHat);
 				}
 				if (a->g.mask[k] > a->g.gmax) a->g.mask[k] = a->g.gmax;
@@ -1048,12 +1060,12 @@ void calc_gain (EMNR a)
 					double xi_ts = a->g.mask[k] * a->g.mask[k] * gamma;
 					xi_ts = max(xi_ts, a->g.xi_min);
 					double v_ts = (xi_ts / (1.0 + xi_ts)) * gamma;
-					a->g.mask[k] = a->g.gf1p5 * sqrt(v_ts) / gamma * exp(-0.5 * v_ts)
+					a->g.mask[k] = a->g.gf1p5 * FM_SQRT(v_ts) / gamma * FM_EXP(-0.5 * v_ts)
 						* ((1.0 + v_ts) * bessI0(0.5 * v_ts) + v_ts * bessI1(0.5 * v_ts));
 					double v2 = min(v_ts, 700.0);
 					double eta = a->g.mask[k] * a->g.mask[k] * a->g.lambda_y[k] / a->g.lambda_d[k];
 					double eps = eta / (1.0 - a->g.q);
-					double witchHat = (1.0 - a->g.q) / a->g.q * exp(v2) / (1.0 + eps);
+					double witchHat = (1.0 - a->g.q) / a->g.q * FM_EXP(v2) / (1.0 + eps);
 					a->g.mask[k] *= witchHat / (1.0 + witchHat);
 					xi_hat = xi_ts;
 				}
@@ -0,0 +1,84 @@
+/*  fastmath.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Christoph van Wuellen, DL1YCF
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#if defined(__GNUC__) && !defined(__clang__)
+// the selects in the fast functions are only turned into vector blends
+// if comparisons are not considered to trap
+#pragma GCC optimize ("no-trapping-math")
+#endif
+
+#include "comm.h"
+
+int wdsp_fastmath = 0;
+
+/********************************************************************************************************
+*                                                                                                       *
+*                                           Batch Versions                                              *
+*                                                                                                       *
+********************************************************************************************************/
+
+void mlog10pv (int n, double* in, double* out)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		out[i] = mlog10p (in[i]);
+}
+
+void mexpv (int n, double* in, double* out)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		out[i] = mexp (in[i]);
+}
+
+void mpow10v (int n, double* in, double* out)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		out[i] = mpow10 (in[i]);
+}
+
+void msqrtv (int n, double* in, double* out)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		out[i] = msqrt (in[i]);
+}
+
+/********************************************************************************************************
+*                                                                                                       *
+*                                             Properties                                                *
+*                                                                                                       *
+********************************************************************************************************/
+
+PORT
+void SetWDSPFastMath (int run)
+{
+	// takes effect with the next buffer, the flag is tested in the loops
+	wdsp_fastmath = (run != 0);
+}
+
+PORT
+int GetWDSPFastMath (void)
+{
+	return wdsp_fastmath;
+}
@@ -0,0 +1,132 @@
+/*  fastmath.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Christoph van Wuellen, DL1YCF
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                                                                       *
+*  Fast approximations of log, exp and sqrt for the per-sample and per-bin loops.                       *
+*                                                                                                       *
+*  Maximum errors (measured over the full argument range given):                                        *
+*                                                                                                       *
+*    mlog10  (x)  table (meterlog10.c), x > 0          absolute error < 2.2e-04 (0.002 dB at 10*log10)  *
+*    mln     (x)  polynomial, x > 0 (normalized)       absolute error < 2.0e-11                         *
+*    mlog10p (x)  mln (x) / ln (10)                    absolute error < 1.0e-11                         *
+*    mexp    (x)  polynomial, -708 <= x <= 709         relative error < 3.0e-10, 0.0 for x < -708       *
+*    mpow10  (x)  mexp (x * ln (10)), -307 <= x <= 307 relative error < 3.0e-10                         *
+*    msqrt   (x)  rsqrt estimate + 3 Newton steps      relative error < 1.0e-10, x >= 0                 *
+*                                                                                                       *
+*  The functions are branch-free, such that the batch versions (mlog10pv, mexpv, mpow10v, msqrtv),      *
+*  which may work in place, are vectorized by the compiler.                                             *
+*                                                                                                       *
+*  They are used instead of the libm functions when "fast math" is switched on (SetWDSPFastMath).      *
+*                                                                                                       *
+********************************************************************************************************/
+
+#ifndef _fastmath_h
+#define _fastmath_h
+
+typedef union _fmbits
+{
+	double d;
+	uint64_t i;
+} fmbits;
+
+extern int wdsp_fastmath;
+
+// natural logarithm, for normalized x > 0 (0.0 and denormals give about -709)
+static __inline double mln (double x)
+{
+	fmbits u, e;
+	double m, s, z, hi;
+	u.d = x;
+	e.i = 0x4330000000000000ULL | ((u.i >> 52) & 2047);			// biased exponent, as a double
+	u.i = (u.i & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;	// mantissa, 1.0 <= m < 2.0
+	m = u.d;
+	hi = (double)(m > 1.4142135623730951);						// fold to sqrt(0.5) <= m < sqrt(2)
+	m *= 1.0 - 0.5 * hi;
+	s = (m - 1.0) / (m + 1.0);
+	z = s * s;
+	return (e.d - 4503599627370496.0 - 1023.0 + hi) * 0.6931471805599453
+		+ 2.0 * s * (1.0 + z * (1.0 / 3.0 + z * (1.0 / 5.0 + z * (1.0 / 7.0 + z * (1.0 / 9.0 + z * (1.0 / 11.0))))));
+}
+
+static __inline double mlog10p (double x)
+{
+	return 0.4342944819032518 * mln (x);
+}
+
+static __inline double mexp (double x)
+{
+	fmbits u, r;
+	double y, k, t, p;
+	double xc = x;
+	xc += (-708.0 - xc) * (double)(xc < -708.0);				// clamp without branches
+	xc += ( 709.0 - xc) * (double)(xc >  709.0);
+	y = 1.4426950408889634 * xc;								// x = (k + t / ln(2)) * ln(2)
+	r.d = y + 6755399441055744.0;								// round to nearest, k in the low bits
+	k = r.d - 6755399441055744.0;
+	t = (y - k) * 0.6931471805599453;							// |t| <= ln(2) / 2
+	p = 1.0 + t * (1.0 + t * (1.0 / 2.0 + t * (1.0 / 6.0 + t * (1.0 / 24.0 + t * (1.0 / 120.0
+		+ t * (1.0 / 720.0 + t * (1.0 / 5040.0 + t * (1.0 / 40320.0))))))));
+	u.i = (r.i + 1023) << 52;									// 2^k
+	return p * u.d * (double)(x >= -708.0);
+}
+
+static __inline double mpow10 (double x)
+{
+	return mexp (2.302585092994046 * x);
+}
+
+static __inline double msqrt (double x)
+{
+	fmbits u;
+	double y;
+	u.d = x;
+	u.i = 0x5FE6EB50C7B537A9ULL - (u.i >> 1);					// 1 / sqrt(x), 3.5% error
+	y = u.d;
+	y = y * (1.5 - 0.5 * x * y * y);
+	y = y * (1.5 - 0.5 * x * y * y);
+	y = y * (1.5 - 0.5 * x * y * y);
+	return x * y;
+}
+
+// select the libm or the fast version, depending on the run-time flag
+#define FM_LN(x)		(wdsp_fastmath ? mln (x)     : log (x))
+#define FM_LOG10(x)		(wdsp_fastmath ? mlog10p (x) : log10 (x))
+#define FM_EXP(x)		(wdsp_fastmath ? mexp (x)    : exp (x))
+#define FM_POW(x, y)	(wdsp_fastmath ? mexp ((y) * mln (x)) : pow (x, y))
+#define FM_SQRT(x)		(wdsp_fastmath ? msqrt (x)   : sqrt (x))
+
+extern void mlog10pv (int n, double* in, double* out);
+
+extern void mexpv (int n, double* in, double* out);
+
+extern void mpow10v (int n, double* in, double* out);
+
+extern void msqrtv (int n, double* in, double* out);
+
+// Properties
+
+extern __declspec (dllexport) void SetWDSPFastMath (int run);
+
+extern __declspec (dllexport) int GetWDSPFastMath (void);
+
+#endif
@@ -218,9 +218,9 @@ void destroy_firopt (FIROPT a)
 void flush_firopt (FIROPT a)
 {
 	int i; 
-	memset (a->fftin, 0, 2 * a->size * sizeof (complex));
+	memset (a->fftin, 0, 2 * a->size * sizeof (rcomplex));
 	for (i = 0; i < a->nfor; i++)
-		memset (a->fftout[i], 0, 2 * a->size * sizeof (complex));
+		memset (a->fftout[i], 0, 2 * a->size * sizeof (rcomplex));
 	a->buffidx = 0;
 }
 
@@ -295,27 +295,33 @@ void plan_fircore (FIRCORE a)
 	a->cset = 0;
 	a->buffidx = 0;
 	a->idxmask = a->nfor - 1;
-	a->fftin = (double *) malloc0 (2 * a->size * sizeof (complex));
-	a->fftout   = (double **) malloc0 (a->nfor * sizeof (double *));
-	a->fmask    = (double ***) malloc0 (2 * sizeof (double **));
-	a->fmask[0] = (double **) malloc0 (a->nfor * sizeof (double *));
-	a->fmask[1] = (double **) malloc0 (a->nfor * sizeof (double *));
-	a->maskgen = (double *) malloc0 (2 * a->size * sizeof (complex));
-	a->pcfor = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
-	a->maskplan    = (fftw_plan **) malloc0 (2 * sizeof (fftw_plan *));
-	a->maskplan[0] = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
-	a->maskplan[1] = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
+	a->fftin = (real *) malloc0 (2 * a->size * sizeof (rcomplex));
+	a->fftout   = (real **) malloc0 (a->nfor * sizeof (real *));
+	a->fmask    = (real ***) malloc0 (2 * sizeof (real **));
+	a->fmask[0] = (real **) malloc0 (a->nfor * sizeof (real *));
+	a->fmask[1] = (real **) malloc0 (a->nfor * sizeof (real *));
+	a->maskgen = (real *) malloc0 (2 * a->size * sizeof (rcomplex));
+	a->pcfor = (FFTW(plan) *) malloc0 (a->nfor * sizeof (FFTW(plan)));
+	a->maskplan    = (FFTW(plan) **) malloc0 (2 * sizeof (FFTW(plan) *));
+	a->maskplan[0] = (FFTW(plan) *) malloc0 (a->nfor * sizeof (FFTW(plan)));
+	a->maskplan[1] = (FFTW(plan) *) malloc0 (a->nfor * sizeof (FFTW(plan)));
 	for (i = 0; i < a->nfor; i++)
 	{
-		a->fftout[i]   = (double *) malloc0 (2 * a->size * sizeof (complex));
-		a->fmask[0][i] = (double *) malloc0 (2 * a->size * sizeof (complex));
-		a->fmask[1][i] = (double *) malloc0 (2 * a->size * sizeof (complex));
-		a->pcfor[i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->fftin, (fftw_complex *)a->fftout[i], FFTW_FORWARD, FFTW_PATIENT);
-		a->maskplan[0][i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->fmask[0][i], FFTW_FORWARD, FFTW_PATIENT);
-		a->maskplan[1][i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->fmask[1][i], FFTW_FORWARD, FFTW_PATIENT);
+		a->fftout[i]   = (real *) malloc0 (2 * a->size * sizeof (rcomplex));
+		a->fmask[0][i] = (real *) malloc0 (2 * a->size * sizeof (rcomplex));
+		a->fmask[1][i] = (real *) malloc0 (2 * a->size * sizeof (rcomplex));
+		a->pcfor[i] = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->fftin, (FFTW(complex) *)a->fftout[i], FFTW_FORWARD, FFTW_PATIENT);
+		a->maskplan[0][i] = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->maskgen, (FFTW(complex) *)a->fmask[0][i], FFTW_FORWARD, FFTW_PATIENT);
+		a->maskplan[1][i] = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->maskgen, (FFTW(complex) *)a->fmask[1][i], FFTW_FORWARD, FFTW_PATIENT);
 	}
-	a->accum = (double *) malloc0 (2 * a->size * sizeof (complex));
-	a->crev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->accum, (fftw_complex *)a->out, FFTW_BACKWARD, FFTW_PATIENT);
+	a->accum = (real *) malloc0 (2 * a->size * sizeof (rcomplex));
+#ifdef WDSP_REAL_FLOAT
+	// the reverse fft cannot write into the (double) output buffer directly
+	a->rout = (real *) malloc0 (2 * a->size * sizeof (rcomplex));
+	a->crev = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->accum, (FFTW(complex) *)a->rout, FFTW_BACKWARD, FFTW_PATIENT);
+#else
+	a->crev = FFTW(plan_dft_1d)(2 * a->size, (FFTW(complex) *)a->accum, (FFTW(complex) *)a->out, FFTW_BACKWARD, FFTW_PATIENT);
+#endif
 	a->masks_ready = 0;
 }
 
@@ -332,8 +338,14 @@ void calc_fircore (FIRCORE a, int flip)
 	{
 		// I right-justified the impulse response => take output from left side of output buff, discard right side
 		// Be careful about flipping an asymmetrical impulse response.
+#ifdef WDSP_REAL_FLOAT
+		int j;
+		for (j = 0; j < 2 * a->size; j++)
+			a->maskgen[2 * a->size + j] = (real)a->imp[2 * a->size * i + j];
+#else
 		memcpy (&(a->maskgen[2 * a->size]), &(a->imp[2 * a->size * i]), a->size * sizeof(complex));
-		fftw_execute (a->maskplan[1 - a->cset][i]);
+#endif
+		FFTW(execute) (a->maskplan[1 - a->cset][i]);
 	}
 	a->masks_ready = 1;
 	if (flip)
@@ -365,16 +377,19 @@ FIRCORE create_fircore (int size, double* in, double* out, int nc, int mp, doubl
 void deplan_fircore (FIRCORE a)
 {
 	int i;
-	fftw_destroy_plan (a->crev);
+	FFTW(destroy_plan) (a->crev);
 	_aligned_free (a->accum);
+#ifdef WDSP_REAL_FLOAT
+	_aligned_free (a->rout);
+#endif
 	for (i = 0; i < a->nfor; i++)
 	{
 		_aligned_free (a->fftout[i]);
 		_aligned_free (a->fmask[0][i]);
 		_aligned_free (a->fmask[1][i]);
-		fftw_destroy_plan (a->pcfor[i]);
-		fftw_destroy_plan (a->maskplan[0][i]);
-		fftw_destroy_plan (a->maskplan[1][i]);
+		FFTW(destroy_plan) (a->pcfor[i]);
+		FFTW(destroy_plan) (a->maskplan[0][i]);
+		FFTW(destroy_plan) (a->maskplan[1][i]);
 	}
 	_aligned_free (a->maskplan[0]);
 	_aligned_free (a->maskplan[1]);
@@ -400,9 +415,9 @@ void destroy_fircore (FIRCORE a)
 void flush_fircore (FIRCORE a)
 {
 	int i; 
-	memset (a->fftin, 0, 2 * a->size * sizeof (complex));
+	memset (a->fftin, 0, 2 * a->size * sizeof (rcomplex));
 	for (i = 0; i < a->nfor; i++)
-		memset (a->fftout[i], 0, 2 * a->size * sizeof (complex));
+		memset (a->fftout[i], 0, 2 * a->size * sizeof (rcomplex));
 	a->buffidx = 0;
 }
 
@@ -410,14 +425,19 @@ void xfircore (FIRCORE a)
 {
 	//[2.10.3.9]MW0LGE refactor to remove pointer chase in the loops
 	int i, j, k;
+#ifdef WDSP_REAL_FLOAT
+	for (i = 0; i < 2 * a->size; i++)
+		a->fftin[2 * a->size + i] = (real)a->in[i];
+#else
 	memcpy (&(a->fftin[2 * a->size]), a->in, a->size * sizeof (complex));
-	fftw_execute (a->pcfor[a->buffidx]);
+#endif
+	FFTW(execute) (a->pcfor[a->buffidx]);
 	k = a->buffidx;
-	memset (a->accum, 0, 2 * a->size * sizeof (complex));
+	memset (a->accum, 0, 2 * a->size * sizeof (rcomplex));
 	EnterCriticalSection (&a->update);
-	double* accum = a->accum;
-	double** fftout = a->fftout;
-	double*** fmask = a->fmask;
+	real* accum = a->accum;
+	real** fftout = a->fftout;
+	real*** fmask = a->fmask;
 	int cset = a->cset;
 	int idxmask = a->idxmask;
 	int sz = a->size;
@@ -433,8 +453,12 @@ void xfircore (FIRCORE a)
 	}
 	LeaveCriticalSection (&a->update);
 	a->buffidx = (a->buffidx + 1) & idxmask;
-	fftw_execute (a->crev);
-	memcpy (a->fftin, &(a->fftin[2 * a->size]), a->size * sizeof(complex));
+	FFTW(execute) (a->crev);
+#ifdef WDSP_REAL_FLOAT
+	for (i = 0; i < 2 * a->size; i++)
+		a->out[i] = (double)a->rout[i];
+#endif
+	memcpy (a->fftin, &(a->fftin[2 * a->size]), a->size * sizeof(rcomplex));
 }
 
 void setBuffers_fircore (FIRCORE a, double* in, double* out)
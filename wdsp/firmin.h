@@ -144,16 +144,17 @@ typedef struct _fircore
 	double* impulse;		// impulse response of filter
 	double* imp;
 	int nfor;				// number of buffers in delay line
-	double* fftin;			// fft input buffer
-	double*** fmask;		// frequency domain masks
-	double** fftout;		// fftout delay line
-	double* accum;			// frequency domain accumulator
+	real* fftin;			// fft input buffer
+	real*** fmask;			// frequency domain masks
+	real** fftout;			// fftout delay line
+	real* accum;			// frequency domain accumulator
+	real* rout;				// reverse fft output (single precision only, else 'out')
 	int buffidx;			// fft out buffer index
 	int idxmask;			// mask for index computations
-	double* maskgen;		// input for mask generation FFT
-	fftw_plan* pcfor;		// array of forward FFT plans
-	fftw_plan crev;			// reverse fft plan
-	fftw_plan** maskplan;	// plans for frequency domain masks
+	real* maskgen;			// input for mask generation FFT
+	FFTW(plan)* pcfor;		// array of forward FFT plans
+	FFTW(plan) crev;		// reverse fft plan
+	FFTW(plan)** maskplan;	// plans for frequency domain masks
 	CRITICAL_SECTION update;
 	int cset;
 	int mp;
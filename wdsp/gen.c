@@ -26,24 +26,17 @@ warren@wpratt.com
 
 #include "comm.h"
 
+// the tones are generated as (+cos, -sin), i.e., with a negative phase increment
+
 void calc_tone (GEN a)
 {
-	a->tone.phs = 0.0;
-	a->tone.delta = TWOPI * a->tone.freq / a->rate;
-	a->tone.cosdelta = cos (a->tone.delta);
-	a->tone.sindelta = sin (a->tone.delta);
+	init_nco (&a->tone.osc, - TWOPI * a->tone.freq / a->rate);
 }
 
 void calc_tt (GEN a)
 {
-	a->tt.phs1 = 0.0;
-	a->tt.phs2 = 0.0;
-	a->tt.delta1 = TWOPI * a->tt.f1 / a->rate;
-	a->tt.delta2 = TWOPI * a->tt.f2 / a->rate;
-	a->tt.cosdelta1 = cos (a->tt.delta1);
-	a->tt.cosdelta2 = cos (a->tt.delta2);
-	a->tt.sindelta1 = sin (a->tt.delta1);
-	a->tt.sindelta2 = sin (a->tt.delta2);
+	init_nco (&a->tt.osc1, - TWOPI * a->tt.f1 / a->rate);
+	init_nco (&a->tt.osc2, - TWOPI * a->tt.f2 / a->rate);
 }
 
 void calc_sweep (GEN a)
@@ -220,51 +213,13 @@ void xgen (GEN a)
 		{
 		case 0:	// tone
 			{
-				int i;
-				double t1, t2;
-				double cosphase = cos (a->tone.phs);
-				double sinphase = sin (a->tone.phs);
-				for (i = 0; i < a->size; i++)
-				{
-					a->out[2 * i + 0] = + a->tone.mag * cosphase;
-					a->out[2 * i + 1] = - a->tone.mag * sinphase;
-					t1 = cosphase;
-					t2 = sinphase;
-					cosphase = t1 * a->tone.cosdelta - t2 * a->tone.sindelta;
-					sinphase = t1 * a->tone.sindelta + t2 * a->tone.cosdelta;
-					a->tone.phs += a->tone.delta;
-					if (a->tone.phs >= TWOPI) a->tone.phs -= TWOPI;
-					if (a->tone.phs <   0.0 ) a->tone.phs += TWOPI;
-				}
+				xnco_gen (&a->tone.osc, a->size, a->tone.mag, a->out, 0);
 				break;
 			}
 		case 1:	// two-tone
 			{
-				int i;
-				double tcos, tsin;
-				double cosphs1 = cos (a->tt.phs1);
-				double sinphs1 = sin (a->tt.phs1);
-				double cosphs2 = cos (a->tt.phs2);
-				double sinphs2 = sin (a->tt.phs2);
-				for (i = 0; i < a->size; i++)
-				{
-					a->out[2 * i + 0] = + a->tt.mag1 * cosphs1 + a->tt.mag2 * cosphs2;
-					a->out[2 * i + 1] = - a->tt.mag1 * sinphs1 - a->tt.mag2 * sinphs2;
-					tcos = cosphs1;
-					tsin = sinphs1;
-					cosphs1 = tcos * a->tt.cosdelta1 - tsin * a->tt.sindelta1;
-					sinphs1 = tcos * a->tt.sindelta1 + tsin * a->tt.cosdelta1;
-					a->tt.phs1 += a->tt.delta1;
-					if (a->tt.phs1 >= TWOPI) a->tt.phs1 -= TWOPI;
-					if (a->tt.phs1 <   0.0 ) a->tt.phs1 += TWOPI;
-					tcos = cosphs2;
-					tsin = sinphs2;
-					cosphs2 = tcos * a->tt.cosdelta2 - tsin * a->tt.sindelta2;
-					sinphs2 = tcos * a->tt.sindelta2 + tsin * a->tt.cosdelta2;
-					a->tt.phs2 += a->tt.delta2;
-					if (a->tt.phs2 >= TWOPI) a->tt.phs2 -= TWOPI;
-					if (a->tt.phs2 <   0.0 ) a->tt.phs2 += TWOPI;
-				}
+				xnco_gen (&a->tt.osc1, a->size, a->tt.mag1, a->out, 0);
+				xnco_gen (&a->tt.osc2, a->size, a->tt.mag2, a->out, 1);
 				break;
 			}
 		case 2: // noise
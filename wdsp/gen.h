@@ -27,6 +27,8 @@ warren@wpratt.com
 #ifndef _gen_h
 #define _gen_h
 
+#include "nco.h"
+
 typedef struct _gen
 {
 	int run;					// run
@@ -39,10 +41,7 @@ typedef struct _gen
 	{
 		double mag;
 		double freq;
-		double phs;
-		double delta;
-		double cosdelta;
-		double sindelta;
+		nco osc;
 	} tone;
 	struct _tt
 	{
@@ -50,14 +49,8 @@ typedef struct _gen
 		double mag2;
 		double f1;
 		double f2;
-		double phs1;
-		double phs2;
-		double delta1;
-		double delta2;
-		double cosdelta1;
-		double cosdelta2;
-		double sindelta1;
-		double sindelta2;
+		nco osc1;
+		nco osc2;
 	} tt;
 	struct _noise
 	{
@@ -36,6 +36,7 @@ void wdspmain (void *pargs)
 #endif
 
 	int channel = (int)(uintptr_t)pargs;
+	channel_thread_start (channel);
 	while (_InterlockedAnd (&ch[channel].run, 1))
 	{
 		WaitForSingleObject(ch[channel].iob.pd->Sem_BuffReady,INFINITE);
@@ -0,0 +1,162 @@
+/*  nco.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Christoph van Wuellen, DL1YCF
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+void set_nco_delta (NCO a, double delta)
+{
+	int k;
+	a->delta = delta;
+	a->cstep = cos (NCO_LANES * delta);
+	a->sstep = sin (NCO_LANES * delta);
+	for (k = 0; k < NCO_LANES; k++)
+	{
+		a->cd[k] = cos (k * delta);
+		a->sd[k] = sin (k * delta);
+	}
+}
+
+void init_nco (NCO a, double delta)
+{
+	a->phase = 0.0;
+	set_nco_delta (a, delta);
+}
+
+void flush_nco (NCO a)
+{
+	a->phase = 0.0;
+}
+
+// set the phasors c, s of a block from the phase of its first sample
+static __inline void sync_nco (NCO a, double phase, double* c, double* s)
+{
+	int k;
+	double cp = cos (phase);
+	double sp = sin (phase);
+	for (k = 0; k < NCO_LANES; k++)
+	{
+		c[k] = cp * a->cd[k] - sp * a->sd[k];
+		s[k] = cp * a->sd[k] + sp * a->cd[k];
+	}
+}
+
+// advance the phasors c, s by NCO_LANES samples
+static __inline void step_nco (NCO a, double* c, double* s)
+{
+	int k;
+	double t;
+	for (k = 0; k < NCO_LANES; k++)
+	{
+		t = c[k];
+		c[k] = t * a->cstep - s[k] * a->sstep;
+		s[k] = t * a->sstep + s[k] * a->cstep;
+	}
+}
+
+static void advance_nco (NCO a, int n)
+{
+	a->phase = fmod (a->phase + n * a->delta, TWOPI);
+	if (a->phase < 0.0) a->phase += TWOPI;
+}
+
+// out = in * exp (j * phase), in-place is allowed
+void xnco_mix (NCO a, int n, double* in, double* out)
+{
+	int i, k, m, blocks = 0;
+	double I, Q;
+	double c[NCO_LANES], s[NCO_LANES];
+	double* pin;
+	double* pout;
+	sync_nco (a, a->phase, c, s);
+	for (i = 0; i < n; i += NCO_LANES)
+	{
+		pin = in + 2 * i;
+		pout = out + 2 * i;
+		if (n - i >= NCO_LANES)
+		{
+			for (k = 0; k < NCO_LANES; k++)
+			{
+				I = pin[2 * k + 0];
+				Q = pin[2 * k + 1];
+				pout[2 * k + 0] = I * c[k] - Q * s[k];
+				pout[2 * k + 1] = I * s[k] + Q * c[k];
+			}
+		}
+		else
+		{
+			m = n - i;
+			for (k = 0; k < m; k++)
+			{
+				I = pin[2 * k + 0];
+				Q = pin[2 * k + 1];
+				pout[2 * k + 0] = I * c[k] - Q * s[k];
+				pout[2 * k + 1] = I * s[k] + Q * c[k];
+			}
+		}
+		if (++blocks == NCO_RESYNC)
+		{
+			sync_nco (a, a->phase + (i + NCO_LANES) * a->delta, c, s);
+			blocks = 0;
+		}
+		else
+			step_nco (a, c, s);
+	}
+	advance_nco (a, n);
+}
+
+// out = mag * exp (j * phase), or out += mag * exp (j * phase) if add != 0
+void xnco_gen (NCO a, int n, double mag, double* out, int add)
+{
+	int i, k, m, blocks = 0;
+	double c[NCO_LANES], s[NCO_LANES];
+	double* pout;
+	sync_nco (a, a->phase, c, s);
+	for (i = 0; i < n; i += NCO_LANES)
+	{
+		pout = out + 2 * i;
+		m = n - i < NCO_LANES ? n - i : NCO_LANES;
+		if (add)
+		{
+			for (k = 0; k < m; k++)
+			{
+				pout[2 * k + 0] += mag * c[k];
+				pout[2 * k + 1] += mag * s[k];
+			}
+		}
+		else
+		{
+			for (k = 0; k < m; k++)
+			{
+				pout[2 * k + 0] = mag * c[k];
+				pout[2 * k + 1] = mag * s[k];
+			}
+		}
+		if (++blocks == NCO_RESYNC)
+		{
+			sync_nco (a, a->phase + (i + NCO_LANES) * a->delta, c, s);
+			blocks = 0;
+		}
+		else
+			step_nco (a, c, s);
+	}
+	advance_nco (a, n);
+}
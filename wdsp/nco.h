@@ -0,0 +1,61 @@
+/*  nco.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Christoph van Wuellen, DL1YCF
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                                                                       *
+*  Block NCO.                                                                                           *
+*                                                                                                       *
+*  The phasors of NCO_LANES consecutive samples are held in two small arrays, and the whole block is    *
+*  advanced by one complex multiplication with exp(j * NCO_LANES * delta). The loops over the lanes     *
+*  have no dependencies between iterations, so the compiler uses SIMD instructions for them.            *
+*  The phase itself is kept in a separate accumulator, and the phasors are re-computed from it at the   *
+*  start of each call and every NCO_RESYNC blocks, so the amplitude and phase cannot drift.             *
+*                                                                                                       *
+********************************************************************************************************/
+
+#ifndef _nco_h
+#define _nco_h
+
+#define NCO_LANES		8
+#define NCO_RESYNC		64
+
+typedef struct _nco
+{
+	double phase;						// phase of the next output sample, 0 <= phase < TWOPI
+	double delta;						// phase increment per sample
+	double cstep;						// cos (NCO_LANES * delta)
+	double sstep;						// sin (NCO_LANES * delta)
+	double cd[NCO_LANES];				// cos (k * delta)
+	double sd[NCO_LANES];				// sin (k * delta)
+} nco, *NCO;
+
+extern void init_nco (NCO a, double delta);
+
+extern void set_nco_delta (NCO a, double delta);
+
+extern void flush_nco (NCO a);
+
+extern void xnco_mix (NCO a, int n, double* in, double* out);
+
+extern void xnco_gen (NCO a, int n, double mag, double* out, int add);
+
+#endif
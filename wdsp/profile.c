@@ -0,0 +1,185 @@
+/*  profile.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Christoph van Wuellen, DL1YCF
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+profile prof[MAX_CHANNELS];
+
+// stage names, same order as enum rxaStage and enum txaStage
+static const char* rxa_stage_name[RXA_STAGE_LAST] =
+{
+	"shift",
+	"input resampler",
+	"generator",
+	"ADC meter",
+	"SNBA bandpass in",
+	"notched bandpass",
+	"S-meter",
+	"sender",
+	"AM squelch capture",
+	"SNBA bandpass out",
+	"AM demodulator",
+	"FM demodulator",
+	"FM squelch",
+	"SNBA bandpass in 2",
+	"SNBA bandpass out 2",
+	"SNBA",
+	"equalizer",
+	"ANF (pre-AGC)",
+	"NR (pre-AGC)",
+	"NR2 (pre-AGC)",
+	"bandpass (pre-AGC)",
+	"AGC",
+	"ANF (post-AGC)",
+	"NR (post-AGC)",
+	"NR2 (post-AGC)",
+	"bandpass (post-AGC)",
+	"AGC meter",
+	"siphon",
+	"carrier block",
+	"CW peak filter",
+	"audio peak filter",
+	"voice squelch",
+	"panel",
+	"AM squelch",
+	"output resampler",
+};
+
+static const char* txa_stage_name[TXA_STAGE_LAST] =
+{
+	"input resampler",
+	"input generator",
+	"panel",
+	"phase rotator",
+	"mic meter",
+	"expander capture",
+	"expander",
+	"equalizer",
+	"EQ meter",
+	"FM pre-emphasis",
+	"leveler",
+	"leveler meter",
+	"CFC",
+	"CFC meter",
+	"bandpass",
+	"compressor",
+	"bandpass (COMP)",
+	"CESSB",
+	"bandpass (CESSB)",
+	"COMP meter",
+	"ALC",
+	"AM modulator",
+	"FM pre-emphasis 2",
+	"FM modulator",
+	"output generator",
+	"up-slew",
+	"ALC meter",
+	"siphon",
+	"PureSignal correction",
+	"CFIR",
+	"output resampler",
+	"output meter",
+};
+
+static double ticks_per_usec = 0.0;
+
+static double now_usec (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return 1.0e6 * ts.tv_sec + 1.0e-3 * ts.tv_nsec;
+}
+
+static void calibrate_profile (void)
+{
+	// measure the frequency of the cycle counter once
+	double t0, t1;
+	unsigned long long c0, c1;
+	if (ticks_per_usec > 0.0) return;
+	t0 = now_usec ();
+	c0 = profile_ticks ();
+	Sleep (20);
+	t1 = now_usec ();
+	c1 = profile_ticks ();
+	ticks_per_usec = (double)(c1 - c0) / (t1 - t0);
+	if (ticks_per_usec <= 0.0) ticks_per_usec = 1.0;
+}
+
+static int get_stage_times (int channel, double* avg, double* peak, int size, int nstages)
+{
+	// the values are read without locking, an occasional torn value does not matter here
+	int i;
+	PROFILE a = &prof[channel];
+	long count = a->count;
+	if (size > nstages) size = nstages;
+	for (i = 0; i < size; i++)
+	{
+		avg[i]  = count > 0 ? (double)a->sum[i] / (count * ticks_per_usec) : 0.0;
+		peak[i] = (double)a->max[i] / ticks_per_usec;
+	}
+	return size;
+}
+
+/********************************************************************************************************
+*																										*
+*											Properties													*
+*																										*
+********************************************************************************************************/
+
+PORT
+void SetChannelProfileRun (int channel, int run)
+{
+	// switching on (again) clears the statistics, this is done by the
+	// channel thread itself at the start of the next xrxa/xtxa call
+	if (run)
+	{
+		calibrate_profile ();
+		prof[channel].reset = 1;
+	}
+	prof[channel].run = run;
+}
+
+PORT
+int GetRXAStageTimes (int channel, double* avg, double* peak, int size)
+{
+	return get_stage_times (channel, avg, peak, size, RXA_STAGE_LAST);
+}
+
+PORT
+int GetTXAStageTimes (int channel, double* avg, double* peak, int size)
+{
+	return get_stage_times (channel, avg, peak, size, TXA_STAGE_LAST);
+}
+
+PORT
+const char* GetRXAStageName (int stage)
+{
+	if (stage < 0 || stage >= RXA_STAGE_LAST) return "";
+	return rxa_stage_name[stage];
+}
+
+PORT
+const char* GetTXAStageName (int stage)
+{
+	if (stage < 0 || stage >= TXA_STAGE_LAST) return "";
+	return txa_stage_name[stage];
+}
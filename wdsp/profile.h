@@ -0,0 +1,122 @@
+/*  profile.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Christoph van Wuellen, DL1YCF
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*                                                                                                       *
+*  Per-stage profiler for xrxa() and xtxa().                                                            *
+*                                                                                                       *
+*  When profiling is switched on for a channel, a time stamp is taken from a cheap cycle counter after *
+*  each stage, and the time since the previous stamp is accumulated for that stage. When switched off, *
+*  the cost is one test per stage.                                                                      *
+*                                                                                                       *
+********************************************************************************************************/
+
+#ifndef _profile_h
+#define _profile_h
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(_WIN32)
+#include <x86intrin.h>
+#endif
+
+#define PROFILE_MAX_STAGES	48
+
+typedef struct _profile
+{
+	volatile long run;							// profiling active
+	volatile long reset;						// clear statistics before the next call
+	unsigned long long last;					// time stamp of the previous stage (ticks)
+	int nstages;								// number of stages seen so far
+	long count;									// number of xrxa/xtxa calls profiled
+	unsigned long long sum[PROFILE_MAX_STAGES];	// accumulated ticks, per stage
+	unsigned long long max[PROFILE_MAX_STAGES];	// max. ticks of a single call, per stage
+} profile, *PROFILE;
+
+extern profile prof[];
+
+static __inline unsigned long long profile_ticks (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc ();
+#elif defined(__aarch64__)
+	unsigned long long t;
+	__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (t));
+	return t;
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return 1000000000ULL * ts.tv_sec + ts.tv_nsec;
+#endif
+}
+
+// called at the start of xrxa/xtxa
+static __inline void profile_begin (int channel)
+{
+	PROFILE a = &prof[channel];
+	if (a->run)
+	{
+		if (a->reset)
+		{
+			memset (a->sum, 0, sizeof (a->sum));
+			memset (a->max, 0, sizeof (a->max));
+			a->count = 0;
+			a->nstages = 0;
+			a->reset = 0;
+		}
+		a->last = profile_ticks ();
+	}
+}
+
+// called after each stage, stages are numbered in calling order
+static __inline void profile_stage (int channel, int stage)
+{
+	PROFILE a = &prof[channel];
+	if (a->run)
+	{
+		unsigned long long now = profile_ticks ();
+		unsigned long long dt = now - a->last;
+		a->last = now;
+		a->sum[stage] += dt;
+		if (dt > a->max[stage]) a->max[stage] = dt;
+		if (stage >= a->nstages) a->nstages = stage + 1;
+	}
+}
+
+// called at the end of xrxa/xtxa
+static __inline void profile_end (int channel)
+{
+	if (prof[channel].run)
+		prof[channel].count++;
+}
+
+// Properties
+
+extern __declspec (dllexport) void SetChannelProfileRun (int channel, int run);
+
+extern __declspec (dllexport) int GetRXAStageTimes (int channel, double* avg, double* peak, int size);
+
+extern __declspec (dllexport) int GetTXAStageTimes (int channel, double* avg, double* peak, int size);
+
+extern __declspec (dllexport) const char* GetRXAStageName (int stage);
+
+extern __declspec (dllexport) const char* GetTXAStageName (int stage);
+
+#endif
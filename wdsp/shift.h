@@ -27,6 +27,8 @@ warren@wpratt.com
 #ifndef _shift_h
 #define _shift_h
 
+#include "nco.h"
+
 typedef struct _shift
 {
 	int run;
@@ -35,10 +37,7 @@ typedef struct _shift
 	double* out;
 	double rate;
 	double shift;
-	double phase;
-	double delta;
-	double cos_delta;
-	double sin_delta;
+	nco osc;
 } shift, *SHIFT;
 
 extern SHIFT create_shift (int run, int size, double* in, double* out, int rate, double fshift);
@@ -336,7 +336,7 @@ void xwcpagc (WCPAGC a)
 			if (a->volts < a->min_volts)
 				a->volts = a->min_volts;
 			a->gain = a->volts * a->inv_out_target;
-			mult = (a->out_target - a->slope_constant * min (0.0, log10(a->inv_max_input * a->volts))) / a->volts;
+			mult = (a->out_target - a->slope_constant * min (0.0, FM_LOG10(a->inv_max_input * a->volts))) / a->volts;
 			a->out[2 * i + 0] = a->out_sample[0] * mult;
 			a->out[2 * i + 1] = a->out_sample[1] * mult;
 		}
@@ -197,6 +197,7 @@ extern void SetDisplayNumAverage (int disp, int pixout, int num);
 extern void SetDisplayAvBackmult (int disp, int pixout, double mult);
 extern void SetDisplaySampleRate (int disp, int rate);
 extern void SetDisplayNormOneHz (int disp, int pixout, int norm);
+extern void SetDisplayPixout (int disp, int pixout, int num_pixels, double clipL, double clipH);
 extern double GetDisplayENB (int disp);
 
 //
@@ -317,6 +318,7 @@ extern void SetChannelTDelayUp (int channel, double time);
 extern void SetChannelTSlewUp (int channel, double time);
 extern void SetChannelTDelayDown (int channel, double time);
 extern void SetChannelTSlewDown (int channel, double time);
+extern void SetChannelThreadCallback (void (*callback)(int channel, int type));
 
 //
 // Interfaces from compress.c
@@ -618,6 +620,23 @@ extern void SetTXAiqcEnd (int channel);
 extern double GetRXAMeter (int channel, int mt);
 extern double GetTXAMeter (int channel, int mt);
 
+//
+// Interfaces from profile.c
+//
+
+extern void SetChannelProfileRun (int channel, int run);
+extern int GetRXAStageTimes (int channel, double* avg, double* peak, int size);
+extern int GetTXAStageTimes (int channel, double* avg, double* peak, int size);
+extern const char* GetRXAStageName (int stage);
+extern const char* GetTXAStageName (int stage);
+
+//
+// Interfaces from fastmath.c
+//
+
+extern void SetWDSPFastMath (int run);
+extern int GetWDSPFastMath (void);
+
 //
 // Interfaces from nbp.c
 //
@@ -115,5 +115,33 @@ int WDSPwisdom (char* directory)
 #endif
 		wisdom_return = 1;
 	}
+#ifdef WDSP_REAL_FLOAT
+	// single-precision plans for the fast-convolution filters are kept in a separate file
+	strncat (wisdom_file, "f", 2);
+	if(!FFTW(import_wisdom_from_filename)(wisdom_file))
+	{
+		FFTW(plan) fplan;
+		real* ffin  = (real *) malloc0 (MAX_WISDOM_SIZE_FILTER * sizeof (rcomplex));
+		real* ffout = (real *) malloc0 (MAX_WISDOM_SIZE_FILTER * sizeof (rcomplex));
+		psize = 64;
+		while (psize <= MAX_WISDOM_SIZE_FILTER)
+		{
+			fprintf(stdout, "Planning SINGLE PRECISION FFT size %d\n", psize);
+			fflush(stdout);
+			sprintf(status, "Planning SINGLE PRECISION FFT size %d\n", psize);
+			fplan = FFTW(plan_dft_1d)(psize, (FFTW(complex) *)ffin, (FFTW(complex) *)ffout, FFTW_FORWARD, FFTW_PATIENT);
+			FFTW(execute) (fplan);
+			FFTW(destroy_plan) (fplan);
+			fplan = FFTW(plan_dft_1d)(psize, (FFTW(complex) *)ffin, (FFTW(complex) *)ffout, FFTW_BACKWARD, FFTW_PATIENT);
+			FFTW(execute) (fplan);
+			FFTW(destroy_plan) (fplan);
+			psize *= 2;
+		}
+		FFTW(export_wisdom_to_filename)(wisdom_file);
+		_aligned_free (ffout);
+		_aligned_free (ffin);
+		wisdom_return = 1;
+	}
+#endif
 	return wisdom_return;
 }